@@ -16,7 +16,7 @@ else if [ `/bin/uname -s` = 'Linux' ]; then
    MLV_XWINDOW_LIBRARY="/usr/X11R6/lib"
    MLV_MOTIF_INCLUDE="/usr/local/LessTif/Motif1.2/include"
    MLV_MOTIF_LIBRARY="/usr/local/LessTif/Motif1.2/lib"
-   FLAGS="-Wall"
+   FLAGS="-Wall -O2"
    CC=gcc
 else if [ `hostname` = gael ]; then
    MLV_XWINDOW_INCLUDE="/users2/telimago/openwin/include"
@@ -36,10 +36,19 @@ fi
 fi
 fi
 
+################################################################################
+# Library shared by the programs of every TD (image type, loader, display and  #
+# operators), rebuilt before linking                                           #
+################################################################################
+LIB=../lib
+export CC FLAGS MLV_XWINDOW_INCLUDE
+$LIB/compi_lib || exit 1
+
 for f in $*
 do
    p=`echo $f | cut -f1 -d"."`
-   $CC -I$MLV_XWINDOW_INCLUDE -I$MLV_MOTIF_INCLUDE $FLAGS   $p.c -o $p         \
-       -L$MLV_MOTIF_LIBRARY -L$MLV_XWINDOW_LIBRARY -lXt -lX11 -lm
+   $CC -I$MLV_XWINDOW_INCLUDE -I$MLV_MOTIF_INCLUDE -I$LIB $FLAGS   $p.c -o $p \
+       -L$LIB -liti                                                           \
+       -L$MLV_MOTIF_LIBRARY -L$MLV_XWINDOW_LIBRARY -lXt -lX11 -lm -lpthread
 #       -L$MLV_MOTIF_LIBRARY -L$MLV_XWINDOW_LIBRARY -lXm -lXt -lX11 -lm
 done
@@ -0,0 +1,1203 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* bench_convol times the convolutions and the other operators of the library */
+/* on a random image, and checks their outputs against references.            */
+/******************************************************************************/
+/* SYNOPSIS                                                                   */
+/* bench_convol [ <line_number> [ <pixel_number> [ <repetition_number> ] ] ]  */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A random RGB image of the given size (default 1024 x 1024) goes through    */
+/* the measures below, in this order. The best time among the repetitions is  */
+/* reported. The program exits with status 1 if any check fails.              */
+/* . Banded convolution: Mean matrices of size 3 to MAX_SIZE are applied      */
+/*   serially by Convolution(), then by ConvolutionBands() on pools of 1, 2,  */
+/*   4 ... threads and of the number of online processors, with the speedup   */
+/*   against the serial run. Every parallel output must equal the serial one. */
+/*   The speedup with one thread is the gain of folding the symmetric         */
+/*   matrices, which Convolution() does not do.                               */
+/* . Methods: for Gauss matrices of size 3 to 31, the direct, separable and   */
+/*   FFT methods are timed on all the threads and compared to the direct      */
+/*   output (greatest difference in gray levels). The method chosen by        */
+/*   ConvolutionMethod() at the CPU level of the kernels (cpu.h) is marked,   */
+/*   and the fastest one is reported when it differs. Timings depend on the   */
+/*   load of the machine and are not checked.                                 */
+/* . Recursive Gauss (iir.c): timed with the same sigma (size / 3.5). Its     */
+/*   difference with the sampled Gaussian over 6 sigma (IirGaussReference()), */
+/*   borders included, must not exceed IirGaussBound().                       */
+/* . Filter bank (bank.c): the six Gradient and Sobel N-S, W-E, NW-SE         */
+/*   matrices are run one by one, then together by FilterBank(). Both outputs */
+/*   must be identical; the speedup of the bank is reported.                  */
+/* . Median (median.c): radii 1 to 16, compared to a reference counting the   */
+/*   window of every pixel; outputs must be identical.                        */
+/* . Morphology (morpho.c): erosions and openings by squares of size 3 to 63; */
+/*   each erosion must equal the repeated erosions by the 3x3 square.         */
+/* . Bilateral (bilateral.c): sigma_space 1 to 8 and sigma_range 4 and 16     */
+/*   (supported range: see bilateral.c), against the exact filter, with the   */
+/*   mean and greatest differences in gray levels, and the times of both.     */
+/*   The differences of the grid are reported, not checked; when              */
+/*   BilateralUsesGrid() chooses the exact filter, the output must be exact.  */
+/* . Starlet (starlet.c): decompositions into 1 to MAX_STARLET_SCALE planes;  */
+/*   the reconstruction must give back the image exactly.                     */
+/* . Pyramids (pyramid.c): the Gaussian and Laplacian pyramids are built with */
+/*   all their levels and collapsed; the collapse must give back the image.   */
+/* . Unsharp mask (unsharp.c): the fused pass against a blur into a whole     */
+/*   plane followed by an arithmetic pass; outputs must be identical.         */
+/* . Canny (canny.c): one thread against all of them; the edge maps must be   */
+/*   identical.                                                               */
+/* . Guarded images (image.c): Mean matrices applied by ConvolutionImage() on */
+/*   images with guards (ImageAllocGuard), on the whole padded lines, next to */
+/*   the direct method of ConvolutionApply() on packed lines, then the        */
+/*   identity and 3x3 shifts; outputs must be identical, borders included.    */
+/* . Pipelines (pipeline.c): three pipelines mixing tables, Gauss 5x5 and     */
+/*   arithmetic, run stage by stage with a plane allocated per stage, stage   */
+/*   by stage with the planes in an arena (arena.c), tile by tile, and tile   */
+/*   by tile in place on a copy of the image; outputs must be identical. The  */
+/*   memory of the intermediates is reported for each way (in place: halos    */
+/*   and rings, no output image).                                             */
+/* . Output stage (saturate.c): the branchless conversion to bytes against    */
+/*   the "if" clipping it replaced, on accumulators spread over [-100,355] at */
+/*   random (noisy image) and on a smooth ramp; bytes must be identical.      */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+/******************************************************************************/
+/* Local inclusion files                                                      */
+/******************************************************************************/
+#include  "convol.h"
+#include  "bank.h"
+#include  "iir.h"
+#include  "median.h"
+#include  "morpho.h"
+#include  "bilateral.h"
+#include  "starlet.h"
+#include  "pyramid.h"
+#include  "unsharp.h"
+#include  "canny.h"
+#include  "saturate.h"
+#include  "pipeline.h"
+
+/******************************************************************************/
+/* ElapsedTime returns the time in seconds of a monotonic clock.              */
+/******************************************************************************/
+static double ElapsedTime (void)
+{
+   struct timespec  now;                /* current time */
+
+   clock_gettime (CLOCK_MONOTONIC,&now);
+   return (now.tv_sec + 1.e-9 * now.tv_nsec);
+} /* ElapsedTime */
+
+/******************************************************************************/
+/* NextThreadNumber returns the number of threads of the next pool measured:  */
+/* twice thread_number, but max_thread last even when it is no power of 2.    */
+/******************************************************************************/
+static int NextThreadNumber (
+   int              thread_number,      /* threads of the current pool */
+   int              max_thread)         /* greatest number of threads */
+{
+   if ((thread_number < max_thread) && (2 * thread_number > max_thread))
+      return (max_thread);
+   return (2 * thread_number);
+} /* NextThreadNumber */
+
+/******************************************************************************/
+/* MedianReference computes the median filter of one channel by counting the  */
+/* whole window of every pixel.                                               */
+/******************************************************************************/
+static void MedianReference (
+   int              radius,             /* half size of the window */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              histogram[256];     /* histogram of the window */
+   int              ili, ipx;           /* line, pixel of the output */
+   int              k, l;               /* line, pixel in the window */
+   int              value;              /* output value */
+   int              count;              /* pixels below value */
+
+   memcpy (image_out,image_in,nliin*npxin);
+   for (ili=radius; ili<nliin-radius; ili++)
+   {
+      for (ipx=radius; ipx<npxin-radius; ipx++)
+      {
+         memset (histogram,0,sizeof(histogram));
+         for (k=-radius; k<=radius; k++)
+         {
+            for (l=-radius; l<=radius; l++)
+               histogram[image_in[(ili+k)*npxin+ipx+l]] =
+                  histogram[image_in[(ili+k)*npxin+ipx+l]] + 1;
+         }
+         count = 0;
+         for (value=0; count+histogram[value]<=(2*radius+1)*(2*radius+1)/2;
+              value++)
+            count = count + histogram[value];
+         image_out[ili*npxin+ipx] = (unsigned char)value;
+      }
+   }
+} /* MedianReference */
+
+
+/******************************************************************************/
+/* UnsharpReference sharpens one channel as two passes would do: Gauss blur   */
+/* into a whole plane, then difference, gain and clipping.                    */
+/******************************************************************************/
+static int UnsharpReference (
+   double           sigma,              /* standard deviation of the blur */
+   double           amount,             /* gain of the difference */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   float            weight[MAX_UNSHARP_RADIUS+1]; /* Gauss taps 0 ... R */
+   int              radius;             /* half size R of the blur */
+   float            *vertical;          /* plane blurred along columns */
+   float            *blur;              /* plane blurred along both */
+   int              ili, ipx;           /* line, pixel */
+   int              k;                  /* index among taps */
+   int              above, below;       /* clamped lines under the taps */
+   int              left, right;        /* clamped pixels under the taps */
+   float            output_value;       /* output value before clipping */
+
+   if ((radius=UnsharpWeights(sigma,weight)) < 0)
+      return (1);
+   if (((vertical=(float*)malloc(nliin*npxin*sizeof(float))) == NULL)      ||
+       ((blur=(float*)malloc(nliin*npxin*sizeof(float))) == NULL))
+      return (1);
+   for (ili=0; ili<nliin; ili++)
+   {
+      for (ipx=0; ipx<npxin; ipx++)
+      {
+         vertical[ili*npxin+ipx] = weight[0] * image_in[ili*npxin+ipx];
+         for (k=1; k<=radius; k++)
+         {
+            above = (ili-k < 0 ? 0 : ili-k);
+            below = (ili+k >= nliin ? nliin-1 : ili+k);
+            vertical[ili*npxin+ipx] = vertical[ili*npxin+ipx] + weight[k] *
+               (image_in[above*npxin+ipx] + image_in[below*npxin+ipx]);
+         }
+      }
+   }
+   for (ili=0; ili<nliin; ili++)
+   {
+      for (ipx=0; ipx<npxin; ipx++)
+      {
+         blur[ili*npxin+ipx] = weight[0] * vertical[ili*npxin+ipx];
+         for (k=1; k<=radius; k++)
+         {
+            left  = (ipx-k < 0 ? 0 : ipx-k);
+            right = (ipx+k >= npxin ? npxin-1 : ipx+k);
+            blur[ili*npxin+ipx] = blur[ili*npxin+ipx] + weight[k] *
+               (vertical[ili*npxin+left] + vertical[ili*npxin+right]);
+         }
+      }
+   }
+   for (ipx=0; ipx<nliin*npxin; ipx++)
+   {
+      output_value = image_in[ipx] +
+                     (float)amount * (image_in[ipx] - blur[ipx]) + 0.5f;
+      if (output_value < 0)
+         output_value = 0;
+      if (output_value > 255)
+         output_value = 255;
+      image_out[ipx] = (unsigned char)output_value;
+   }
+   free (blur);
+   free (vertical);
+   return (0);
+} /* UnsharpReference */
+
+/******************************************************************************/
+/* SaturateReference converts accumulated values into bytes with the two      */
+/* tests the filters used before saturate.c.                                  */
+/******************************************************************************/
+static void SaturateReference (
+   float            *value,             /* accumulated values */
+   unsigned char    *output,            /* output bytes */
+   int              n,                  /* number of values */
+   float            gain,               /* gain of the values */
+   float            offset)             /* offset added after the gain */
+{
+   int              i;                  /* index among values */
+   float            output_value;       /* output value before clipping */
+
+   for (i=0; i<n; i++)
+   {
+      output_value = gain * value[i] + offset;
+      if (output_value < 0)
+         output_value = 0;
+      if (output_value > 255)
+         output_value = 255;
+      output[i] = (unsigned char)output_value;
+   }
+} /* SaturateReference */
+
+/******************************************************************************/
+/* PipelineReference runs the declared stages of a pipeline one after the     */
+/* other on whole planes, each stage writing a plane of its own. Returns 1 if */
+/* memory is lacking.                                                         */
+/******************************************************************************/
+static int PipelineReference (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pipeline    *pipeline,          /* pipeline to be run */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   unsigned char    *plane[MAX_STAGE][3]; /* output planes of the stages */
+   unsigned char    **a_image;          /* first input of a stage */
+   unsigned char    **b_image;          /* second input of a stage */
+   type_stage       *stage;             /* current stage */
+   float            *row;               /* float values of one line */
+   int              istage;             /* index among stages */
+   int              ichannel;           /* index among channels */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              status;             /* status of the allocations */
+
+   status = ((row=(float*)malloc(npxin*sizeof(float))) == NULL);
+   memset (plane,0,sizeof(plane));
+   for (istage=0; istage<pipeline->stage_number-1; istage++)
+   {
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if ((plane[istage][ichannel]=(unsigned char*)malloc(nliin*npxin)) ==
+             NULL)
+            status = 1;
+      }
+   }
+   for (ichannel=0; ichannel<3; ichannel++)
+      plane[pipeline->stage_number-1][ichannel] = image_out[ichannel];
+   for (istage=0; (istage<pipeline->stage_number) && (status == 0); istage++)
+   {
+      stage   = &(pipeline->stage[istage]);
+      a_image = (stage->input[0] == PIPE_INPUT ? image_in :
+                                                 plane[stage->input[0]]);
+      b_image = (stage->input[1] == PIPE_INPUT ? image_in :
+                                                 plane[stage->input[1]]);
+      if (stage->kind == PIPE_CONVOL)
+      {
+         status = ConvolutionApply (pool,stage->convol,CONVOL_DIRECT,3,
+                     a_image,plane[istage],nliin,npxin);
+         continue;
+      }
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         for (ili=0; ili<nliin; ili++)
+         {
+            if (stage->kind == PIPE_LUT)
+            {
+               for (ipx=0; ipx<npxin; ipx++)
+                  plane[istage][ichannel][ili*npxin+ipx] =
+                     stage->table[a_image[ichannel][ili*npxin+ipx]];
+               continue;
+            }
+            for (ipx=0; ipx<npxin; ipx++)
+               row[ipx] = stage->gain[0] * a_image[ichannel][ili*npxin+ipx] +
+                          stage->gain[1] * b_image[ichannel][ili*npxin+ipx];
+            SaturateRow (row,&(plane[istage][ichannel][ili*npxin]),npxin,1.f,
+                         stage->offset);
+         }
+      }
+   }
+   for (istage=0; istage<pipeline->stage_number-1; istage++)
+   {
+      for (ichannel=0; ichannel<3; ichannel++)
+         free (plane[istage][ichannel]);
+   }
+   free (row);
+   return (status);
+} /* PipelineReference */
+
+/******************************************************************************/
+/* Application core                                                           */
+/******************************************************************************/
+int main (
+   int              argc,               /* argument count */
+   char             **argv)             /* argument list */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   unsigned char    *origin_image[3];   /* image array: ORIGIN IMAGE */
+   unsigned char    *serial_image[3];   /* image array: SERIAL OUTPUT */
+   unsigned char    *processed_image[3];/* image array: PARALLEL OUTPUT */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              repetition_number;  /* number of runs per measure */
+   int              ichannel;           /* index among channels */
+   int              ipixel;             /* index among pixels */
+   int              irepetition;        /* index among repetitions */
+   int              size;               /* size of current matrix */
+   int              thread_number;      /* number of threads of the pool */
+   int              max_thread;         /* greatest number of threads */
+   int              mismatch;           /* "some output differs" flag */
+   type_convol      convol;             /* Mean matrix of the current size */
+   float            coeff[MAX_SIZE * MAX_SIZE]; /* coefficients of convol */
+   type_convol      gauss;              /* Gauss matrix of the current size */
+   int              method;             /* index among methods */
+   int              chosen_method;      /* method chosen by the cost model */
+   double           chosen_time;        /* best time of the chosen method */
+   double           fastest_time;       /* best time of the fastest method */
+   int              fastest_method;     /* fastest method measured */
+   int              tile_size;          /* FFT tile chosen by the cost model */
+   int              difference;         /* greatest difference with direct */
+   int              ili;                /* index among lines */
+   int              tolerance;          /* bound of the recursive Gauss */
+   char             *family[6];         /* names of the directional family */
+   type_bank        bank;               /* bank of the directional family */
+   int              ibank;              /* index among matrices of the bank */
+   unsigned char    *response[MAX_BANK][3]; /* responses of the bank */
+   unsigned char    *single[MAX_BANK][3];   /* responses of separate runs */
+   double           bank_time;          /* best time of the bank runs */
+   double           opening_time;       /* best time of the openings */
+   int              ipass;              /* index among 3x3 erosions */
+   double           sigma_space;        /* spatial sigma of the bilateral */
+   double           sigma_range;        /* range sigma of the bilateral */
+   double           mean_difference;    /* mean difference with exact */
+   int              pixel_difference;   /* difference at one pixel */
+   type_starlet     starlet;            /* starlet planes of one channel */
+   int              scale_number;       /* number of starlet detail planes */
+   double           decompose_time;     /* mean time of the decompositions */
+   double           reconstruct_time;   /* mean time of the reconstructions */
+   type_pyramid     pyramid;            /* pyramid of the image */
+   double           laplacian_time;     /* best time of the Laplacian levels */
+   double           collapse_time;      /* best time of the collapses */
+   double           sigma;              /* sigma of the unsharp mask blur */
+   type_image       guarded_in;         /* origin image with guards */
+   type_image       guarded_out;        /* output image with padded lines */
+   int              ishift;             /* identity, unit shift, scaled */
+   double           direct_time;        /* best time on packed lines */
+   type_pipeline    pipeline;           /* pipeline of the current measure */
+   char             pipeline_name[40];  /* name of the pipeline */
+   int              ipipeline;          /* index among pipelines */
+   int              istage;             /* last stage declared */
+   double           arena_time;         /* best time of the planes in arena */
+   size_t           arena_total;        /* bytes of a plane per stage */
+   size_t           arena_peak;         /* bytes of the planes in arena */
+   double           place_time;         /* best time of the in-place run */
+   size_t           tiled_peak;         /* bytes of the rings */
+   float            *accumulator;       /* values of the output stage */
+   int              smooth;             /* 1 = ramp, 0 = random values */
+   type_pool        *serial_pool;       /* pool of one thread */
+   type_pool        *pool;              /* pool of the current measure */
+   double           start;              /* start time of a run */
+   double           serial_time;        /* best time of the serial runs */
+   double           best_time;          /* best time of the parallel runs */
+
+/******************************************************************************/
+/* Get parameters                                                             */
+/******************************************************************************/
+   nliin             = 1024;
+   npxin             = 1024;
+   repetition_number = 5;
+   if ((argc >= 2) && (sscanf(argv[1],"%d",&nliin) != 1))
+      nliin = 1024;
+   if ((argc >= 3) && (sscanf(argv[2],"%d",&npxin) != 1))
+      npxin = 1024;
+   if ((argc >= 4) && (sscanf(argv[3],"%d",&repetition_number) != 1))
+      repetition_number = 5;
+   max_thread = PoolDefaultThreadNumber ();
+/******************************************************************************/
+/* Allocate and fill the image arrays                                         */
+/******************************************************************************/
+   srand (1);
+   for (ichannel=0; ichannel<3; ichannel++)
+   {
+      if (((origin_image[ichannel]=(unsigned char*)malloc(npxin*nliin)) ==
+            NULL)                                                             ||
+          ((serial_image[ichannel]=(unsigned char*)malloc(npxin*nliin)) ==
+            NULL)                                                             ||
+          ((processed_image[ichannel]=(unsigned char*)malloc(npxin*nliin)) ==
+            NULL))
+      {
+         fprintf (stderr,
+            "bench_convol : Cannot allocate memory for image arrays.\n");
+         exit (1);
+      }
+      for (ipixel=0; ipixel<npxin*nliin; ipixel++)
+         origin_image[ichannel][ipixel] = (unsigned char)(rand() & 0xff);
+   }
+/******************************************************************************/
+/* Loop on convolution sizes                                                  */
+/******************************************************************************/
+   printf ("image %d x %d x 3, best of %d runs, up to %d threads\n",
+      nliin,npxin,repetition_number,max_thread);
+   printf ("size threads      ms   Mpixel/s  speedup  output\n");
+   mismatch = 0;
+   for (size=3; size<=MAX_SIZE; size=size+2)
+   {
+      convol.coeff  = coeff;
+      sprintf (convol.name,"Mean %dx%d",size,size);
+      convol.size   = size;
+      convol.gain   = 1. / (float)(size * size);
+      convol.offset = 0.;
+      for (ipixel=0; ipixel<size*size; ipixel++)
+         convol.coeff[ipixel] = 1.;
+      ConvolAnalyze (&convol);
+/*============================================================================*/
+/*    Serial reference                                                        */
+/*============================================================================*/
+      serial_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         Convolution (&convol,3,origin_image,serial_image,nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < serial_time))
+            serial_time = start;
+      }
+      printf ("%4d  serial %7.2f %10.2f %8.2f\n",size,1.e3*serial_time,
+         3.e-6*nliin*npxin/serial_time,1.);
+/*============================================================================*/
+/*    Banded parallel convolution                                             */
+/*============================================================================*/
+      for (thread_number=1; thread_number<=max_thread;
+           thread_number=NextThreadNumber(thread_number,max_thread))
+      {
+         if ((pool=PoolCreate(thread_number)) == NULL)
+         {
+            fprintf (stderr,"bench_convol : Cannot create thread pool.\n");
+            exit (1);
+         }
+         best_time = 0.;
+         for (irepetition=0; irepetition<repetition_number; irepetition++)
+         {
+            for (ichannel=0; ichannel<3; ichannel++)
+               memset (processed_image[ichannel],0,npxin*nliin);
+            start = ElapsedTime ();
+            ConvolutionBands (pool,&convol,3,origin_image,processed_image,
+               nliin,npxin);
+            start = ElapsedTime () - start;
+            if ((irepetition == 0) || (start < best_time))
+               best_time = start;
+         }
+         PoolDestroy (pool);
+         for (ichannel=0; ichannel<3; ichannel++)
+         {
+            if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                       npxin*nliin) != 0)
+               mismatch = 1;
+         }
+         printf ("%4d %7d %7.2f %10.2f %8.2f  %s\n",size,thread_number,
+            1.e3*best_time,3.e-6*nliin*npxin/best_time,serial_time/best_time,
+            (mismatch ? "DIFFERS" : "identical"));
+      }
+   } /* Loop on convolution sizes */
+/******************************************************************************/
+/* Loop on Gauss matrices: compare the methods with the cost model            */
+/******************************************************************************/
+   if ((pool=PoolCreate(max_thread)) == NULL)
+   {
+      fprintf (stderr,"bench_convol : Cannot create thread pool.\n");
+      exit (1);
+   }
+   printf ("\nsize     method       ms  Mpixel/s  cost  max.diff\n");
+   for (size=3; size<=31; size=size+4)
+   {
+      if (ConvolGauss(size,&gauss) != 0)
+      {
+         fprintf (stderr,"bench_convol : Cannot build Gauss matrix.\n");
+         exit (1);
+      }
+      tile_size     = 0;
+      chosen_method = ConvolutionMethod (&gauss,nliin,npxin,&tile_size);
+      ConvolutionApply (pool,&gauss,CONVOL_DIRECT,3,origin_image,serial_image,
+         nliin,npxin);
+      chosen_time    = 0.;
+      fastest_time   = 0.;
+      fastest_method = CONVOL_DIRECT;
+      for (method=CONVOL_DIRECT; method<=CONVOL_FFT; method++)
+      {
+         if (ConvolutionCost(&gauss,method,nliin,npxin,NULL) < 0.)
+            continue;
+         best_time = 0.;
+         for (irepetition=0; irepetition<repetition_number; irepetition++)
+         {
+            start = ElapsedTime ();
+            ConvolutionApply (pool,&gauss,method,3,origin_image,
+               processed_image,nliin,npxin);
+            start = ElapsedTime () - start;
+            if ((irepetition == 0) || (start < best_time))
+               best_time = start;
+         }
+         difference = 0;
+         for (ichannel=0; ichannel<3; ichannel++)
+         {
+            for (ipixel=0; ipixel<npxin*nliin; ipixel++)
+            {
+               if (abs(serial_image[ichannel][ipixel] -
+                       processed_image[ichannel][ipixel]) > difference)
+                  difference = abs(serial_image[ichannel][ipixel] -
+                                   processed_image[ichannel][ipixel]);
+            }
+         }
+         printf ("%4d %10s %8.2f %9.2f %5.1f %9d %s\n",size,
+            CONVOL_METHOD_NAME[method],1.e3*best_time,
+            3.e-6*nliin*npxin/best_time,
+            ConvolutionCost(&gauss,method,nliin,npxin,NULL),difference,
+            (method == chosen_method ? "<= chosen" : ""));
+         if (method == chosen_method)
+            chosen_time = best_time;
+         if ((method == CONVOL_DIRECT) || (best_time < fastest_time))
+         {
+            fastest_time   = best_time;
+            fastest_method = method;
+         }
+      }
+      if (fastest_method != chosen_method)
+         printf ("%4d %10s is %.2f times faster than the chosen %s\n",size,
+            CONVOL_METHOD_NAME[fastest_method],chosen_time/fastest_time,
+            CONVOL_METHOD_NAME[chosen_method]);
+/*============================================================================*/
+/*    Recursive filter of the same sigma                                      */
+/*============================================================================*/
+      best_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         IirGauss (pool,size/3.5,3,origin_image,processed_image,nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      tolerance = IirGaussBound (size/3.5);
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (IirGaussReference(size/3.5,origin_image[ichannel],
+                serial_image[ichannel],nliin,npxin) != 0)
+         {
+            fprintf (stderr,"bench_convol : Cannot compute Gauss reference.\n");
+            exit (1);
+         }
+         for (ipixel=0; ipixel<npxin*nliin; ipixel++)
+         {
+            if (abs(serial_image[ichannel][ipixel] -
+                    processed_image[ichannel][ipixel]) > difference)
+               difference = abs(serial_image[ichannel][ipixel] -
+                                processed_image[ichannel][ipixel]);
+         }
+      }
+      printf ("%4d %10s %8.2f %9.2f %5s %9d <= %d%s\n",size,"recursive",
+         1.e3*best_time,3.e-6*nliin*npxin/best_time,"-",difference,tolerance,
+         (difference > tolerance ? "  WRONG" : ""));
+      if (difference > tolerance)
+         mismatch = 1;
+      free (gauss.coeff);
+   } /* Loop on Gauss matrices */
+/******************************************************************************/
+/* Directional family: separate runs against one FilterBank pass              */
+/******************************************************************************/
+   family[0] = "Gradient 3x3 N-S";
+   family[1] = "Gradient 3x3 W-E";
+   family[2] = "Gradient 3x3 NW-SE";
+   family[3] = "Sobel 3x3 N-S";
+   family[4] = "Sobel 3x3 W-E";
+   family[5] = "Sobel 3x3 NW-SE";
+   bank.convol_number = 0;
+   bank.gradient_x    = -1;
+   bank.gradient_y    = -1;
+   for (ibank=0; ibank<6; ibank++)
+   {
+      if (BankAdd(&bank,ConvolFind(family[ibank])) < 0)
+      {
+         fprintf (stderr,"bench_convol : \"%s\" not found.\n",family[ibank]);
+         exit (1);
+      }
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (((response[ibank][ichannel]=(unsigned char*)malloc(npxin*nliin))
+               == NULL)                                                       ||
+             ((single[ibank][ichannel]=(unsigned char*)malloc(npxin*nliin))
+               == NULL))
+         {
+            fprintf (stderr,
+               "bench_convol : Cannot allocate memory for image arrays.\n");
+            exit (1);
+         }
+      }
+   }
+   best_time = 0.;
+   bank_time = 0.;
+   for (irepetition=0; irepetition<repetition_number; irepetition++)
+   {
+      start = ElapsedTime ();
+      for (ibank=0; ibank<6; ibank++)
+         ConvolutionApply (pool,bank.convol[ibank],CONVOL_DIRECT,3,
+            origin_image,single[ibank],nliin,npxin);
+      start = ElapsedTime () - start;
+      if ((irepetition == 0) || (start < best_time))
+         best_time = start;
+      start = ElapsedTime ();
+      FilterBank (pool,&bank,3,origin_image,response,NULL,NULL,nliin,npxin);
+      start = ElapsedTime () - start;
+      if ((irepetition == 0) || (start < bank_time))
+         bank_time = start;
+   }
+   difference = 0;
+   for (ibank=0; ibank<6; ibank++)
+   {
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(single[ibank][ichannel],response[ibank][ichannel],
+                    npxin*nliin) != 0)
+            difference = 1;
+         free (single[ibank][ichannel]);
+         free (response[ibank][ichannel]);
+      }
+   }
+   printf ("\ndirectional family (6 matrices)      ms  speedup  output\n");
+   printf ("   separate runs               %8.2f %8.2f\n",1.e3*best_time,1.);
+   printf ("   filter bank                 %8.2f %8.2f  %s\n",1.e3*bank_time,
+      best_time/bank_time,(difference ? "DIFFERS" : "identical"));
+   if (difference)
+      mismatch = 1;
+/******************************************************************************/
+/* Median filter: constant cost against the window size                       */
+/******************************************************************************/
+   printf ("\nmedian radius       ms  Mpixel/s  reference ms  output\n");
+   for (size=1; size<=16; size=2*size)
+   {
+      best_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         MedianFilter (pool,size,3,origin_image,processed_image,nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      serial_time = ElapsedTime ();
+      for (ichannel=0; ichannel<3; ichannel++)
+         MedianReference (size,origin_image[ichannel],serial_image[ichannel],
+            nliin,npxin);
+      serial_time = ElapsedTime () - serial_time;
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    npxin*nliin) != 0)
+            difference = 1;
+      }
+      printf ("%13d %8.2f %9.2f %13.2f  %s\n",size,1.e3*best_time,
+         3.e-6*nliin*npxin/best_time,1.e3*serial_time,
+         (difference ? "DIFFERS" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+/******************************************************************************/
+/* Morphology: constant cost against the size of the square                   */
+/******************************************************************************/
+   printf ("\nsquare  erosion ms  opening ms  Mpixel/s  3x3 erosions\n");
+   for (size=3; size<=63; size=2*size+1)
+   {
+      best_time    = 0.;
+      opening_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         Morphology (pool,MORPHO_OPEN,size,size,3,origin_image,serial_image,
+            nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < opening_time))
+            opening_time = start;
+         start = ElapsedTime ();
+         Morphology (pool,MORPHO_ERODE,size,size,3,origin_image,
+            processed_image,nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      Morphology (pool,MORPHO_ERODE,3,3,3,origin_image,serial_image,nliin,
+         npxin);
+      for (ipass=3; ipass<size; ipass=ipass+2)
+         Morphology (pool,MORPHO_ERODE,3,3,3,serial_image,serial_image,nliin,
+            npxin);
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    npxin*nliin) != 0)
+            difference = 1;
+      }
+      printf ("%6d %11.2f %11.2f %9.2f  %s\n",size,1.e3*best_time,
+         1.e3*opening_time,3.e-6*nliin*npxin/best_time,
+         (difference ? "DIFFERS" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+/******************************************************************************/
+/* Bilateral grid against the exact bilateral filter                          */
+/******************************************************************************/
+   printf ("\nsigma space  range  method  grid ms  Mpixel/s  exact ms"
+           "  mean diff  max diff\n");
+   for (sigma_space=1.; sigma_space<=8.; sigma_space=2.*sigma_space)
+   {
+      for (sigma_range=4.; sigma_range<=16.; sigma_range=4.*sigma_range)
+      {
+         best_time = 0.;
+         for (irepetition=0; irepetition<repetition_number; irepetition++)
+         {
+            start = ElapsedTime ();
+            BilateralGrid (pool,sigma_space,sigma_range,3,origin_image,
+               processed_image,nliin,npxin);
+            start = ElapsedTime () - start;
+            if ((irepetition == 0) || (start < best_time))
+               best_time = start;
+         }
+         serial_time = ElapsedTime ();
+         BilateralExact (pool,sigma_space,sigma_range,3,origin_image,
+            serial_image,nliin,npxin);
+         serial_time = ElapsedTime () - serial_time;
+         difference      = 0;
+         mean_difference = 0.;
+         for (ichannel=0; ichannel<3; ichannel++)
+         {
+            for (ipixel=0; ipixel<nliin*npxin; ipixel++)
+            {
+               pixel_difference = abs(serial_image[ichannel][ipixel] -
+                                      processed_image[ichannel][ipixel]);
+               mean_difference  = mean_difference + pixel_difference;
+               if (pixel_difference > difference)
+                  difference = pixel_difference;
+            }
+         }
+         printf ("%11.0f %6.0f  %-6s %8.2f %9.2f %9.2f %10.3f %9d",
+            sigma_space,sigma_range,
+            BilateralUsesGrid(sigma_space,sigma_range,nliin,npxin) ? "grid" :
+            "exact",1.e3*best_time,3.e-6*nliin*npxin/best_time,
+            1.e3*serial_time,mean_difference/(3.*nliin*npxin),difference);
+         if ((!BilateralUsesGrid(sigma_space,sigma_range,nliin,npxin)) &&
+             (difference != 0))
+         {
+            printf ("  DIFFERS");
+            mismatch = 1;
+         }
+         printf ("\n");
+      }
+   }
+/******************************************************************************/
+/* Starlet: cost linear in the number of scales, exact reconstruction         */
+/******************************************************************************/
+   printf ("\nscales  decomposition ms  per scale ms  reconstruction ms"
+           "  image\n");
+   for (scale_number=1; scale_number<=MAX_STARLET_SCALE; scale_number++)
+   {
+      if (StarletAlloc(&starlet,scale_number,nliin,npxin) != 0)
+      {
+         fprintf (stderr,
+            "bench_convol : Cannot allocate memory for starlet planes.\n");
+         exit (1);
+      }
+      decompose_time        = 0.;
+      reconstruct_time = 0.;
+      difference       = 0;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         for (ichannel=0; ichannel<3; ichannel++)
+         {
+            start = ElapsedTime ();
+            StarletDecompose (pool,&starlet,origin_image[ichannel]);
+            decompose_time = decompose_time + ElapsedTime () - start;
+            start = ElapsedTime ();
+            StarletReconstruct (pool,&starlet,processed_image[ichannel]);
+            reconstruct_time = reconstruct_time + ElapsedTime () - start;
+            if (memcmp(origin_image[ichannel],processed_image[ichannel],
+                       npxin*nliin) != 0)
+               difference = 1;
+         }
+      }
+      decompose_time        = decompose_time / repetition_number;
+      reconstruct_time = reconstruct_time / repetition_number;
+      StarletFree (&starlet);
+      printf ("%6d %17.2f %13.2f %18.2f  %s\n",scale_number,1.e3*decompose_time,
+         1.e3*decompose_time/scale_number,1.e3*reconstruct_time,
+         (difference ? "DIFFERS" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+/******************************************************************************/
+/* Pyramids: fused reduce, Laplacian levels, exact collapse                   */
+/******************************************************************************/
+   if (PyramidAlloc(&pyramid,0,3,nliin,npxin) != 0)
+   {
+      fprintf (stderr,"bench_convol : Cannot allocate memory for pyramid.\n");
+      exit (1);
+   }
+   best_time      = 0.;
+   laplacian_time = 0.;
+   collapse_time  = 0.;
+   for (irepetition=0; irepetition<repetition_number; irepetition++)
+   {
+      start = ElapsedTime ();
+      PyramidBuild (pool,&pyramid,origin_image);
+      start = ElapsedTime () - start;
+      if ((irepetition == 0) || (start < best_time))
+         best_time = start;
+      start = ElapsedTime ();
+      PyramidLaplacian (pool,&pyramid);
+      start = ElapsedTime () - start;
+      if ((irepetition == 0) || (start < laplacian_time))
+         laplacian_time = start;
+      start = ElapsedTime ();
+      PyramidCollapse (pool,&pyramid,processed_image);
+      start = ElapsedTime () - start;
+      if ((irepetition == 0) || (start < collapse_time))
+         collapse_time = start;
+   }
+   difference = 0;
+   for (ichannel=0; ichannel<3; ichannel++)
+   {
+      if (memcmp(origin_image[ichannel],processed_image[ichannel],
+                 npxin*nliin) != 0)
+         difference = 1;
+   }
+   printf ("\nlevels  Gaussian ms  Mpixel/s  Laplacian ms  collapse ms"
+           "  image\n");
+   printf ("%6d %12.2f %9.2f %13.2f %12.2f  %s\n",pyramid.level_number,
+      1.e3*best_time,3.e-6*nliin*npxin/best_time,1.e3*laplacian_time,
+      1.e3*collapse_time,(difference ? "DIFFERS" : "identical"));
+   if (difference)
+      mismatch = 1;
+   PyramidFree (&pyramid);
+/******************************************************************************/
+/* Unsharp mask: one fused pass against blur plane + arithmetic pass          */
+/******************************************************************************/
+   printf ("\nsigma  fused ms  Mpixel/s  two passes ms  image\n");
+   for (sigma=1.; sigma<=8.; sigma=2.*sigma)
+   {
+      best_time   = 0.;
+      serial_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         UnsharpMask (pool,sigma,1.5,0.,3,origin_image,processed_image,nliin,
+            npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+         start = ElapsedTime ();
+         for (ichannel=0; ichannel<3; ichannel++)
+            UnsharpReference (sigma,1.5,origin_image[ichannel],
+               serial_image[ichannel],nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < serial_time))
+            serial_time = start;
+      }
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    npxin*nliin) != 0)
+            difference = 1;
+      }
+      printf ("%5.0f %9.2f %9.2f %14.2f  %s\n",sigma,1.e3*best_time,
+         3.e-6*nliin*npxin/best_time,1.e3*serial_time,
+         (difference ? "DIFFERS" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+/******************************************************************************/
+/* Canny: one thread against all the threads (band borders of hysteresis)     */
+/******************************************************************************/
+   printf ("\nsigma  1 thread ms  %d threads ms  Mpixel/s  edge maps\n",
+      max_thread);
+   serial_pool = PoolCreate (1);
+   for (sigma=0.; sigma<=4.; sigma=(sigma == 0. ? 1. : 2.*sigma))
+   {
+      best_time   = 0.;
+      serial_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         Canny (serial_pool,sigma,10.,30.,3,origin_image,serial_image,nliin,
+            npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < serial_time))
+            serial_time = start;
+         start = ElapsedTime ();
+         Canny (pool,sigma,10.,30.,3,origin_image,processed_image,nliin,
+            npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    nliin*CANNY_STRIDE(npxin)) != 0)
+            difference = 1;
+      }
+      printf ("%5.0f %12.2f %14.2f %9.2f  %s\n",sigma,1.e3*serial_time,
+         1.e3*best_time,3.e-6*nliin*npxin/best_time,
+         (difference ? "DIFFER" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+   PoolDestroy (serial_pool);
+/******************************************************************************/
+/* Guarded images: whole padded lines against packed lines                    */
+/******************************************************************************/
+   if ((ImageAllocGuard(&guarded_in,3,nliin,npxin,MAX_SIZE/2) != 0)          ||
+       (ImageAllocGuard(&guarded_out,3,nliin,npxin,0) != 0))
+   {
+      fprintf (stderr,"bench_convol : Cannot allocate guarded images.\n");
+      exit (1);
+   }
+   for (ichannel=0; ichannel<3; ichannel++)
+   {
+      for (ili=0; ili<nliin; ili++)
+         memcpy (&(guarded_in.plane[ichannel][ili*guarded_in.stride]),
+                 &(origin_image[ichannel][ili*npxin]),npxin);
+   }
+   ImageExtend (&guarded_in);
+   printf ("\nsize  packed ms  guarded ms  Mpixel/s  image\n");
+   for (size=3; size<=MAX_SIZE; size=size+2)
+   {
+      convol.coeff  = coeff;
+      sprintf (convol.name,"Mean %dx%d",size,size);
+      convol.size   = size;
+      convol.gain   = 1. / (float)(size * size);
+      convol.offset = 0.;
+      for (ipixel=0; ipixel<size*size; ipixel++)
+         convol.coeff[ipixel] = 1.;
+      ConvolAnalyze (&convol);
+      direct_time = 0.;
+      best_time   = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         ConvolutionApply (pool,&convol,CONVOL_DIRECT,3,origin_image,
+            processed_image,nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < direct_time))
+            direct_time = start;
+         start = ElapsedTime ();
+         ConvolutionImage (pool,&convol,&guarded_in,&guarded_out);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         for (ili=0; ili<nliin; ili++)
+         {
+            if (memcmp(&(processed_image[ichannel][ili*npxin]),
+                       &(guarded_out.plane[ichannel][ili*guarded_out.stride]),
+                       npxin) != 0)
+               difference = 1;
+         }
+      }
+      printf ("%4d %10.2f %11.2f %9.2f  %s\n",size,1.e3*direct_time,
+         1.e3*best_time,3.e-6*nliin*npxin/best_time,
+         (difference ? "DIFFER" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+   for (ishift=0; ishift<3; ishift++)
+   {
+      sprintf (convol.name,"%s 3x3",
+         (ishift == 0 ? "Identity" : (ishift == 1 ? "Shift" : "Shift x2")));
+      convol.size   = 3;
+      convol.gain   = (ishift == 2 ? 2. : 1.);
+      convol.offset = 0.;
+      for (ipixel=0; ipixel<9; ipixel++)
+         convol.coeff[ipixel] = 0.;
+      convol.coeff[ishift == 0 ? 4 : 2] = 1.;
+      ConvolAnalyze (&convol);
+      ConvolutionApply (pool,&convol,CONVOL_DIRECT,3,origin_image,
+         processed_image,nliin,npxin);
+      ConvolutionImage (pool,&convol,&guarded_in,&guarded_out);
+      difference = 0;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         for (ili=0; ili<nliin; ili++)
+         {
+            if (memcmp(&(processed_image[ichannel][ili*npxin]),
+                       &(guarded_out.plane[ichannel][ili*guarded_out.stride]),
+                       npxin) != 0)
+               difference = 1;
+         }
+      }
+      printf ("%-12s %s\n",convol.name,(difference ? "DIFFER" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+   ImageFree (&guarded_out);
+   ImageFree (&guarded_in);
+/******************************************************************************/
+/* Pipelines: tiles in cache against whole planes stage by stage              */
+/******************************************************************************/
+   if (ConvolGauss(5,&gauss) != 0)
+   {
+      fprintf (stderr,"bench_convol : Cannot build the Gauss matrix.\n");
+      exit (1);
+   }
+   printf ("\n                            stages");
+   printf (" ----------- time ms -----------");
+   printf (" ------------ memory KiB ------------\n");
+   printf ("pipeline                    all run  planes   arena   tiled");
+   printf (" inplace   planes    arena    tiled  inplace  outputs\n");
+   for (ipipeline=0; ipipeline<3; ipipeline++)
+   {
+      PipelineInit (&pipeline);
+      switch (ipipeline)
+      {
+         case 0:
+            strcpy (pipeline_name,"stretch gauss threshold");
+            istage = PipelineLinear (&pipeline,PIPE_INPUT,1.5f,-40.f);
+            istage = PipelineConvol (&pipeline,istage,&gauss);
+            istage = PipelineThreshold (&pipeline,istage,128);
+            break;
+         case 1:
+            strcpy (pipeline_name,"gauss boost stretch");
+            istage = PipelineConvol (&pipeline,PIPE_INPUT,&gauss);
+            istage = PipelineCombine (&pipeline,PIPE_INPUT,istage,2.f,-1.f,
+                                      0.5f);
+            istage = PipelineLinear (&pipeline,istage,1.2f,-20.f);
+            break;
+         default:
+            strcpy (pipeline_name,"stretch gauss x3 threshold");
+            istage = PipelineLinear (&pipeline,PIPE_INPUT,1.5f,-40.f);
+            istage = PipelineConvol (&pipeline,istage,&gauss);
+            istage = PipelineConvol (&pipeline,istage,&gauss);
+            istage = PipelineConvol (&pipeline,istage,&gauss);
+            istage = PipelineThreshold (&pipeline,istage,128);
+            break;
+      }
+      if ((istage == PIPE_ERROR) || (PipelinePlan(&pipeline,nliin,npxin) != 0))
+      {
+         fprintf (stderr,"bench_convol : Cannot build pipeline %s.\n",
+            pipeline_name);
+         exit (1);
+      }
+      best_time   = 0.;
+      serial_time = 0.;
+      arena_time  = 0.;
+      difference  = 0;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         PipelineReference (pool,&pipeline,origin_image,serial_image,nliin,
+            npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < serial_time))
+            serial_time = start;
+         start = ElapsedTime ();
+         PipelineApplyPlanes (pool,&pipeline,3,origin_image,processed_image,
+            nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < arena_time))
+            arena_time = start;
+      }
+      arena_total = pipeline.arena.total;
+      arena_peak  = pipeline.arena.peak;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    nliin*npxin) != 0)
+            difference = 1;
+      }
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         PipelineApply (pool,&pipeline,3,origin_image,processed_image,nliin,
+            npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    nliin*npxin) != 0)
+            difference = 1;
+      }
+      tiled_peak = pipeline.arena.peak;
+      place_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         for (ichannel=0; ichannel<3; ichannel++)
+            memcpy (processed_image[ichannel],origin_image[ichannel],
+               nliin*npxin);
+         start = ElapsedTime ();
+         PipelineApply (pool,&pipeline,3,processed_image,processed_image,
+            nliin,npxin);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < place_time))
+            place_time = start;
+      }
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (memcmp(serial_image[ichannel],processed_image[ichannel],
+                    nliin*npxin) != 0)
+            difference = 1;
+      }
+      printf ("%-27s %3d %3d %7.2f %7.2f %7.2f %7.2f %8ld %8ld %8ld %8ld  %s\n",
+         pipeline_name,pipeline.stage_number,pipeline.kernel_number,
+         1.e3*serial_time,1.e3*arena_time,1.e3*best_time,1.e3*place_time,
+         (long)(arena_total/1024),(long)(arena_peak/1024),
+         (long)(tiled_peak/1024),(long)(pipeline.arena.peak/1024),
+         (difference ? "DIFFER" : "identical"));
+      if (difference)
+         mismatch = 1;
+      PipelineRelease (&pipeline);
+   }
+   free (gauss.coeff);
+/******************************************************************************/
+/* Output stage: "if" clipping against the branchless saturate.c              */
+/******************************************************************************/
+   if ((accumulator=(float*)malloc(nliin*npxin*sizeof(float))) == NULL)
+   {
+      fprintf (stderr,"bench_convol : Cannot allocate memory for values.\n");
+      exit (1);
+   }
+   printf ("\nvalues  if ms  branchless ms  Mpixel/s  bytes\n");
+   for (smooth=0; smooth<=1; smooth++)
+   {
+      for (ipixel=0; ipixel<nliin*npxin; ipixel++)
+         accumulator[ipixel] = (smooth ? -100.f + 455.f * ipixel /
+                                         (nliin*npxin) :
+                                -100.f + 455.f * rand() / RAND_MAX);
+      best_time   = 0.;
+      serial_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         SaturateReference (accumulator,serial_image[0],nliin*npxin,1.f,
+            0.5f);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < serial_time))
+            serial_time = start;
+         start = ElapsedTime ();
+         SaturateRow (accumulator,processed_image[0],nliin*npxin,1.f,0.5f);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+      }
+      difference = (memcmp(serial_image[0],processed_image[0],
+                           nliin*npxin) != 0);
+      printf ("%-6s %6.2f %14.2f %9.0f  %s\n",(smooth ? "smooth" : "noisy"),
+         1.e3*serial_time,1.e3*best_time,1.e-6*nliin*npxin/best_time,
+         (difference ? "DIFFER" : "identical"));
+      if (difference)
+         mismatch = 1;
+   }
+   free (accumulator);
+   PoolDestroy (pool);
+   exit (mismatch);
+}
@@ -0,0 +1,394 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* bench_ops measures the speed of every operator of the library on the       */
+/* images of the TD and on synthetic images up to 16384 x 16384.              */
+/******************************************************************************/
+/* SYNOPSIS                                                                   */
+/* bench_ops [ -json <file> ] [ <max_size> [ <repetition_number> ] ]          */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* The operators are the histogram (histogram.c), a look-up table, the        */
+/* stretch of [min,max] to [0,255] and a threshold (one-stage pipelines,      */
+/* pipeline.c), the Gauss 3x3 and 5x5 convolutions (ConvolutionApply, method  */
+/* chosen by the cost model) and the conversion into a 32 bit frame buffer of */
+/* the display (DisplayFrameBuffer, without X server). Each runs on all the   */
+/* threads of the pool.                                                       */
+/*                                                                            */
+/* Images are girl, roissy, san-remo (512 x 512 RGB), phytoplancton           */
+/* (800 x 800 RGB) and new-york (1024 x 1024 gray), read from the TD          */
+/* directories under $ITI_IMAGES (default ../.., the root of the TD from      */
+/* here); missing ones are skipped. Then random gray images of 1024 x 1024,   */
+/* 2048 x 2048 ... up to <max_size> (default 4096, at most 16384).            */
+/*                                                                            */
+/* Each measure is run WARMUP_NUMBER times untimed (page faults, plans of     */
+/* the pipelines, caches), then <repetition_number> times (default 5). The    */
+/* best time gives the nanoseconds per pixel, the megapixels per second and   */
+/* the gigabytes per second read and written (a pixel counts all its          */
+/* channels). With -json, the results are also written to <file>, one record  */
+/* per (image,operator), to be compared from a version to the next.           */
+/* The kernels run at the CPU level of the processor, or the one set by       */
+/* ITI_CPU (scalar, sse4.2, avx2, avx512) to compare the levels (cpu.h).      */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+/******************************************************************************/
+/* Local inclusion files                                                      */
+/******************************************************************************/
+#include  "image.h"
+#include  "display.h"
+#include  "convol.h"
+#include  "histogram.h"
+#include  "pipeline.h"
+#include  "cpu.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define WARMUP_NUMBER   1               /* untimed runs before a measure */
+#define MIN_SYNTHETIC   1024            /* smallest synthetic image */
+#define MAX_SYNTHETIC   16384           /* greatest synthetic image */
+#define BUNDLED_NUMBER  5               /* number of images of the TD */
+#define OPERATOR_NUMBER 7               /* number of operators measured */
+#define FRAME_BYTES     4               /* bytes per pixel in frame buffer */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   char             *name;              /* name of the image */
+   char             *file[3];           /* files, from the root of the TD */
+   int              channel_number;     /* number of channels (1 or 3) */
+   int              nliin;              /* line number */
+   int              npxin;              /* pixel number */
+} type_bundled;
+
+typedef struct {
+   type_pool        *pool;              /* threads of the operators */
+   type_image       *image;             /* input image */
+   type_image       output;             /* output image, same size */
+   unsigned char    *frame_buffer;      /* FRAME_BYTES per pixel */
+   long             histogram[3][256];  /* histogram of the image */
+   type_pipeline    pipeline[3];        /* table, stretch, threshold */
+   type_convol      gauss[2];           /* Gauss 3x3 and 5x5 */
+} type_bench;
+
+/******************************************************************************/
+/* Images of the TD and operators                                             */
+/******************************************************************************/
+static type_bundled BUNDLED[BUNDLED_NUMBER] = {
+   {"girl",          {"TD1/girl.1","TD1/girl.2","TD1/girl.3"},       3,512,512},
+   {"roissy",        {"TD3/roissy.1","TD3/roissy.2","TD3/roissy.3"}, 3,512,512},
+   {"san-remo",      {"TD2 iti -final version/san-remo.1",
+                      "TD2 iti -final version/san-remo.2",
+                      "TD2 iti -final version/san-remo.3"},          3,512,512},
+   {"phytoplancton", {"TD3/phytoplancton.r","TD3/phytoplancton.g",
+                      "TD3/phytoplancton.b"},                        3,800,800},
+   {"new-york",      {"TD1/new-york",NULL,NULL},                  1,1024,1024}};
+
+static char *OPERATOR_NAME[OPERATOR_NUMBER] = {
+   "histogram","lut","stretch","threshold","gauss 3x3","gauss 5x5",
+   "framebuffer"};
+
+/******************************************************************************/
+/* ElapsedTime returns the time in seconds of a monotonic clock.              */
+/******************************************************************************/
+static double ElapsedTime (void)
+{
+   struct timespec  now;                /* current time */
+
+   clock_gettime (CLOCK_MONOTONIC,&now);
+   return (now.tv_sec + 1.e-9 * now.tv_nsec);
+} /* ElapsedTime */
+
+/******************************************************************************/
+/* BenchRun runs operator ioperator once on the image of the bench. Returns 1 */
+/* if the operator fails.                                                     */
+/******************************************************************************/
+static int BenchRun (
+   type_bench       *bench,             /* image, buffers and operators */
+   int              ioperator)          /* index in OPERATOR_NAME[] */
+{
+   type_image       *image;             /* input image */
+
+   image = bench->image;
+   switch (ioperator)
+   {
+      case 0:
+         return (Histogram(bench->pool,image->channel_number,image->plane,
+                           image->nliin,image->npxin,bench->histogram));
+      case 1:
+      case 2:
+      case 3:
+         return (PipelineApply(bench->pool,&(bench->pipeline[ioperator-1]),
+                               image->channel_number,image->plane,
+                               bench->output.plane,image->nliin,
+                               image->npxin));
+      case 4:
+      case 5:
+         return (ConvolutionApply(bench->pool,&(bench->gauss[ioperator-4]),
+                                  CONVOL_AUTO,image->channel_number,
+                                  image->plane,bench->output.plane,
+                                  image->nliin,image->npxin));
+      default:
+         return (DisplayFrameBuffer(image,FRAME_BYTES,0xff0000,0x00ff00,
+                                    0x0000ff,bench->frame_buffer));
+   }
+} /* BenchRun */
+
+/******************************************************************************/
+/* BenchImage measures every operator on an image, prints one line per        */
+/* operator and appends the records to json (if not NULL). Returns 1 if       */
+/* memory is lacking or an operator fails.                                    */
+/******************************************************************************/
+static int BenchImage (
+   type_pool        *pool,              /* threads of the operators */
+   char             *name,              /* name of the image */
+   type_image       *image,             /* image to be measured */
+   int              repetition_number,  /* number of timed runs */
+   FILE             *json,              /* JSON results, or NULL */
+   int              *record_number)     /* records already written */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   type_bench       bench;              /* image, buffers and operators */
+   unsigned char    table[256];         /* table of the look-up table */
+   int              ioperator;          /* index among operators */
+   int              irepetition;        /* index among runs */
+   int              low;                /* smallest level of the image */
+   int              high;               /* greatest level of the image */
+   int              i;                  /* index among levels */
+   int              status;             /* status of the runs */
+   double           pixel_number;       /* pixels of the image */
+   double           bytes;              /* bytes read and written by a run */
+   double           start;              /* start time of a run */
+   double           best_time;          /* best time of the runs */
+   double           total_time;         /* time of all the timed runs */
+
+/*----------------------------------------------------------------------------*/
+/* Output image, frame buffer and operators                                   */
+/*----------------------------------------------------------------------------*/
+   bench.pool  = pool;
+   bench.image = image;
+   pixel_number = (double)image->nliin * image->npxin;
+   if ((ImageAlloc(&(bench.output),image->channel_number,image->nliin,
+                   image->npxin) != 0)                                        ||
+       ((bench.frame_buffer=(unsigned char*)malloc((size_t)image->nliin*
+          image->npxin*FRAME_BYTES)) == NULL)                                 ||
+       (Histogram(pool,image->channel_number,image->plane,image->nliin,
+                  image->npxin,bench.histogram) != 0))
+   {
+      fprintf (stderr,"bench_ops : Cannot allocate memory for %s.\n",name);
+      return (1);
+   }
+   for (low=0; (low < 255) && (bench.histogram[0][low] == 0); low++)
+      ;
+   for (high=255; (high > low) && (bench.histogram[0][high] == 0); high--)
+      ;
+   if (high == low)
+      high = low + 1;
+   for (i=0; i<256; i++)
+      table[i] = (unsigned char)(rand() & 0xff);
+   for (i=0; i<3; i++)
+      PipelineInit (&(bench.pipeline[i]));
+   PipelineLut (&(bench.pipeline[0]),PIPE_INPUT,table);
+   PipelineLinear (&(bench.pipeline[1]),PIPE_INPUT,255.f/(high-low),
+                   -255.f*low/(high-low));
+   PipelineThreshold (&(bench.pipeline[2]),PIPE_INPUT,128);
+   ConvolGauss (3,&(bench.gauss[0]));
+   ConvolGauss (5,&(bench.gauss[1]));
+/*----------------------------------------------------------------------------*/
+/* Warm-up runs, then best and mean of the timed runs                         */
+/*----------------------------------------------------------------------------*/
+   status = 0;
+   for (ioperator=0; (ioperator<OPERATOR_NUMBER) && (status == 0);
+        ioperator++)
+   {
+      for (irepetition=0; irepetition<WARMUP_NUMBER; irepetition++)
+         status = status | BenchRun (&bench,ioperator);
+      best_time  = 0.;
+      total_time = 0.;
+      for (irepetition=0; irepetition<repetition_number; irepetition++)
+      {
+         start = ElapsedTime ();
+         status = status | BenchRun (&bench,ioperator);
+         start = ElapsedTime () - start;
+         if ((irepetition == 0) || (start < best_time))
+            best_time = start;
+         total_time = total_time + start;
+      }
+      bytes = pixel_number * image->channel_number;
+      if (ioperator == OPERATOR_NUMBER - 1)
+         bytes = bytes + pixel_number * FRAME_BYTES;
+      else if (ioperator > 0)
+         bytes = 2 * bytes;
+      printf ("%-14s %5d x %-5d %d  %-12s %9.3f %10.1f %8.2f\n",name,
+         image->nliin,image->npxin,image->channel_number,
+         OPERATOR_NAME[ioperator],1.e9*best_time/pixel_number,
+         1.e-6*pixel_number/best_time,1.e-9*bytes/best_time);
+      if (json != NULL)
+      {
+         fprintf (json,"%s    {\"image\": \"%s\", \"lines\": %d, ",
+            (*record_number > 0 ? ",\n" : ""),name,image->nliin);
+         fprintf (json,"\"pixels\": %d, \"channels\": %d, ",image->npxin,
+            image->channel_number);
+         fprintf (json,"\"operator\": \"%s\", \"best_ms\": %.4f, ",
+            OPERATOR_NAME[ioperator],1.e3*best_time);
+         fprintf (json,"\"mean_ms\": %.4f, \"ns_per_pixel\": %.4f, ",
+            1.e3*total_time/repetition_number,1.e9*best_time/pixel_number);
+         fprintf (json,"\"mpixel_per_s\": %.2f, \"gbyte_per_s\": %.3f}",
+            1.e-6*pixel_number/best_time,1.e-9*bytes/best_time);
+         *record_number = *record_number + 1;
+      }
+   }
+   if (status != 0)
+      fprintf (stderr,"bench_ops : %s failed on %s.\n",
+         OPERATOR_NAME[ioperator-1],name);
+/*----------------------------------------------------------------------------*/
+/* Release                                                                    */
+/*----------------------------------------------------------------------------*/
+   for (i=0; i<3; i++)
+      PipelineRelease (&(bench.pipeline[i]));
+   free (bench.gauss[0].coeff);
+   free (bench.gauss[1].coeff);
+   free (bench.frame_buffer);
+   ImageFree (&(bench.output));
+   return (status);
+} /* BenchImage */
+
+/******************************************************************************/
+/* Application core                                                           */
+/******************************************************************************/
+int main (
+   int              argc,               /* argument count */
+   char             **argv)             /* argument list */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   type_image       image;              /* image being measured */
+   type_pool        *pool;              /* threads of the operators */
+   FILE             *json;              /* JSON results, or NULL */
+   char             *json_file;         /* name of the JSON file */
+   char             *root;              /* root of the TD directories */
+   char             path[3][IMAGE_NAME_LENGTH+256]; /* files of an image */
+   char             *file_name[3];      /* pointers to path[] */
+   char             name[40];           /* name of a synthetic image */
+   int              max_size;           /* greatest synthetic image */
+   int              repetition_number;  /* number of timed runs */
+   int              record_number;      /* JSON records written */
+   int              ibundled;           /* index among images of the TD */
+   int              ichannel;           /* index among channels */
+   int              size;               /* size of a synthetic image */
+   size_t           ipixel;             /* index among pixels */
+   int              status;             /* 1 if a measure failed */
+
+/******************************************************************************/
+/* Get parameters                                                             */
+/******************************************************************************/
+   json_file = NULL;
+   if ((argc >= 3) && (strcmp(argv[1],"-json") == 0))
+   {
+      json_file = argv[2];
+      argv[2]   = argv[0];
+      argv      = argv + 2;
+      argc      = argc - 2;
+   }
+   max_size          = 4096;
+   repetition_number = 5;
+   if ((argc >= 2) && (sscanf(argv[1],"%d",&max_size) != 1))
+      max_size = 4096;
+   if (max_size > MAX_SYNTHETIC)
+      max_size = MAX_SYNTHETIC;
+   if ((argc >= 3) && ((sscanf(argv[2],"%d",&repetition_number) != 1)       ||
+                       (repetition_number < 1)))
+      repetition_number = 5;
+   if ((root=getenv("ITI_IMAGES")) == NULL)
+      root = "../..";
+   json = NULL;
+   if ((json_file != NULL) && ((json=fopen(json_file,"w")) == NULL))
+   {
+      fprintf (stderr,"bench_ops : Cannot create \"%s\".\n",json_file);
+      exit (1);
+   }
+   if ((pool=PoolCreate(0)) == NULL)
+   {
+      fprintf (stderr,"bench_ops : Cannot create thread pool.\n");
+      exit (1);
+   }
+   if (json != NULL)
+   {
+      fprintf (json,"{\n  \"program\": \"bench_ops\",\n");
+      fprintf (json,"  \"cpu\": \"%s\",\n",CPU_LEVEL_NAME[CpuLevel()]);
+      fprintf (json,"  \"threads\": %d,\n  \"warmup\": %d,\n",
+         PoolThreadNumber(pool),WARMUP_NUMBER);
+      fprintf (json,"  \"repetitions\": %d,\n  \"results\": [\n",
+         repetition_number);
+   }
+   printf ("cpu level %s, %d threads, %d warm-up + %d timed runs, best time\n",
+      CPU_LEVEL_NAME[CpuLevel()],PoolThreadNumber(pool),WARMUP_NUMBER,
+      repetition_number);
+   printf ("image           lines x pixels c  operator      ns/pixel   ");
+   printf ("Mpixel/s   Gbyte/s\n");
+   srand (1);
+   status        = 0;
+   record_number = 0;
+/******************************************************************************/
+/* Images of the TD                                                           */
+/******************************************************************************/
+   for (ibundled=0; ibundled<BUNDLED_NUMBER; ibundled++)
+   {
+      if (ImageAlloc(&image,BUNDLED[ibundled].channel_number,
+                     BUNDLED[ibundled].nliin,BUNDLED[ibundled].npxin) != 0)
+      {
+         fprintf (stderr,"bench_ops : Cannot allocate memory for %s.\n",
+            BUNDLED[ibundled].name);
+         exit (1);
+      }
+      for (ichannel=0; ichannel<image.channel_number; ichannel++)
+      {
+         sprintf (path[ichannel],"%s/%s",root,
+            BUNDLED[ibundled].file[ichannel]);
+         file_name[ichannel] = path[ichannel];
+      }
+      if (ImageRead(&image,file_name) != 0)
+         printf ("%-14s skipped\n",BUNDLED[ibundled].name);
+      else
+         status = status | BenchImage (pool,BUNDLED[ibundled].name,&image,
+                                       repetition_number,json,
+                                       &record_number);
+      ImageFree (&image);
+   }
+/******************************************************************************/
+/* Synthetic gray images of random pixels                                     */
+/******************************************************************************/
+   for (size=MIN_SYNTHETIC; size<=max_size; size=2*size)
+   {
+      if (ImageAlloc(&image,1,size,size) != 0)
+      {
+         fprintf (stderr,"bench_ops : Cannot allocate a %d x %d image.\n",
+            size,size);
+         exit (1);
+      }
+      for (ipixel=0; ipixel<(size_t)size*size; ipixel++)
+         image.plane[0][ipixel] = (unsigned char)(rand() & 0xff);
+      sprintf (name,"random");
+      status = status | BenchImage (pool,name,&image,repetition_number,json,
+                                    &record_number);
+      ImageFree (&image);
+   }
+   if (json != NULL)
+   {
+      fprintf (json,"\n  ]\n}\n");
+      fclose (json);
+   }
+   PoolDestroy (pool);
+   exit (status);
+} /* Application core */
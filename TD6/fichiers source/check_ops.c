@@ -0,0 +1,1089 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* check_ops compares every optimized operator of the library to a plain      */
+/* scalar reference on the images of the TD, and the references to the        */
+/* checksums of a golden file.                                                */
+/******************************************************************************/
+/* SYNOPSIS                                                                   */
+/* check_ops [ -record <golden_file> | -golden <golden_file> ]                */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* For each image, every operator is first computed by a reference written    */
+/* here, pixel by pixel and without any of the tricks of the library, then by */
+/* each of its optimized variants, and the outputs are compared:              */
+/*    histogram            Histogram() on the pool and serially;              */
+/*    lut, threshold,      one-stage pipelines, run tile by tile on the pool  */
+/*    stretch, matching,   and serially, stage by stage on planes, and in     */
+/*    linear+lut           place; stretch is compared to the formula of TD4,  */
+/*                         matching maps the histogram of each channel onto a */
+/*                         triangular one, linear+lut checks the fusion of    */
+/*                         two tables;                                        */
+/*    every CONVOL[]       Convolution(), ConvolutionApply() with the direct, */
+/*    matrix               separable (when the matrix is), FFT and automatic  */
+/*                         methods, a one-stage pipeline, and                 */
+/*                         ConvolutionImage() on an image with guards (all    */
+/*                         the pixels, borders included);                     */
+/*    framebuffer 32 / 16  DisplayFrameBuffer() for 8-8-8 and 5-6-5 visuals;  */
+/*    IirGauss NxN         (random images only) IirGauss() with sigma = N/3.5 */
+/*                         against IirGaussReference(), the sampled Gaussian  */
+/*                         over 6 sigma, N from 3 to IIR_CHECK_SIZE, all the  */
+/*                         pixels.                                            */
+/* A variant passes if no byte differs from the reference by more than the    */
+/* tolerance declared for it: 0 (bit exact), except 1 gray level for the FFT  */
+/* method, for the stretch (gain and offset folded into one product) and for  */
+/* matrices with non integer coefficients, whose folded sums are rounded in   */
+/* another order, and IirGaussBound() (iir.h) for the recursive Gauss filter. */
+/* Each line gives the greatest difference and the number of bytes that       */
+/* differ.                                                                    */
+/*                                                                            */
+/* The matrices of the description file (ITI_CONVOL, default convol.txt) are  */
+/* appended to CONVOL[] as skelet does. Images are those of bench_ops, under  */
+/* $ITI_IMAGES (default ../..), missing ones being skipped, and two random    */
+/* images (RGB and gray) of RANDOM_NLIIN x RANDOM_NPXIN pixels, odd sizes     */
+/* that leave uneven bands and vector tails. The pool has CHECK_THREADS       */
+/* threads whatever the number of processors, so that images are cut into     */
+/* several bands.                                                             */
+/*                                                                            */
+/* The kernels of the library have a variant per CPU level (cpu.h): all the   */
+/* images are checked at each level, from scalar up to the one of the         */
+/* processor (capped by ITI_CPU), with the same tolerances. The golden file   */
+/* is recorded at the first level only.                                       */
+/*                                                                            */
+/* With -record, the 64 bit FNV-1a checksum of every reference output is      */
+/* written to <golden_file>, one "image<tab>operator<tab>checksum" line per   */
+/* output. With -golden, the reference outputs are checked against such a     */
+/* file, so that a change of the references themselves, or of the images, is  */
+/* seen too. The frame buffer checksums depend on the byte order of the host. */
+/* check_ops.golden, next to this file, was recorded on a little-endian       */
+/* host with the images and convol.txt of the TD.                             */
+/*                                                                            */
+/* No display is opened. The exit status is 1 if a variant exceeds its        */
+/* tolerance, fails, or if a checksum differs from the golden file.           */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+/******************************************************************************/
+/* Local inclusion files                                                      */
+/******************************************************************************/
+#include  "image.h"
+#include  "display.h"
+#include  "convol.h"
+#include  "registry.h"
+#include  "histogram.h"
+#include  "pipeline.h"
+#include  "iir.h"
+#include  "cpu.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define CHECK_THREADS   4               /* threads of the pool */
+#define BUNDLED_NUMBER  5               /* number of images of the TD */
+#define RANDOM_NLIIN    67              /* lines of the random images */
+#define RANDOM_NPXIN    131             /* pixels of the random images */
+#define RANDOM_SEED     12345           /* seed of images and tables */
+#define IIR_CHECK_SIZE  31              /* largest N of IirGauss, sigma N/3.5 */
+#define MAX_GOLDEN      4096            /* greatest number of golden records */
+#define KEY_LENGTH      160             /* longest "image<tab>operator" */
+#define FNV_OFFSET      0xcbf29ce484222325ULL /* FNV-1a 64 bit basis */
+#define FNV_PRIME       0x100000001b3ULL /* FNV-1a 64 bit prime */
+
+#define VARIANT_TILED   0               /* PipelineApply() on the pool */
+#define VARIANT_SERIAL  1               /* PipelineApply() without pool */
+#define VARIANT_PLANES  2               /* PipelineApplyPlanes() */
+#define VARIANT_IN_PLACE 3              /* PipelineApply(), in = out */
+#define VARIANT_NUMBER  4               /* number of pipeline variants */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   char             *name;              /* name of the image */
+   char             *file[3];           /* files, from the root of the TD */
+   int              channel_number;     /* number of channels (1 or 3) */
+   int              nliin;              /* line number */
+   int              npxin;              /* pixel number */
+} type_bundled;
+
+typedef struct {
+   char             key[KEY_LENGTH];    /* "image<tab>operator" */
+   unsigned long long checksum;         /* checksum of the reference */
+} type_golden;
+
+typedef struct {
+   type_pool        *pool;              /* CHECK_THREADS threads */
+   char             *name;              /* name of the image */
+   type_image       *image;             /* input image */
+   type_image       reference;          /* output of the reference */
+   type_image       output;             /* output of a variant */
+   FILE             *record;            /* golden file written, or NULL */
+   type_golden      *golden;            /* golden records read, or NULL */
+   int              golden_number;      /* number of golden records read */
+   int              comparison_number;  /* variants compared */
+   int              failure_number;     /* variants beyond tolerance */
+   int              golden_difference;  /* checksums differing from golden */
+   int              golden_missing;     /* checksums absent from golden */
+} type_check;
+
+/******************************************************************************/
+/* Images of the TD and names of the pipeline variants                        */
+/******************************************************************************/
+static type_bundled BUNDLED[BUNDLED_NUMBER] = {
+   {"girl",          {"TD1/girl.1","TD1/girl.2","TD1/girl.3"},       3,512,512},
+   {"roissy",        {"TD3/roissy.1","TD3/roissy.2","TD3/roissy.3"}, 3,512,512},
+   {"san-remo",      {"TD2 iti -final version/san-remo.1",
+                      "TD2 iti -final version/san-remo.2",
+                      "TD2 iti -final version/san-remo.3"},          3,512,512},
+   {"phytoplancton", {"TD3/phytoplancton.r","TD3/phytoplancton.g",
+                      "TD3/phytoplancton.b"},                        3,800,800},
+   {"new-york",      {"TD1/new-york",NULL,NULL},                  1,1024,1024}};
+
+static char *VARIANT_NAME[VARIANT_NUMBER] = {
+   "tiled","serial","planes","in place"};
+
+/******************************************************************************/
+/* CheckRandom returns a pseudo-random byte, the same on every host.          */
+/******************************************************************************/
+static int CheckRandom (
+   unsigned int     *seed)              /* state of the generator */
+{
+   *seed = *seed * 1103515245u + 12345u;
+   return ((*seed >> 16) & 0xff);
+} /* CheckRandom */
+
+/******************************************************************************/
+/* Checksum continues the FNV-1a checksum hash with n bytes.                  */
+/******************************************************************************/
+static unsigned long long Checksum (
+   unsigned long long hash,             /* checksum of the previous bytes */
+   unsigned char    *data,              /* bytes to be added */
+   size_t           n)                  /* number of bytes */
+{
+   size_t           i;                  /* index among bytes */
+
+   for (i=0; i<n; i++)
+      hash = (hash ^ data[i]) * FNV_PRIME;
+   return (hash);
+} /* Checksum */
+
+/******************************************************************************/
+/* ImageChecksum returns the checksum of the pixels of an image, line by      */
+/* line, whatever its stride.                                                 */
+/******************************************************************************/
+static unsigned long long ImageChecksum (
+   type_image       *image)             /* image to be summed */
+{
+   unsigned long long hash;             /* checksum */
+   int              ichannel;           /* index among channels */
+   int              ili;                /* index among lines */
+
+   hash = FNV_OFFSET;
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      for (ili=0; ili<image->nliin; ili++)
+         hash = Checksum (hash,&(image->plane[ichannel][ili*image->stride]),
+                          image->npxin);
+   }
+   return (hash);
+} /* ImageChecksum */
+
+/******************************************************************************/
+/* CheckGolden writes the checksum of a reference output in the golden file   */
+/* (-record) or compares it to the one read from it (-golden).                */
+/******************************************************************************/
+static void CheckGolden (
+   type_check       *check,             /* image and golden records */
+   char             *operator,          /* name of the operator */
+   unsigned long long checksum)         /* checksum of the reference output */
+{
+   char             key[KEY_LENGTH];    /* "image<tab>operator" */
+   int              igolden;            /* index among golden records */
+
+   snprintf (key,KEY_LENGTH,"%s\t%s",check->name,operator);
+   if (check->record != NULL)
+      fprintf (check->record,"%s\t%016llx\n",key,checksum);
+   if (check->golden == NULL)
+      return;
+   for (igolden=0; (igolden<check->golden_number)                             &&
+                   (strcmp(check->golden[igolden].key,key) != 0); igolden++)
+      ;
+   if (igolden == check->golden_number)
+   {
+      printf ("%-14s %-26s golden     not recorded\n",check->name,operator);
+      check->golden_missing = check->golden_missing + 1;
+   }
+   else if (check->golden[igolden].checksum != checksum)
+   {
+      printf ("%-14s %-26s golden     %016llx instead of %016llx  FAILED\n",
+         check->name,operator,checksum,check->golden[igolden].checksum);
+      check->golden_difference = check->golden_difference + 1;
+   }
+} /* CheckGolden */
+
+/******************************************************************************/
+/* CheckDifference updates the greatest difference between two arrays of      */
+/* bytes and the number of bytes that differ.                                 */
+/******************************************************************************/
+static void CheckDifference (
+   unsigned char    *reference,         /* bytes of the reference */
+   unsigned char    *output,            /* bytes of the variant */
+   int              n,                  /* number of bytes */
+   int              *difference,        /* greatest difference so far */
+   long             *count)             /* bytes differing so far */
+{
+   int              i;                  /* index among bytes */
+
+   for (i=0; i<n; i++)
+   {
+      if (reference[i] != output[i])
+      {
+         *count = *count + 1;
+         if (abs(reference[i] - output[i]) > *difference)
+            *difference = abs(reference[i] - output[i]);
+      }
+   }
+} /* CheckDifference */
+
+/******************************************************************************/
+/* CheckReport prints the result of a variant and counts it.                  */
+/******************************************************************************/
+static void CheckReport (
+   type_check       *check,             /* image and counters */
+   char             *operator,          /* name of the operator */
+   char             *variant,           /* name of the variant */
+   int              tolerance,          /* greatest difference allowed */
+   int              status,             /* status returned by the variant */
+   int              difference,         /* greatest difference found */
+   long             count)              /* number of bytes differing */
+{
+   int              failed;             /* "variant does not pass" flag */
+
+   failed = ((status != 0) || (difference > tolerance));
+   check->comparison_number = check->comparison_number + 1;
+   check->failure_number    = check->failure_number + failed;
+   if (status != 0)
+      printf ("%-14s %-26s %-10s returned %d  FAILED\n",check->name,operator,
+         variant,status);
+   else
+      printf ("%-14s %-26s %-10s max %3d  count %8ld  tol %d  %s\n",
+         check->name,operator,variant,difference,count,tolerance,
+         (failed ? "FAILED" : "ok"));
+} /* CheckReport */
+
+/******************************************************************************/
+/* CheckCompare compares the output image of a variant to the reference, off  */
+/* a border of margin lines and pixels, and reports it.                       */
+/******************************************************************************/
+static void CheckCompare (
+   type_check       *check,             /* image, reference and output */
+   char             *operator,          /* name of the operator */
+   char             *variant,           /* name of the variant */
+   int              tolerance,          /* greatest difference allowed */
+   int              status,             /* status returned by the variant */
+   int              margin)             /* border not compared */
+{
+   int              difference;         /* greatest difference */
+   long             count;              /* bytes differing */
+   int              ichannel;           /* index among channels */
+   int              ili;                /* index among lines */
+   int              offset;             /* first byte compared in a line */
+
+   difference = 0;
+   count      = 0;
+   for (ichannel=0; (ichannel<check->image->channel_number) && (status == 0);
+        ichannel++)
+   {
+      for (ili=margin; ili<check->image->nliin-margin; ili++)
+      {
+         offset = ili * check->image->npxin + margin;
+         CheckDifference (&(check->reference.plane[ichannel][offset]),
+                          &(check->output.plane[ichannel][offset]),
+                          check->image->npxin-2*margin,&difference,&count);
+      }
+   }
+   CheckReport (check,operator,variant,tolerance,status,difference,count);
+} /* CheckCompare */
+
+/******************************************************************************/
+/* HistogramReference counts the pixels of each level, one by one.            */
+/******************************************************************************/
+static void HistogramReference (
+   type_image       *image,             /* image to be counted */
+   long             histogram[3][256])  /* pixels per channel and level */
+{
+   int              ichannel;           /* index among channels */
+   int              ipixel;             /* index among pixels */
+
+   memset (histogram,0,3*256*sizeof(long));
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      for (ipixel=0; ipixel<image->nliin*image->npxin; ipixel++)
+         histogram[ichannel][image->plane[ichannel][ipixel]] =
+            histogram[ichannel][image->plane[ichannel][ipixel]] + 1;
+   }
+} /* HistogramReference */
+
+/******************************************************************************/
+/* LutReference applies to each channel its own table, pixel by pixel.        */
+/******************************************************************************/
+static void LutReference (
+   unsigned char    *table[3],          /* table of each channel */
+   type_image       *image_in,          /* input image */
+   type_image       *image_out)         /* output image */
+{
+   int              ichannel;           /* index among channels */
+   int              ipixel;             /* index among pixels */
+
+   for (ichannel=0; ichannel<image_in->channel_number; ichannel++)
+   {
+      for (ipixel=0; ipixel<image_in->nliin*image_in->npxin; ipixel++)
+         image_out->plane[ichannel][ipixel] =
+            table[ichannel][image_in->plane[ichannel][ipixel]];
+   }
+} /* LutReference */
+
+/******************************************************************************/
+/* StretchReference maps [low,high] onto [0,255] as TD4 does:                 */
+/* (in - low) x 255 / (high - low), clipped and truncated.                    */
+/******************************************************************************/
+static void StretchReference (
+   int              low,                /* level mapped to 0 */
+   int              high,               /* level mapped to 255 */
+   type_image       *image_in,          /* input image */
+   type_image       *image_out)         /* output image */
+{
+   int              ichannel;           /* index among channels */
+   int              ipixel;             /* index among pixels */
+   float            value;              /* stretched value */
+
+   for (ichannel=0; ichannel<image_in->channel_number; ichannel++)
+   {
+      for (ipixel=0; ipixel<image_in->nliin*image_in->npxin; ipixel++)
+      {
+         value = (image_in->plane[ichannel][ipixel] - low) * 255.f /
+                 (high - low);
+         if (value < 0)
+            value = 0;
+         if (value > 255)
+            value = 255;
+         image_out->plane[ichannel][ipixel] = (unsigned char)value;
+      }
+   }
+} /* StretchReference */
+
+/******************************************************************************/
+/* LinearReference computes gain x in + offset, clipped and truncated, pixel  */
+/* by pixel.                                                                  */
+/******************************************************************************/
+static void LinearReference (
+   float            gain,               /* multiplicative factor */
+   float            offset,             /* value added after the gain */
+   type_image       *image_in,          /* input image */
+   type_image       *image_out)         /* output image */
+{
+   int              ichannel;           /* index among channels */
+   int              ipixel;             /* index among pixels */
+   float            value;              /* output value before clipping */
+
+   for (ichannel=0; ichannel<image_in->channel_number; ichannel++)
+   {
+      for (ipixel=0; ipixel<image_in->nliin*image_in->npxin; ipixel++)
+      {
+         value = gain * image_in->plane[ichannel][ipixel] + offset;
+         if (value < 0)
+            value = 0;
+         if (value > 255)
+            value = 255;
+         image_out->plane[ichannel][ipixel] = (unsigned char)value;
+      }
+   }
+} /* LinearReference */
+
+/******************************************************************************/
+/* MatchTable computes the table mapping a histogram onto a target one: each  */
+/* level goes to the first target level whose cumulated count reaches its     */
+/* own (both counts in proportion of their totals).                           */
+/******************************************************************************/
+static void MatchTable (
+   long             histogram[256],     /* histogram of the channel */
+   long             target[256],        /* histogram to be matched */
+   unsigned char    table[256])         /* table of the 256 output values */
+{
+   long long        total;              /* pixels of the channel */
+   long long        target_total;       /* pixels of the target */
+   long long        cumulated;          /* pixels up to the current level */
+   long long        target_cumulated;   /* target pixels up to level */
+   int              level;              /* input level */
+   int              target_level;       /* output level */
+
+   total        = 0;
+   target_total = 0;
+   for (level=0; level<256; level++)
+   {
+      total        = total + histogram[level];
+      target_total = target_total + target[level];
+   }
+   cumulated        = 0;
+   target_cumulated = target[0];
+   target_level     = 0;
+   for (level=0; level<256; level++)
+   {
+      cumulated = cumulated + histogram[level];
+      while ((target_level < 255)                                             &&
+             (target_cumulated * total < cumulated * target_total))
+      {
+         target_level     = target_level + 1;
+         target_cumulated = target_cumulated + target[target_level];
+      }
+      table[level] = (unsigned char)target_level;
+   }
+} /* MatchTable */
+
+/******************************************************************************/
+/* ConvolReference computes the convolution of each channel pixel by pixel:   */
+/* the size x size products summed line by line in the matrix, then gain,     */
+/* offset, clipping and truncation. Pixels where the matrix does not fit keep */
+/* their input value.                                                         */
+/******************************************************************************/
+static void ConvolReference (
+   type_convol      *convol,            /* matrix to be applied */
+   type_image       *image_in,          /* input image */
+   type_image       *image_out)         /* output image */
+{
+   int              half;               /* half size of the matrix */
+   int              ichannel;           /* index among channels */
+   int              ili, ipx;           /* line, pixel of the output */
+   int              k, l;               /* line, pixel in the matrix */
+   int              npxin;              /* pixel number */
+   unsigned char    *input;             /* input plane */
+   float            sum;                /* sum of the products */
+   float            value;              /* output value before clipping */
+
+   half  = convol->size / 2;
+   npxin = image_in->npxin;
+   for (ichannel=0; ichannel<image_in->channel_number; ichannel++)
+   {
+      input = image_in->plane[ichannel];
+      memcpy (image_out->plane[ichannel],input,image_in->nliin*npxin);
+      for (ili=half; ili<image_in->nliin-half; ili++)
+      {
+         for (ipx=half; ipx<npxin-half; ipx++)
+         {
+            sum = 0.f;
+            for (k=0; k<convol->size; k++)
+            {
+               for (l=0; l<convol->size; l++)
+                  sum = sum + convol->coeff[k*convol->size+l] *
+                              input[(ili+k-half)*npxin+ipx+l-half];
+            }
+            value = convol->gain * sum + convol->offset;
+            if (value < 0)
+               value = 0;
+            if (value > 255)
+               value = 255;
+            image_out->plane[ichannel][ili*npxin+ipx] = (unsigned char)value;
+         }
+      }
+   }
+} /* ConvolReference */
+
+/******************************************************************************/
+/* FrameBufferReference fills a frame buffer pixel by pixel: each component   */
+/* is scaled to the entries of its mask, rounded half up (strictly), shifted  */
+/* to the mask and the bytes_per_rgb low bytes are stored in host order.      */
+/******************************************************************************/
+static void FrameBufferReference (
+   type_image       *image,             /* image to be converted */
+   int              bytes_per_rgb,      /* bytes per pixel in frame buffer */
+   unsigned long    mask[3],            /* masks of red, green, blue */
+   unsigned char    *frame_buffer)      /* frame buffer to be filled */
+{
+   int              shift[3];           /* first bit of each mask */
+   int              entries[3];         /* values of each component */
+   unsigned int     pixel;              /* value stored for a pixel */
+   unsigned int     one;                /* 1, to test the byte order */
+   int              icolor;             /* index among components */
+   int              ipixel;             /* index among pixels */
+   int              ibyte;              /* index among bytes of a pixel */
+   int              level;              /* level of a component */
+   int              scaled;             /* level x entries */
+
+   for (icolor=0; icolor<3; icolor++)
+   {
+      for (shift[icolor]=0; ((mask[icolor] >> shift[icolor]) & 1) == 0;
+           shift[icolor]++)
+         ;
+      entries[icolor] = (int)(mask[icolor] >> shift[icolor]) + 1;
+   }
+   one = 1;
+   for (ipixel=0; ipixel<image->nliin*image->npxin; ipixel++)
+   {
+      pixel = 0;
+      for (icolor=0; icolor<3; icolor++)
+      {
+         level  = image->plane[image->channel_number == 3 ? icolor : 0][ipixel];
+         scaled = entries[icolor] * level;
+         level  = scaled / 256 + (scaled % 256 > 128);
+         if (level >= entries[icolor])
+            level = entries[icolor] - 1;
+         pixel  = pixel | ((unsigned int)level << shift[icolor]);
+      }
+      for (ibyte=0; ibyte<bytes_per_rgb; ibyte++)
+      {
+         if (*(unsigned char*)&one == 1)
+            frame_buffer[ipixel*bytes_per_rgb+ibyte] =
+               (unsigned char)(pixel >> (8*ibyte));
+         else
+            frame_buffer[ipixel*bytes_per_rgb+ibyte] =
+               (unsigned char)(pixel >> (8*(bytes_per_rgb-1-ibyte)));
+      }
+   }
+} /* FrameBufferReference */
+
+/******************************************************************************/
+/* CheckPipelines runs every variant of one-stage pipelines and compares      */
+/* them to the reference: pipeline_number is 1 (the same pipeline on all the  */
+/* channels) or the channel number (a pipeline per channel).                  */
+/******************************************************************************/
+static void CheckPipelines (
+   type_check       *check,             /* image, reference and output */
+   char             *operator,          /* name of the operator */
+   type_pipeline    *pipeline,          /* pipelines to be run */
+   int              pipeline_number,    /* 1 or the channel number */
+   int              tolerance)          /* greatest difference allowed */
+{
+   type_image       *image;             /* input image */
+   unsigned char    *image_in[3];       /* channels read by one run */
+   unsigned char    *image_out[3];      /* channels written by one run */
+   int              channel_number;     /* channels of one run */
+   int              variant;            /* VARIANT_... */
+   int              ipipeline;          /* index among pipelines */
+   int              status;             /* status of the runs */
+
+   image = check->image;
+   channel_number = (pipeline_number == 1 ? image->channel_number : 1);
+   CheckGolden (check,operator,ImageChecksum(&(check->reference)));
+   for (variant=0; variant<VARIANT_NUMBER; variant++)
+   {
+      for (ipipeline=0; ipipeline<image->channel_number; ipipeline++)
+         memset (check->output.plane[ipipeline],0,
+                 (size_t)image->nliin*image->npxin);
+      if (variant == VARIANT_IN_PLACE)
+         ImageCopy (image,&(check->output));
+      status = 0;
+      for (ipipeline=0; ipipeline<pipeline_number; ipipeline++)
+      {
+         memcpy (image_in,(variant == VARIANT_IN_PLACE ? check->output.plane :
+                           image->plane)+ipipeline,
+                 channel_number*sizeof(unsigned char*));
+         memcpy (image_out,check->output.plane+ipipeline,
+                 channel_number*sizeof(unsigned char*));
+         if (variant == VARIANT_PLANES)
+            status = status | PipelineApplyPlanes (check->pool,
+                                 &(pipeline[ipipeline]),channel_number,
+                                 image_in,image_out,image->nliin,image->npxin);
+         else
+            status = status | PipelineApply (
+                                 (variant == VARIANT_SERIAL ? NULL :
+                                  check->pool),&(pipeline[ipipeline]),
+                                 channel_number,image_in,image_out,
+                                 image->nliin,image->npxin);
+      }
+      CheckCompare (check,operator,VARIANT_NAME[variant],tolerance,status,0);
+   }
+} /* CheckPipelines */
+
+/******************************************************************************/
+/* CheckConvolution compares every method of a matrix to the reference.       */
+/******************************************************************************/
+static void CheckConvolution (
+   type_check       *check,             /* image, reference and output */
+   type_convol      *convol)            /* matrix to be applied */
+{
+   type_image       *image;             /* input image */
+   type_image       guarded;            /* copy of image with guards */
+   type_pipeline    pipeline;           /* one-stage pipeline */
+   int              tolerance;          /* rounding allowed to the methods */
+   int              method;             /* CONVOL_DIRECT ... CONVOL_FFT */
+   int              status;             /* status of a variant */
+
+   image = check->image;
+   ConvolAnalyze (convol);
+   tolerance = ((convol->property & CONVOL_IS_INTEGER) ? 0 : 1);
+   ConvolReference (convol,image,&(check->reference));
+   CheckGolden (check,convol->name,ImageChecksum(&(check->reference)));
+   status = Convolution (convol,image->channel_number,image->plane,
+                         check->output.plane,image->nliin,image->npxin);
+   CheckCompare (check,convol->name,"serial",tolerance,status,0);
+   for (method=CONVOL_DIRECT; method<=CONVOL_FFT; method++)
+   {
+      if ((method == CONVOL_SEPARABLE)                                        &&
+          ((convol->property & CONVOL_IS_SEPARABLE) == 0))
+         continue;
+      status = ConvolutionApply (check->pool,convol,method,
+                  image->channel_number,image->plane,check->output.plane,
+                  image->nliin,image->npxin);
+      CheckCompare (check,convol->name,CONVOL_METHOD_NAME[method],
+         (method == CONVOL_FFT ? 1 : tolerance),status,0);
+   }
+   method = ConvolutionMethod (convol,image->nliin,image->npxin,NULL);
+   status = ConvolutionApply (check->pool,convol,CONVOL_AUTO,
+               image->channel_number,image->plane,check->output.plane,
+               image->nliin,image->npxin);
+   CheckCompare (check,convol->name,"auto",
+      (method == CONVOL_FFT ? 1 : tolerance),status,0);
+   PipelineInit (&pipeline);
+   PipelineConvol (&pipeline,PIPE_INPUT,convol);
+   status = PipelineApply (check->pool,&pipeline,image->channel_number,
+               image->plane,check->output.plane,image->nliin,image->npxin);
+   PipelineRelease (&pipeline);
+   CheckCompare (check,convol->name,"pipeline",tolerance,status,0);
+   status = ImageAllocGuard (&guarded,image->channel_number,image->nliin,
+                             image->npxin,convol->size/2);
+   if (status == 0)
+   {
+      ImageCopy (image,&guarded);
+      ImageExtend (&guarded);
+      status = ConvolutionImage (check->pool,convol,&guarded,
+                                 &(check->output));
+      ImageFree (&guarded);
+   }
+   CheckCompare (check,convol->name,"guarded",tolerance,status,0);
+} /* CheckConvolution */
+
+/******************************************************************************/
+/* CheckIir compares IirGauss() with sigma = size / 3.5 to the sampled        */
+/* Gaussian over 6 sigma of IirGaussReference() (iir.h), on each channel. The */
+/* tolerance is IirGaussBound(), on all the pixels, borders included.         */
+/******************************************************************************/
+static void CheckIir (
+   type_check       *check)             /* image and counters */
+{
+   type_image       *image;             /* input image */
+   char             operator[KEY_LENGTH]; /* "IirGauss NxN" */
+   int              size;               /* size of the matching Gauss matrix */
+   int              ichannel;           /* channel index */
+   int              tolerance;          /* greatest difference allowed */
+   int              status;             /* status of IirGauss() */
+
+   image = check->image;
+   if ((ImageAlloc(&(check->reference),image->channel_number,image->nliin,
+                   image->npxin) != 0)                                        ||
+       (ImageAlloc(&(check->output),image->channel_number,image->nliin,
+                   image->npxin) != 0))
+   {
+      fprintf (stderr,"check_ops : Cannot allocate memory for %s.\n",
+         check->name);
+      exit (1);
+   }
+   for (size=3; size<=IIR_CHECK_SIZE; size=size+2)
+   {
+      sprintf (operator,"IirGauss %dx%d",size,size);
+      for (ichannel=0; ichannel<image->channel_number; ichannel++)
+      {
+         if (IirGaussReference(size/3.5,image->plane[ichannel],
+                check->reference.plane[ichannel],image->nliin,
+                image->npxin) != 0)
+         {
+            fprintf (stderr,"check_ops : Cannot compute the reference of %s.\n",
+               operator);
+            exit (1);
+         }
+      }
+      CheckGolden (check,operator,ImageChecksum(&(check->reference)));
+      tolerance = IirGaussBound (size/3.5);
+      status = IirGauss (check->pool,size/3.5,image->channel_number,
+                  image->plane,check->output.plane,image->nliin,image->npxin);
+      CheckCompare (check,operator,"iir",tolerance,status,0);
+   }
+   ImageFree (&(check->output));
+   ImageFree (&(check->reference));
+} /* CheckIir */
+
+/******************************************************************************/
+/* CheckFrameBuffer compares DisplayFrameBuffer() to the reference for one    */
+/* visual.                                                                    */
+/******************************************************************************/
+static void CheckFrameBuffer (
+   type_check       *check,             /* image and counters */
+   char             *operator,          /* name of the operator */
+   int              bytes_per_rgb,      /* bytes per pixel in frame buffer */
+   unsigned long    mask[3])            /* masks of red, green, blue */
+{
+   unsigned char    *reference;         /* frame buffer of the reference */
+   unsigned char    *output;            /* frame buffer of the library */
+   size_t           size;               /* bytes of a frame buffer */
+   int              difference;         /* greatest difference */
+   long             count;              /* bytes differing */
+   int              status;             /* status of the library */
+
+   size = (size_t)check->image->nliin * check->image->npxin * bytes_per_rgb;
+   if (((reference=(unsigned char*)malloc(size)) == NULL)                     ||
+       ((output=(unsigned char*)calloc(size,1)) == NULL))
+   {
+      fprintf (stderr,"check_ops : Cannot allocate memory for frame buffer.\n");
+      exit (1);
+   }
+   FrameBufferReference (check->image,bytes_per_rgb,mask,reference);
+   CheckGolden (check,operator,Checksum(FNV_OFFSET,reference,size));
+   status = DisplayFrameBuffer (check->image,bytes_per_rgb,mask[0],mask[1],
+                                mask[2],output);
+   difference = 0;
+   count      = 0;
+   CheckDifference (reference,output,(int)size,&difference,&count);
+   CheckReport (check,operator,"display",0,status,difference,count);
+   free (output);
+   free (reference);
+} /* CheckFrameBuffer */
+
+/******************************************************************************/
+/* CheckImage checks every operator on an image.                              */
+/******************************************************************************/
+static void CheckImage (
+   type_check       *check)             /* image, golden file and counters */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   type_image       *image;             /* input image */
+   long             reference[3][256];  /* histogram of the reference */
+   long             histogram[3][256];  /* histogram of a variant */
+   long             target[256];        /* triangular histogram */
+   unsigned char    table[3][256];      /* tables of the point operators */
+   unsigned char    *channel_table[3];  /* table of each channel */
+   unsigned char    level[4];           /* bytes of a count, for checksum */
+   unsigned long long hash;             /* checksum of the histogram */
+   type_pipeline    pipeline[3];        /* pipelines of the point operators */
+   unsigned long    mask_32[3];         /* masks of a 8-8-8 visual */
+   unsigned long    mask_16[3];         /* masks of a 5-6-5 visual */
+   unsigned int     seed;               /* state of CheckRandom() */
+   int              ichannel;           /* index among channels */
+   int              iconvol;            /* index among matrices */
+   int              variant;            /* 0: pool, 1: serial */
+   int              i, j;               /* indexes among levels, bytes */
+   int              low;                /* smallest level of the image */
+   int              high;               /* greatest level of the image */
+   int              difference;         /* greatest difference of counts */
+   long             count;              /* counts that differ */
+   int              status;             /* status of a variant */
+
+   image = check->image;
+   if ((ImageAlloc(&(check->reference),image->channel_number,image->nliin,
+                   image->npxin) != 0)                                        ||
+       (ImageAlloc(&(check->output),image->channel_number,image->nliin,
+                   image->npxin) != 0))
+   {
+      fprintf (stderr,"check_ops : Cannot allocate memory for %s.\n",
+         check->name);
+      exit (1);
+   }
+/*----------------------------------------------------------------------------*/
+/* Histogram, its checksum on 4 bytes per count whatever the size of long     */
+/*----------------------------------------------------------------------------*/
+   HistogramReference (image,reference);
+   hash = FNV_OFFSET;
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      for (i=0; i<256; i++)
+      {
+         for (j=0; j<4; j++)
+            level[j] = (unsigned char)(reference[ichannel][i] >> (8*j));
+         hash = Checksum (hash,level,4);
+      }
+   }
+   CheckGolden (check,"histogram",hash);
+   for (variant=0; variant<2; variant++)
+   {
+      status = Histogram ((variant == 0 ? check->pool : NULL),
+                  image->channel_number,image->plane,image->nliin,
+                  image->npxin,histogram);
+      difference = 0;
+      count      = 0;
+      for (ichannel=0; (ichannel<image->channel_number) && (status == 0);
+           ichannel++)
+      {
+         for (i=0; i<256; i++)
+         {
+            if (histogram[ichannel][i] != reference[ichannel][i])
+            {
+               count = count + 1;
+               if (labs(histogram[ichannel][i] - reference[ichannel][i]) >
+                   difference)
+                  difference = (int)labs(histogram[ichannel][i] -
+                                         reference[ichannel][i]);
+            }
+         }
+      }
+      CheckReport (check,"histogram",(variant == 0 ? "bands" : "serial"),0,
+         status,difference,count);
+   }
+/*----------------------------------------------------------------------------*/
+/* Point operators: random table, threshold, stretch of the levels of the     */
+/* first channel, the same stretch as gain and offset followed by the table   */
+/*----------------------------------------------------------------------------*/
+   seed = RANDOM_SEED;
+   for (i=0; i<256; i++)
+      table[0][i] = (unsigned char)CheckRandom(&seed);
+   for (ichannel=0; ichannel<3; ichannel++)
+      channel_table[ichannel] = table[0];
+   PipelineInit (&(pipeline[0]));
+   PipelineLut (&(pipeline[0]),PIPE_INPUT,table[0]);
+   LutReference (channel_table,image,&(check->reference));
+   CheckPipelines (check,"lut",pipeline,1,0);
+   PipelineRelease (&(pipeline[0]));
+
+   for (i=0; i<256; i++)
+      table[1][i] = (i >= 128 ? 255 : 0);
+   for (ichannel=0; ichannel<3; ichannel++)
+      channel_table[ichannel] = table[1];
+   PipelineInit (&(pipeline[0]));
+   PipelineThreshold (&(pipeline[0]),PIPE_INPUT,128);
+   LutReference (channel_table,image,&(check->reference));
+   CheckPipelines (check,"threshold",pipeline,1,0);
+   PipelineRelease (&(pipeline[0]));
+
+   for (low=0; (low < 255) && (reference[0][low] == 0); low++)
+      ;
+   for (high=255; (high > low) && (reference[0][high] == 0); high--)
+      ;
+   if (high == low)
+      high = low + 1;
+   PipelineInit (&(pipeline[0]));
+   PipelineLinear (&(pipeline[0]),PIPE_INPUT,255.f/(high-low),
+                   -255.f*low/(high-low));
+   StretchReference (low,high,image,&(check->reference));
+   CheckPipelines (check,"stretch",pipeline,1,1);
+   PipelineLut (&(pipeline[0]),0,table[0]);
+   for (ichannel=0; ichannel<3; ichannel++)
+      channel_table[ichannel] = table[0];
+   LinearReference (255.f/(high-low),-255.f*low/(high-low),image,
+                    &(check->output));
+   LutReference (channel_table,&(check->output),&(check->reference));
+   CheckPipelines (check,"linear+lut",pipeline,1,0);
+   PipelineRelease (&(pipeline[0]));
+/*----------------------------------------------------------------------------*/
+/* Histogram matching of each channel onto a triangular histogram             */
+/*----------------------------------------------------------------------------*/
+   for (i=0; i<256; i++)
+      target[i] = 129 - abs(i - 128);
+   status = Histogram (check->pool,image->channel_number,image->plane,
+                       image->nliin,image->npxin,histogram);
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      MatchTable (reference[ichannel],target,table[ichannel]);
+      channel_table[ichannel] = table[ichannel];
+   }
+   LutReference (channel_table,image,&(check->reference));
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      MatchTable (histogram[ichannel],target,table[ichannel]);
+      PipelineInit (&(pipeline[ichannel]));
+      PipelineLut (&(pipeline[ichannel]),PIPE_INPUT,table[ichannel]);
+   }
+   CheckPipelines (check,"matching",pipeline,image->channel_number,0);
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+      PipelineRelease (&(pipeline[ichannel]));
+/*----------------------------------------------------------------------------*/
+/* Convolutions by every matrix of CONVOL[]                                   */
+/*----------------------------------------------------------------------------*/
+   for (iconvol=0; iconvol<CONVOL_NUMBER; iconvol++)
+      CheckConvolution (check,&CONVOL[iconvol]);
+/*----------------------------------------------------------------------------*/
+/* Frame buffers of 32 and 16 bits per pixel                                  */
+/*----------------------------------------------------------------------------*/
+   mask_32[0] = 0xff0000;
+   mask_32[1] = 0x00ff00;
+   mask_32[2] = 0x0000ff;
+   mask_16[0] = 0xf800;
+   mask_16[1] = 0x07e0;
+   mask_16[2] = 0x001f;
+   CheckFrameBuffer (check,"framebuffer 32",4,mask_32);
+   CheckFrameBuffer (check,"framebuffer 16",2,mask_16);
+   ImageFree (&(check->output));
+   ImageFree (&(check->reference));
+} /* CheckImage */
+
+/******************************************************************************/
+/* CheckImages checks every operator on the images of the TD found under root */
+/* and on the random images, at the current CPU level.                        */
+/******************************************************************************/
+static void CheckImages (
+   type_check       *check,             /* golden file and counters */
+   char             *root)              /* root of the TD directories */
+{
+   type_image       image;              /* image being checked */
+   char             path[3][IMAGE_NAME_LENGTH+256]; /* files of an image */
+   char             *file_name[3];      /* pointers to path[] */
+   unsigned int     seed;               /* state of CheckRandom() */
+   int              ibundled;           /* index among images of the TD */
+   int              ichannel;           /* index among channels */
+   int              ipixel;             /* index among pixels */
+   int              irandom;            /* 0: RGB, 1: gray random image */
+
+/*----------------------------------------------------------------------------*/
+/* Images of the TD                                                           */
+/*----------------------------------------------------------------------------*/
+   for (ibundled=0; ibundled<BUNDLED_NUMBER; ibundled++)
+   {
+      if (ImageAlloc(&image,BUNDLED[ibundled].channel_number,
+                     BUNDLED[ibundled].nliin,BUNDLED[ibundled].npxin) != 0)
+      {
+         fprintf (stderr,"check_ops : Cannot allocate memory for %s.\n",
+            BUNDLED[ibundled].name);
+         exit (1);
+      }
+      for (ichannel=0; ichannel<image.channel_number; ichannel++)
+      {
+         sprintf (path[ichannel],"%s/%s",root,
+            BUNDLED[ibundled].file[ichannel]);
+         file_name[ichannel] = path[ichannel];
+      }
+      check->name  = BUNDLED[ibundled].name;
+      check->image = &image;
+      if (ImageRead(&image,file_name) != 0)
+         printf ("%-14s skipped\n",check->name);
+      else
+         CheckImage (check);
+      ImageFree (&image);
+   }
+/*----------------------------------------------------------------------------*/
+/* Random images, RGB then gray                                               */
+/*----------------------------------------------------------------------------*/
+   seed = RANDOM_SEED;
+   for (irandom=0; irandom<2; irandom++)
+   {
+      if (ImageAlloc(&image,(irandom == 0 ? 3 : 1),RANDOM_NLIIN,
+                     RANDOM_NPXIN) != 0)
+      {
+         fprintf (stderr,"check_ops : Cannot allocate memory for images.\n");
+         exit (1);
+      }
+      for (ichannel=0; ichannel<image.channel_number; ichannel++)
+      {
+         for (ipixel=0; ipixel<RANDOM_NLIIN*RANDOM_NPXIN; ipixel++)
+            image.plane[ichannel][ipixel] = (unsigned char)CheckRandom(&seed);
+      }
+      check->name  = (irandom == 0 ? "random rgb" : "random gray");
+      check->image = &image;
+      CheckImage (check);
+      CheckIir (check);
+      ImageFree (&image);
+   }
+} /* CheckImages */
+
+/******************************************************************************/
+/* Application core                                                           */
+/******************************************************************************/
+int main (
+   int              argc,               /* argument count */
+   char             **argv)             /* argument list */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   type_check       check;              /* image, golden file and counters */
+   char             *root;              /* root of the TD directories */
+   char             *convol_file;       /* description file of matrices */
+   int              convol_line;        /* line of an error in it */
+   char             line[KEY_LENGTH+32];/* line of the golden file */
+   char             *separator;         /* last tab of the line */
+   FILE             *golden_file;       /* golden file read */
+   int              top_level;          /* CPU level of the processor */
+   int              level;              /* CPU level being checked */
+   int              status;             /* status of ConvolLoad() */
+
+/******************************************************************************/
+/* Get parameters                                                             */
+/******************************************************************************/
+   memset (&check,0,sizeof(check));
+   if ((argc == 3) && (strcmp(argv[1],"-record") == 0))
+   {
+      if ((check.record=fopen(argv[2],"w")) == NULL)
+      {
+         fprintf (stderr,"check_ops : Cannot create \"%s\".\n",argv[2]);
+         exit (1);
+      }
+      fprintf (check.record,"# check_ops golden checksums\n");
+   }
+   else if ((argc == 3) && (strcmp(argv[1],"-golden") == 0))
+   {
+      if (((golden_file=fopen(argv[2],"r")) == NULL)                          ||
+          ((check.golden=(type_golden*)malloc(MAX_GOLDEN*
+                                              sizeof(type_golden))) == NULL))
+      {
+         fprintf (stderr,"check_ops : Cannot read \"%s\".\n",argv[2]);
+         exit (1);
+      }
+      while ((fgets(line,sizeof(line),golden_file) != NULL)                   &&
+             (check.golden_number < MAX_GOLDEN))
+      {
+         if ((line[0] == '#') || ((separator=strrchr(line,'\t')) == NULL))
+            continue;
+         *separator = '\0';
+         if (sscanf(separator+1,"%llx",
+                    &(check.golden[check.golden_number].checksum)) != 1)
+            continue;
+         memcpy (check.golden[check.golden_number].key,line,KEY_LENGTH);
+         check.golden[check.golden_number].key[KEY_LENGTH-1] = '\0';
+         check.golden_number = check.golden_number + 1;
+      }
+      fclose (golden_file);
+   }
+   else if (argc != 1)
+   {
+      fprintf (stderr,
+         "check_ops : usage: check_ops [ -record <file> | -golden <file> ]\n");
+      exit (1);
+   }
+/*----------------------------------------------------------------------------*/
+/* Matrices of the description file, thread pool                              */
+/*----------------------------------------------------------------------------*/
+   if ((convol_file=getenv(CONVOL_FILE_ENV)) == NULL)
+      convol_file = CONVOL_FILE;
+   status = ConvolLoad (convol_file,&convol_line);
+   if ((status == 2)                                                          ||
+       ((status == 1) && (getenv(CONVOL_FILE_ENV) != NULL)))
+   {
+      fprintf (stderr,"check_ops : error in \"%s\" at line %d.\n",convol_file,
+         convol_line);
+      exit (1);
+   }
+   if ((check.pool=PoolCreate(CHECK_THREADS)) == NULL)
+   {
+      fprintf (stderr,"check_ops : Cannot create thread pool.\n");
+      exit (1);
+   }
+   if ((root=getenv("ITI_IMAGES")) == NULL)
+      root = "../..";
+/******************************************************************************/
+/* Every image at every CPU level, the golden file recorded at the first one  */
+/******************************************************************************/
+   top_level = CpuLevel ();
+   for (level=CPU_SCALAR; level<=top_level; level++)
+   {
+      CpuSelect (level);
+      printf ("cpu level %s\n",CPU_LEVEL_NAME[level]);
+      CheckImages (&check,root);
+      if (check.record != NULL)
+         fclose (check.record);
+      check.record = NULL;
+   }
+/******************************************************************************/
+/* Summary                                                                    */
+/******************************************************************************/
+   printf ("%d variants compared, %d beyond tolerance",
+      check.comparison_number,check.failure_number);
+   if (check.golden != NULL)
+      printf ("; %d checksums differ from the golden file, %d not recorded",
+         check.golden_difference,check.golden_missing);
+   printf ("\n");
+   free (check.golden);
+   PoolDestroy (check.pool);
+   exit ((check.failure_number != 0) || (check.golden_difference != 0));
+} /* Application core */
@@ -2,6 +2,18 @@
 /* NAME                                                                       */
 /* coeff_gauss computes the coefficients of a Gauss convolution matrix.       */
 /******************************************************************************/
+/* SYNOPSIS                                                                   */
+/* coeff_gauss [ <max_size> ]                                                 */
+/* Matrices of odd sizes from 3 to <max_size> (default MAX_SIZE) are printed. */
+/* Sizes above MAX_SIZE are meant for the FFT method of convol.c.             */
+/* The impulse response of the recursive Gauss filter of iir.c for the same   */
+/* sigma is compared with the sampled Gaussian, normalized over               */
+/* IIR_REFERENCE_SIGMAS sigma and not truncated to the matrix ("IIR residual" */
+/* = greatest absolute difference over the matrix, relative to the centre     */
+/* value). It must not exceed IIR_RESIDUAL; the exit status is 1 otherwise.   */
+/* IirGaussBound(), the greatest difference in gray levels that follows on    */
+/* an image, is printed too.                                                  */
+/******************************************************************************/
 /* ADMINISTRATION                                                             */
 /* Serge RIAZANOFF  | 05.12.06 | v00.01 | Creation of the SW component        */
 /* Serge RIAZANOFF  | 19.01.07 | v00.02 | Empirical value of (size / 3.5)     */
@@ -18,11 +30,18 @@
 #include  <memory.h>
 #include  <math.h>
 
+/******************************************************************************/
+/* Local inclusion files                                                      */
+/******************************************************************************/
+#include  "iir.h"
+
 /******************************************************************************/
 /* Constant definitions                                                       */
 /******************************************************************************/
-#define MAX_SIZE    11                  /* maximum size of convolution */
+#define MAX_SIZE    11                  /* default maximum size of convolution*/
+#define MAX_FFT_SIZE 255                /* greatest maximum size (FFT method) */
 #define SIGMA       (size / 3.5)        /* Gaussian standard deviation */
+#define IIR_RESIDUAL 0.12               /* greatest IIR residual allowed */
 
 /******************************************************************************/
 /* Macro definitions                                                          */
@@ -41,8 +60,9 @@ int main (
 /******************************************************************************/
 /* Local variables                                                            */
 /******************************************************************************/
-   double           coeff[MAX_SIZE * MAX_SIZE]; /* matrix coefficients */
-   int              coeff_int[MAX_SIZE * MAX_SIZE]; /* integer values of coeff*/
+   double           *coeff;             /* matrix coefficients */
+   int              *coeff_int;         /* integer values of coeff */
+   int              max_size;           /* size of the largest matrix */
    int              size;               /* size of current matrix */
    int              k;                  /* index anmong lines in matrix */
    int              l;                  /* index anmong columns in matrix */
@@ -50,11 +70,36 @@ int main (
    double           gain;               /* multiplicative factor */
    int              sum;                /* sum of integer coefficients */
    double           residual;           /* nint approximation residual */
+   double           *response;          /* IIR impulse response */
+   double           *sampled;           /* sampled Gaussian, normalized */
+   int              radius;             /* half support of the Gaussian */
+   double           total;              /* sum of the sampled Gaussian */
+   double           iir_residual;       /* greatest difference with IIR */
+   int              failure;            /* "residual beyond IIR_RESIDUAL" */
 
 /******************************************************************************/
+/* Get the largest size (default MAX_SIZE) and allocate the matrices          */
+/******************************************************************************/
+   if ((argc < 2) || (sscanf(argv[1],"%d",&max_size) != 1))
+      max_size = MAX_SIZE;
+   if ((max_size < 3) || (max_size > MAX_FFT_SIZE))
+   {
+      fprintf (stderr,"coeff_gauss : size must lie in [3,%d].\n",MAX_FFT_SIZE);
+      exit (1);
+   }
+   if (((coeff=(double*)malloc(max_size*max_size*sizeof(double))) == NULL)  ||
+       ((coeff_int=(int*)malloc(max_size*max_size*sizeof(int))) == NULL)    ||
+       ((response=(double*)malloc(max_size*sizeof(double))) == NULL)   ||
+       ((sampled=(double*)malloc(max_size*sizeof(double))) == NULL))
+   {
+      fprintf (stderr,"coeff_gauss : Cannot allocate matrices.\n");
+      exit (1);
+   }
+/******************************************************************************/
 /* Loop on convolution sizes                                                  */
 /******************************************************************************/
-   for (size=3; size<=MAX_SIZE; size=size+2)
+   failure = 0;
+   for (size=3; size<=max_size; size=size+2)
    {
       printf ("\n\nCONVOLUTION SIZE = %d\n",size);
 /*============================================================================*/
@@ -97,6 +142,42 @@ printf("SIGMA    = %lf \n",SIGMA);
 printf("residual = %lf / ( %d x %d ) = %lf \n",residual,size,size,
    residual/(size*size));
 
+/*============================================================================*/
+/*    Compare with the recursive filter (separable: r(k) * r(l))              */
+/*============================================================================*/
+      radius = (int)ceil(IIR_REFERENCE_SIGMAS * SIGMA);
+      total  = 0.0;
+      for (k=-radius; k<=radius; k++)
+         total = total + exp(-k*k / (2.*SIGMA*SIGMA));
+      for (k=-size/2; k<=size/2; k++)
+         sampled[k+size/2] = exp(-k*k / (2.*SIGMA*SIGMA)) / total;
+      iir_residual = 0.0;
+      if (IirGaussImpulse(SIGMA,size,response) == 0)
+      {
+         for (k=0; k<size; k++)
+         {
+            for (l=0; l<size; l++)
+            {
+               if (fabs(response[k] * response[l] -
+                        sampled[k] * sampled[l]) > iir_residual)
+                  iir_residual = fabs(response[k] * response[l] -
+                                      sampled[k] * sampled[l]);
+            }
+         }
+         iir_residual = iir_residual /
+                        (sampled[size/2] * sampled[size/2]);
+printf("IIR residual = %lf (centre %lf / %lf, bound %d gray levels)",
+   iir_residual,response[size/2] * response[size/2],
+   sampled[size/2] * sampled[size/2],IirGaussBound(SIGMA));
+         if (iir_residual > IIR_RESIDUAL)
+         {
+            printf ("  beyond %lf  FAILED\n",IIR_RESIDUAL);
+            failure = 1;
+         }
+         else
+            printf ("  ok\n");
+      }
+
    } /* Loop on convolution sizes */
-   exit (0);
+   exit (failure);
 }
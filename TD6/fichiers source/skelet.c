@@ -5,10 +5,14 @@
 /******************************************************************************/
 /* SYNOPSIS                                                                   */
 /* COLOR DISPLAY                                                              */
-/* skelet [ <image_red> <image_green> <image_blue> [ <line_number>            */
+/* skelet [ --in-place ] [ --roi <line> <pixel> <lines> <pixels> ]            */
+/*        [ --profile ] [ --trace <file> ]                                    */
+/*        [ <image_red> <image_green> <image_blue> [ <line_number>            */
 /*                                                 [ <pixel_number> ] ] ]     */
 /* GRAY-SCALE DISPLAY                                                         */
-/* skelet [ <image_gray> [ <line_number>  [ <pixel_number> ] ] ]              */
+/* skelet [ --in-place ] [ --roi <line> <pixel> <lines> <pixels> ]            */
+/*        [ --profile ] [ --trace <file> ]                                    */
+/*        [ <image_gray> [ <line_number> [ <pixel_number> ] ] ]               */
 /******************************************************************************/
 /* DESCRIPTION                                                                */
 /* This process connects to the X server and displays a RGB raster image from */
@@ -20,7 +24,7 @@
 /*                                                                            */
 /* Images provided are supposed to have the same size (<line_number> and      */
 /* <pixel_number>) given as last parameters.                                  */
-/* These images in input must be in BSQ (Bit Sequential, also called DUMP)   */
+/* These images in input must be in BSQ (Bit Sequential, also called DUMP)    */
 /* format. In such organization, pixels are stored in the file as shown in the*/
 /* figure.                                                                    */
 /* Let (i,j) i=0,N-1 j=0,M-1 be the value of point in line i and pixel ,      */
@@ -40,6 +44,22 @@
 /*           N-1 +---------------------------------+                          */
 /* Pixel representation expected in input is 8 bits per pixel.                */
 /* As a consequence, size of input file must exactly match N x M bytes.       */
+/*                                                                            */
+/* With --in-place, the operators run as a pipeline (the convolutions of the  */
+/* list and the Gauss NxN, by the direct method, and the pipeline) write over */
+/* the origin image when PipelineInPlace() accepts all their stages: no       */
+/* processed image is allocated, which halves the memory of very large        */
+/* rasters. The other operators allocate it as usual (SeparateOutput).        */
+/*                                                                            */
+/* With --roi, only the window of <lines> x <pixels> from (<line>,<pixel>) is */
+/* read from the files (image.c reads its lines at their offsets), and        */
+/* processed as the whole image: a small area of a huge scene is inspected    */
+/* without reading the scene.                                                 */
+/*                                                                            */
+/* With --profile, the wall and CPU time, pixels and bytes of the load, of    */
+/* the operator, of InitFrameBuffer and of XPutImage are printed when the     */
+/* window is closed (profile.c); --trace <file> also writes them as a Chrome  */
+/* trace, for chrome://tracing or ui.perfetto.dev.                            */
 /******************************************************************************/
 /* ADMINISTRATION                                                             */
 /* Serge RIAZANOFF  | 28.01.00 | v00.01 | Creation of the SW component        */
@@ -60,26 +80,51 @@
 #include  <errno.h>
 #include  <memory.h>
 
-#include  <X11/X.h>
-#include  <X11/Xlib.h>
-#include  <X11/Intrinsic.h>
-
 /******************************************************************************/
-/* Constant definitions                                                       */
+/* Local inclusion files                                                      */
 /******************************************************************************/
-#define MAX_COLOR   255                 /* Greatest pixel value */
+#include  "image.h"
+#include  "display.h"
+#include  "convol.h"
+#include  "bank.h"
+#include  "chain.h"
+#include  "iir.h"
+#include  "registry.h"
+#include  "median.h"
+#include  "morpho.h"
+#include  "bilateral.h"
+#include  "starlet.h"
+#include  "pyramid.h"
+#include  "unsharp.h"
+#include  "canny.h"
+#include  "pipeline.h"
+#include  "profile.h"
 
 /******************************************************************************/
-/* Macro definitions                                                          */
+/* Constant definitions                                                       */
 /******************************************************************************/
-#define nint(float_value)  (((float_value)-(int)(float_value) > 0.5)?          \
-                            (int)(float_value)+1 : (int)(float_value))
+#define MAX_COLOR   255                 /* Greatest pixel value */
 
 /******************************************************************************/
-/* Forward declarations                                                       */
+/* SeparateOutput gives the processed image arrays of its own when it shares  */
+/* those of the origin (--in-place) and the operator cannot run in place.     */
 /******************************************************************************/
-int InitFrameBuffer ( );
-
+static void SeparateOutput (
+   int              *in_place,          /* "--in-place" option, cleared */
+   type_image       *origin,            /* ORIGIN IMAGE */
+   type_image       *processed)         /* PROCESSED IMAGE */
+{
+   if (!*in_place)
+      return;
+   printf ("Operateur non executable en place : image resultat allouee\n");
+   *in_place = 0;
+   if (ImageAlloc(processed,origin->channel_number,origin->nliin,
+                  origin->npxin) != 0)
+   {
+      fprintf (stderr,"skelet : Cannot allocate memory for image arrays.\n");
+      exit (1);
+   }
+} /* SeparateOutput */
 
 /******************************************************************************/
 /* Application core                                                           */
@@ -91,621 +136,624 @@ int main (
 /******************************************************************************/
 /* Local variables                                                            */
 /******************************************************************************/
-   Display          *display;           /* display returned from connection */
-   int              screen;             /* default screen of connection */
-   unsigned int     display_planes;     /* screen color planes */
-   XImage           *origin_ximage;     /* origin XImage structure */
-   XImage           *processed_ximage;  /* processed XImage structure */
-   Visual           *visual;            /* true-color visual */
-   XVisualInfo      visual_info;        /* structure used to get visual info */
-   unsigned char    *origin_frame_buffer;    /* origin frame buffer */
-   unsigned char    *processed_frame_buffer; /* processed frame buffer */
-   XEvent           event;              /* standard event structure */
-   Window           window;             /* window XID */
-   GC               gc;                 /* default graphic context */
-
-   char             file_name[3][80];   /* name of RGB image files */
-   FILE             *fp[3];             /* red image file pointer */
-   char             window_title[3*80]; /* title reported in window bar */
-   unsigned char    *origin_image[3];   /* image array: ORIGIN IMAGE */
-   unsigned char    *processed_image[3];/* image array: PROCESSED IMAGE */
+   char             window_title[IMAGE_TITLE_LENGTH]; /* title of window bar */
+   type_image       origin;             /* ORIGIN IMAGE */
+   type_image       processed;          /* PROCESSED IMAGE */
+   type_image       guarded;            /* origin image with guards */
+   unsigned char    **origin_image;     /* image array: ORIGIN IMAGE */
+   unsigned char    **processed_image;  /* image array: PROCESSED IMAGE */
 
    int              channel_number;     /* number of channels (1 or 3) */
    int              nliin;              /* input line number */
    int              npxin;              /* input pixel number */
    int              ichannel;           /* index among channels */
-   int              ili;                /* index among lines */
-   int              ipx;                /* index among pixels */
-   int              nread;              /* number of bytes actually read */
-
-   int              required_depth;     /* expected depth when getting visual */
-   int              status;             /* status returned by X function call */
-
-   int              red_colormap_entries; /* nb.of possible values for Red */
-   int              red_offset;         /* left offset to match the Red mask*/
-   int              green_colormap_entries; /* nb.of possible values for Green*/
-   int              green_offset;       /* left offset to match the Green mask*/
-   int              blue_colormap_entries; /* nb.of possible values for Blue */
-   int              blue_offset;        /* left offset to match the Blue mask*/
-   int              bits_per_rgb;       /* bits nb.per RGB pixel in frame buf*/
-   int              bytes_per_rgb;      /* bytes nb.per RGB pixel in frame bu*/
-
-   XSetWindowAttributes window_attributes; /* used to set window attributes */
-   Colormap         colormap;           /* Colormap used for TrueColor display*/
-   XGCValues        GC_values;          /* structure used to initialize GC */
-
-/******************************************************************************/
-/* Connect to X server                                                        */
-/******************************************************************************/
-   if ((display=XOpenDisplay(NULL)) == NULL)
-   {
-      fprintf (stderr,"skelet : Cannot connect to X server.\n");
-      exit (1);
-   }
-   screen         = DefaultScreen (display);
-   display_planes = DisplayPlanes (display,screen);
-/******************************************************************************/
-/* Get the TrueColor visual                                                   */
-/******************************************************************************/
-   required_depth = 24;
-   do
+   int              iconvol;            /* index among convolutions */
+   int              size;               /* size of a Gauss matrix */
+   double           sigma;              /* standard deviation of IIR Gauss */
+   int              radius;             /* half size of a rank window */
+   double           percentile;         /* rank of the rank filter, in % */
+   int              ioperation;         /* index among morphology operators */
+   int              width;              /* width of a structuring element */
+   int              height;             /* height of a structuring element */
+   double           sigma_space;        /* spatial sigma of the bilateral */
+   double           sigma_range;        /* range sigma of the bilateral */
+   int              scale_number;       /* number of starlet detail planes */
+   int              iscale;             /* starlet plane to be displayed */
+   double           factor;             /* denoising threshold, in sigmas */
+   type_pyramid     pyramid;            /* pyramid of the origin image */
+   int              level;              /* pyramid level to be displayed */
+   double           amount;             /* gain of the unsharp mask */
+   double           threshold;          /* threshold of the unsharp mask */
+   double           low;                /* weak threshold of Canny */
+   double           high;               /* strong threshold of Canny */
+   unsigned char    *edge[3];           /* bit-packed Canny edge maps */
+   int              method;             /* method computing the convolution */
+   type_convol      convol;             /* convolution to be applied */
+   type_bank        bank;               /* bank of 3x3 matrices */
+   int              ibank;              /* index among matrices of the bank */
+   unsigned char    *response[MAX_BANK][3]; /* responses of the bank */
+   type_chain       chain;              /* chain of convolutions */
+   type_pipeline    pipeline;           /* stretch, convolution, threshold */
+   int              istage;             /* last stage of the pipeline */
+   int              ichain;             /* index of a convolution of chain */
+   type_pool        *pool;              /* threads computing the convolution */
+   char             *convol_file;       /* description file of matrices */
+   int              convol_line;        /* line of an error in convol_file */
+   char             property[100];      /* properties of a matrix */
+   int              status;             /* status returned by a function */
+   int              in_place;           /* "--in-place" option */
+   int              roi[4];             /* "--roi" line, pixel, lines, pixels */
+   int              shift;              /* arguments of an option */
+   char             *trace_file;        /* "--trace" file, or NULL */
+   int              ievent;             /* event of the profile */
+   double           pixel_number;       /* pixels of the image */
+   double           byte_number;        /* bytes read and written by the
+                                           operators (origin and processed) */
+
+/******************************************************************************/
+/* Read input image (file names and size from the command line or asked)      */
+/******************************************************************************/
+   in_place   = 0;
+   trace_file = NULL;
+   memset (roi,0,sizeof(roi));
+   while ((argc > 1) && (strncmp(argv[1],"--",2) == 0))
    {
-      if ((status=XMatchVisualInfo(display,screen,required_depth,TrueColor,
-           &visual_info)) == 0)
+      if (strcmp(argv[1],"--in-place") == 0)
       {
-         required_depth = required_depth - 1;
+         in_place = 1;
+         shift    = 1;
       }
-   } while ((status == 0) && (required_depth >= 8));
-   if (required_depth < 8)
-   {
-      fprintf (stderr,
-     "skelet : Cannot get a TrueColor visual for whatever depth.\n");
-      exit (1);
+      else if ((strcmp(argv[1],"--roi") == 0) && (argc > 5)                 &&
+               (sscanf(argv[2],"%d",&roi[0]) == 1)                          &&
+               (sscanf(argv[3],"%d",&roi[1]) == 1)                          &&
+               (sscanf(argv[4],"%d",&roi[2]) == 1)                          &&
+               (sscanf(argv[5],"%d",&roi[3]) == 1)                          &&
+               (roi[2] > 0) && (roi[3] > 0))
+         shift = 5;
+      else if (strcmp(argv[1],"--profile") == 0)
+      {
+         ProfileStart ();
+         shift = 1;
+      }
+      else if ((strcmp(argv[1],"--trace") == 0) && (argc > 2))
+      {
+         ProfileStart ();
+         trace_file = argv[2];
+         shift      = 2;
+      }
+      else
+      {
+         fprintf (stderr,"skelet : wrong option \"%s\".\n",argv[1]);
+         exit (1);
+      }
+      argv[shift] = argv[0];
+      argv        = argv + shift;
+      argc        = argc - shift;
    }
-/*============================================================================*/
-/* Check that the number of bits per pixels in frame buffer is multiple of 8  */
-/*============================================================================*/
-   bits_per_rgb = BitmapUnit(display);
-   if (required_depth == 16)
-      bits_per_rgb = 16;
-   if (bits_per_rgb % 8 != 0)
+   ievent = ProfileBegin ("ImageLoadRegion");
+   if (ImageLoadRegion(argc,argv,roi[0],roi[1],roi[2],roi[3],&origin,
+                       window_title) != 0)
+      exit (1);
+   channel_number = origin.channel_number;
+   nliin          = origin.nliin;
+   npxin          = origin.npxin;
+   pixel_number   = (double)nliin * npxin;
+   byte_number    = 2. * channel_number * pixel_number;
+   ProfileEnd (ievent,pixel_number,channel_number*pixel_number);
+/******************************************************************************/
+/* Allocate memory for the processed image (in place: the origin image)       */
+/******************************************************************************/
+   if (in_place)
+      processed = origin;
+   else if (ImageAlloc(&processed,channel_number,nliin,npxin) != 0)
    {
-      fprintf (stderr,"skelet : Only number of bits per pixels in ");
-      fprintf (stderr,"frame buffer multiple of 8 are supported.\n");
+      fprintf (stderr,
+         "skelet : Cannot allocate memory for image arrays.\n");
       exit (1);
    }
-   bytes_per_rgb = bits_per_rgb / 8;
+   origin_image    = origin.plane;
+   processed_image = processed.plane;
 /******************************************************************************/
-/* Analyze the way Red, Green and Blue component are mapped in frame buffer   */
 /******************************************************************************/
-/* Red component                                                              */
+/* PROCESSING SECTION                                                         */
+/******************************************************************************/
+/* Append the matrices of the description file (optional unless ITI_CONVOL    */
+/* names it) to CONVOL[]                                                      */
 /*----------------------------------------------------------------------------*/
-   red_colormap_entries = visual_info.red_mask;
-   red_offset           = 0;
-   while ((red_colormap_entries & 0x00000001) == 0)
+   if ((convol_file=getenv(CONVOL_FILE_ENV)) == NULL)
+      convol_file = CONVOL_FILE;
+   status = ConvolLoad (convol_file,&convol_line);
+   if ((status == 2)                                                          ||
+       ((status == 1) && (getenv(CONVOL_FILE_ENV) != NULL)))
    {
-      red_offset           = red_offset + 1;
-      red_colormap_entries = (red_colormap_entries >> 1);
+      fprintf (stderr,"skelet : error in \"%s\" at line %d.\n",convol_file,
+         convol_line);
+      exit (1);
    }
-   red_colormap_entries = red_colormap_entries + 1;
-/*----------------------------------------------------------------------------*/
-/* Green component                                                            */
 /*----------------------------------------------------------------------------*/
-   green_colormap_entries = visual_info.green_mask;
-   green_offset           = 0;
-   while ((green_colormap_entries & 0x00000001) == 0)
+/* Select the convolution among the CONVOL[] matrices or a Gauss matrix of    */
+/* any size                                                                   */
+/*----------------------------------------------------------------------------*/
+   printf ("\n**********  Skelet.c  -  Convolutions  **********\n");
+   for (iconvol=0; iconvol<CONVOL_NUMBER; iconvol++)
+      printf ("%2d - %-24s :%s\n",iconvol+1,CONVOL[iconvol].name,
+         ConvolPropertyString(&CONVOL[iconvol],property));
+   printf ("%2d - Gauss NxN (N impair, au plus %d)\n",CONVOL_NUMBER+1,
+      MAX_FFT_SIZE);
+   printf ("%2d - Banc Sobel : module du gradient\n",CONVOL_NUMBER+2);
+   printf ("%2d - Banc Sobel : direction du gradient\n",CONVOL_NUMBER+3);
+   printf ("%2d - Chaine de convolutions\n",CONVOL_NUMBER+4);
+   printf ("%2d - Gauss recursif (sigma quelconque)\n",CONVOL_NUMBER+5);
+   printf ("%2d - Filtre de rang (mediane : 50 %%)\n",CONVOL_NUMBER+6);
+   for (ioperation=0; ioperation<MORPHO_NUMBER; ioperation++)
+      printf ("%2d - Morphologie : %s\n",CONVOL_NUMBER+7+ioperation,
+         MORPHO_NAME[ioperation]);
+   printf ("%2d - Bilateral (grille bilaterale)\n",
+      CONVOL_NUMBER+7+MORPHO_NUMBER);
+   printf ("%2d - Ondelettes : plan de detail\n",CONVOL_NUMBER+8+MORPHO_NUMBER);
+   printf ("%2d - Ondelettes : debruitage\n",CONVOL_NUMBER+9+MORPHO_NUMBER);
+   printf ("%2d - Pyramide : niveau gaussien\n",CONVOL_NUMBER+10+MORPHO_NUMBER);
+   printf ("%2d - Pyramide : niveau laplacien\n",
+      CONVOL_NUMBER+11+MORPHO_NUMBER);
+   printf ("%2d - Masque flou (rehaussement)\n",CONVOL_NUMBER+12+MORPHO_NUMBER);
+   printf ("%2d - Contours de Canny\n",CONVOL_NUMBER+13+MORPHO_NUMBER);
+   printf ("%2d - Pipeline : etirement, convolution, seuil\n",
+      CONVOL_NUMBER+14+MORPHO_NUMBER);
+   printf ("Numero de la convolution     : ");
+   if ((scanf("%d",&iconvol) != 1) || (iconvol < 1) ||
+       (iconvol > CONVOL_NUMBER+14+MORPHO_NUMBER))
    {
-      green_offset           = green_offset + 1;
-      green_colormap_entries = (green_colormap_entries >> 1);
+      fprintf (stderr,"skelet : unknown convolution.\n");
+      exit (1);
    }
-   green_colormap_entries = green_colormap_entries + 1;
+   if (iconvol <= CONVOL_NUMBER)
+      convol = CONVOL[iconvol-1];
+   else if (iconvol == CONVOL_NUMBER+4)
+   {
 /*----------------------------------------------------------------------------*/
-/* Blue component                                                             */
+/*    Chain: applied as a cascade or as its composite matrix                  */
 /*----------------------------------------------------------------------------*/
-   blue_colormap_entries = visual_info.blue_mask;
-   blue_offset           = 0;
-   while ((blue_colormap_entries & 0x00000001) == 0)
-   {
-      blue_offset           = blue_offset + 1;
-      blue_colormap_entries = (blue_colormap_entries >> 1);
+      SeparateOutput (&in_place,&origin,&processed);
+      ChainInit (&chain);
+      printf ("Numeros des convolutions (0 pour finir) : ");
+      while ((scanf("%d",&ichain) == 1) && (ichain >= 1) &&
+             (ichain <= CONVOL_NUMBER))
+      {
+         if (ChainAdd(&chain,&CONVOL[ichain-1]) != 0)
+            break;
+      }
+      if (ChainPlan(&chain,nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : empty chain of convolutions.\n");
+         exit (1);
+      }
+      if (chain.composite_valid)
+         printf ("%s : cascade %.1f, composite %dx%d %.1f => %s\n",
+            chain.composite.name,chain.cascade_cost,chain.composite.size,
+            chain.composite.size,chain.composite_cost,
+            (chain.use_composite ? "composite" : "cascade"));
+      else
+         printf ("%d convolutions : cascade %.1f, pas de composite => "
+                 "cascade\n",chain.convol_number,chain.cascade_cost);
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("ChainApply");
+      if (ChainApply(pool,&chain,channel_number,origin_image,processed_image,
+                     nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute the chain.\n");
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      if (!chain.use_composite)
+         printf ("Images intermediaires : %ld Ko (%ld Ko sans reutilisation)\n",
+            (long)(chain.arena.peak/1024),(long)(chain.arena.total/1024));
+      PoolDestroy (pool);
+      ChainRelease (&chain);
    }
-   blue_colormap_entries = blue_colormap_entries + 1;
-/******************************************************************************/
-/* GET PARAMETERS                                                             */
-/******************************************************************************/
-/* CASE OF GRAY-SCALE                                                         */
-/*============================================================================*/
-   if ((argc == 4)                                                            &&
-       (sscanf(argv[2],"%d",&nliin) == 1)                                     &&
-       (sscanf(argv[3],"%d",&npxin) == 1))
+   else if (iconvol == CONVOL_NUMBER+14+MORPHO_NUMBER)
    {
-      channel_number = 1;
 /*----------------------------------------------------------------------------*/
-/*    Get and open input file                                                 */
+/*    Pipeline: stretch of [min,max] to [0,255] (TD4), convolution and        */
+/*    threshold, run tile by tile without intermediate planes                 */
 /*----------------------------------------------------------------------------*/
-      strcpy (file_name[0],argv[1]);
-      if ((fp[0]=fopen(file_name[0],"r")) == NULL)
+      PipelineInit (&pipeline);
+      printf ("Dynamique a etirer (min max)  : ");
+      if ((scanf("%lf %lf",&low,&high) != 2) || (high <= low))
+      {
+         fprintf (stderr,"skelet : wrong dynamic.\n");
+         exit (1);
+      }
+      istage = PipelineLinear (&pipeline,PIPE_INPUT,
+                               (float)(255. / (high - low)),
+                               (float)(-low * 255. / (high - low)));
+      printf ("Numero de la convolution     : ");
+      if ((scanf("%d",&ichain) != 1) || (ichain < 1)                         ||
+          (ichain > CONVOL_NUMBER))
+      {
+         fprintf (stderr,"skelet : unknown convolution.\n");
+         exit (1);
+      }
+      istage = PipelineConvol (&pipeline,istage,&CONVOL[ichain-1]);
+      printf ("Seuil (-1 : aucun)            : ");
+      if ((scanf("%lf",&threshold) == 1) && (threshold >= 0.))
+         istage = PipelineThreshold (&pipeline,istage,(int)threshold);
+      if (!PipelineInPlace(&pipeline))
+         SeparateOutput (&in_place,&origin,&processed);
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("PipelineApply");
+      if ((istage == PIPE_ERROR)                                              ||
+          (PipelineApply(pool,&pipeline,channel_number,origin_image,
+                         processed_image,nliin,npxin) != 0))
       {
-         fprintf (stderr,"skelet : can't open \"%s\"\n",file_name[0]);
+         fprintf (stderr,"skelet : Cannot run the pipeline.\n");
          exit (1);
       }
-   } /* CASE OF GRAY-SCALE */
-/*============================================================================*/
-/* CASE OF RED-GREE-BLUE IMAGES                                               */
-/*============================================================================*/
-   else
+      ProfileEnd (ievent,pixel_number,byte_number);
+      printf ("%d operateurs, %d apres fusion, tuiles de %d lignes, %ld Ko\n",
+         pipeline.stage_number,pipeline.kernel_number,pipeline.tile_lines,
+         (long)(pipeline.arena.peak/1024));
+      PipelineRelease (&pipeline);
+      PoolDestroy (pool);
+   }
+   else if (iconvol == CONVOL_NUMBER+13+MORPHO_NUMBER)
    {
-      channel_number = 3;
 /*----------------------------------------------------------------------------*/
-/*    Process RED file                                                        */
+/*    Canny: bit-packed edge maps, displayed white on black                   */
 /*----------------------------------------------------------------------------*/
-      if (argc >= 2)
-         strcpy(file_name[0],argv[1]);
-      else
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Sigma du lissage (0 : aucun)  : ");
+      if (scanf("%lf",&sigma) != 1)
+         sigma = -1.;
+      printf ("Seuils bas et haut            : ");
+      if (scanf("%lf %lf",&low,&high) != 2)
+         sigma = -1.;
+      for (ichannel=0; ichannel<channel_number; ichannel++)
       {
-         printf("Nom du fichier image: ROUGE  : ");
-         scanf ("%s",file_name[0]);
+         if ((edge[ichannel]=(unsigned char*)malloc(nliin*
+               CANNY_STRIDE(npxin))) == NULL)
+         {
+            fprintf (stderr,"skelet : Cannot allocate memory for edges.\n");
+            exit (1);
+         }
       }
-      if ((fp[0]=fopen(file_name[0],"r")) == NULL)
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("Canny");
+      if (Canny(pool,sigma,low,high,channel_number,origin_image,edge,nliin,
+                npxin) != 0)
       {
-         fprintf (stderr,"skelet : can't open \"%s\"\n",file_name[0]);
+         fprintf (stderr,"skelet : Cannot compute the Canny edges.\n");
          exit (1);
       }
-/*----------------------------------------------------------------------------*/
-/*    Process GREEN file                                                      */
-/*----------------------------------------------------------------------------*/
-      if (argc >= 3)
-         strcpy(file_name[1],argv[2]);
-      else
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
+      for (ichannel=0; ichannel<channel_number; ichannel++)
       {
-         printf("Nom du fichier image: VERT   : ");
-         scanf ("%s",file_name[1]);
+         CannyUnpack (edge[ichannel],processed_image[ichannel],nliin,npxin);
+         free (edge[ichannel]);
       }
-      if ((fp[1]=fopen(file_name[1],"r")) == NULL)
+   }
+   else if (iconvol == CONVOL_NUMBER+12+MORPHO_NUMBER)
+   {
+/*----------------------------------------------------------------------------*/
+/*    Unsharp mask: blur, difference, gain and clipping in one pass           */
+/*----------------------------------------------------------------------------*/
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Sigma du flou (>= %.1f)       : ",MIN_UNSHARP_SIGMA);
+      if (scanf("%lf",&sigma) != 1)
+         sigma = -1.;
+      printf ("Gain et seuil                 : ");
+      if (scanf("%lf %lf",&amount,&threshold) != 2)
+         sigma = -1.;
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("UnsharpMask");
+      if (UnsharpMask(pool,sigma,amount,threshold,channel_number,
+                      origin_image,processed_image,nliin,npxin) != 0)
       {
-         fprintf (stderr,"skelet : can't open \"%s\"\n",file_name[1]);
+         fprintf (stderr,"skelet : Cannot compute the unsharp mask.\n");
          exit (1);
       }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
+   }
+   else if (iconvol > CONVOL_NUMBER+9+MORPHO_NUMBER)
+   {
 /*----------------------------------------------------------------------------*/
-/*    Process BLUE file                                                       */
+/*    Pyramid: one level in the upper left corner                             */
 /*----------------------------------------------------------------------------*/
-      if (argc >= 4)
-         strcpy(file_name[2],argv[3]);
-      else
+      SeparateOutput (&in_place,&origin,&processed);
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("PyramidBuild");
+      if ((PyramidAlloc(&pyramid,0,channel_number,nliin,npxin) != 0)      ||
+          (PyramidBuild(pool,&pyramid,origin_image) != 0)                  ||
+          (PyramidLaplacian(pool,&pyramid) != 0))
       {
-         printf("Nom du fichier image: BLEU   : ");
-         scanf ("%s",file_name[2]);
+         fprintf (stderr,"skelet : Cannot build the pyramid.\n");
+         exit (1);
       }
-      if ((fp[2]=fopen(file_name[2],"r")) == NULL)
+      ProfileEnd (ievent,pixel_number,byte_number);
+      printf ("Niveau (0 a %d)               : ",pyramid.level_number-1);
+      if ((scanf("%d",&level) != 1)                                           ||
+          (PyramidLevel(&pyramid,level,
+                        iconvol == CONVOL_NUMBER+11+MORPHO_NUMBER,
+                        processed_image) != 0))
       {
-         fprintf (stderr,"skelet : can't open \"%s\"\n",file_name[2]);
+         fprintf (stderr,"skelet : unknown pyramid level.\n");
          exit (1);
       }
+      PyramidFree (&pyramid);
+      PoolDestroy (pool);
+   }
+   else if (iconvol > CONVOL_NUMBER+7+MORPHO_NUMBER)
+   {
 /*----------------------------------------------------------------------------*/
-/*    Get size of input image                                                 */
+/*    Starlet: one plane of the decomposition, or denoising                   */
 /*----------------------------------------------------------------------------*/
-      if ((argc < 5)                                                          ||
-          (sscanf(argv[4],"%d",&nliin) <= 0))
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Nombre de plans (1 a %d)      : ",MAX_STARLET_SCALE);
+      if (scanf("%d",&scale_number) != 1)
+         scale_number = -1;
+      if (iconvol == CONVOL_NUMBER+8+MORPHO_NUMBER)
       {
-         printf("Nombre de lignes en entree   : ");
-         scanf ("%d",&nliin);
+         printf ("Plan (%d : residu)            : ",scale_number+1);
+         if (scanf("%d",&iscale) != 1)
+            iscale = -1;
       }
-      if ((argc < 6)                                                          ||
-          (sscanf(argv[5],"%d",&npxin) <= 0))
+      else
       {
-         printf("Nombre de pixels en entree   : ");
-         scanf ("%d",&npxin);
+         printf ("Seuil (en ecarts types)       : ");
+         if (scanf("%lf",&factor) != 1)
+            factor = -1.;
       }
-   } /* CASE OF RED-GREE-BLUE IMAGES */
-/******************************************************************************/
-/* Allocate memory for the internal frame buffers                             */
-/******************************************************************************/
-   if (((origin_frame_buffer=(unsigned char*)malloc((npxin*nliin*bytes_per_rgb)*
-         sizeof(char))) == NULL)                                              ||
-       ((processed_frame_buffer=(unsigned char*)malloc((npxin*nliin*
-         bytes_per_rgb)*sizeof(char))) == NULL))
-   {
-      fprintf (stderr,
-         "skelet : Cannot allocate internal frame buffers.\n");
-      exit (1);
-   }
-/******************************************************************************/
-/* Allocate memory for the image arrays                                       */
-/******************************************************************************/
-   for (ichannel=0; ichannel<channel_number; ichannel++)
-   {
-      if (((origin_image[ichannel]=(unsigned char*)malloc((npxin*nliin)*
-            sizeof(char))) == NULL)                                           ||
-          ((processed_image[ichannel]=(unsigned char*)malloc((npxin*nliin)*
-            sizeof(char))) == NULL))
+      pool = PoolCreate (0);
+      if (iconvol == CONVOL_NUMBER+8+MORPHO_NUMBER)
       {
-         fprintf (stderr,
-            "skelet : Cannot allocate memory for image arrays.\n");
-         exit (1);
+         ievent = ProfileBegin ("StarletDetail");
+         if (StarletDetail(pool,scale_number,iscale,channel_number,
+                           origin_image,processed_image,nliin,npxin) != 0)
+         {
+            fprintf (stderr,"skelet : Cannot compute the wavelet plane.\n");
+            exit (1);
+         }
       }
-   }
-/******************************************************************************/
-/* Read input image                                                           */
-/******************************************************************************/
-   for (ichannel=0; ichannel<channel_number; ichannel++)
-   {
-      for (ili=0; ili<nliin; ili++)
+      else
       {
-         if ((nread=fread(&(origin_image[ichannel][ili*npxin]),sizeof(char),
-              npxin,fp[ichannel])) < npxin)
+         ievent = ProfileBegin ("StarletDenoise");
+         if (StarletDenoise(pool,scale_number,factor,channel_number,
+                            origin_image,processed_image,nliin,npxin) != 0)
          {
-            fprintf (stderr,
-         "skelet : error while reading record nb. %d from \"%s\",  ",
-               ili,file_name[ichannel]);
-            fprintf (stderr,"(returned=%d, status=%d)\n",nread,errno);
-            perror ("skelet");
+            fprintf (stderr,"skelet : Cannot denoise with wavelets.\n");
             exit (1);
          }
       }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
    }
-/******************************************************************************/
-/******************************************************************************/
-/* PROCESSING SECTION                                                         */
-/******************************************************************************/
-/* Initialize the processed image                                             */
-/******************************************************************************/
-char nom ="";
-int size = 0;
-float coeff = 0.0;
-
-#define MAX_SIZE 11;
-
-typedef struct {
-	char name[100];
-	int size;
-	float gain;
-	float offset;
-	float coeff[MAX_SIZE * MAX_SIZE];
-}  type-convol;
-
-// filtre moyenne 3*3
-type-convol CONVOL[] = {
-"Moyenne 3*3", 3, 1/(float)9.0, 0., {1.0, 1.0, 1.0,
-		   		     1.0, 1.0, 1.0,
-		   	  	     1.0, 1.0, 1.0}};
-
-
-
-for (ichannel=0; ichannel<channel_number; ichannel++) {
-/*----------------------------------------------------------------------------*/
-/*	Compute convolution	*/
-/*	Loop on lines	*/
-/*----------------------------------------------------------------------------*/
-	for (ili=CONVOL[CONVOL_INDEX].size/2; ili<nliin-CONVOL[CONVOL_INDEX].size/2; ili++) {
-		for (ipx=CONVOL[CONVOL_INDEX].size/2;ipx<npxin-CONVOL[CONVOL_INDEX].size/2; ipx++) {
-			output_value = 0.0;
-			for (k=-CONVOL[CONVOL_INDEX].size/2; k<= CONVOL[CONVOL_INDEX].size/2 ; k++) {
-				for (l=-CONVOL[CONVOL_INDEX].size/2; l<= CONVOL[CONVOL_INDEX].size/2; l++) {
-					output_value = output_value + CONVOL[CONVOL_INDEX].coeff[k*size+l] * origin_image[ichannel][ili*npxin+ipx];
-				}
-			}
-			output_value = CONVOL[CONVOL_INDEX].gain * output_value + CONVOL[CONVOL_INDEX].offset;
-			if (output_value < 0) { output_value = 0 ;}
-			if (output_value > 255) { output_value = 255 ;}
-			processed_image[ichannel][ili*npxin+ipx] = output_value;
-		}
-	}
-}
-
-
-// -------- initialisation des matrices :
-type_convol CONVOL[] = {
-	{ "Mean 3x3",	3, 1./(float)9., 0., { 1., 1., 1.,
-				       	       1., 1., 1.,
-				               1., 1., 1. } },
-
-	{ "Mean 5x5",	5, 1./(float)25., 0., { 1., 1., 1., 1., 1.,
-			      	 	 	1., 1., 1., 1., 1.,
-				        	1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1. } },
-
-	{ "Mean 7x7",	7, 1./(float)49., 0., { 1., 1., 1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1., 1., 1.,
-					 	1., 1., 1., 1., 1., 1., 1. } },
-
- 	{ "Gauss 3x3",	3, 1./(float)16., 0., { 1., 2., 1.,
-	 				        2., 4., 2.,
-					 	1., 2., 1. } },
-
-	{ "Gradient 3x3 4-connex", 3, 10./(float)4., 128., { 0., -1., 0.,
-						     	    -1., 4., -1.,
-						      	     0., -1., 0. } },
-
-	{ "Gradient 3x3 8-connex", 3, 10./(float)9.657, 128.,{ -1., -1., -1.,
-							       -1., 8., -1.,
-							       -1., -1., -1. } },
-
-	{ "Gradient 3x3 N-S", 3, 10./(float)6., 128.,{ -1., -1., -1.,
-							0., 0., 0.,
-							1., 1., 1. } },
-
-	{ "Gradient 3x3 W-E", 3, 10./(float)6., 128.,{ -1., 0., 1.,
-						       -1., 0., 1.,
-						       -1., 0., 1. } },
-
-	{ "Gradient 3x3 NW-SE", 3, 10./(float)5.6569, 128.,{ -1., -1., 0.,
-							     -1., 0., 1.,
-							      0., 1., 1. } },
-
-	{ "Sobel 3x3 N-S", 3, 10./(float)8., 128.,{ -1., -2., -1.,
-						     0., 0., 0.,
-						     1., 2., 1. } },
-	
-	{ "Sobel 3x3 W-E", 3, 10./(float)8., 128.,{ -1., 0., 1.,
-						    -2., 0., 2.,
-						    -1., 0., 1. } },
-
-	{ "Sobel 3x3 NW-SE", 3, 10./(float)3.7712, 128.,{ -2., -1., 0.,
-						          -1., 0., 1.,
-						           0., 1., 2. } },
-
-	{ "Courbure 3x3 N-S", 3, 10./(float)3., 128.,{ -1., -1., -1.,
-						        2., 2., 2.,
-						       -1., -1., -1. } },
-
-	{ "Courbure 3x3 W-E", 3, 10./(float)3., 128.,{ -1., 2., 1.,
-						       -1., 2., -1.,
-						       -1., 2., -1. } },
-
-	{ "Courbure 3x3 NW-SE", 3, 10./(float)3., 128.,{ -1., -1., 2.,
-							 -1., 2., -1.,
-							  2., -1., -1. } },
-
-	{ "Laplacien 3x3", 3, 10./(float)4., 128.,{ 1., -2., 1.,
-						   -2., 4., -2.,
-						    1., -2., 1. } },
-
-	{ "Pratt 3x3", 3, 1./(float)0., 128.,{ -1., -1., -1.,
-					       -1., 17., -1.,
-					       -1., -1., -1. } },
-
-}
-/******************************************************************************/
-/******************************************************************************/
-/* Transfer image into the "origin" frame buffer                              */
-/******************************************************************************/
-   if (InitFrameBuffer(channel_number,origin_image,nliin,npxin,bytes_per_rgb,
-                       red_colormap_entries,red_offset,
-                       green_colormap_entries,green_offset,
-                       blue_colormap_entries,blue_offset,
-                       origin_frame_buffer) != 0)
+   else if (iconvol == CONVOL_NUMBER+7+MORPHO_NUMBER)
    {
-      fprintf (stderr,
-         "skelet : Cannot transfer origin image in frame buffer.\n");
-      return (1);
+/*----------------------------------------------------------------------------*/
+/*    Bilateral filter through the bilateral grid                             */
+/*----------------------------------------------------------------------------*/
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Sigma spatial (>= %.1f)       : ",MIN_SIGMA_SPACE);
+      if (scanf("%lf",&sigma_space) != 1)
+         sigma_space = -1.;
+      printf ("Sigma des niveaux (>= %.1f)   : ",MIN_SIGMA_RANGE);
+      if (scanf("%lf",&sigma_range) != 1)
+         sigma_range = -1.;
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("BilateralGrid");
+      if (BilateralGrid(pool,sigma_space,sigma_range,channel_number,
+                        origin_image,processed_image,nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute the bilateral filter.\n");
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
    }
-/******************************************************************************/
-/* Transfer image into the "processed" frame buffer                           */
-/******************************************************************************/
-   if (InitFrameBuffer(channel_number,processed_image,nliin,npxin,bytes_per_rgb,
-                       red_colormap_entries,red_offset,
-                       green_colormap_entries,green_offset,
-                       blue_colormap_entries,blue_offset,
-                       processed_frame_buffer) != 0)
+   else if (iconvol > CONVOL_NUMBER+6)
    {
-      fprintf (stderr,
-      "skelet : Cannot transfer processed image in frame buffer.\n");
-      return (1);
+/*----------------------------------------------------------------------------*/
+/*    Morphology with a rectangle: same cost whatever its size                */
+/*----------------------------------------------------------------------------*/
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Largeur et hauteur (impaires): ");
+      if (scanf("%d %d",&width,&height) != 2)
+         width = -1;
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("Morphology");
+      if (Morphology(pool,iconvol-CONVOL_NUMBER-7,width,height,channel_number,
+                     origin_image,processed_image,nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute the morphology.\n");
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
    }
-/******************************************************************************/
-/* Allocate memory for the XImage structures                                  */
-/******************************************************************************/
-   visual = visual_info.visual;
-   if (((origin_ximage=XCreateImage(display,visual,required_depth,ZPixmap,0,
-         (char*)origin_frame_buffer,npxin,nliin,32,0)) == NULL)               ||
-       ((processed_ximage=XCreateImage(display,visual,required_depth,ZPixmap,0,
-         (char*)processed_frame_buffer,npxin,nliin,32,0)) == NULL))
+   else if (iconvol == CONVOL_NUMBER+6)
    {
-      fprintf (stderr,
-         "skelet : cannot allocate ximage structures\n");
-      exit (1);
-   }
-/******************************************************************************/
-/* Create a window                                                            */
-/******************************************************************************/
-/* Create and install a colormap for the selected visual                      */
 /*----------------------------------------------------------------------------*/
-   if ((colormap=XCreateColormap(display,RootWindow(display,screen),visual,
-        AllocNone)) == None)
-   {
-      fprintf (stderr,"skelet : Cannot create a colormap.\n");
-      exit (1);
+/*    Rank filter: same cost whatever the radius                              */
+/*----------------------------------------------------------------------------*/
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Rayon de la fenetre (<= %d) : ",MAX_RANK_RADIUS);
+      if (scanf("%d",&radius) != 1)
+         radius = -1;
+      printf ("Percentile (0 a 100)         : ");
+      if (scanf("%lf",&percentile) != 1)
+         percentile = -1.;
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("RankFilter");
+      if (RankFilter(pool,radius,percentile,channel_number,origin_image,
+                     processed_image,nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute the rank filter.\n");
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
    }
-   XInstallColormap (display,colormap);
+   else if (iconvol == CONVOL_NUMBER+5)
+   {
 /*----------------------------------------------------------------------------*/
-/* Set window attributes for the window creation                              */
+/*    Recursive Gauss filter: same cost whatever sigma                        */
 /*----------------------------------------------------------------------------*/
-   window_attributes.colormap     = colormap;
-   window_attributes.border_pixel = 1;
+      SeparateOutput (&in_place,&origin,&processed);
+      printf ("Ecart type sigma (>= %.1f)   : ",MIN_IIR_SIGMA);
+      if (scanf("%lf",&sigma) != 1)
+         sigma = -1.;
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("IirGauss");
+      if (IirGauss(pool,sigma,channel_number,origin_image,processed_image,
+                   nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute the recursive Gauss.\n");
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
+   }
+   else if (iconvol > CONVOL_NUMBER+1)
+   {
 /*----------------------------------------------------------------------------*/
-/* Create the window                                                          */
+/*    Sobel bank: the W-E, N-S and NW-SE responses are computed in one pass,  */
+/*    the magnitude or the direction is displayed                             */
 /*----------------------------------------------------------------------------*/
-   if ((window=XCreateWindow (
-           display,                     /* connection to X server */
-           RootWindow(display,screen),  /* parent window */
-           0,0,                         /* coord.of UL corner in parent window*/
-           2*npxin,nliin,               /* width/height of window */
-           1,                           /* border width */
-           required_depth,              /* depth of window in bits */
-           InputOutput,                 /* class of this window */
-           visual,                      /* visual to be used for the window */
-           CWBorderPixel | CWColormap,  /* value mask within window_attributes*/
-           &window_attributes)) == 0)
+      SeparateOutput (&in_place,&origin,&processed);
+      if (BankSobel(&bank) != 0)
+      {
+         fprintf (stderr,"skelet : Sobel matrices not found.\n");
+         exit (1);
+      }
+      for (ibank=0; ibank<bank.convol_number; ibank++)
+      {
+         for (ichannel=0; ichannel<channel_number; ichannel++)
+         {
+            if ((response[ibank][ichannel]=(unsigned char*)malloc(npxin*
+                 nliin*sizeof(char))) == NULL)
+            {
+               fprintf (stderr,
+                  "skelet : Cannot allocate memory for image arrays.\n");
+               exit (1);
+            }
+         }
+      }
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("FilterBank");
+      if (FilterBank(pool,&bank,channel_number,origin_image,response,
+             (iconvol == CONVOL_NUMBER+2 ? processed_image : NULL),
+             (iconvol == CONVOL_NUMBER+3 ? processed_image : NULL),
+             nliin,npxin) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute the Sobel bank.\n");
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
+      for (ibank=0; ibank<bank.convol_number; ibank++)
+         for (ichannel=0; ichannel<channel_number; ichannel++)
+            free (response[ibank][ichannel]);
+   }
+   if (iconvol == CONVOL_NUMBER+1)
    {
-      fprintf (stderr,"skelet : Cannot create the window \n");
-      exit (1);
+      printf ("Taille N de la matrice       : ");
+      if ((scanf("%d",&size) != 1) || (ConvolGauss(size,&convol) != 0))
+      {
+         fprintf (stderr,"skelet : cannot build a Gauss matrix.\n");
+         exit (1);
+      }
    }
 /*----------------------------------------------------------------------------*/
-/* Set window title                                                           */
+/* Compute the processed image, channels and bands of lines in parallel, with */
+/* the cheapest of the direct, separable and FFT methods (in place: the       */
+/* direct method, as a pipeline of one stage). The direct method runs on a    */
+/* copy of the origin with guards and a processed image of padded lines       */
+/* (ConvolutionImage): no scalar tail, same output as ConvolutionApply().     */
 /*----------------------------------------------------------------------------*/
-   strcpy (window_title,"- ");
-   for (ichannel=0; ichannel<channel_number; ichannel++)
+   if ((iconvol <= CONVOL_NUMBER+1) && in_place)
    {
-      strcpy (window_title,file_name[ichannel]);
-      strcpy (window_title," -");
+      PipelineInit (&pipeline);
+      istage = PipelineConvol (&pipeline,PIPE_INPUT,&convol);
+      if (!PipelineInPlace(&pipeline))
+         SeparateOutput (&in_place,&origin,&processed);
+      printf ("%s : methode %s%s\n",convol.name,
+         CONVOL_METHOD_NAME[CONVOL_DIRECT],(in_place ? ", en place" : ""));
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("PipelineApply");
+      if ((istage == PIPE_ERROR)                                              ||
+          (PipelineApply(pool,&pipeline,channel_number,origin_image,
+                         processed_image,nliin,npxin) != 0))
+      {
+         fprintf (stderr,"skelet : Cannot compute \"%s\".\n",convol.name);
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PipelineRelease (&pipeline);
+      PoolDestroy (pool);
    }
-   XStoreName (display,window,window_title);
-/*----------------------------------------------------------------------------*/
-/* Select events that will be received by window                              */
-/*----------------------------------------------------------------------------*/
-   XSelectInput (display,window,ExposureMask | ButtonPressMask);
-/*----------------------------------------------------------------------------*/
-/* Display the window                                                         */
-/*----------------------------------------------------------------------------*/
-   XMapWindow (display,window);
-/******************************************************************************/
-/* Get graphic context                                                        */
-/******************************************************************************/
-   gc = DefaultGC(display,screen);
-   gc = XCreateGC(display,window,0L,&GC_values);
-/******************************************************************************/
-/* Events loop                                                                */
-/******************************************************************************/
-   while (True)
+   else if ((iconvol <= CONVOL_NUMBER+1)                                    &&
+            (ConvolutionMethod(&convol,nliin,npxin,NULL) == CONVOL_DIRECT))
    {
-/*----------------------------------------------------------------------------*/
-/*    Get next event                                                          */
-/*----------------------------------------------------------------------------*/
-      XNextEvent (display,&event);
-      switch (event.type) {
-/*----------------------------------------------------------------------------*/
-/*       Expose => send image into the window                                 */
-/*----------------------------------------------------------------------------*/
-         case Expose:
-            XPutImage (display,window,gc,origin_ximage,
-                       0,0,0,0,npxin,nliin);
-            XPutImage (display,window,gc,processed_ximage,
-                       0,0,npxin,0,npxin,nliin);
-            break;
-/*----------------------------------------------------------------------------*/
-/*       ButtonPress => close display and exit application                    */
-/*----------------------------------------------------------------------------*/
-         case ButtonPress:
-            XCloseDisplay (display);
-            exit (0);
-/*----------------------------------------------------------------------------*/
-/*       Any other event is not processed                                     */
-/*----------------------------------------------------------------------------*/
-         default:
-            break;
+      printf ("%s : methode %s, lignes alignees\n",convol.name,
+         CONVOL_METHOD_NAME[CONVOL_DIRECT]);
+      ImageFree (&processed);
+      if ((ImageAllocGuard(&guarded,channel_number,nliin,npxin,
+                           convol.size/2) != 0)                               ||
+          (ImageAllocGuard(&processed,channel_number,nliin,npxin,0) != 0))
+      {
+         fprintf (stderr,
+            "skelet : Cannot allocate memory for image arrays.\n");
+         exit (1);
       }
-   } /* event loop */
-} /* Application core */
-
-
-
-/******************************************************************************/
-/* InitFrameBuffer initializes the frame buffer from the entire image provided*/
-/* in input.                                                                  */
-/******************************************************************************/
-int InitFrameBuffer (
-   int              channel_number,     /* number of channels (1 or 3) */
-   unsigned char    *image_buffer[3],   /* image array: ORIGIN or PROCESSED */
-   int              nliin,              /* input line number */
-   int              npxin,              /* input pixel number */
-   int              bytes_per_rgb,       /* bytes nb.per RGB pixel in frame bu*/
-   int              red_colormap_entries, /* nb.of possible values for Red */
-   int              red_offset,         /* left offset to match the Red mask*/
-   int              green_colormap_entries, /* nb.of possible values for Green*/
-   int              green_offset,       /* left offset to match the Green mask*/
-   int              blue_colormap_entries, /* nb.of possible values for Blue */
-   int              blue_offset,        /* left offset to match the Blue mask*/
-   unsigned char    *frame_buffer)      /* frame buffer to be initialized */
-{
-/******************************************************************************/
-/* Local variables                                                            */
-/******************************************************************************/
-   int              ili;                /* index among lines */
-   int              ipx;                /* index among pixels */
-   int              icolor_rgb;         /* color value for compound RGB values*/
-   unsigned char    byte_order[4];      /* used to check byte order in int */
-   int              int_MSB_first;      /* "Most Significant Byte first in
-                                           integer representation" flag */
-   int              icolor_red;         /* color value for component red */
-   int              icolor_green;       /* color value for component green */
-   int              icolor_blue;        /* color value for component blue */
-
-/******************************************************************************/
-/* Initialise the frame buffer                                                */
-/******************************************************************************/
-/* Analyze order inside an integer                                            */
-/*----------------------------------------------------------------------------*/
-   icolor_rgb = 0x01020304;
-   memcpy (byte_order,&icolor_rgb,4);
-   if (byte_order[0] == 0x01)
-      int_MSB_first = True;
-   else
-      int_MSB_first = False;
-/*============================================================================*/
-/* Initialize origin frame buffer                                             */
-/*============================================================================*/
-/* Loop on lines                                                              */
-/*----------------------------------------------------------------------------*/
-   for (ili=0; ili<nliin; ili++)
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("ImageExtend");
+      ImageCopy (&origin,&guarded);
+      ImageExtend (&guarded);
+      ProfileEnd (ievent,pixel_number,byte_number);
+      ievent = ProfileBegin ("ConvolutionImage");
+      if (ConvolutionImage(pool,&convol,&guarded,&processed) != 0)
+      {
+         fprintf (stderr,"skelet : Cannot compute \"%s\".\n",convol.name);
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
+      ImageFree (&guarded);
+   }
+   else if (iconvol <= CONVOL_NUMBER+1)
    {
-/*----------------------------------------------------------------------------*/
-/*    Interleave Red, Green and Blue components into frame buffer             */
-/*----------------------------------------------------------------------------*/
-      for (ipx=0; ipx<npxin; ipx++)
+      method = ConvolutionMethod (&convol,nliin,npxin,NULL);
+      printf ("%s : methode %s\n",convol.name,CONVOL_METHOD_NAME[method]);
+      pool = PoolCreate (0);
+      ievent = ProfileBegin ("ConvolutionApply");
+      if (ConvolutionApply(pool,&convol,CONVOL_AUTO,channel_number,
+                           origin_image,processed_image,nliin,npxin) != 0)
       {
-         if (channel_number == 3)
-         {
-            icolor_red   = image_buffer[0][ili*npxin+ipx];
-            icolor_green = image_buffer[1][ili*npxin+ipx];
-            icolor_blue  = image_buffer[2][ili*npxin+ipx];
-         }
-         else
-         {
-            icolor_red   = image_buffer[0][ili*npxin+ipx];
-            icolor_green = icolor_red;
-            icolor_blue  = icolor_red;
-         }
-/*----------------------------------------------------------------------------*/
-/*       Set RGB values according to their colormap entries                   */
-/*----------------------------------------------------------------------------*/
-         icolor_red   = nint((float)red_colormap_entries  * icolor_red   / 256);
-         if (icolor_red >= red_colormap_entries)
-            icolor_red = red_colormap_entries - 1;
-         icolor_green = nint((float)green_colormap_entries* icolor_green / 256);
-         if (icolor_green >= green_colormap_entries)
-            icolor_green = green_colormap_entries - 1;
-         icolor_blue  = nint((float)blue_colormap_entries * icolor_blue  / 256);
-         if (icolor_blue >= blue_colormap_entries)
-            icolor_blue = blue_colormap_entries - 1;
-/*----------------------------------------------------------------------------*/
-/*       Combine the three components according to their masks                */
-/*----------------------------------------------------------------------------*/
-         icolor_rgb   = (icolor_red   << red_offset)    |
-                        (icolor_green << green_offset)  |
-                        (icolor_blue  << blue_offset);
-/*----------------------------------------------------------------------------*/
-/*       Report value in frame buffer                                         */
-/*----------------------------------------------------------------------------*/
-         if (int_MSB_first)
-         {
-            memcpy (&(frame_buffer[(ili*npxin+ipx)*bytes_per_rgb]),
-                 &(((unsigned char*)(&icolor_rgb))[sizeof(int)-bytes_per_rgb]),
-                 bytes_per_rgb);
-         }
-         else
-         {
-            memcpy (&(frame_buffer[(ili*npxin+ipx)*bytes_per_rgb]),
-                 &icolor_rgb,bytes_per_rgb);
-         }
-      } /* Loop on pixels */
-   } /* Loop on lines */
+         fprintf (stderr,"skelet : Cannot compute \"%s\".\n",convol.name);
+         exit (1);
+      }
+      ProfileEnd (ievent,pixel_number,byte_number);
+      PoolDestroy (pool);
+   }
+/******************************************************************************/
 /******************************************************************************/
-/* Return "Ok" status                                                         */
+/* Display the origin and processed images until a button is pressed, then    */
+/* the profile (also when the display failed: load and operator are timed)    */
 /******************************************************************************/
-   return (0);
-} /* InitFrameBuffer */
+   status = DisplayImages (window_title,&origin,&processed);
+   ProfileReport (stdout);
+   if ((trace_file != NULL) && (ProfileTrace(trace_file) != 0))
+      exit (1);
+   if (status != 0)
+   {
+      fprintf (stderr,"skelet : Cannot display the images.\n");
+      exit (1);
+   }
+   if (processed.buffer != origin.buffer)
+      ImageFree (&processed);
+   ImageFree (&origin);
+   if (iconvol == CONVOL_NUMBER+1)
+      free (convol.coeff);
+   exit (0);
+} /* Application core */
@@ -0,0 +1,173 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* arena places the intermediate buffers of a multi-step treatment in one     */
+/* allocation, buffers whose lifetimes do not overlap sharing their bytes.    */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A treatment run as steps 0, 1, 2 ... first requests its buffers, each with */
+/* its size and the steps [first,last] during which it is written or read:    */
+/*    ArenaReset (&arena);                                                    */
+/*    for each intermediate i: buffer[i] = ArenaRequest (&arena,size,         */
+/*                                                 step writing i,            */
+/*                                                 last step reading i);      */
+/*    ArenaPlan (&arena);                                                     */
+/*    ... ArenaBuffer (&arena,buffer[i]) ...                                  */
+/* ArenaPlan() gives every buffer an offset in one block such that two        */
+/* buffers live at the same step never overlap. Buffers are placed from the   */
+/* largest, each at the lowest offset free during its lifetime. A chain of N  */
+/* steps thus needs 2 buffers whatever N, where allocating every step needs   */
+/* N. peak is the size of the block, total the sum of the sizes.              */
+/*                                                                            */
+/* The block is only reallocated when it grows: a treatment run again on      */
+/* images of the same size (batch mode) does not call the allocator.          */
+/* Buffers start on IMAGE_ALIGN boundaries.                                   */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "arena.h"
+#include  "image.h"
+
+/******************************************************************************/
+/* ArenaInit initializes an empty arena, without block.                       */
+/******************************************************************************/
+void ArenaInit (
+   type_arena       *arena)             /* arena to be initialized */
+{
+   memset (arena,0,sizeof(type_arena));
+} /* ArenaInit */
+
+/******************************************************************************/
+/* ArenaReset forgets the requested buffers and keeps the block, for the next */
+/* run.                                                                       */
+/******************************************************************************/
+void ArenaReset (
+   type_arena       *arena)             /* arena to be reset */
+{
+   arena->buffer_number = 0;
+   arena->total         = 0;
+   arena->peak          = 0;
+} /* ArenaReset */
+
+/******************************************************************************/
+/* ArenaRequest requests a buffer of size bytes used from step first to step  */
+/* last (included). Returns the index of the buffer, or -1 if the arena is    */
+/* full or the steps are wrong.                                               */
+/******************************************************************************/
+int ArenaRequest (
+   type_arena       *arena,             /* arena being planned */
+   size_t           size,               /* bytes of the buffer */
+   int              first,              /* first step using the buffer */
+   int              last)               /* last step using the buffer */
+{
+   int              ibuffer;            /* index of the new buffer */
+
+   if ((arena->buffer_number >= MAX_ARENA_BUFFER) || (last < first))
+      return (-1);
+   ibuffer = arena->buffer_number;
+   arena->size[ibuffer]  = IMAGE_ROUND(size);
+   arena->first[ibuffer] = first;
+   arena->last[ibuffer]  = last;
+   arena->total          = arena->total + arena->size[ibuffer];
+   arena->buffer_number  = arena->buffer_number + 1;
+   return (ibuffer);
+} /* ArenaRequest */
+
+/******************************************************************************/
+/* ArenaPlan places the requested buffers, largest first, each at the lowest  */
+/* offset where it overlaps no buffer already placed and live at a common     */
+/* step, and (re)allocates the block if it is too small. Returns 1 if memory  */
+/* is lacking.                                                                */
+/******************************************************************************/
+int ArenaPlan (
+   type_arena       *arena)             /* arena to be planned */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              order[MAX_ARENA_BUFFER]; /* buffers, largest first */
+   int              iorder;             /* index among placed buffers */
+   int              jorder;             /* index among placed buffers */
+   int              ibuffer;            /* buffer being placed */
+   int              jbuffer;            /* buffer already placed */
+   int              moved;              /* "offset changed" flag */
+   size_t           offset;             /* candidate offset */
+
+/*----------------------------------------------------------------------------*/
+/* Largest buffers first (insertion sort: a few dozens of buffers)            */
+/*----------------------------------------------------------------------------*/
+   for (iorder=0; iorder<arena->buffer_number; iorder++)
+   {
+      for (jorder=iorder; (jorder > 0)                                       &&
+           (arena->size[order[jorder-1]] < arena->size[iorder]); jorder--)
+         order[jorder] = order[jorder-1];
+      order[jorder] = iorder;
+   }
+/*----------------------------------------------------------------------------*/
+/* Lowest free offset: moved above every conflicting buffer until none is     */
+/*----------------------------------------------------------------------------*/
+   arena->peak = 0;
+   for (iorder=0; iorder<arena->buffer_number; iorder++)
+   {
+      ibuffer = order[iorder];
+      offset  = 0;
+      do
+      {
+         moved = 0;
+         for (jorder=0; jorder<iorder; jorder++)
+         {
+            jbuffer = order[jorder];
+            if ((arena->first[jbuffer] <= arena->last[ibuffer])               &&
+                (arena->first[ibuffer] <= arena->last[jbuffer])               &&
+                (arena->offset[jbuffer] < offset + arena->size[ibuffer])      &&
+                (offset < arena->offset[jbuffer] + arena->size[jbuffer]))
+            {
+               offset = arena->offset[jbuffer] + arena->size[jbuffer];
+               moved  = 1;
+            }
+         }
+      } while (moved);
+      arena->offset[ibuffer] = offset;
+      if (arena->peak < offset + arena->size[ibuffer])
+         arena->peak = offset + arena->size[ibuffer];
+   }
+/*----------------------------------------------------------------------------*/
+/* Block grown only if needed                                                 */
+/*----------------------------------------------------------------------------*/
+   if (arena->peak > arena->capacity)
+   {
+      free (arena->block);
+      arena->capacity = 0;
+      if ((arena->block=malloc(arena->peak+IMAGE_ALIGN-1)) == NULL)
+         return (1);
+      arena->capacity = arena->peak;
+      arena->base     = (char*)arena->block + (IMAGE_ALIGN - 1);
+      arena->base     = arena->base - (size_t)arena->base % IMAGE_ALIGN;
+   }
+   return (0);
+} /* ArenaPlan */
+
+/******************************************************************************/
+/* ArenaBuffer returns the first byte of a planned buffer.                    */
+/******************************************************************************/
+void *ArenaBuffer (
+   type_arena       *arena,             /* planned arena */
+   int              ibuffer)            /* index of the buffer */
+{
+   return (arena->base + arena->offset[ibuffer]);
+} /* ArenaBuffer */
+
+/******************************************************************************/
+/* ArenaFree releases the block of the arena, which is left empty.            */
+/******************************************************************************/
+void ArenaFree (
+   type_arena       *arena)             /* arena to be released */
+{
+   free (arena->block);
+   ArenaInit (arena);
+} /* ArenaFree */
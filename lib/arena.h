@@ -0,0 +1,42 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* arena places the intermediate buffers of a multi-step treatment in one     */
+/* allocation, buffers whose lifetimes do not overlap sharing their bytes.    */
+/******************************************************************************/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include  <stddef.h>
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_ARENA_BUFFER 64             /* greatest number of buffers */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              buffer_number;      /* number of requested buffers */
+   size_t           size[MAX_ARENA_BUFFER];   /* bytes of each buffer */
+   int              first[MAX_ARENA_BUFFER];  /* first step using it */
+   int              last[MAX_ARENA_BUFFER];   /* last step using it */
+   size_t           offset[MAX_ARENA_BUFFER]; /* place in the block */
+   size_t           total;              /* bytes of all the buffers */
+   size_t           peak;               /* bytes of the block actually used */
+   size_t           capacity;           /* bytes allocated */
+   void             *block;             /* the allocation */
+   char             *base;              /* its first aligned byte */
+} type_arena;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+void ArenaInit (type_arena *arena);
+void ArenaReset (type_arena *arena);
+int ArenaRequest (type_arena *arena, size_t size, int first, int last);
+int ArenaPlan (type_arena *arena);
+void *ArenaBuffer (type_arena *arena, int ibuffer);
+void ArenaFree (type_arena *arena);
+
+#endif /* ARENA_H */
@@ -0,0 +1,515 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* bank applies a bank of 3x3 convolution matrices in a single pass over the  */
+/* image, with the gradient magnitude and quantized direction derived from a  */
+/* pair of them.                                                              */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Lines are processed by chunks of CHUNK pixels. The taps of every matrix    */
+/* are listed once per call (BankTaps): as ConvolutionFoldedLine() does, a    */
+/* symmetric or antisymmetric matrix multiplies the central sample, then the  */
+/* sum (difference) of the samples at (k,l) and (-k,-l) for each nonzero      */
+/* coefficient of its first half, i.e. 3 or 4 products for the Gradient and   */
+/* Sobel matrices instead of 9; other matrices multiply their nonzero         */
+/* coefficients only. The float vectors these taps read (neighbors, sums and  */
+/* differences of mirrored neighbors) are built once per chunk and shared by  */
+/* all the matrices: a directional family (Gradient and Sobel N-S, W-E,       */
+/* NW-SE) needs the 4 differences only. Each matrix then accumulates its taps */
+/* on the chunk, followed by the gain, offset and clipping of SaturateRow().  */
+/* Building and accumulating run through BankKernel, compiled once per CPU    */
+/* level (cpu.h) like the convolution kernels.                                */
+/* Products are added in the order of ConvolutionLine(): for matrices with    */
+/* integer coefficients the responses are identical to separate runs (the     */
+/* first product is stored instead of being added to 0, and a zero central    */
+/* coefficient is skipped: only the sign of a zero sum may change).           */
+/*                                                                            */
+/* When gradient_x and gradient_y designate a W-E and a N-S matrix, their     */
+/* raw sums gx and gy (before gain and offset) also give:                     */
+/* . magnitude = magnitude_gain * sqrt(gx^2 + gy^2), clipped to [0,255];      */
+/* . direction = one of DIRECTION_W_E ... DIRECTION_NE_SW (gradient modulo    */
+/*   180 degrees, sectors of 45 degrees), stored as direction << 6 so that    */
+/*   the direction image can be displayed as is.                              */
+/* Border pixels keep their origin value in the responses and are set to 0 in */
+/* the magnitude and direction images.                                        */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "bank.h"
+#include  "cpu.h"
+#include  "saturate.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define CHUNK       256                 /* pixels processed per chunk */
+#define TAN_22_5    0.41421356f         /* tan(22.5 degrees) */
+#define TAN_67_5    2.41421356f         /* tan(67.5 degrees) */
+
+#define BANK_LOAD       0               /* operations of BankKernel */
+#define BANK_SUM        1
+#define BANK_DIFFERENCE 2
+#define BANK_SET        3
+#define BANK_ADD        4
+#define BANK_FUSED      4               /* products per accumulating pass */
+
+#define VECTOR_SUM        9             /* vectors of a chunk: 9 neighbors, */
+#define VECTOR_DIFFERENCE 13            /* then 4 sums and 4 differences of */
+#define VECTOR_NUMBER     17            /* mirrored neighbors */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   type_bank        *bank;              /* bank to be applied */
+   unsigned char    **image_in;         /* input image arrays */
+   unsigned char    *(*response)[3];    /* response arrays [matrix][channel] */
+   unsigned char    **magnitude;        /* magnitude arrays, or NULL */
+   unsigned char    **direction;        /* direction arrays, or NULL */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a band */
+} type_bank_job;
+
+typedef struct {
+   int              tap_number;         /* number of products */
+   int              vector[9];          /* vector read by each product */
+   float            coeff[9];           /* coefficient of each product */
+} type_bank_taps;
+
+typedef void (*type_bank_kernel) (int operation, float *output_row,
+   unsigned char *input_row, unsigned char *mirror_row, int tap_number,
+   float *vector[], float coeff[], int n);
+
+/******************************************************************************/
+/* GradientDirection quantizes the direction of the gradient (gx,gy) modulo   */
+/* 180 degrees into DIRECTION_W_E ... DIRECTION_NE_SW (sectors of 45          */
+/* degrees). gx and gy have the same sign along the NW-SE diagonal.           */
+/******************************************************************************/
+int GradientDirection (
+   float            gx,                 /* W-E gradient */
+   float            gy)                 /* N-S gradient */
+{
+   float            ax;                 /* |gx| */
+   float            ay;                 /* |gy| */
+
+   ax = fabsf (gx);
+   ay = fabsf (gy);
+   if (ay <= TAN_22_5 * ax)
+      return (DIRECTION_W_E);
+   if (ay >= TAN_67_5 * ax)
+      return (DIRECTION_N_S);
+   if ((gx > 0) == (gy > 0))
+      return (DIRECTION_NW_SE);
+   return (DIRECTION_NE_SW);
+} /* GradientDirection */
+
+/******************************************************************************/
+/* BankAdd appends a 3x3 matrix to the bank. Returns its index, or -1 if the  */
+/* bank is full or the matrix is not 3x3.                                     */
+/******************************************************************************/
+int BankAdd (
+   type_bank        *bank,              /* bank being built */
+   type_convol      *convol)            /* matrix to be appended */
+{
+   if ((convol == NULL) || (convol->size != 3) ||
+       (bank->convol_number >= MAX_BANK))
+      return (-1);
+   bank->convol[bank->convol_number] = convol;
+   bank->convol_number = bank->convol_number + 1;
+   return (bank->convol_number - 1);
+} /* BankAdd */
+
+/******************************************************************************/
+/* BankSobel initializes the bank with the Sobel W-E, N-S and NW-SE matrices  */
+/* of CONVOL[], the first two giving the magnitude and the direction.         */
+/******************************************************************************/
+int BankSobel (
+   type_bank        *bank)              /* bank to be initialized */
+{
+   bank->convol_number  = 0;
+   bank->gradient_x     = BankAdd (bank,ConvolFind("Sobel 3x3 W-E"));
+   bank->gradient_y     = BankAdd (bank,ConvolFind("Sobel 3x3 N-S"));
+   bank->magnitude_gain = 0.25;
+   if ((bank->gradient_x < 0) || (bank->gradient_y < 0)                      ||
+       (BankAdd(bank,ConvolFind("Sobel 3x3 NW-SE")) < 0))
+      return (1);
+   return (0);
+} /* BankSobel */
+
+/******************************************************************************/
+/* BankKernel builds a vector of the chunk from byte samples, or accumulates  */
+/* up to BANK_FUSED products in the raw sums of a matrix in a single pass,    */
+/* according to operation:                                                    */
+/*    BANK_LOAD       out = in                                                */
+/*    BANK_SUM        out = in + mirror                                       */
+/*    BANK_DIFFERENCE out = in - mirror                                       */
+/*    BANK_SET        out = coeff[0] * vector[0] + coeff[1] * vector[1] + ... */
+/*    BANK_ADD        out = out + coeff[0] * vector[0] + ...                  */
+/* Sums and differences of bytes are exact in float: each product is the one */
+/* of ConvolutionBytesKernel(), and they are added from left to right.        */
+/******************************************************************************/
+static CPU_INLINE void BankKernel (
+   int              operation,          /* BANK_LOAD ... BANK_ADD */
+   float            *output_row,        /* built or accumulated values */
+   unsigned char    *input_row,         /* input samples */
+   unsigned char    *mirror_row,        /* mirrored input samples */
+   int              tap_number,         /* number of products (1 ... 4) */
+   float            *vector[BANK_FUSED],/* vectors of the products */
+   float            coeff[BANK_FUSED],  /* coefficients of the products */
+   int              n)                  /* number of samples */
+{
+   float            *v0, *v1, *v2, *v3; /* vectors of the products */
+   float            c0, c1, c2, c3;     /* coefficients of the products */
+   int              i;                  /* index in the chunk */
+
+   switch (operation)
+   {
+      case BANK_LOAD:
+         for (i=0; i<n; i++)
+            output_row[i] = input_row[i];
+         return;
+      case BANK_SUM:
+         for (i=0; i<n; i++)
+            output_row[i] = input_row[i] + mirror_row[i];
+         return;
+      case BANK_DIFFERENCE:
+         for (i=0; i<n; i++)
+            output_row[i] = input_row[i] - mirror_row[i];
+         return;
+   }
+   v0 = vector[0];  c0 = coeff[0];
+   v1 = vector[1];  c1 = coeff[1];
+   v2 = vector[2];  c2 = coeff[2];
+   v3 = vector[3];  c3 = coeff[3];
+   if (operation == BANK_SET)
+      switch (tap_number)
+      {
+         case 1:
+            for (i=0; i<n; i++)
+               output_row[i] = c0 * v0[i];
+            break;
+         case 2:
+            for (i=0; i<n; i++)
+               output_row[i] = c0 * v0[i] + c1 * v1[i];
+            break;
+         case 3:
+            for (i=0; i<n; i++)
+               output_row[i] = c0 * v0[i] + c1 * v1[i] + c2 * v2[i];
+            break;
+         default:
+            for (i=0; i<n; i++)
+               output_row[i] = c0 * v0[i] + c1 * v1[i] + c2 * v2[i] +
+                               c3 * v3[i];
+      }
+   else
+      switch (tap_number)
+      {
+         case 1:
+            for (i=0; i<n; i++)
+               output_row[i] = output_row[i] + c0 * v0[i];
+            break;
+         case 2:
+            for (i=0; i<n; i++)
+               output_row[i] = output_row[i] + c0 * v0[i] + c1 * v1[i];
+            break;
+         case 3:
+            for (i=0; i<n; i++)
+               output_row[i] = output_row[i] + c0 * v0[i] + c1 * v1[i] +
+                               c2 * v2[i];
+            break;
+         default:
+            for (i=0; i<n; i++)
+               output_row[i] = output_row[i] + c0 * v0[i] + c1 * v1[i] +
+                               c2 * v2[i] + c3 * v3[i];
+      }
+} /* BankKernel */
+
+/******************************************************************************/
+/* Variants of the kernel, one per CPU level (cpu.h), and their table         */
+/******************************************************************************/
+#define BANK_VARIANT(name,target)                                              \
+static target void name (int operation, float *output_row,                     \
+                         unsigned char *input_row, unsigned char *mirror_row,  \
+                         int tap_number, float *vector[], float coeff[],       \
+                         int n)                                                \
+{                                                                              \
+   BankKernel (operation,output_row,input_row,mirror_row,tap_number,vector,    \
+               coeff,n);                                                       \
+}
+
+BANK_VARIANT (BankScalar,CPU_TARGET_SCALAR)
+BANK_VARIANT (BankSse42,CPU_TARGET_SSE42)
+BANK_VARIANT (BankAvx2,CPU_TARGET_AVX2)
+BANK_VARIANT (BankAvx512,CPU_TARGET_AVX512)
+
+static type_bank_kernel BANK_KERNEL[CPU_LEVEL_NUMBER] = {
+   BankScalar, BankSse42, BankAvx2, BankAvx512 };
+
+/******************************************************************************/
+/* BankTaps lists the products of a 3x3 matrix in the order of                */
+/* ConvolutionLine(), and marks the vectors they read in used[].              */
+/******************************************************************************/
+static void BankTaps (
+   type_convol      *convol,            /* matrix of the bank */
+   type_bank_taps   *taps,              /* products of the matrix */
+   int              used[VECTOR_NUMBER])/* vectors read by the bank */
+{
+   int              folded;             /* first folded vector, 0 if none */
+   int              k;                  /* index among coefficients */
+
+   folded = 0;
+   if (ConvolProperties(convol) & CONVOL_IS_SYMMETRIC)
+      folded = VECTOR_SUM;
+   else if (ConvolProperties(convol) & CONVOL_IS_ANTISYMMETRIC)
+      folded = VECTOR_DIFFERENCE;
+   taps->tap_number = 0;
+   if (folded && (convol->coeff[4] != 0.0))
+   {
+      taps->vector[0]  = 4;
+      taps->coeff[0]   = convol->coeff[4];
+      taps->tap_number = 1;
+   }
+   for (k=0; k<(folded ? 4 : 9); k++)
+   {
+      if (convol->coeff[k] == 0.0)
+         continue;
+      taps->vector[taps->tap_number] = folded + k;
+      taps->coeff[taps->tap_number]  = convol->coeff[k];
+      taps->tap_number               = taps->tap_number + 1;
+   }
+   for (k=0; k<taps->tap_number; k++)
+      used[taps->vector[k]] = 1;
+} /* BankTaps */
+
+/******************************************************************************/
+/* FilterBankRows applies the bank on lines [ili_first,ili_last[ of one       */
+/* channel. response[i] receives matrix i; magnitude and direction may be     */
+/* NULL, and are ignored if the bank has no gradient pair.                    */
+/******************************************************************************/
+int FilterBankRows (
+   type_bank        *bank,              /* bank to be applied */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *response[MAX_BANK],/* output arrays, one per matrix */
+   unsigned char    *magnitude,         /* magnitude array, or NULL */
+   unsigned char    *direction,         /* direction array, or NULL */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   float            vector[VECTOR_NUMBER][CHUNK]; /* vectors of the chunk */
+   float            sum[MAX_BANK][CHUNK]; /* raw sums of the matrices */
+   float            norm[CHUNK];        /* raw magnitudes of the gradient */
+   type_bank_taps   taps[MAX_BANK];     /* products of the matrices */
+   int              used[VECTOR_NUMBER];/* vectors read by the bank */
+   type_bank_kernel kernel;             /* variant of BankKernel */
+   int              gradient;           /* "magnitude/direction wanted" flag */
+   int              ili;                /* index among lines */
+   int              ipx;                /* first pixel of the chunk */
+   int              npx;                /* number of pixels in the chunk */
+   int              i;                  /* index in the chunk */
+   int              k;                  /* index among neighbors */
+   int              itap;               /* index among products */
+   int              fused;              /* products of the current pass */
+   float            *tap_vector[BANK_FUSED]; /* vectors of the pass */
+   float            tap_coeff[BANK_FUSED]; /* coefficients of the pass */
+   int              iconvol;            /* index among matrices */
+   float            gain;               /* gain of the current output */
+   float            *accumulator;       /* raw sums of the current matrix */
+   float            *sum_x;             /* raw sums of the W-E matrix */
+   float            *sum_y;             /* raw sums of the N-S matrix */
+   unsigned char    *output_line;       /* output pixels of the chunk */
+   unsigned char    *input_row[9];      /* input line shifted by a neighbor */
+
+   memset (used,0,sizeof(used));
+   for (iconvol=0; iconvol<bank->convol_number; iconvol++)
+      BankTaps (bank->convol[iconvol],&(taps[iconvol]),used);
+   kernel = BANK_KERNEL[CpuLevel()];
+   gradient = (bank->gradient_x >= 0) && (bank->gradient_y >= 0);
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+/*----------------------------------------------------------------------------*/
+/*    Border lines and pixels                                                 */
+/*----------------------------------------------------------------------------*/
+      if ((ili < 1) || (ili >= nliin-1) || (npxin <= 2))
+      {
+         for (iconvol=0; iconvol<bank->convol_number; iconvol++)
+            memcpy (&(response[iconvol][ili*npxin]),&(image_in[ili*npxin]),
+                    npxin);
+         if (magnitude != NULL)
+            memset (&(magnitude[ili*npxin]),0,npxin);
+         if (direction != NULL)
+            memset (&(direction[ili*npxin]),0,npxin);
+         continue;
+      }
+      for (iconvol=0; iconvol<bank->convol_number; iconvol++)
+      {
+         response[iconvol][ili*npxin]         = image_in[ili*npxin];
+         response[iconvol][ili*npxin+npxin-1] = image_in[ili*npxin+npxin-1];
+      }
+      if (magnitude != NULL)
+      {
+         magnitude[ili*npxin]         = 0;
+         magnitude[ili*npxin+npxin-1] = 0;
+      }
+      if (direction != NULL)
+      {
+         direction[ili*npxin]         = 0;
+         direction[ili*npxin+npxin-1] = 0;
+      }
+/*============================================================================*/
+/*    Loop on chunks of pixels                                                */
+/*============================================================================*/
+      for (ipx=1; ipx<npxin-1; ipx=ipx+CHUNK)
+      {
+         npx = npxin - 1 - ipx;
+         if (npx > CHUNK)
+            npx = CHUNK;
+/*----------------------------------------------------------------------------*/
+/*       Vectors read by the bank, built once                                 */
+/*----------------------------------------------------------------------------*/
+         for (k=0; k<9; k++)
+            input_row[k] = &(image_in[(ili+k/3-1)*npxin+ipx+k%3-1]);
+         for (k=0; k<9; k++)
+            if (used[k])
+               kernel (BANK_LOAD,vector[k],input_row[k],NULL,0,NULL,NULL,npx);
+         for (k=0; k<4; k++)
+         {
+            if (used[VECTOR_SUM+k])
+               kernel (BANK_SUM,vector[VECTOR_SUM+k],input_row[k],
+                       input_row[8-k],0,NULL,NULL,npx);
+            if (used[VECTOR_DIFFERENCE+k])
+               kernel (BANK_DIFFERENCE,vector[VECTOR_DIFFERENCE+k],
+                       input_row[k],input_row[8-k],0,NULL,NULL,npx);
+         }
+/*----------------------------------------------------------------------------*/
+/*       Each matrix: its products accumulated on the chunk, then gain,       */
+/*       offset and clipping. Raw sums are kept for the gradient pair.        */
+/*----------------------------------------------------------------------------*/
+         for (iconvol=0; iconvol<bank->convol_number; iconvol++)
+         {
+            accumulator = sum[iconvol];
+            output_line = &(response[iconvol][ili*npxin+ipx]);
+            if (taps[iconvol].tap_number == 0)
+               memset (accumulator,0,npx*sizeof(float));
+            for (itap=0; itap<taps[iconvol].tap_number; itap=itap+BANK_FUSED)
+            {
+               fused = taps[iconvol].tap_number - itap;
+               if (fused > BANK_FUSED)
+                  fused = BANK_FUSED;
+               for (k=0; k<BANK_FUSED; k++)   /* unused ones: any product */
+               {
+                  tap_vector[k] = vector[taps[iconvol].vector[itap+k%fused]];
+                  tap_coeff[k]  = taps[iconvol].coeff[itap+k%fused];
+               }
+               kernel ((itap == 0 ? BANK_SET : BANK_ADD),accumulator,NULL,
+                       NULL,fused,tap_vector,tap_coeff,npx);
+            }
+            SaturateRow (accumulator,output_line,npx,
+                         bank->convol[iconvol]->gain,
+                         bank->convol[iconvol]->offset);
+         }
+/*----------------------------------------------------------------------------*/
+/*       Magnitude and quantized direction of the gradient                    */
+/*----------------------------------------------------------------------------*/
+         if (gradient)
+         {
+            sum_x = sum[bank->gradient_x];
+            sum_y = sum[bank->gradient_y];
+            gain  = bank->magnitude_gain;
+         }
+         if (gradient && (magnitude != NULL))
+         {
+            output_line = &(magnitude[ili*npxin+ipx]);
+            for (i=0; i<npx; i++)
+               norm[i] = sqrtf (sum_x[i]*sum_x[i] + sum_y[i]*sum_y[i]);
+            SaturateRow (norm,output_line,npx,gain,0.f);
+         }
+         if (gradient && (direction != NULL))
+         {
+            output_line = &(direction[ili*npxin+ipx]);
+            for (i=0; i<npx; i++)
+               output_line[i] = (unsigned char)
+                  (GradientDirection(sum_x[i],sum_y[i]) << DIRECTION_SHIFT);
+         }
+      } /* Loop on chunks */
+   } /* Loop on lines */
+   return (0);
+} /* FilterBankRows */
+
+/******************************************************************************/
+/* FilterBankBand is the pool task computing one (channel,band) pair.         */
+/******************************************************************************/
+static void FilterBankBand (
+   void             *argument,          /* type_bank_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_bank_job    *job;               /* job the task belongs to */
+   unsigned char    *response[MAX_BANK];/* response arrays of the channel */
+   int              ichannel;           /* channel of the band */
+   int              iconvol;            /* index among matrices */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+
+   job       = (type_bank_job*)argument;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   for (iconvol=0; iconvol<job->bank->convol_number; iconvol++)
+      response[iconvol] = job->response[iconvol][ichannel];
+   if (FilterBankRows(job->bank,job->image_in[ichannel],response,
+          (job->magnitude == NULL ? NULL : job->magnitude[ichannel]),
+          (job->direction == NULL ? NULL : job->direction[ichannel]),
+          job->nliin,job->npxin,ili_first,ili_last) != 0)
+      job->status = 1;
+} /* FilterBankBand */
+
+/******************************************************************************/
+/* FilterBank applies the bank on all the channels, bands of lines being run  */
+/* concurrently on the thread pool. response[i][channel] receives matrix i.   */
+/******************************************************************************/
+int FilterBank (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_bank        *bank,              /* bank to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *response[MAX_BANK][3], /* output arrays */
+   unsigned char    *magnitude[3],      /* magnitude arrays, or NULL */
+   unsigned char    *direction[3],      /* direction arrays, or NULL */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_bank_job    job;                /* job shared by all the bands */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   job.bank        = bank;
+   job.image_in    = image_in;
+   job.response    = response;
+   job.magnitude   = magnitude;
+   job.direction   = direction;
+   job.nliin       = nliin;
+   job.npxin       = npxin;
+   job.status      = 0;
+   job.band_number = 4 * PoolThreadNumber (pool);
+   if (job.band_number > nliin)
+      job.band_number = nliin;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+   PoolRun (pool,channel_number*job.band_number,FilterBankBand,&job);
+   return (job.status);
+} /* FilterBank */
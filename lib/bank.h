@@ -0,0 +1,51 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* bank applies a bank of 3x3 convolution matrices in a single pass over the  */
+/* image, with the gradient magnitude and quantized direction derived from a  */
+/* pair of them.                                                              */
+/******************************************************************************/
+#ifndef BANK_H
+#define BANK_H
+
+#include  "pool.h"
+#include  "convol.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_BANK    8                   /* greatest number of matrices */
+
+#define DIRECTION_W_E    0              /* gradient along lines (vertical edge)*/
+#define DIRECTION_NW_SE  1              /* gradient along the NW-SE diagonal */
+#define DIRECTION_N_S    2              /* gradient along columns */
+#define DIRECTION_NE_SW  3              /* gradient along the NE-SW diagonal */
+#define DIRECTION_SHIFT  6              /* direction gray level = dir << shift*/
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              convol_number;      /* number of matrices in the bank */
+   type_convol      *convol[MAX_BANK];  /* 3x3 matrices of the bank */
+   int              gradient_x;         /* index of the W-E matrix, or -1 */
+   int              gradient_y;         /* index of the N-S matrix, or -1 */
+   float            magnitude_gain;     /* factor applied on the magnitude */
+} type_bank;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int GradientDirection (float gx, float gy);
+int BankAdd (type_bank *bank, type_convol *convol);
+int BankSobel (type_bank *bank);
+int FilterBankRows (type_bank *bank, unsigned char *image_in,
+                    unsigned char *response[MAX_BANK],
+                    unsigned char *magnitude, unsigned char *direction,
+                    int nliin, int npxin, int ili_first, int ili_last);
+int FilterBank (type_pool *pool, type_bank *bank, int channel_number,
+                unsigned char *image_in[3],
+                unsigned char *response[MAX_BANK][3],
+                unsigned char *magnitude[3], unsigned char *direction[3],
+                int nliin, int npxin);
+
+#endif /* BANK_H */
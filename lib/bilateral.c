@@ -0,0 +1,553 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* bilateral applies the edge-preserving bilateral filter, through a          */
+/* downsampled bilateral grid or exactly (reference).                         */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* The bilateral filter averages the pixels of a neighborhood weighted by     */
+/* their distance in space AND in gray level:                                 */
+/*    out(p) = SUM(q) Gs(|p-q|) Gr(|in(p)-in(q)|) in(q) / SUM(q) Gs Gr        */
+/* with Gaussians of standard deviations sigma_space and sigma_range.         */
+/*                                                                            */
+/* BilateralExact() computes the sums over a (2R+1)^2 window, R = 2           */
+/* sigma_space: O(R^2) per pixel, it is the reference of the accuracy checks. */
+/*                                                                            */
+/* BilateralGrid() follows Chen, Paris and Durand (SIGGRAPH 2007): the image  */
+/* is seen as a surface in the 3-D space (line, pixel, gray level), sampled   */
+/* by a grid of cells of sigma_space x sigma_space x sigma_range:             */
+/* . splat: each pixel adds (in(p), 1) to the nearest cell;                   */
+/* . blur : the grid of (value, weight) pairs is convolved by [1 4 6 4 1]/16  */
+/*          along its three axes (a Gaussian of one cell);                    */
+/* . slice: the output is value / weight interpolated trilinearly in the      */
+/*          grid at (line, pixel, in(p)).                                     */
+/* The cost is O(1) per pixel plus O(grid), small for the usual sigmas        */
+/* (1024 x 1024 with sigma_space = sigma_range = 16: 68 x 68 x 20 cells).     */
+/* The grid is padded by two empty cells on every side for the blur.          */
+/*                                                                            */
+/* Supported parameters: sigma_space >= MIN_SIGMA_SPACE (1 pixel) and         */
+/* sigma_range >= MIN_SIGMA_RANGE (1 gray level). The grid of a channel holds */
+/* (nliin/sigma_space + 5) x (npxin/sigma_space + 5) x (255/sigma_range + 6)  */
+/* pairs of floats, that is more cells than pixels for small sigmas (1024 x   */
+/* 1024, sigma_space = 2, sigma_range = 16: 5 cells per pixel, 42 Mbytes),    */
+/* whereas the exact window shrinks. BilateralGrid() therefore estimates both */
+/* costs (BilateralUsesGrid(), in products of the exact window, calibrated by */
+/* bench_convol) and runs the exact filter when it is cheaper: for 1024 x     */
+/* 1024, below sigma_space = 2 with sigma_range = 16 and below sigma_space =  */
+/* 3 with sigma_range = 4. The grid stays within 1 gray level of the exact    */
+/* filter on average up to sigma_range = 32; beyond, the splat into the       */
+/* nearest cell blurs the edges (sigma_range = 64: up to 20 gray levels).     */
+/*                                                                            */
+/* Channels are filtered independently. With the grid, each channel builds    */
+/* and blurs its grid in one task, then bands of lines are sliced on the      */
+/* pool; the reference runs bands of lines on the pool. As for the            */
+/* convolutions, output values are truncated.                                 */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "bilateral.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+#define GRID_PAD    2                   /* empty cells on every side */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+#define COST_GRID_PIXEL 5.5             /* cost of the splat and slice of a
+                                           pixel, in products of the exact
+                                           window (calibrated by bench_convol)*/
+#define COST_GRID_CELL  6.0             /* cost of the blur of a cell */
+
+#define PHASE_GRID  0                   /* splat and blur, one task/channel */
+#define PHASE_SLICE 1                   /* slice, by bands of lines */
+#define PHASE_EXACT 2                   /* reference, by bands of lines */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              nz;                 /* cells along gray levels */
+   int              ny;                 /* cells along lines */
+   int              nx;                 /* cells along pixels */
+   float            *cell;              /* (value, weight) pairs, z fastest */
+   int              *x_cell;            /* lower cell of each pixel */
+   float            *x_frac;            /* position of each pixel in it */
+   int              z_cell[MAX_COLOR+1];/* lower cell of each gray level */
+   float            z_frac[MAX_COLOR+1];/* position of each level in it */
+} type_grid;
+
+typedef struct {
+   double           sigma_space;        /* spatial standard deviation */
+   double           sigma_range;        /* range standard deviation */
+   int              phase;              /* PHASE_GRID ... PHASE_EXACT */
+   type_grid        grid[3];            /* grids of the channels */
+   unsigned char    **image_in;         /* input image arrays */
+   unsigned char    **image_out;        /* output image arrays */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a task */
+} type_bilateral_job;
+
+/******************************************************************************/
+/* BilateralSize computes the number of cells of the grid along each axis.    */
+/******************************************************************************/
+static void BilateralSize (
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              *nz,                /* cells along gray levels */
+   int              *ny,                /* cells along lines */
+   int              *nx)                /* cells along pixels */
+{
+   *nz = (int)(MAX_COLOR / sigma_range) + 1 + 2*GRID_PAD;
+   *ny = (int)((nliin - 1) / sigma_space) + 1 + 2*GRID_PAD;
+   *nx = (int)((npxin - 1) / sigma_space) + 1 + 2*GRID_PAD;
+} /* BilateralSize */
+
+/******************************************************************************/
+/* BilateralBlur convolves count blocks of run floats spaced by stride floats */
+/* by [1 4 6 4 1] / 16, in place (the two first and last blocks stay empty).  */
+/* Blocks are whole rows or planes of the grid for the pixel and line axes,   */
+/* so that the inner loop runs on contiguous floats.                          */
+/******************************************************************************/
+static void BilateralBlur (
+   float            *cell,              /* first block */
+   int              count,              /* number of blocks */
+   int              stride,             /* distance between blocks (floats) */
+   int              run,                /* floats per block */
+   float            *work)              /* work array of 3 x run floats */
+{
+   float            *previous2;         /* original block i - 2 */
+   float            *previous1;         /* original block i - 1 */
+   float            *current;           /* original block i */
+   float            *swap;              /* rotation of the three blocks */
+   float            *block;             /* block i */
+   int              i;                  /* index among blocks */
+   int              j;                  /* index in a block */
+
+   previous2 = work;
+   previous1 = work + run;
+   current   = work + 2 * run;
+   memcpy (previous2,cell,run*sizeof(float));
+   memcpy (previous1,cell+stride,run*sizeof(float));
+   for (i=GRID_PAD; i<count-GRID_PAD; i++)
+   {
+      block = cell + i * stride;
+      memcpy (current,block,run*sizeof(float));
+      for (j=0; j<run; j++)
+         block[j] = (previous2[j] + block[2*stride+j] +
+                     4.f * (previous1[j] + block[stride+j]) +
+                     6.f * current[j]) / 16.f;
+      swap      = previous2;
+      previous2 = previous1;
+      previous1 = current;
+      current   = swap;
+   }
+} /* BilateralBlur */
+
+/******************************************************************************/
+/* BilateralBlurRange is BilateralBlur along the gray levels of one (line,    */
+/* pixel) cell column: nz contiguous pairs, the original values of the two    */
+/* previous pairs kept in registers.                                          */
+/******************************************************************************/
+static void BilateralBlurRange (
+   float            *cell,              /* first pair */
+   int              nz)                 /* number of pairs */
+{
+   float            value2, weight2;    /* original pair z - 2 */
+   float            value1, weight1;    /* original pair z - 1 */
+   float            value0, weight0;    /* original pair z */
+   int              z;                  /* index among pairs */
+
+   value2  = cell[0];
+   weight2 = cell[1];
+   value1  = cell[2];
+   weight1 = cell[3];
+   for (z=GRID_PAD; z<nz-GRID_PAD; z++)
+   {
+      value0  = cell[2*z];
+      weight0 = cell[2*z+1];
+      cell[2*z]   = (value2 + cell[2*z+4] + 4.f * (value1 + cell[2*z+2]) +
+                     6.f * value0) / 16.f;
+      cell[2*z+1] = (weight2 + cell[2*z+5] + 4.f * (weight1 + cell[2*z+3]) +
+                     6.f * weight0) / 16.f;
+      value2  = value1;
+      weight2 = weight1;
+      value1  = value0;
+      weight1 = weight0;
+   }
+} /* BilateralBlurRange */
+
+/******************************************************************************/
+/* BilateralBuild tabulates the cells of the pixels and gray levels, splats   */
+/* one channel into its grid and blurs the grid.                              */
+/******************************************************************************/
+static int BilateralBuild (
+   type_grid        *grid,              /* grid being built */
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   unsigned char    *image_in,          /* input image array */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              x, y, z;            /* cell indexes */
+   int              level;              /* gray level */
+   double           position;           /* position in cells */
+   int              plane;              /* floats of a plane (fixed y) */
+   float            *work;              /* work array of the blur */
+   float            *cell;              /* current cell */
+   float            *row;               /* cells of the current line */
+
+   BilateralSize (sigma_space,sigma_range,nliin,npxin,&grid->nz,&grid->ny,
+                  &grid->nx);
+   plane    = 2 * grid->nx * grid->nz;
+   if (((grid->cell=(float*)calloc(plane*grid->ny,sizeof(float))) == NULL)    ||
+       ((grid->x_cell=(int*)malloc(npxin*sizeof(int))) == NULL)               ||
+       ((grid->x_frac=(float*)malloc(npxin*sizeof(float))) == NULL)           ||
+       ((work=(float*)malloc(3*plane*sizeof(float))) == NULL))
+      return (1);
+   for (ipx=0; ipx<npxin; ipx++)
+   {
+      position          = ipx / sigma_space;
+      grid->x_cell[ipx] = (int)position + GRID_PAD;
+      grid->x_frac[ipx] = (float)(position - (int)position);
+   }
+   for (level=0; level<=MAX_COLOR; level++)
+   {
+      position            = level / sigma_range;
+      grid->z_cell[level] = (int)position + GRID_PAD;
+      grid->z_frac[level] = (float)(position - (int)position);
+   }
+/*----------------------------------------------------------------------------*/
+/* Splat into the nearest cell                                                */
+/*----------------------------------------------------------------------------*/
+   for (ili=0; ili<nliin; ili++)
+   {
+      y   = (int)(ili / sigma_space + 0.5) + GRID_PAD;
+      row = &(grid->cell[y*plane]);
+      for (ipx=0; ipx<npxin; ipx++)
+      {
+         level = image_in[ili*npxin+ipx];
+         x     = grid->x_cell[ipx] + (grid->x_frac[ipx] >= 0.5f);
+         z     = grid->z_cell[level] + (grid->z_frac[level] >= 0.5f);
+         cell  = &(row[2*(x*grid->nz+z)]);
+         cell[0] = cell[0] + level;
+         cell[1] = cell[1] + 1.f;
+      }
+   }
+/*----------------------------------------------------------------------------*/
+/* Blur along gray levels, pixels (rows of a plane), lines (whole planes)     */
+/*----------------------------------------------------------------------------*/
+   for (y=0; y<grid->ny; y++)
+   {
+      for (x=0; x<grid->nx; x++)
+         BilateralBlurRange (&(grid->cell[y*plane+2*x*grid->nz]),grid->nz);
+      BilateralBlur (&(grid->cell[y*plane]),grid->nx,2*grid->nz,2*grid->nz,
+                     work);
+   }
+   BilateralBlur (grid->cell,grid->ny,plane,plane,work);
+   free (work);
+   return (0);
+} /* BilateralBuild */
+
+/******************************************************************************/
+/* BilateralSlice interpolates the grid of one channel for lines              */
+/* [ili_first,ili_last[.                                                      */
+/******************************************************************************/
+static void BilateralSlice (
+   type_grid        *grid,              /* blurred grid */
+   double           sigma_space,        /* spatial standard deviation */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              y;                  /* lower cell index along lines */
+   int              level;              /* input gray level */
+   float            fx, fy, fz;         /* interpolation weights */
+   float            *cell;              /* lower cell */
+   int              dx;                 /* floats from a cell to the next x */
+   int              dy;                 /* floats from a cell to the next y */
+   float            w00, w01, w10, w11; /* weights of the 4 (y,x) corners */
+   float            value;              /* interpolated value */
+   float            weight;             /* interpolated weight */
+   float            output_value;       /* output value before clipping */
+
+   dx = 2 * grid->nz;
+   dy = 2 * grid->nx * grid->nz;
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      fy = ili / sigma_space + GRID_PAD;
+      y  = (int)fy;
+      fy = fy - y;
+      for (ipx=0; ipx<npxin; ipx++)
+      {
+         level = image_in[ili*npxin+ipx];
+         fx    = grid->x_frac[ipx];
+         fz    = grid->z_frac[level];
+         cell  = &(grid->cell[y*dy+grid->x_cell[ipx]*dx+
+                              2*grid->z_cell[level]]);
+         w00   = (1.f-fy) * (1.f-fx);
+         w01   = (1.f-fy) * fx;
+         w10   = fy * (1.f-fx);
+         w11   = fy * fx;
+         value  = (1.f-fz) * (w00 * cell[0] + w01 * cell[dx] +
+                              w10 * cell[dy] + w11 * cell[dy+dx]) +
+                  fz * (w00 * cell[2] + w01 * cell[dx+2] +
+                        w10 * cell[dy+2] + w11 * cell[dy+dx+2]);
+         weight = (1.f-fz) * (w00 * cell[1] + w01 * cell[dx+1] +
+                              w10 * cell[dy+1] + w11 * cell[dy+dx+1]) +
+                  fz * (w00 * cell[3] + w01 * cell[dx+3] +
+                        w10 * cell[dy+3] + w11 * cell[dy+dx+3]);
+         output_value = (weight > 0.f ? value / weight : level);
+         if (output_value < 0)
+            output_value = 0;
+         if (output_value > MAX_COLOR)
+            output_value = MAX_COLOR;
+         image_out[ili*npxin+ipx] = (unsigned char)output_value;
+      }
+   }
+} /* BilateralSlice */
+
+/******************************************************************************/
+/* BilateralExactRows computes the reference filter on lines                  */
+/* [ili_first,ili_last[ of one channel.                                       */
+/******************************************************************************/
+static int BilateralExactRows (
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   int              radius;             /* half size of the window */
+   float            *space;             /* spatial weights of the window */
+   float            range[2*MAX_COLOR+1]; /* range weights, by difference */
+   int              ili, ipx;           /* line, pixel of the output */
+   int              k, l;               /* line, pixel in the window */
+   int              centre;             /* value of the output pixel */
+   float            w;                  /* weight of a pixel */
+   float            sum;                /* weighted sum of the values */
+   float            weight;             /* sum of the weights */
+   float            output_value;       /* output value before clipping */
+
+   radius = (int)ceil(2. * sigma_space);
+   if ((space=(float*)malloc((2*radius+1)*(2*radius+1)*sizeof(float))) ==
+       NULL)
+      return (1);
+   for (k=-radius; k<=radius; k++)
+   {
+      for (l=-radius; l<=radius; l++)
+         space[(k+radius)*(2*radius+1)+l+radius] =
+            (float)exp(-(k*k + l*l) / (2. * sigma_space * sigma_space));
+   }
+   for (k=-MAX_COLOR; k<=MAX_COLOR; k++)
+      range[k+MAX_COLOR] = (float)exp(-k*k / (2. * sigma_range * sigma_range));
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      for (ipx=0; ipx<npxin; ipx++)
+      {
+         centre = image_in[ili*npxin+ipx];
+         sum    = 0.f;
+         weight = 0.f;
+         for (k=-radius; k<=radius; k++)
+         {
+            if ((ili+k < 0) || (ili+k >= nliin))
+               continue;
+            for (l=-radius; l<=radius; l++)
+            {
+               if ((ipx+l < 0) || (ipx+l >= npxin))
+                  continue;
+               w = space[(k+radius)*(2*radius+1)+l+radius] *
+                   range[image_in[(ili+k)*npxin+ipx+l]-centre+MAX_COLOR];
+               sum    = sum + w * image_in[(ili+k)*npxin+ipx+l];
+               weight = weight + w;
+            }
+         }
+         output_value = sum / weight;
+         if (output_value > MAX_COLOR)
+            output_value = MAX_COLOR;
+         image_out[ili*npxin+ipx] = (unsigned char)output_value;
+      }
+   }
+   free (space);
+   return (0);
+} /* BilateralExactRows */
+
+/******************************************************************************/
+/* BilateralTask is the pool task running one part of the current phase.      */
+/******************************************************************************/
+static void BilateralTask (
+   void             *argument,          /* type_bilateral_job being run */
+   int              itask)              /* channel (* band_number + band) */
+{
+   type_bilateral_job *job;             /* job the task belongs to */
+   int              ichannel;           /* channel of the task */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+
+   job = (type_bilateral_job*)argument;
+   if (job->phase == PHASE_GRID)
+   {
+      if (BilateralBuild(&job->grid[itask],job->sigma_space,job->sigma_range,
+                         job->image_in[itask],job->nliin,job->npxin) != 0)
+         job->status = 1;
+      return;
+   }
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   if (job->phase == PHASE_SLICE)
+      BilateralSlice (&job->grid[ichannel],job->sigma_space,
+                      job->image_in[ichannel],job->image_out[ichannel],
+                      job->npxin,ili_first,ili_last);
+   else if (BilateralExactRows(job->sigma_space,job->sigma_range,
+               job->image_in[ichannel],job->image_out[ichannel],job->nliin,
+               job->npxin,ili_first,ili_last) != 0)
+      job->status = 1;
+} /* BilateralTask */
+
+/******************************************************************************/
+/* BilateralInit fills the job and cuts the channels into bands of lines.     */
+/* Returns 1 if a sigma is too small.                                         */
+/******************************************************************************/
+static int BilateralInit (
+   type_bilateral_job *job,             /* job to be filled */
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   if ((sigma_space < MIN_SIGMA_SPACE) || (sigma_range < MIN_SIGMA_RANGE))
+      return (1);
+   memset (job,0,sizeof(type_bilateral_job));
+   job->sigma_space = sigma_space;
+   job->sigma_range = sigma_range;
+   job->image_in    = image_in;
+   job->image_out   = image_out;
+   job->nliin       = nliin;
+   job->npxin       = npxin;
+   job->band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                       channel_number - 1) / channel_number;
+   if (job->band_number > nliin / MIN_BAND_LINES)
+      job->band_number = nliin / MIN_BAND_LINES;
+   if (job->band_number < 1)
+      job->band_number = 1;
+   job->band_lines  = (nliin + job->band_number - 1) / job->band_number;
+   job->band_number = (nliin + job->band_lines - 1) / job->band_lines;
+   return (0);
+} /* BilateralInit */
+
+/******************************************************************************/
+/* BilateralUsesGrid returns 1 if the grid is estimated cheaper than the      */
+/* exact filter for these sigmas and this image size, 0 otherwise.            */
+/******************************************************************************/
+int BilateralUsesGrid (
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              nz, ny, nx;         /* cells along each axis */
+   int              window;             /* size of the exact window */
+   double           grid_cost;          /* cost per pixel of the grid */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (1);
+   BilateralSize (sigma_space,sigma_range,nliin,npxin,&nz,&ny,&nx);
+   window    = 2 * (int)ceil(2. * sigma_space) + 1;
+   grid_cost = COST_GRID_PIXEL + COST_GRID_CELL * ((double)nz * ny * nx) /
+                                 ((double)nliin * npxin);
+   return (grid_cost < (double)window * window);
+} /* BilateralUsesGrid */
+
+/******************************************************************************/
+/* BilateralGrid applies the bilateral filter through the bilateral grid on   */
+/* all the channels, or the exact filter when BilateralUsesGrid() finds it    */
+/* cheaper. Returns 1 if a sigma is too small or memory is lacking.           */
+/******************************************************************************/
+int BilateralGrid (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_bilateral_job job;              /* job shared by all the tasks */
+   int              ichannel;           /* index among channels */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   if ((sigma_space >= MIN_SIGMA_SPACE) && (sigma_range >= MIN_SIGMA_RANGE)  &&
+       !BilateralUsesGrid(sigma_space,sigma_range,nliin,npxin))
+      return (BilateralExact(pool,sigma_space,sigma_range,channel_number,
+                             image_in,image_out,nliin,npxin));
+   if (BilateralInit(&job,pool,sigma_space,sigma_range,channel_number,
+                     image_in,image_out,nliin,npxin) != 0)
+      return (1);
+   job.phase = PHASE_GRID;
+   PoolRun (pool,channel_number,BilateralTask,&job);
+   job.phase = PHASE_SLICE;
+   if (job.status == 0)
+      PoolRun (pool,channel_number*job.band_number,BilateralTask,&job);
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      free (job.grid[ichannel].cell);
+      free (job.grid[ichannel].x_cell);
+      free (job.grid[ichannel].x_frac);
+   }
+   return (job.status);
+} /* BilateralGrid */
+
+/******************************************************************************/
+/* BilateralExact applies the exact bilateral filter on all the channels.     */
+/* Returns 1 if a sigma is too small or memory is lacking.                    */
+/******************************************************************************/
+int BilateralExact (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   double           sigma_space,        /* spatial standard deviation */
+   double           sigma_range,        /* range standard deviation */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_bilateral_job job;              /* job shared by all the tasks */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   if (BilateralInit(&job,pool,sigma_space,sigma_range,channel_number,
+                     image_in,image_out,nliin,npxin) != 0)
+      return (1);
+   job.phase = PHASE_EXACT;
+   PoolRun (pool,channel_number*job.band_number,BilateralTask,&job);
+   return (job.status);
+} /* BilateralExact */
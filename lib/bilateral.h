@@ -0,0 +1,29 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* bilateral applies the edge-preserving bilateral filter, through a          */
+/* downsampled bilateral grid or exactly (reference).                         */
+/******************************************************************************/
+#ifndef BILATERAL_H
+#define BILATERAL_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MIN_SIGMA_SPACE 1.0             /* smallest spatial sigma (pixels) */
+#define MIN_SIGMA_RANGE 1.0             /* smallest range sigma (gray levels)*/
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int BilateralUsesGrid (double sigma_space, double sigma_range, int nliin,
+                       int npxin);
+int BilateralGrid (type_pool *pool, double sigma_space, double sigma_range,
+                   int channel_number, unsigned char *image_in[3],
+                   unsigned char *image_out[3], int nliin, int npxin);
+int BilateralExact (type_pool *pool, double sigma_space, double sigma_range,
+                    int channel_number, unsigned char *image_in[3],
+                    unsigned char *image_out[3], int nliin, int npxin);
+
+#endif /* BILATERAL_H */
@@ -0,0 +1,474 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* canny detects the edges of an image (Canny): Gauss smoothing, Sobel        */
+/* gradient, non-maximum suppression and hysteresis, into bit-packed maps.    */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* 1. smoothing by IirGauss() of iir.c (skipped if sigma is 0), the recursive */
+/*    filter, whose cost does not depend on sigma;                            */
+/* 2. Sobel gradient, magnitude and non-maximum suppression FUSED: each band  */
+/*    of lines keeps the magnitudes and directions of 3 lines in a ring of    */
+/*    rows. A pixel is kept if its magnitude is a local maximum along its     */
+/*    gradient direction (GradientDirection() of bank.c, sectors of 45        */
+/*    degrees); it is then "strong" above high, "weak" above low. The         */
+/*    magnitude is the Sobel one divided by 4, so that a step of h gray       */
+/*    levels has a magnitude of h: low and high are contrasts in gray levels; */
+/* 3. hysteresis: weak pixels 8-connected to a strong pixel become edges.     */
+/*    Each band first follows the chains from its strong pixels without       */
+/*    leaving the band (stack-based flood fill); then, serially, the fill     */
+/*    starts again from the edge pixels on both sides of the band borders,    */
+/*    which only visits the weak pixels left to join across a border;         */
+/* 4. packing: pixel ipx of line ili is bit ipx % 8 (least significant        */
+/*    first) of byte ili * CANNY_STRIDE(npxin) + ipx / 8 of the edge map.     */
+/* Steps 2 to 4 run bands of lines of all the channels on the pool. Border    */
+/* pixels are never edges.                                                    */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "canny.h"
+#include  "bank.h"
+#include  "iir.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+
+#define CLASS_NONE  0                   /* not an edge */
+#define CLASS_WEAK  1                   /* local maximum above low */
+#define CLASS_EDGE  2                   /* strong, or joined to a strong one */
+
+#define PHASE_SUPPRESS  0               /* gradient, non-maximum suppression */
+#define PHASE_HYSTERESIS 1              /* flood fill inside the bands */
+#define PHASE_PACK      2               /* classes -> bit-packed edge map */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   float            low;                /* weak threshold on the magnitude */
+   float            high;               /* strong threshold */
+   int              phase;              /* PHASE_SUPPRESS ... PHASE_PACK */
+   unsigned char    **smooth;           /* smoothed image arrays */
+   unsigned char    *class[3];          /* CLASS_ of the pixels */
+   unsigned char    **edge;             /* bit-packed edge maps */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a task */
+} type_canny_job;
+
+/******************************************************************************/
+/* CannyGradient computes the magnitude and direction of line ili (ili is     */
+/* neither the first nor the last line).                                      */
+/******************************************************************************/
+static void CannyGradient (
+   unsigned char    *smooth,            /* smoothed image array */
+   int              npxin,              /* input pixel number */
+   int              ili,                /* line to be computed */
+   float            *magnitude,         /* magnitudes of the line */
+   unsigned char    *direction)         /* directions of the line */
+{
+   int              ipx;                /* index among pixels */
+   unsigned char    *above;             /* line ili - 1 */
+   unsigned char    *centre;            /* line ili */
+   unsigned char    *below;             /* line ili + 1 */
+   float            gx;                 /* W-E Sobel gradient */
+   float            gy;                 /* N-S Sobel gradient */
+
+   above  = &(smooth[(ili-1)*npxin]);
+   centre = &(smooth[ili*npxin]);
+   below  = &(smooth[(ili+1)*npxin]);
+   magnitude[0]       = 0.f;
+   magnitude[npxin-1] = 0.f;
+   for (ipx=1; ipx<npxin-1; ipx++)
+   {
+      gx = (float)(above[ipx+1] + 2 * centre[ipx+1] + below[ipx+1] -
+                   above[ipx-1] - 2 * centre[ipx-1] - below[ipx-1]);
+      gy = (float)(below[ipx-1] + 2 * below[ipx] + below[ipx+1] -
+                   above[ipx-1] - 2 * above[ipx] - above[ipx+1]);
+      magnitude[ipx] = 0.25f * sqrtf(gx*gx + gy*gy);
+      direction[ipx] = (unsigned char)GradientDirection(gx,gy);
+   }
+} /* CannyGradient */
+
+/******************************************************************************/
+/* CannySuppress classifies line ili from the magnitudes of lines ili - 1,    */
+/* ili, ili + 1 and the directions of line ili.                               */
+/******************************************************************************/
+static void CannySuppress (
+   type_canny_job   *job,               /* job being run */
+   float            *magnitude[3],      /* lines ili - 1, ili, ili + 1 */
+   unsigned char    *direction,         /* directions of line ili */
+   unsigned char    *class)             /* classes of line ili */
+{
+   int              ipx;                /* index among pixels */
+   float            m;                  /* magnitude of the pixel */
+   float            before;             /* neighbor against the gradient */
+   float            after;              /* neighbor along the gradient */
+
+   class[0]            = CLASS_NONE;
+   class[job->npxin-1] = CLASS_NONE;
+   for (ipx=1; ipx<job->npxin-1; ipx++)
+   {
+      m = magnitude[1][ipx];
+      if (m < job->low)
+      {
+         class[ipx] = CLASS_NONE;
+         continue;
+      }
+      switch (direction[ipx])
+      {
+         case DIRECTION_W_E:
+            before = magnitude[1][ipx-1];
+            after  = magnitude[1][ipx+1];
+            break;
+         case DIRECTION_N_S:
+            before = magnitude[0][ipx];
+            after  = magnitude[2][ipx];
+            break;
+         case DIRECTION_NW_SE:
+            before = magnitude[0][ipx-1];
+            after  = magnitude[2][ipx+1];
+            break;
+         default:
+            before = magnitude[0][ipx+1];
+            after  = magnitude[2][ipx-1];
+            break;
+      }
+      if ((m <= before) || (m < after))
+         class[ipx] = CLASS_NONE;
+      else
+         class[ipx] = (m >= job->high ? CLASS_EDGE : CLASS_WEAK);
+   }
+} /* CannySuppress */
+
+/******************************************************************************/
+/* CannySuppressRows classifies lines [ili_first,ili_last[ of one channel.    */
+/* Returns 1 if memory is lacking.                                            */
+/******************************************************************************/
+static int CannySuppressRows (
+   type_canny_job   *job,               /* job being run */
+   int              ichannel,           /* channel */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   float            *ring;              /* magnitudes of 3 lines */
+   unsigned char    *direction;         /* directions of 3 lines */
+   float            *magnitude[3];      /* lines ili - 1, ili, ili + 1 */
+   int              npxin;              /* input pixel number */
+   int              ili;                /* line being computed */
+   int              k;                  /* index among the 3 lines */
+
+   npxin = job->npxin;
+   if (((ring=(float*)malloc(3*npxin*sizeof(float))) == NULL)              ||
+       ((direction=(unsigned char*)malloc(3*npxin)) == NULL))
+   {
+      free (ring);
+      return (1);
+   }
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      if ((ili == 0) || (ili == job->nliin-1))
+      {
+         memset (&(job->class[ichannel][ili*npxin]),CLASS_NONE,npxin);
+         continue;
+      }
+/*----------------------------------------------------------------------------*/
+/*    Gradient of line ili + 1 (and of the lines above at the band start)     */
+/*----------------------------------------------------------------------------*/
+      for (k=(ili == ili_first || ili == 1 ? -1 : 1); k<=1; k++)
+      {
+         if ((ili+k == 0) || (ili+k == job->nliin-1))
+            memset (&(ring[((ili+k)%3)*npxin]),0,npxin*sizeof(float));
+         else
+            CannyGradient (job->smooth[ichannel],npxin,ili+k,
+               &(ring[((ili+k)%3)*npxin]),&(direction[((ili+k)%3)*npxin]));
+      }
+      for (k=0; k<3; k++)
+         magnitude[k] = &(ring[((ili+k-1)%3)*npxin]);
+      CannySuppress (job,magnitude,&(direction[(ili%3)*npxin]),
+         &(job->class[ichannel][ili*npxin]));
+   }
+   free (direction);
+   free (ring);
+   return (0);
+} /* CannySuppressRows */
+
+/******************************************************************************/
+/* CannyFill turns into edges the weak pixels of lines [ili_first,ili_last[   */
+/* 8-connected to the stacked edge pixels. stack holds one int per pixel of   */
+/* these lines.                                                               */
+/******************************************************************************/
+static void CannyFill (
+   unsigned char    *class,             /* classes of the channel */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line of the fill */
+   int              ili_last,           /* line following the last one */
+   int              *stack,             /* stacked pixel indexes */
+   int              top)                /* number of stacked pixels */
+{
+   int              ipixel;             /* pixel taken from the stack */
+   int              ili;                /* its line */
+   int              ipx;                /* its pixel */
+   int              k, l;               /* neighbor offsets */
+
+   while (top > 0)
+   {
+      top    = top - 1;
+      ipixel = stack[top];
+      ili    = ipixel / npxin;
+      ipx    = ipixel % npxin;
+      for (k=-1; k<=1; k++)
+      {
+         if ((ili+k < ili_first) || (ili+k >= ili_last))
+            continue;
+         for (l=-1; l<=1; l++)
+         {
+            if ((ipx+l >= 0) && (ipx+l < npxin)                             &&
+                (class[ipixel+k*npxin+l] == CLASS_WEAK))
+            {
+               class[ipixel+k*npxin+l] = CLASS_EDGE;
+               stack[top] = ipixel + k*npxin + l;
+               top = top + 1;
+            }
+         }
+      }
+   }
+} /* CannyFill */
+
+/******************************************************************************/
+/* CannyHysteresisRows follows the chains from the strong pixels of lines     */
+/* [ili_first,ili_last[ without leaving them. Returns 1 if memory is lacking. */
+/******************************************************************************/
+static int CannyHysteresisRows (
+   type_canny_job   *job,               /* job being run */
+   int              ichannel,           /* channel */
+   int              ili_first,          /* first line of the band */
+   int              ili_last)           /* line following the band */
+{
+   int              *stack;             /* stacked pixel indexes */
+   int              top;                /* number of stacked pixels */
+   int              ipixel;             /* index among pixels */
+   unsigned char    *class;             /* classes of the channel */
+
+   if ((stack=(int*)malloc((ili_last-ili_first)*job->npxin*sizeof(int))) ==
+       NULL)
+      return (1);
+   class = job->class[ichannel];
+   top   = 0;
+   for (ipixel=ili_first*job->npxin; ipixel<ili_last*job->npxin; ipixel++)
+   {
+      if (class[ipixel] == CLASS_EDGE)
+      {
+         stack[top] = ipixel;
+         top = top + 1;
+      }
+   }
+   CannyFill (class,job->npxin,ili_first,ili_last,stack,top);
+   free (stack);
+   return (0);
+} /* CannyHysteresisRows */
+
+/******************************************************************************/
+/* CannyPackRows packs lines [ili_first,ili_last[ of one channel into bits.   */
+/******************************************************************************/
+static void CannyPackRows (
+   type_canny_job   *job,               /* job being run */
+   int              ichannel,           /* channel */
+   int              ili_first,          /* first line of the band */
+   int              ili_last)           /* line following the band */
+{
+   int              stride;             /* bytes per edge map line */
+   int              ili;                /* index among lines */
+   int              ibyte;              /* index among bytes of the line */
+   int              bit;                /* index among bits of the byte */
+   int              byte;               /* byte being packed */
+   unsigned char    *class;             /* classes of the line */
+
+   stride = CANNY_STRIDE(job->npxin);
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      class = &(job->class[ichannel][ili*job->npxin]);
+      for (ibyte=0; ibyte<stride; ibyte++)
+      {
+         byte = 0;
+         for (bit=0; (bit<8) && (8*ibyte+bit<job->npxin); bit++)
+            byte = byte | ((class[8*ibyte+bit] == CLASS_EDGE) << bit);
+         job->edge[ichannel][ili*stride+ibyte] = (unsigned char)byte;
+      }
+   }
+} /* CannyPackRows */
+
+/******************************************************************************/
+/* CannyTask is the pool task running one band of the current phase.          */
+/******************************************************************************/
+static void CannyTask (
+   void             *argument,          /* type_canny_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_canny_job   *job;               /* job the task belongs to */
+   int              ichannel;           /* channel of the task */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+
+   job       = (type_canny_job*)argument;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   if (job->phase == PHASE_SUPPRESS)
+   {
+      if (CannySuppressRows(job,ichannel,ili_first,ili_last) != 0)
+         job->status = 1;
+   }
+   else if (job->phase == PHASE_HYSTERESIS)
+   {
+      if (CannyHysteresisRows(job,ichannel,ili_first,ili_last) != 0)
+         job->status = 1;
+   }
+   else
+      CannyPackRows (job,ichannel,ili_first,ili_last);
+} /* CannyTask */
+
+/******************************************************************************/
+/* CannyBorders ends the hysteresis of one channel across the band borders.   */
+/* Returns 1 if memory is lacking.                                            */
+/******************************************************************************/
+static int CannyBorders (
+   type_canny_job   *job,               /* job being run */
+   int              ichannel)           /* channel */
+{
+   int              *stack;             /* stacked pixel indexes */
+   int              top;                /* number of stacked pixels */
+   int              iband;              /* index among bands */
+   int              ipixel;             /* index among pixels */
+   unsigned char    *class;             /* classes of the channel */
+
+   if (job->band_number == 1)
+      return (0);
+   if ((stack=(int*)malloc(job->nliin*job->npxin*sizeof(int))) == NULL)
+      return (1);
+   class = job->class[ichannel];
+   top   = 0;
+   for (iband=1; iband<job->band_number; iband++)
+   {
+      for (ipixel=(iband*job->band_lines-1)*job->npxin;
+           ipixel<(iband*job->band_lines+1)*job->npxin; ipixel++)
+      {
+         if (class[ipixel] == CLASS_EDGE)
+         {
+            stack[top] = ipixel;
+            top = top + 1;
+         }
+      }
+   }
+   CannyFill (class,job->npxin,0,job->nliin,stack,top);
+   free (stack);
+   return (0);
+} /* CannyBorders */
+
+/******************************************************************************/
+/* Canny computes the bit-packed edge maps of all the channels: edge[c] has   */
+/* nliin lines of CANNY_STRIDE(npxin) bytes. sigma = 0 skips the smoothing.   */
+/* Returns 1 if sigma or the thresholds are out of range or memory is         */
+/* lacking.                                                                   */
+/******************************************************************************/
+int Canny (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   double           sigma,              /* Gauss smoothing, 0: none */
+   double           low,                /* weak threshold (gray levels) */
+   double           high,               /* strong threshold (gray levels) */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *edge[3],           /* bit-packed edge maps */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_canny_job   job;                /* job shared by all the tasks */
+   unsigned char    *smooth[3];         /* smoothed image arrays */
+   unsigned char    *buffer;            /* smoothed planes and classes */
+   int              ichannel;           /* index among channels */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   if ((sigma < 0.) || ((sigma > 0.) && (sigma < MIN_IIR_SIGMA))            ||
+       (low < 0.) || (high < low))
+      return (1);
+   if ((buffer=(unsigned char*)malloc(2*channel_number*nliin*npxin)) == NULL)
+      return (1);
+   memset (&job,0,sizeof(type_canny_job));
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      job.class[ichannel] = &(buffer[ichannel*nliin*npxin]);
+      smooth[ichannel]    = (sigma > 0. ?
+                             &(buffer[(channel_number+ichannel)*nliin*npxin]) :
+                             image_in[ichannel]);
+   }
+   if ((sigma > 0.)                                                         &&
+       (IirGauss(pool,sigma,channel_number,image_in,smooth,nliin,npxin) != 0))
+   {
+      free (buffer);
+      return (1);
+   }
+   job.low         = (float)low;
+   job.high        = (float)high;
+   job.smooth      = smooth;
+   job.edge        = edge;
+   job.nliin       = nliin;
+   job.npxin       = npxin;
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      channel_number - 1) / channel_number;
+   if (job.band_number > nliin / MIN_BAND_LINES)
+      job.band_number = nliin / MIN_BAND_LINES;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+   job.phase = PHASE_SUPPRESS;
+   PoolRun (pool,channel_number*job.band_number,CannyTask,&job);
+   job.phase = PHASE_HYSTERESIS;
+   if (job.status == 0)
+      PoolRun (pool,channel_number*job.band_number,CannyTask,&job);
+   for (ichannel=0; (ichannel<channel_number) && (job.status == 0);
+        ichannel++)
+      job.status = CannyBorders (&job,ichannel);
+   job.phase = PHASE_PACK;
+   if (job.status == 0)
+      PoolRun (pool,channel_number*job.band_number,CannyTask,&job);
+   free (buffer);
+   return (job.status);
+} /* Canny */
+
+/******************************************************************************/
+/* CannyUnpack expands one bit-packed edge map into an image: edges are       */
+/* white, the rest black.                                                     */
+/******************************************************************************/
+void CannyUnpack (
+   unsigned char    *edge,              /* bit-packed edge map */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+
+   for (ili=0; ili<nliin; ili++)
+   {
+      for (ipx=0; ipx<npxin; ipx++)
+         image_out[ili*npxin+ipx] =
+            ((edge[ili*CANNY_STRIDE(npxin)+ipx/8] >> (ipx%8)) & 1 ?
+             MAX_COLOR : 0);
+   }
+} /* CannyUnpack */
@@ -0,0 +1,25 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* canny detects the edges of an image (Canny): Gauss smoothing, Sobel        */
+/* gradient, non-maximum suppression and hysteresis, into bit-packed maps.    */
+/******************************************************************************/
+#ifndef CANNY_H
+#define CANNY_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define CANNY_STRIDE(npxin) (((npxin) + 7) / 8) /* bytes per edge map line */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int Canny (type_pool *pool, double sigma, double low, double high,
+           int channel_number, unsigned char *image_in[3],
+           unsigned char *edge[3], int nliin, int npxin);
+void CannyUnpack (unsigned char *edge, unsigned char *image_out, int nliin,
+                  int npxin);
+
+#endif /* CANNY_H */
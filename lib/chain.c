@@ -0,0 +1,291 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* chain applies a chain of convolutions, either as a cascade of passes or as */
+/* the single composite matrix of the chain, whichever is cheaper.            */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Applying A (size a) then B (size b) is the same as applying once the       */
+/* composite matrix C of size a+b-1:                                          */
+/*    C(n) = SUM(m) B(m) * A(n-m)                                             */
+/*    gain(C)   = gain(A) * gain(B)                                           */
+/*    offset(C) = gain(B) * offset(A) * SUM(m) B(m) + offset(B)               */
+/* When both matrices have integer coefficients, C is computed in integers    */
+/* and is exact (e.g. Gauss 3x3 twice gives the 5x5 binomial matrix with gain */
+/* 1/256, as worked out in Rapport6 section 3).                               */
+/* The composite differs from the cascade only by the rounding and clipping   */
+/* done between passes, which it avoids, and on the borders: the cascade      */
+/* leaves size/2 border pixels of every pass untouched, the composite the     */
+/* (a+b-1)/2 border pixels of the whole chain.                                */
+/*                                                                            */
+/* ChainPlan() estimates the cost of both forms with the cost model of        */
+/* convol.c (each pass taking its own cheapest method, plus the cost of       */
+/* writing and reading back an intermediate image) and keeps the cheaper.     */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "chain.h"
+#include  "image.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define PASS_COST   2.0                 /* cost of an intermediate image, in
+                                           units of the convol.c cost model */
+
+/******************************************************************************/
+/* ConvolCompose computes the composite of first then second. Its coeff array */
+/* is allocated and must be freed by the caller. Returns 1 if the composite   */
+/* would exceed MAX_FFT_SIZE or memory is lacking.                            */
+/******************************************************************************/
+int ConvolCompose (
+   type_convol      *first,             /* matrix applied first */
+   type_convol      *second,            /* matrix applied second */
+   type_convol      *composite)         /* composite matrix */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              size;               /* size of the composite */
+   int              integer;            /* "integer coefficients" flag */
+   int              k1, l1;             /* line, column in first matrix */
+   int              k2, l2;             /* line, column in second matrix */
+   long long        *exact;             /* integer composite coefficients */
+   double           *approximate;       /* real composite coefficients */
+   double           second_sum;         /* sum of second coefficients */
+   float            a;                  /* coefficient of first matrix */
+   float            b;                  /* coefficient of second matrix */
+   int              n;                  /* index in the composite */
+   char             name[2*sizeof(first->name)+4]; /* name of the composite */
+
+   size = first->size + second->size - 1;
+   if (size > MAX_FFT_SIZE)
+      return (1);
+   integer     = (ConvolProperties(first) & ConvolProperties(second) &
+                  CONVOL_IS_INTEGER) != 0;
+   exact       = (long long*)calloc(size*size,sizeof(long long));
+   approximate = (double*)calloc(size*size,sizeof(double));
+   if ((exact == NULL) || (approximate == NULL)                               ||
+       ((composite->coeff=(float*)malloc(size*size*sizeof(float))) == NULL))
+   {
+      free (exact);
+      free (approximate);
+      return (1);
+   }
+/*----------------------------------------------------------------------------*/
+/* C(k1+k2,l1+l2) += B(k2,l2) * A(k1,l1)                                      */
+/*----------------------------------------------------------------------------*/
+   second_sum = 0.;
+   for (k2=0; k2<second->size; k2++)
+   {
+      for (l2=0; l2<second->size; l2++)
+      {
+         b          = second->coeff[k2*second->size+l2];
+         second_sum = second_sum + b;
+         if (b == 0.)
+            continue;
+         for (k1=0; k1<first->size; k1++)
+         {
+            for (l1=0; l1<first->size; l1++)
+            {
+               a = first->coeff[k1*first->size+l1];
+               n = (k1+k2)*size + (l1+l2);
+               if (integer)
+                  exact[n] = exact[n] + (long long)b * (long long)a;
+               else
+                  approximate[n] = approximate[n] + (double)b * a;
+            }
+         }
+      }
+   }
+   for (n=0; n<size*size; n++)
+      composite->coeff[n] = (integer ? (float)exact[n] : (float)approximate[n]);
+   free (exact);
+   free (approximate);
+/*----------------------------------------------------------------------------*/
+/* Gain, offset and name                                                      */
+/*----------------------------------------------------------------------------*/
+   composite->size   = size;
+   composite->gain   = first->gain * second->gain;
+   composite->offset = second->gain * first->offset * second_sum +
+                       second->offset;
+   composite->analyzed = 0;
+   sprintf (name,"%s * %s",first->name,second->name);
+   strncpy (composite->name,name,sizeof(composite->name)-1);
+   composite->name[sizeof(composite->name)-1] = '\0';
+   return (0);
+} /* ConvolCompose */
+
+/******************************************************************************/
+/* ChainInit empties the chain.                                               */
+/******************************************************************************/
+void ChainInit (
+   type_chain       *chain)             /* chain to be initialized */
+{
+   memset (chain,0,sizeof(type_chain));
+} /* ChainInit */
+
+/******************************************************************************/
+/* ChainAdd appends a matrix to the chain. Returns 1 if the chain is full.    */
+/******************************************************************************/
+int ChainAdd (
+   type_chain       *chain,             /* chain being built */
+   type_convol      *convol)            /* matrix to be appended */
+{
+   if (chain->convol_number >= MAX_CHAIN)
+      return (1);
+   chain->convol[chain->convol_number] = convol;
+   chain->convol_number = chain->convol_number + 1;
+   ChainRelease (chain);
+   return (0);
+} /* ChainAdd */
+
+/******************************************************************************/
+/* ConvolutionBestCost returns the cost of the cheapest method of a matrix.   */
+/******************************************************************************/
+static double ConvolutionBestCost (
+   type_convol      *convol,            /* matrix to be applied */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   return (ConvolutionCost(convol,ConvolutionMethod(convol,nliin,npxin,NULL),
+                           nliin,npxin,NULL));
+} /* ConvolutionBestCost */
+
+/******************************************************************************/
+/* ChainPlan computes the composite matrix of the chain, estimates the cost   */
+/* of the cascade and of the composite for the image size, and selects the    */
+/* cheaper form (the cascade if the composite exceeds MAX_FFT_SIZE).          */
+/******************************************************************************/
+int ChainPlan (
+   type_chain       *chain,             /* chain to be planned */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_convol      partial;            /* composite of the first matrices */
+   int              iconvol;            /* index among matrices */
+
+   if (chain->convol_number < 1)
+      return (1);
+   ChainRelease (chain);
+   chain->planned = 1;
+   chain->nliin   = nliin;
+   chain->npxin   = npxin;
+/*----------------------------------------------------------------------------*/
+/* Cost of the cascade                                                        */
+/*----------------------------------------------------------------------------*/
+   chain->cascade_cost = PASS_COST * (chain->convol_number - 1);
+   for (iconvol=0; iconvol<chain->convol_number; iconvol++)
+      chain->cascade_cost = chain->cascade_cost +
+         ConvolutionBestCost (chain->convol[iconvol],nliin,npxin);
+/*----------------------------------------------------------------------------*/
+/* Composite matrix, built from left to right                                 */
+/*----------------------------------------------------------------------------*/
+   chain->use_composite  = 0;
+   chain->composite_cost = -1.;
+   chain->composite      = *(chain->convol[0]);
+   if ((chain->composite.coeff=(float*)malloc(chain->composite.size *
+        chain->composite.size * sizeof(float))) == NULL)
+      return (1);
+   memcpy (chain->composite.coeff,chain->convol[0]->coeff,
+           chain->composite.size*chain->composite.size*sizeof(float));
+   for (iconvol=1; iconvol<chain->convol_number; iconvol++)
+   {
+      partial = chain->composite;
+      if (ConvolCompose(&partial,chain->convol[iconvol],&chain->composite) != 0)
+      {
+         free (partial.coeff);
+         chain->composite.coeff = NULL;
+         return (0);
+      }
+      free (partial.coeff);
+   }
+   chain->composite_valid = 1;
+   chain->composite_cost  = ConvolutionBestCost (&chain->composite,nliin,npxin);
+   chain->use_composite   = (chain->composite_cost < chain->cascade_cost);
+   return (0);
+} /* ChainPlan */
+
+/******************************************************************************/
+/* ChainApply applies the chain on all the channels, in the form selected by  */
+/* ChainPlan(), which is called again if the chain was planned for another    */
+/* image size, or not planned at all. The intermediate images of the          */
+/* cascade are taken from the arena of the chain: each one lives from the     */
+/* pass writing it to the pass reading it, so that two of them share the      */
+/* memory of all (none for a single matrix), allocated once for a size.       */
+/******************************************************************************/
+int ChainApply (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_chain       *chain,             /* chain to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   unsigned char    *intermediate[MAX_CHAIN][3]; /* intermediate arrays */
+   int              buffer[MAX_CHAIN];  /* intermediates in the arena */
+   size_t           plane_size;         /* bytes of an intermediate plane */
+   unsigned char    **pass_in;          /* input of the current pass */
+   unsigned char    **pass_out;         /* output of the current pass */
+   int              ichannel;           /* index among channels */
+   int              iconvol;            /* index among matrices */
+   int              status;             /* status of the passes */
+
+   if (((!chain->planned) || (chain->nliin != nliin)                          ||
+        (chain->npxin != npxin)) && (ChainPlan(chain,nliin,npxin) != 0))
+      return (1);
+   if (chain->use_composite)
+      return (ConvolutionApply(pool,&chain->composite,CONVOL_AUTO,
+                               channel_number,image_in,image_out,nliin,npxin));
+/*----------------------------------------------------------------------------*/
+/* Cascade                                                                    */
+/*----------------------------------------------------------------------------*/
+   ArenaReset (&chain->arena);
+   plane_size = IMAGE_ROUND((size_t)nliin*npxin);
+   for (iconvol=0; iconvol<chain->convol_number-1; iconvol++)
+      buffer[iconvol] = ArenaRequest (&chain->arena,channel_number*plane_size,
+                                      iconvol,iconvol+1);
+   if (ArenaPlan(&chain->arena) != 0)
+      return (1);
+   for (iconvol=0; iconvol<chain->convol_number-1; iconvol++)
+   {
+      for (ichannel=0; ichannel<channel_number; ichannel++)
+         intermediate[iconvol][ichannel] = (unsigned char*)ArenaBuffer(
+            &chain->arena,buffer[iconvol]) + ichannel * plane_size;
+   }
+   status  = 0;
+   pass_in = image_in;
+   for (iconvol=0; (iconvol<chain->convol_number) && (status == 0); iconvol++)
+   {
+      if (iconvol == chain->convol_number-1)
+         pass_out = image_out;
+      else
+         pass_out = intermediate[iconvol];
+      status = ConvolutionApply (pool,chain->convol[iconvol],CONVOL_AUTO,
+                  channel_number,pass_in,pass_out,nliin,npxin);
+      pass_in = pass_out;
+   }
+   return (status);
+} /* ChainApply */
+
+/******************************************************************************/
+/* ChainRelease frees the composite matrix and the intermediates of the       */
+/* chain, which must then be planned again.                                   */
+/******************************************************************************/
+void ChainRelease (
+   type_chain       *chain)             /* chain to be released */
+{
+   if (chain->composite_valid)
+      free (chain->composite.coeff);
+   chain->composite_valid = 0;
+   chain->use_composite   = 0;
+   chain->planned         = 0;
+   ArenaFree (&chain->arena);
+} /* ChainRelease */
@@ -0,0 +1,48 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* chain applies a chain of convolutions, either as a cascade of passes or as */
+/* the single composite matrix of the chain, whichever is cheaper.            */
+/******************************************************************************/
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include  "pool.h"
+#include  "convol.h"
+#include  "arena.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_CHAIN   16                  /* greatest number of matrices */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              convol_number;      /* number of matrices in the chain */
+   type_convol      *convol[MAX_CHAIN]; /* matrices, in order of application */
+   type_convol      composite;          /* composite matrix of the chain */
+   int              planned;            /* "ChainPlan() has been called" */
+   int              nliin;              /* line number of the plan */
+   int              npxin;              /* pixel number of the plan */
+   int              composite_valid;    /* "composite has been computed" */
+   int              use_composite;      /* "apply composite, not the cascade"*/
+   double           cascade_cost;       /* estimated cost of the cascade */
+   double           composite_cost;     /* estimated cost of the composite */
+   type_arena       arena;              /* intermediates of the cascade */
+} type_chain;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int ConvolCompose (type_convol *first, type_convol *second,
+                   type_convol *composite);
+void ChainInit (type_chain *chain);
+int ChainAdd (type_chain *chain, type_convol *convol);
+int ChainPlan (type_chain *chain, int nliin, int npxin);
+int ChainApply (type_pool *pool, type_chain *chain, int channel_number,
+                unsigned char *image_in[3], unsigned char *image_out[3],
+                int nliin, int npxin);
+void ChainRelease (type_chain *chain);
+
+#endif /* CHAIN_H */
@@ -0,0 +1,1631 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* convol gathers the convolution matrices of TD6 and the functions applying  */
+/* them on the image arrays.                                                  */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* For each output pixel (i,j) whose (size x size) neighborhood lies inside   */
+/* the image:                                                                 */
+/*    out(i,j) = gain * SUM(k,l) coeff(k,l) * in(i+k,j+l) + offset            */
+/* clipped to [0,MAX_COLOR]. Border pixels, where the matrix does not fit,    */
+/* keep their origin value.                                                   */
+/*                                                                            */
+/* Three methods compute the same sums:                                       */
+/* . CONVOL_DIRECT    accumulates the size x size products of each pixel;     */
+/* . CONVOL_SEPARABLE applies a vertical then a horizontal vector when the    */
+/*                    matrix is their outer product (Mean, Gauss 3x3...);     */
+/* . CONVOL_FFT       multiplies FFT tiles by the spectrum of the matrix and  */
+/*                    adds the overlapping tile outputs (overlap-add).        */
+/* ConvolutionMethod() estimates their cost and picks the cheapest one.       */
+/*                                                                            */
+/* Most matrices are symmetric (coeff(-k,-l) = coeff(k,l): Mean, Gauss,       */
+/* Laplacien, Pratt...) or antisymmetric (Gradient, Sobel). The direct and    */
+/* separable methods then add (or subtract) the two mirrored input samples    */
+/* before multiplying them by their common coefficient, which halves the      */
+/* multiplies. A matrix with a single coefficient (shift) is applied as a     */
+/* move of input line segments, a mere memcpy when its overall gain is 1 and  */
+/* its offset 0.                                                              */
+/*                                                                            */
+/* CONVOL[] is a registry: the matrices below are compiled in, others are     */
+/* appended at startup from a description file (registry.c). Each matrix is   */
+/* analyzed once by ConvolAnalyze(), which caches its properties (separable,  */
+/* symmetric, antisymmetric, integer, zero sum, shift, identity) in the       */
+/* type_convol; the cost model and ConvolutionApply() read these flags        */
+/* instead of inspecting the coefficients on every call.                      */
+/* Matrices with integer coefficients give exactly the same output with the   */
+/* direct and separable methods; the FFT method may differ by one gray level  */
+/* where a value falls on an integer boundary after rounding errors.          */
+/*                                                                            */
+/* ConvolutionApply() cuts every channel into bands of lines and runs all the */
+/* (channel,band) pairs on a thread pool. A band reads the size/2 lines above */
+/* and below it (its "halo") directly in the shared input array, so no line   */
+/* is copied, and every output pixel is computed by the same code and in the  */
+/* same order as by a serial run. Convolution() is the plain, unfolded        */
+/* reference: for integer matrices, whose folded sums are exact, the output   */
+/* of ConvolutionBands() is identical byte for byte to the one of it.         */
+/*                                                                            */
+/* ConvolutionImage() is the direct method on images allocated with guards    */
+/* (ImageAllocGuard): the neighborhoods of the border pixels are read in the  */
+/* replicated guards, so that every line is computed and stored on its whole  */
+/* padded width by the same loop, without border tests nor scalar tail; the   */
+/* border pixels then get back their origin value. The output is that of the  */
+/* direct method of ConvolutionApply(), identity and shifts included.         */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "convol.h"
+#include  "cpu.h"
+#include  "fft.h"
+#include  "saturate.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+#define MAX_TILE    1024                /* largest FFT tile size */
+#define SEPARABLE_EPSILON 1.e-5         /* relative error of a separation */
+#define COST_BUTTERFLY  4.5             /* cost of a FFT butterfly, in units of
+                                           one multiply-add of the scalar
+                                           direct method (calibrated by
+                                           bench_convol at -O2) */
+#define COST_FOLDED 1.3                 /* cost of a pair of mirrored products
+                                           after folding (one add, one
+                                           multiply-add) */
+#define COST_MOVE   0.25                /* cost of a pixel moved by memcpy */
+
+static double COST_VECTOR[CPU_LEVEL_NUMBER] = { /* speedup of the direct
+                                           and separable kernels (the FFT is
+                                           not vectorized), bench_convol */
+   1.0,                                 /* CPU_SCALAR */
+   4.0,                                 /* CPU_SSE42 */
+   7.0,                                 /* CPU_AVX2 */
+   10.0};                               /* CPU_AVX512 */
+
+#define CONVOL_SET            0         /* operations of the kernels */
+#define CONVOL_ADD            1
+#define CONVOL_ADD_SUM        2
+#define CONVOL_ADD_DIFFERENCE 3
+#define CONVOL_ADD_PAIR       4
+
+/******************************************************************************/
+/* Macro definitions                                                          */
+/******************************************************************************/
+#define nint(float_value)  (((float_value)-(int)(float_value) > 0.5)?          \
+                            (int)(float_value)+1 : (int)(float_value))
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   type_convol      *convol;            /* convolution to be applied */
+   int              method;             /* CONVOL_DIRECT, _SEPARABLE, _FFT */
+   float            *vertical;          /* separable: vector along lines */
+   float            *horizontal;        /* separable: vector along pixels */
+   int              tile_size;          /* FFT: size of the tiles */
+   type_complex     *spectrum;          /* FFT: spectrum of the matrix */
+   unsigned char    **image_in;         /* input image arrays */
+   unsigned char    **image_out;        /* output image arrays */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a band */
+} type_band_job;
+
+typedef struct {
+   type_convol      *convol;            /* convolution to be applied */
+   type_image       *image_in;          /* input image, guards extended */
+   type_image       *image_out;         /* output image */
+   int              width;              /* pixels computed per line */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a band */
+} type_image_job;
+
+typedef void (*type_bytes_kernel) (int operation, float *output_row,
+                                   unsigned char *input_row,
+                                   unsigned char *mirror_row, float coeff,
+                                   float mirror_coeff, int n);
+typedef void (*type_floats_kernel) (int operation, float *output_row,
+                                    float *input_row, float *mirror_row,
+                                    float coeff, float mirror_coeff, int n);
+
+/******************************************************************************/
+/* Convolution matrices compiled in                                           */
+/******************************************************************************/
+static type_convol CONVOL_BUILTIN[] = {
+	{ "Mean 3x3",	3, 1./(float)9., 0., (float []) { 1., 1., 1.,
+				       	       1., 1., 1.,
+				               1., 1., 1. } },
+
+	{ "Mean 5x5",	5, 1./(float)25., 0., (float []) { 1., 1., 1., 1., 1.,
+			      	 	 	1., 1., 1., 1., 1.,
+				        	1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1. } },
+
+	{ "Mean 7x7",	7, 1./(float)49., 0., (float []) { 1., 1., 1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1., 1., 1.,
+					 	1., 1., 1., 1., 1., 1., 1. } },
+
+ 	{ "Gauss 3x3",	3, 1./(float)16., 0., (float []) { 1., 2., 1.,
+	 				        2., 4., 2.,
+					 	1., 2., 1. } },
+
+	{ "Gradient 3x3 4-connex", 3, 10./(float)4., 128., (float []) { 0., -1., 0.,
+						     	    -1., 4., -1.,
+						      	     0., -1., 0. } },
+
+	{ "Gradient 3x3 8-connex", 3, 10./(float)9.657, 128., (float []) { -1., -1., -1.,
+							       -1., 8., -1.,
+							       -1., -1., -1. } },
+
+	{ "Gradient 3x3 N-S", 3, 10./(float)6., 128., (float []) { -1., -1., -1.,
+							0., 0., 0.,
+							1., 1., 1. } },
+
+	{ "Gradient 3x3 W-E", 3, 10./(float)6., 128., (float []) { -1., 0., 1.,
+						       -1., 0., 1.,
+						       -1., 0., 1. } },
+
+	{ "Gradient 3x3 NW-SE", 3, 10./(float)5.6569, 128., (float []) { -1., -1., 0.,
+							     -1., 0., 1.,
+							      0., 1., 1. } },
+
+	{ "Sobel 3x3 N-S", 3, 10./(float)8., 128., (float []) { -1., -2., -1.,
+						     0., 0., 0.,
+						     1., 2., 1. } },
+
+	{ "Sobel 3x3 W-E", 3, 10./(float)8., 128., (float []) { -1., 0., 1.,
+						    -2., 0., 2.,
+						    -1., 0., 1. } },
+
+	{ "Sobel 3x3 NW-SE", 3, 10./(float)3.7712, 128., (float []) { -2., -1., 0.,
+						          -1., 0., 1.,
+						           0., 1., 2. } },
+
+	{ "Courbure 3x3 N-S", 3, 10./(float)3., 128., (float []) { -1., -1., -1.,
+						        2., 2., 2.,
+						       -1., -1., -1. } },
+
+	{ "Courbure 3x3 W-E", 3, 10./(float)3., 128., (float []) { -1., 2., 1.,
+						       -1., 2., -1.,
+						       -1., 2., -1. } },
+
+	{ "Courbure 3x3 NW-SE", 3, 10./(float)3., 128., (float []) { -1., -1., 2.,
+							 -1., 2., -1.,
+							  2., -1., -1. } },
+
+	{ "Laplacien 3x3", 3, 10./(float)4., 128., (float []) { 1., -2., 1.,
+						   -2., 4., -2.,
+						    1., -2., 1. } },
+
+	{ "Pratt 3x3", 3, 1./(float)9., 0., (float []) { -1., -1., -1.,
+					       -1., 17., -1.,
+					       -1., -1., -1. } },
+
+};
+type_convol *CONVOL = CONVOL_BUILTIN;
+int CONVOL_NUMBER = sizeof(CONVOL_BUILTIN) / sizeof(CONVOL_BUILTIN[0]);
+char *CONVOL_METHOD_NAME[3] = { "direct", "separable", "fft" };
+
+/******************************************************************************/
+/* ConvolFind returns the CONVOL[] matrix of the given name, or NULL.         */
+/******************************************************************************/
+type_convol *ConvolFind (
+   char             *name)              /* name of the matrix */
+{
+   int              iconvol;            /* index among convolutions */
+
+   for (iconvol=0; iconvol<CONVOL_NUMBER; iconvol++)
+   {
+      if (strcmp(CONVOL[iconvol].name,name) == 0)
+         return (&CONVOL[iconvol]);
+   }
+   return (NULL);
+} /* ConvolFind */
+
+/******************************************************************************/
+/* ConvolGauss builds the Gauss matrix of the given size, as coeff_gauss      */
+/* (gauss.c) does: sigma = size / 3.5, coefficients rounded to integers after */
+/* scaling the corners to 1, gain = 1 / sum of coefficients.                  */
+/* The coeff array is allocated and must be freed by the caller.              */
+/******************************************************************************/
+int ConvolGauss (
+   int              size,               /* size of the matrix (odd) */
+   type_convol      *convol)            /* matrix being built */
+{
+   int              k;                  /* index among lines in matrix */
+   int              l;                  /* index among columns in matrix */
+   double           sigma;              /* Gaussian standard deviation */
+   double           corner;             /* value of the four corners */
+   double           value;              /* scaled value of a coefficient */
+   int              sum;                /* sum of integer coefficients */
+
+   if ((size < 1) || (size % 2 == 0) || (size > MAX_FFT_SIZE))
+      return (1);
+   if ((convol->coeff=(float*)malloc(size*size*sizeof(float))) == NULL)
+      return (1);
+   sprintf (convol->name,"Gauss %dx%d",size,size);
+   convol->size     = size;
+   convol->offset   = 0.;
+   convol->analyzed = 0;
+   sigma  = size / 3.5;
+   corner = exp(-2. * (size/2) * (size/2) / (2. * sigma * sigma));
+   sum    = 0;
+   for (k=-size/2; k<=size/2; k++)
+   {
+      for (l=-size/2; l<=size/2; l++)
+      {
+         value = exp(-(k*k + l*l) / (2. * sigma * sigma)) / corner;
+         convol->coeff[(k+size/2)*size+(l+size/2)] = nint(value);
+         sum = sum + nint(value);
+      }
+   }
+   convol->gain = 1. / (float)sum;
+   return (0);
+} /* ConvolGauss */
+
+/******************************************************************************/
+/* ConvolSeparate checks whether the matrix is the outer product of a         */
+/* vertical and a horizontal vector: coeff(k,l) = vertical(k)*horizontal(l).  */
+/* Returns 1 and fills both vectors (size values each) if so, 0 otherwise.    */
+/******************************************************************************/
+int ConvolSeparate (
+   type_convol      *convol,            /* matrix to be analyzed */
+   float            *vertical,          /* vector along lines */
+   float            *horizontal)        /* vector along pixels */
+{
+   int              size;               /* size of the matrix */
+   int              k;                  /* index among lines in matrix */
+   int              l;                  /* index among columns in matrix */
+   int              k_pivot;            /* line of the largest coefficient */
+   int              l_pivot;            /* column of the largest coefficient */
+   float            largest;            /* largest absolute coefficient */
+
+   size    = convol->size;
+   k_pivot = 0;
+   l_pivot = 0;
+   largest = 0.;
+   for (k=0; k<size*size; k++)
+   {
+      if (fabs(convol->coeff[k]) > largest)
+      {
+         largest = fabs(convol->coeff[k]);
+         k_pivot = k / size;
+         l_pivot = k % size;
+      }
+   }
+   if (largest == 0.)
+      return (0);
+   for (l=0; l<size; l++)
+      horizontal[l] = convol->coeff[k_pivot*size+l];
+   for (k=0; k<size; k++)
+      vertical[k] = convol->coeff[k*size+l_pivot] / horizontal[l_pivot];
+   for (k=0; k<size; k++)
+   {
+      for (l=0; l<size; l++)
+      {
+         if (fabs(convol->coeff[k*size+l] - vertical[k] * horizontal[l]) >
+             SEPARABLE_EPSILON * largest)
+            return (0);
+      }
+   }
+   return (1);
+} /* ConvolSeparate */
+
+/******************************************************************************/
+/* ConvolAnalyze computes the properties of the matrix and caches them in it. */
+/* It must be called again whenever the coefficients, gain or offset change.  */
+/* Returns the CONVOL_IS_... flags.                                           */
+/******************************************************************************/
+int ConvolAnalyze (
+   type_convol      *convol)            /* matrix to be analyzed */
+{
+   float            vertical[MAX_FFT_SIZE];   /* separable: vertical vector */
+   float            horizontal[MAX_FFT_SIZE]; /* separable: horizontal vector */
+   int              size;               /* size of the matrix */
+   int              k;                  /* index among coefficients */
+   float            coeff;              /* current coefficient */
+   float            mirror;             /* coefficient symmetric about centre*/
+   double           sum;                /* sum of the coefficients */
+   double           absolute_sum;       /* sum of their absolute values */
+
+   size             = convol->size;
+   convol->property = CONVOL_IS_SYMMETRIC | CONVOL_IS_ANTISYMMETRIC |
+                      CONVOL_IS_INTEGER;
+   convol->nonzero  = 0;
+   sum              = 0.;
+   absolute_sum     = 0.;
+   for (k=0; k<size*size; k++)
+   {
+      coeff  = convol->coeff[k];
+      mirror = convol->coeff[size*size-1-k];
+      if (coeff != mirror)
+         convol->property = convol->property & ~CONVOL_IS_SYMMETRIC;
+      if (coeff != -mirror)
+         convol->property = convol->property & ~CONVOL_IS_ANTISYMMETRIC;
+      if (coeff != floorf(coeff))
+         convol->property = convol->property & ~CONVOL_IS_INTEGER;
+      if (coeff != 0.)
+      {
+         convol->nonzero     = convol->nonzero + 1;
+         convol->shift_line  = k / size - size / 2;
+         convol->shift_pixel = k % size - size / 2;
+      }
+      sum          = sum + coeff;
+      absolute_sum = absolute_sum + fabs(coeff);
+   }
+   if (fabs(sum) <= SEPARABLE_EPSILON * absolute_sum)
+      convol->property = convol->property | CONVOL_IS_ZERO_SUM;
+   if (ConvolSeparate(convol,vertical,horizontal))
+      convol->property = convol->property | CONVOL_IS_SEPARABLE;
+/*----------------------------------------------------------------------------*/
+/* A single coefficient moves the image; by (0,0) with a unit overall gain    */
+/* and no offset, it leaves it unchanged                                      */
+/*----------------------------------------------------------------------------*/
+   if (convol->nonzero == 1)
+   {
+      convol->property = convol->property | CONVOL_IS_SHIFT;
+      if ((convol->shift_line == 0) && (convol->shift_pixel == 0)           &&
+          (convol->gain * convol->coeff[size*size/2] == 1.)                 &&
+          (convol->offset == 0.))
+         convol->property = convol->property | CONVOL_IS_IDENTITY;
+   }
+   else
+   {
+      convol->shift_line  = 0;
+      convol->shift_pixel = 0;
+   }
+   convol->analyzed = 1;
+   return (convol->property);
+} /* ConvolAnalyze */
+
+/******************************************************************************/
+/* ConvolProperties returns the cached CONVOL_IS_... flags of the matrix,     */
+/* analyzing it first if needed.                                              */
+/******************************************************************************/
+int ConvolProperties (
+   type_convol      *convol)            /* matrix to be analyzed */
+{
+   if (!convol->analyzed)
+      return (ConvolAnalyze(convol));
+   return (convol->property);
+} /* ConvolProperties */
+
+/******************************************************************************/
+/* ConvolPropertyString writes the properties of the matrix, for the menus,   */
+/* in string (at least 100 characters) and returns it.                        */
+/******************************************************************************/
+char *ConvolPropertyString (
+   type_convol      *convol,            /* matrix to be described */
+   char             *string)            /* description of the properties */
+{
+   int              property;           /* CONVOL_IS_... flags */
+
+   property  = ConvolProperties (convol);
+   string[0] = '\0';
+   if (property & CONVOL_IS_IDENTITY)
+      strcat (string," identite");
+   else if (property & CONVOL_IS_SHIFT)
+      sprintf (string+strlen(string)," decalage (%d,%d)",convol->shift_line,
+               convol->shift_pixel);
+   if (property & CONVOL_IS_SEPARABLE)
+      strcat (string," separable");
+   if (property & CONVOL_IS_SYMMETRIC)
+      strcat (string," symetrique");
+   if (property & CONVOL_IS_ANTISYMMETRIC)
+      strcat (string," antisymetrique");
+   if (property & CONVOL_IS_INTEGER)
+      strcat (string," entiere");
+   if (property & CONVOL_IS_ZERO_SUM)
+      strcat (string," somme-nulle");
+   return (string);
+} /* ConvolPropertyString */
+
+/******************************************************************************/
+/* ConvolutionUnitShift returns 1 if the matrix is a shift whose overall gain */
+/* is 1 and offset 0, i.e. a pure move of the input pixels.                   */
+/******************************************************************************/
+static int ConvolutionUnitShift (
+   type_convol      *convol)            /* matrix to be checked */
+{
+   int              centre;             /* index of the single coefficient */
+
+   if (!(ConvolProperties(convol) & CONVOL_IS_SHIFT))
+      return (0);
+   centre = (convol->shift_line + convol->size / 2) * convol->size +
+            convol->shift_pixel + convol->size / 2;
+   return ((convol->gain * convol->coeff[centre] == 1.)                     &&
+           (convol->offset == 0.));
+} /* ConvolutionUnitShift */
+
+/******************************************************************************/
+/* ConvolutionCost estimates the cost per pixel of a method, in units of one  */
+/* multiply-add of the scalar direct method. The products of the direct and   */
+/* separable methods are divided by the speedup of their kernels at the CPU   */
+/* level (COST_VECTOR). For CONVOL_FFT, the cheapest tile size is returned in */
+/* *tile_size (when not NULL). Returns -1 if not applicable.                  */
+/******************************************************************************/
+double ConvolutionCost (
+   type_convol      *convol,            /* matrix to be applied */
+   int              method,             /* method to be estimated */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              *tile_size)         /* FFT: cheapest tile size */
+{
+   int              size;               /* size of the matrix */
+   int              property;           /* CONVOL_IS_... flags */
+   int              tile;               /* candidate tile size */
+   int              block;              /* useful part of a tile */
+   int              largest_tile;       /* tile covering the whole image */
+   int              log2_tile;          /* log2(tile) */
+   double           cost;               /* cost of the candidate tile */
+   double           best_cost;          /* cost of the cheapest tile */
+
+   size = convol->size;
+   switch (method)
+   {
+      case CONVOL_DIRECT:
+         property = ConvolProperties (convol);
+         if (property & CONVOL_IS_SHIFT)
+            return (ConvolutionUnitShift(convol) ? COST_MOVE : 2.);
+         if (property & (CONVOL_IS_SYMMETRIC | CONVOL_IS_ANTISYMMETRIC))
+            return ((COST_FOLDED * (convol->nonzero / 2) +
+                     convol->nonzero % 2 + 1.) / COST_VECTOR[CpuLevel()]);
+         return ((convol->nonzero + 1.) / COST_VECTOR[CpuLevel()]);
+      case CONVOL_SEPARABLE:
+         if (!(ConvolProperties(convol) & CONVOL_IS_SEPARABLE))
+            return (-1.);
+         return ((2. * size + 1.) / COST_VECTOR[CpuLevel()]);
+      case CONVOL_FFT:
+/*----------------------------------------------------------------------------*/
+/*       Two real tiles share one complex transform: per pair of tiles, one   */
+/*       forward and one inverse 2-D FFT (tile^2 log2(tile) butterflies each),*/
+/*       the spectrum product and the overlap-add. Incomplete blocks on the   */
+/*       right and bottom sides cost as much as complete ones.                */
+/*----------------------------------------------------------------------------*/
+         largest_tile = FftPowerOfTwo ((nliin > npxin ? nliin : npxin) + size);
+         if (largest_tile > MAX_TILE)
+            largest_tile = MAX_TILE;
+         best_cost = -1.;
+         for (tile=FftPowerOfTwo(2*size); tile<=largest_tile; tile=2*tile)
+         {
+            block     = tile - size + 1;
+            log2_tile = 0;
+            while ((1 << log2_tile) < tile)
+               log2_tile = log2_tile + 1;
+            cost = (2. * tile * tile * log2_tile * COST_BUTTERFLY +
+                    4. * tile * tile)                                        *
+                   ((npxin + 2*block - 1) / (2*block))                       *
+                   ((nliin + block - 1) / block) / ((double)nliin * npxin);
+            if ((best_cost < 0.) || (cost < best_cost))
+            {
+               best_cost = cost;
+               if (tile_size != NULL)
+                  *tile_size = tile;
+            }
+         }
+         return (best_cost);
+      default:
+         return (-1.);
+   }
+} /* ConvolutionCost */
+
+/******************************************************************************/
+/* ConvolutionMethod returns the cheapest method for the matrix and image     */
+/* size, and for CONVOL_FFT the tile size to be used in *tile_size.           */
+/******************************************************************************/
+int ConvolutionMethod (
+   type_convol      *convol,            /* matrix to be applied */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              *tile_size)         /* FFT: tile size to be used */
+{
+   int              method;             /* candidate method */
+   int              best_method;        /* cheapest method */
+   double           cost;               /* cost of the candidate method */
+   double           best_cost;          /* cost of the cheapest method */
+   int              tile;               /* tile size of the FFT method */
+
+   tile        = 0;
+   best_method = CONVOL_DIRECT;
+   best_cost   = ConvolutionCost (convol,CONVOL_DIRECT,nliin,npxin,NULL);
+   for (method=CONVOL_SEPARABLE; method<=CONVOL_FFT; method++)
+   {
+      cost = ConvolutionCost (convol,method,nliin,npxin,&tile);
+      if ((cost >= 0.) && (cost < best_cost))
+      {
+         best_cost   = cost;
+         best_method = method;
+         if ((method == CONVOL_FFT) && (tile_size != NULL))
+            *tile_size = tile;
+      }
+   }
+   return (best_method);
+} /* ConvolutionMethod */
+
+/******************************************************************************/
+/* ConvolutionStore applies gain and offset to the accumulated values of one  */
+/* line, clips them and reports them in the output line (SaturateRow); the    */
+/* half first and last pixels keep their origin value.                        */
+/******************************************************************************/
+static void ConvolutionStore (
+   type_convol      *convol,            /* convolution being applied */
+   float            *output_row,        /* accumulated values of the line */
+   unsigned char    *input_line,        /* input line */
+   unsigned char    *output_line,       /* output line */
+   int              npxin)              /* input pixel number */
+{
+   int              half;               /* half size of the matrix */
+   int              ipx;                /* index among pixels */
+
+   half = convol->size / 2;
+   for (ipx=0; ipx<half; ipx++)
+   {
+      output_line[ipx]         = input_line[ipx];
+      output_line[npxin-1-ipx] = input_line[npxin-1-ipx];
+   }
+   if (npxin > 2*half)
+      SaturateRow (&(output_row[half]),&(output_line[half]),npxin-2*half,
+                   convol->gain,convol->offset);
+} /* ConvolutionStore */
+
+/******************************************************************************/
+/* ConvolutionBytesKernel accumulates n products of byte input samples in a   */
+/* row of floats, according to operation:                                     */
+/*    CONVOL_SET            out = coeff * in                                  */
+/*    CONVOL_ADD            out = out + coeff * in                            */
+/*    CONVOL_ADD_SUM        out = out + coeff * (in + mirror)                 */
+/*    CONVOL_ADD_DIFFERENCE out = out + coeff * (in - mirror)                 */
+/*    CONVOL_ADD_PAIR       out = out + coeff * in + mirror_coeff * mirror    */
+/* It is the inner loop of the direct and separable methods, compiled once    */
+/* per CPU level by the variants below.                                       */
+/******************************************************************************/
+static CPU_INLINE void ConvolutionBytesKernel (
+   int              operation,          /* CONVOL_SET ... CONVOL_ADD_PAIR */
+   float            *output_row,        /* accumulated values */
+   unsigned char    *input_row,         /* input samples */
+   unsigned char    *mirror_row,        /* mirrored input samples */
+   float            coeff,              /* coefficient of input_row */
+   float            mirror_coeff,       /* coefficient of mirror_row */
+   int              n)                  /* number of samples */
+{
+   int              ipx;                /* index among pixels */
+
+   switch (operation)
+   {
+      case CONVOL_SET:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = coeff * input_row[ipx];
+         break;
+      case CONVOL_ADD:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] + coeff * input_row[ipx];
+         break;
+      case CONVOL_ADD_SUM:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] +
+                              coeff * (input_row[ipx] + mirror_row[ipx]);
+         break;
+      case CONVOL_ADD_DIFFERENCE:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] +
+                              coeff * (input_row[ipx] - mirror_row[ipx]);
+         break;
+      default:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] + coeff * input_row[ipx] +
+                              mirror_coeff * mirror_row[ipx];
+   }
+} /* ConvolutionBytesKernel */
+
+/******************************************************************************/
+/* ConvolutionFloatsKernel is ConvolutionBytesKernel on float input samples   */
+/* (horizontal vector of the separable method).                               */
+/******************************************************************************/
+static CPU_INLINE void ConvolutionFloatsKernel (
+   int              operation,          /* CONVOL_SET ... CONVOL_ADD_PAIR */
+   float            *output_row,        /* accumulated values */
+   float            *input_row,         /* input samples */
+   float            *mirror_row,        /* mirrored input samples */
+   float            coeff,              /* coefficient of input_row */
+   float            mirror_coeff,       /* coefficient of mirror_row */
+   int              n)                  /* number of samples */
+{
+   int              ipx;                /* index among pixels */
+
+   switch (operation)
+   {
+      case CONVOL_SET:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = coeff * input_row[ipx];
+         break;
+      case CONVOL_ADD:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] + coeff * input_row[ipx];
+         break;
+      case CONVOL_ADD_SUM:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] +
+                              coeff * (input_row[ipx] + mirror_row[ipx]);
+         break;
+      case CONVOL_ADD_DIFFERENCE:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] +
+                              coeff * (input_row[ipx] - mirror_row[ipx]);
+         break;
+      default:
+         for (ipx=0; ipx<n; ipx++)
+            output_row[ipx] = output_row[ipx] + coeff * input_row[ipx] +
+                              mirror_coeff * mirror_row[ipx];
+   }
+} /* ConvolutionFloatsKernel */
+
+/******************************************************************************/
+/* Variants of the kernels, one per CPU level (cpu.h), and their tables       */
+/******************************************************************************/
+#define CONVOL_VARIANT(name,target,kernel,type)                                \
+static target void name (int operation, float *output_row, type *input_row,    \
+                         type *mirror_row, float coeff, float mirror_coeff,    \
+                         int n)                                                \
+{                                                                              \
+   kernel (operation,output_row,input_row,mirror_row,coeff,mirror_coeff,n);    \
+}
+
+CONVOL_VARIANT (ConvolutionBytesScalar,CPU_TARGET_SCALAR,
+                ConvolutionBytesKernel,unsigned char)
+CONVOL_VARIANT (ConvolutionBytesSse42,CPU_TARGET_SSE42,
+                ConvolutionBytesKernel,unsigned char)
+CONVOL_VARIANT (ConvolutionBytesAvx2,CPU_TARGET_AVX2,
+                ConvolutionBytesKernel,unsigned char)
+CONVOL_VARIANT (ConvolutionBytesAvx512,CPU_TARGET_AVX512,
+                ConvolutionBytesKernel,unsigned char)
+CONVOL_VARIANT (ConvolutionFloatsScalar,CPU_TARGET_SCALAR,
+                ConvolutionFloatsKernel,float)
+CONVOL_VARIANT (ConvolutionFloatsSse42,CPU_TARGET_SSE42,
+                ConvolutionFloatsKernel,float)
+CONVOL_VARIANT (ConvolutionFloatsAvx2,CPU_TARGET_AVX2,
+                ConvolutionFloatsKernel,float)
+CONVOL_VARIANT (ConvolutionFloatsAvx512,CPU_TARGET_AVX512,
+                ConvolutionFloatsKernel,float)
+
+static type_bytes_kernel CONVOL_BYTES_KERNEL[CPU_LEVEL_NUMBER] = {
+   ConvolutionBytesScalar, ConvolutionBytesSse42, ConvolutionBytesAvx2,
+   ConvolutionBytesAvx512 };
+static type_floats_kernel CONVOL_FLOATS_KERNEL[CPU_LEVEL_NUMBER] = {
+   ConvolutionFloatsScalar, ConvolutionFloatsSse42, ConvolutionFloatsAvx2,
+   ConvolutionFloatsAvx512 };
+
+/******************************************************************************/
+/* ConvolutionBytes runs the variant of ConvolutionBytesKernel of the CPU.    */
+/******************************************************************************/
+static void ConvolutionBytes (
+   int              operation,          /* CONVOL_SET ... CONVOL_ADD_PAIR */
+   float            *output_row,        /* accumulated values */
+   unsigned char    *input_row,         /* input samples */
+   unsigned char    *mirror_row,        /* mirrored input samples */
+   float            coeff,              /* coefficient of input_row */
+   float            mirror_coeff,       /* coefficient of mirror_row */
+   int              n)                  /* number of samples */
+{
+   CONVOL_BYTES_KERNEL[CpuLevel()] (operation,output_row,input_row,
+                                    mirror_row,coeff,mirror_coeff,n);
+} /* ConvolutionBytes */
+
+/******************************************************************************/
+/* ConvolutionFloats runs the variant of ConvolutionFloatsKernel of the CPU.  */
+/******************************************************************************/
+static void ConvolutionFloats (
+   int              operation,          /* CONVOL_SET ... CONVOL_ADD_PAIR */
+   float            *output_row,        /* accumulated values */
+   float            *input_row,         /* input samples */
+   float            *mirror_row,        /* mirrored input samples */
+   float            coeff,              /* coefficient of input_row */
+   float            mirror_coeff,       /* coefficient of mirror_row */
+   int              n)                  /* number of samples */
+{
+   CONVOL_FLOATS_KERNEL[CpuLevel()] (operation,output_row,input_row,
+                                     mirror_row,coeff,mirror_coeff,n);
+} /* ConvolutionFloats */
+
+/******************************************************************************/
+/* ConvolutionPairing returns the operation adding the products of two        */
+/* mirrored samples by their coefficients (separable vectors).                */
+/******************************************************************************/
+static int ConvolutionPairing (
+   float            coeff,              /* coefficient of the sample */
+   float            mirror_coeff)       /* coefficient of the mirrored one */
+{
+   if (coeff == mirror_coeff)
+      return (CONVOL_ADD_SUM);
+   if (coeff == -mirror_coeff)
+      return (CONVOL_ADD_DIFFERENCE);
+   return (CONVOL_ADD_PAIR);
+} /* ConvolutionPairing */
+
+/******************************************************************************/
+/* ConvolutionDirectLine accumulates coeff(k,l) * in(ili+k,ipx+l) for the     */
+/* inner pixels of one line, line by line of the matrix. input_line[half+k]   */
+/* is the input line ili+k.                                                   */
+/******************************************************************************/
+static void ConvolutionDirectLine (
+   type_convol      *convol,            /* convolution being applied */
+   unsigned char    *input_line[],      /* the size input lines around ili */
+   float            *output_row,        /* accumulated values of the line */
+   int              npxin)              /* input pixel number */
+{
+   int              half;               /* half size of the matrix */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among lines in matrix */
+   int              l;                  /* index among columns in matrix */
+   float            coeff;              /* current matrix coefficient */
+
+   half = convol->size / 2;
+   for (ipx=half; ipx<npxin-half; ipx++)
+      output_row[ipx] = 0.0;
+   for (k=-half; k<=half; k++)
+   {
+      for (l=-half; l<=half; l++)
+      {
+         coeff = convol->coeff[(k+half)*convol->size+(l+half)];
+         if (coeff == 0.0)
+            continue;
+         ConvolutionBytes (CONVOL_ADD,&(output_row[half]),
+            &(input_line[half+k][half+l]),NULL,coeff,0.0,npxin-2*half);
+      }
+   }
+} /* ConvolutionDirectLine */
+
+/******************************************************************************/
+/* ConvolutionFoldedLine accumulates the inner pixels of one line for a       */
+/* symmetric or antisymmetric matrix: the samples at (k,l) and (-k,-l) are    */
+/* added (subtracted) before the multiply.                                    */
+/******************************************************************************/
+static void ConvolutionFoldedLine (
+   type_convol      *convol,            /* convolution being applied */
+   unsigned char    *input_line[],      /* the size input lines around ili */
+   float            *output_row,        /* accumulated values of the line */
+   int              npxin)              /* input pixel number */
+{
+   int              half;               /* half size of the matrix */
+   int              operation;          /* CONVOL_ADD_SUM or _DIFFERENCE */
+   int              n;                  /* index among coefficients */
+   int              k;                  /* line of coefficient n in matrix */
+   int              l;                  /* column of coefficient n in matrix */
+   float            coeff;              /* current matrix coefficient */
+
+   half      = convol->size / 2;
+   operation = (ConvolProperties(convol) & CONVOL_IS_SYMMETRIC) ?
+               CONVOL_ADD_SUM : CONVOL_ADD_DIFFERENCE;
+/*----------------------------------------------------------------------------*/
+/* Central coefficient, then the pairs of the first half of the matrix        */
+/*----------------------------------------------------------------------------*/
+   ConvolutionBytes (CONVOL_SET,&(output_row[half]),&(input_line[half][half]),
+      NULL,convol->coeff[half*convol->size+half],0.0,npxin-2*half);
+   for (n=0; n<convol->size*convol->size/2; n++)
+   {
+      coeff = convol->coeff[n];
+      if (coeff == 0.0)
+         continue;
+      k = n / convol->size - half;
+      l = n % convol->size - half;
+      ConvolutionBytes (operation,&(output_row[half]),
+         &(input_line[half+k][half+l]),&(input_line[half-k][half-l]),coeff,
+         0.0,npxin-2*half);
+   }
+} /* ConvolutionFoldedLine */
+
+/******************************************************************************/
+/* ConvolutionLine computes one output line with the direct method from the   */
+/* size input lines around it (input_line[half] is the line itself), with the */
+/* same products in the same order as ConvolutionApply(CONVOL_DIRECT): folded */
+/* for symmetric and antisymmetric matrices. The line must be an inner one    */
+/* (half <= ili < nliin - half); the half first and last pixels keep their    */
+/* origin value. output_row is a work row of npxin floats.                    */
+/******************************************************************************/
+void ConvolutionLine (
+   type_convol      *convol,            /* convolution to be applied */
+   unsigned char    *input_line[],      /* the size input lines around ili */
+   unsigned char    *output_line,       /* output line ili */
+   int              npxin,              /* input pixel number */
+   float            *output_row)        /* work row of npxin floats */
+{
+   if (npxin <= 2*(convol->size/2))
+   {
+      memcpy (output_line,input_line[convol->size/2],npxin);
+      return;
+   }
+   if (ConvolProperties(convol) &
+       (CONVOL_IS_SYMMETRIC | CONVOL_IS_ANTISYMMETRIC))
+      ConvolutionFoldedLine (convol,input_line,output_row,npxin);
+   else
+      ConvolutionDirectLine (convol,input_line,output_row,npxin);
+   ConvolutionStore (convol,output_row,input_line[convol->size/2],
+                     output_line,npxin);
+} /* ConvolutionLine */
+
+/******************************************************************************/
+/* ConvolutionRows applies the convolution on lines [ili_first,ili_last[ of   */
+/* one channel with the direct method. Other lines of image_in are only read. */
+/******************************************************************************/
+int ConvolutionRows (
+   type_convol      *convol,            /* convolution to be applied */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              half;               /* half size of the matrix */
+   int              ili;                /* index among lines */
+   int              k;                  /* index among lines in matrix */
+   float            *output_row;        /* accumulated values of one line */
+   unsigned char    *input_line[MAX_FFT_SIZE]; /* input lines around ili */
+
+   half = convol->size / 2;
+   if ((output_row=(float*)malloc(npxin*sizeof(float))) == NULL)
+      return (1);
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+/*----------------------------------------------------------------------------*/
+/*    Lines where the matrix does not fit keep their origin value             */
+/*----------------------------------------------------------------------------*/
+      if ((ili < half) || (ili >= nliin-half) || (npxin <= 2*half))
+      {
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),npxin);
+         continue;
+      }
+/*----------------------------------------------------------------------------*/
+/*    Accumulate coeff(k,l) * in(ili+k,ipx+l) line by line of the matrix      */
+/*----------------------------------------------------------------------------*/
+      for (k=-half; k<=half; k++)
+         input_line[half+k] = &(image_in[(ili+k)*npxin]);
+      ConvolutionDirectLine (convol,input_line,output_row,npxin);
+      ConvolutionStore (convol,output_row,&(image_in[ili*npxin]),
+                        &(image_out[ili*npxin]),npxin);
+   } /* Loop on lines */
+   free (output_row);
+   return (0);
+} /* ConvolutionRows */
+
+/******************************************************************************/
+/* ConvolutionFoldedRows applies a symmetric or antisymmetric matrix on lines */
+/* [ili_first,ili_last[ of one channel with the direct method (see            */
+/* ConvolutionFoldedLine).                                                    */
+/******************************************************************************/
+static int ConvolutionFoldedRows (
+   type_convol      *convol,            /* convolution to be applied */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              half;               /* half size of the matrix */
+   int              ili;                /* index among lines */
+   int              k;                  /* index among lines in matrix */
+   float            *output_row;        /* accumulated values of one line */
+   unsigned char    *input_line[MAX_FFT_SIZE]; /* input lines around ili */
+
+   half = convol->size / 2;
+   if ((output_row=(float*)malloc(npxin*sizeof(float))) == NULL)
+      return (1);
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      if ((ili < half) || (ili >= nliin-half) || (npxin <= 2*half))
+      {
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),npxin);
+         continue;
+      }
+      for (k=-half; k<=half; k++)
+         input_line[half+k] = &(image_in[(ili+k)*npxin]);
+      ConvolutionFoldedLine (convol,input_line,output_row,npxin);
+      ConvolutionStore (convol,output_row,&(image_in[ili*npxin]),
+                        &(image_out[ili*npxin]),npxin);
+   } /* Loop on lines */
+   free (output_row);
+   return (0);
+} /* ConvolutionFoldedRows */
+
+/******************************************************************************/
+/* ConvolutionShiftRows applies a matrix with a single coefficient on lines   */
+/* [ili_first,ili_last[ of one channel: each output line is a segment of one  */
+/* input line, copied as is for a unit shift, scaled otherwise.               */
+/******************************************************************************/
+static int ConvolutionShiftRows (
+   type_convol      *convol,            /* convolution to be applied */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   int              half;               /* half size of the matrix */
+   int              unit;               /* "pure move" flag */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   float            coeff;              /* single coefficient */
+   float            *output_row;        /* scaled values of one line */
+   unsigned char    *input_row;         /* input line shifted by the matrix */
+
+   half  = convol->size / 2;
+   unit  = ConvolutionUnitShift (convol);
+   coeff = convol->coeff[(convol->shift_line+half)*convol->size+
+                         convol->shift_pixel+half];
+   if ((output_row=(float*)malloc(npxin*sizeof(float))) == NULL)
+      return (1);
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      if ((ili < half) || (ili >= nliin-half) || (npxin <= 2*half))
+      {
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),npxin);
+         continue;
+      }
+      input_row = &(image_in[(ili+convol->shift_line)*npxin+
+                             convol->shift_pixel]);
+      if (unit)
+      {
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),half);
+         memcpy (&(image_out[ili*npxin+npxin-half]),
+                 &(image_in[ili*npxin+npxin-half]),half);
+         memcpy (&(image_out[ili*npxin+half]),&(input_row[half]),
+                 npxin-2*half);
+         continue;
+      }
+      for (ipx=half; ipx<npxin-half; ipx++)
+         output_row[ipx] = coeff * input_row[ipx];
+      ConvolutionStore (convol,output_row,&(image_in[ili*npxin]),
+                        &(image_out[ili*npxin]),npxin);
+   } /* Loop on lines */
+   free (output_row);
+   return (0);
+} /* ConvolutionShiftRows */
+
+/******************************************************************************/
+/* ConvolutionSeparableRows applies the convolution on lines                  */
+/* [ili_first,ili_last[ of one channel with the separable method: for each    */
+/* line, the vertical vector is applied on the size input lines around it,    */
+/* then the horizontal vector on the resulting line. No plane is allocated.   */
+/* Mirrored lines (pixels) are folded where the vector is symmetric or        */
+/* antisymmetric.                                                             */
+/******************************************************************************/
+static int ConvolutionSeparableRows (
+   type_convol      *convol,            /* convolution to be applied */
+   float            *vertical,          /* vector along lines */
+   float            *horizontal,        /* vector along pixels */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   int              half;               /* half size of the matrix */
+   int              ili;                /* index among lines */
+   int              k;                  /* index among lines in matrix */
+   int              l;                  /* index among columns in matrix */
+   float            *column_row;        /* line after the vertical vector */
+   float            *output_row;        /* line after the horizontal vector */
+
+   half = convol->size / 2;
+   if (((column_row=(float*)malloc(npxin*sizeof(float))) == NULL)           ||
+       ((output_row=(float*)malloc(npxin*sizeof(float))) == NULL))
+   {
+      free (column_row);
+      return (1);
+   }
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      if ((ili < half) || (ili >= nliin-half) || (npxin <= 2*half))
+      {
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),npxin);
+         continue;
+      }
+/*----------------------------------------------------------------------------*/
+/*    Vertical vector on whole lines                                          */
+/*----------------------------------------------------------------------------*/
+      ConvolutionBytes (CONVOL_SET,column_row,&(image_in[ili*npxin]),NULL,
+         vertical[half],0.0,npxin);
+      for (k=1; k<=half; k++)
+      {
+         if ((vertical[half+k] == 0.0) && (vertical[half-k] == 0.0))
+            continue;
+         ConvolutionBytes (ConvolutionPairing(vertical[half+k],
+            vertical[half-k]),column_row,&(image_in[(ili+k)*npxin]),
+            &(image_in[(ili-k)*npxin]),vertical[half+k],vertical[half-k],
+            npxin);
+      }
+/*----------------------------------------------------------------------------*/
+/*    Horizontal vector on the resulting line                                 */
+/*----------------------------------------------------------------------------*/
+      ConvolutionFloats (CONVOL_SET,&(output_row[half]),&(column_row[half]),
+         NULL,horizontal[half],0.0,npxin-2*half);
+      for (l=1; l<=half; l++)
+      {
+         if ((horizontal[half+l] == 0.0) && (horizontal[half-l] == 0.0))
+            continue;
+         ConvolutionFloats (ConvolutionPairing(horizontal[half+l],
+            horizontal[half-l]),&(output_row[half]),&(column_row[half+l]),
+            &(column_row[half-l]),horizontal[half+l],horizontal[half-l],
+            npxin-2*half);
+      }
+      ConvolutionStore (convol,output_row,&(image_in[ili*npxin]),
+                        &(image_out[ili*npxin]),npxin);
+   } /* Loop on lines */
+   free (column_row);
+   free (output_row);
+   return (0);
+} /* ConvolutionSeparableRows */
+
+/******************************************************************************/
+/* ConvolutionSpectrum returns the (tile x tile) spectrum of the flipped      */
+/* matrix, divided by tile*tile to account for the unscaled inverse FFT.      */
+/******************************************************************************/
+static type_complex *ConvolutionSpectrum (
+   type_convol      *convol,            /* convolution to be applied */
+   int              tile_size)          /* size of the tiles */
+{
+   type_fft         *fft;               /* transform of tile_size points */
+   type_complex     *spectrum;          /* spectrum being computed */
+   int              size;               /* size of the matrix */
+   int              u;                  /* line in flipped matrix */
+   int              v;                  /* column in flipped matrix */
+
+   size = convol->size;
+   if ((fft=FftCreate(tile_size)) == NULL)
+      return (NULL);
+   if ((spectrum=(type_complex*)calloc(tile_size*tile_size,
+                                       sizeof(type_complex))) == NULL)
+   {
+      FftDestroy (fft);
+      return (NULL);
+   }
+   for (u=0; u<size; u++)
+   {
+      for (v=0; v<size; v++)
+      {
+         spectrum[u*tile_size+v].re = convol->coeff[(size-1-u)*size+(size-1-v)]
+                                      / ((float)tile_size * tile_size);
+      }
+   }
+   Fft2D (fft,spectrum,0);
+   FftDestroy (fft);
+   return (spectrum);
+} /* ConvolutionSpectrum */
+
+/******************************************************************************/
+/* ConvolutionFftRows applies the convolution on lines [ili_first,ili_last[   */
+/* of one channel with the FFT method.                                        */
+/* The input lines needed by the band (band plus halo) are cut into blocks of */
+/* (tile - size + 1) x (tile - size + 1) pixels; two horizontally adjacent    */
+/* blocks are put in the real and imaginary parts of one complex tile, which  */
+/* is transformed, multiplied by the spectrum and transformed back: since the */
+/* matrix is real, the real and imaginary parts of the result are the full    */
+/* convolutions of both blocks. These are added into a rolling accumulator of */
+/* tile lines; when a row of blocks is done, its first block lines are        */
+/* complete, reported and dropped, the size - 1 next lines are kept.          */
+/******************************************************************************/
+static int ConvolutionFftRows (
+   type_convol      *convol,            /* convolution to be applied */
+   type_complex     *spectrum,          /* spectrum of the matrix */
+   int              tile_size,          /* size of the tiles */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              size;               /* size of the matrix */
+   int              half;               /* half size of the matrix */
+   int              block;              /* size of the input blocks */
+   int              width;              /* pixels of a full convolution line */
+   int              block_number;       /* number of blocks along a line */
+   int              ili;                /* index among lines */
+   int              ili_in;             /* first input line of the band */
+   int              nli_in;             /* number of input lines of the band */
+   int              ili_block;          /* first band line of current blocks */
+   int              nli_block;          /* number of lines of current blocks */
+   int              iblock;             /* index of the "real" block */
+   int              u;                  /* line in tile */
+   int              v;                  /* column in tile */
+   int              column;             /* column in full convolution */
+   float            re;                 /* real part of the product */
+   float            im;                 /* imaginary part of the product */
+   type_fft         *fft;               /* transform of tile_size points */
+   type_complex     *tile;              /* tile being transformed */
+   float            *accumulator;       /* tile_size full convolution lines */
+
+   size   = convol->size;
+   half   = size / 2;
+   block  = tile_size - size + 1;
+   width  = npxin + size - 1;
+/*----------------------------------------------------------------------------*/
+/* Lines where the matrix does not fit keep their origin value                */
+/*----------------------------------------------------------------------------*/
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      if ((ili < half) || (ili >= nliin-half) || (npxin <= 2*half))
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),npxin);
+   }
+   if (ili_first < half)
+      ili_first = half;
+   if (ili_last > nliin-half)
+      ili_last = nliin-half;
+   if ((ili_first >= ili_last) || (npxin <= 2*half))
+      return (0);
+/*----------------------------------------------------------------------------*/
+/* Allocate the tile, the accumulator and the transform                       */
+/*----------------------------------------------------------------------------*/
+   fft         = FftCreate (tile_size);
+   tile        = (type_complex*)malloc(tile_size*tile_size*sizeof(type_complex));
+   accumulator = (float*)calloc(tile_size*width,sizeof(float));
+   if ((fft == NULL) || (tile == NULL) || (accumulator == NULL))
+   {
+      FftDestroy (fft);
+      free (tile);
+      free (accumulator);
+      return (1);
+   }
+   block_number = (npxin + block - 1) / block;
+   ili_in       = ili_first - half;
+   nli_in       = (ili_last + half) - ili_in;
+/*============================================================================*/
+/* Loop on rows of blocks                                                     */
+/*============================================================================*/
+   for (ili_block=0; ili_block<nli_in; ili_block=ili_block+block)
+   {
+      nli_block = nli_in - ili_block;
+      if (nli_block > block)
+         nli_block = block;
+      for (iblock=0; iblock<block_number; iblock=iblock+2)
+      {
+/*----------------------------------------------------------------------------*/
+/*       Blocks iblock and iblock+1 in the real and imaginary parts           */
+/*----------------------------------------------------------------------------*/
+         memset (tile,0,tile_size*tile_size*sizeof(type_complex));
+         for (u=0; u<nli_block; u++)
+         {
+            for (v=0; v<block; v++)
+            {
+               column = iblock*block + v;
+               if (column < npxin)
+                  tile[u*tile_size+v].re =
+                     image_in[(ili_in+ili_block+u)*npxin+column];
+               column = column + block;
+               if (column < npxin)
+                  tile[u*tile_size+v].im =
+                     image_in[(ili_in+ili_block+u)*npxin+column];
+            }
+         }
+/*----------------------------------------------------------------------------*/
+/*       Product with the spectrum of the matrix                              */
+/*----------------------------------------------------------------------------*/
+         Fft2D (fft,tile,0);
+         for (u=0; u<tile_size*tile_size; u++)
+         {
+            re = tile[u].re * spectrum[u].re - tile[u].im * spectrum[u].im;
+            im = tile[u].re * spectrum[u].im + tile[u].im * spectrum[u].re;
+            tile[u].re = re;
+            tile[u].im = im;
+         }
+         Fft2D (fft,tile,1);
+/*----------------------------------------------------------------------------*/
+/*       Overlap-add both full convolutions into the accumulator              */
+/*----------------------------------------------------------------------------*/
+         for (u=0; u<tile_size; u++)
+         {
+            for (v=0; v<tile_size; v++)
+            {
+               column = iblock*block + v;
+               if (column < width)
+                  accumulator[u*width+column] += tile[u*tile_size+v].re;
+               column = column + block;
+               if ((column < width) && (iblock+1 < block_number))
+                  accumulator[u*width+column] += tile[u*tile_size+v].im;
+            }
+         }
+      } /* Loop on blocks */
+/*----------------------------------------------------------------------------*/
+/*    Report the completed lines; full convolution line (size-1) of the band  */
+/*    is output line ili_first                                                */
+/*----------------------------------------------------------------------------*/
+      for (u=0; u<block; u++)
+      {
+         ili = ili_in + ili_block + u - half;
+         if ((ili_block + u >= size - 1) && (ili < ili_last))
+            ConvolutionStore (convol,&(accumulator[u*width+half]),
+                              &(image_in[ili*npxin]),&(image_out[ili*npxin]),
+                              npxin);
+      }
+      memmove (accumulator,&(accumulator[block*width]),
+               (tile_size-block)*width*sizeof(float));
+      memset (&(accumulator[(tile_size-block)*width]),0,
+              block*width*sizeof(float));
+   } /* Loop on rows of blocks */
+   FftDestroy (fft);
+   free (tile);
+   free (accumulator);
+   return (0);
+} /* ConvolutionFftRows */
+
+/******************************************************************************/
+/* Convolution applies the convolution on all the channels, serially, with    */
+/* the direct method. It is the reference implementation of the others.       */
+/******************************************************************************/
+int Convolution (
+   type_convol      *convol,            /* convolution to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              ichannel;           /* index among channels */
+
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      if (ConvolutionRows(convol,image_in[ichannel],image_out[ichannel],
+                          nliin,npxin,0,nliin) != 0)
+         return (1);
+   }
+   return (0);
+} /* Convolution */
+
+/******************************************************************************/
+/* ConvolutionBand is the pool task computing one (channel,band) pair.        */
+/******************************************************************************/
+static void ConvolutionBand (
+   void             *argument,          /* type_band_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_band_job    *job;               /* job the task belongs to */
+   int              ichannel;           /* channel of the band */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              status;             /* status of the band */
+
+   job       = (type_band_job*)argument;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   switch (job->method)
+   {
+      case CONVOL_SEPARABLE:
+         status = ConvolutionSeparableRows (job->convol,job->vertical,
+                     job->horizontal,job->image_in[ichannel],
+                     job->image_out[ichannel],job->nliin,job->npxin,
+                     ili_first,ili_last);
+         break;
+      case CONVOL_FFT:
+         status = ConvolutionFftRows (job->convol,job->spectrum,job->tile_size,
+                     job->image_in[ichannel],job->image_out[ichannel],
+                     job->nliin,job->npxin,ili_first,ili_last);
+         break;
+      default:
+         if (job->convol->property & CONVOL_IS_SHIFT)
+            status = ConvolutionShiftRows (job->convol,job->image_in[ichannel],
+                        job->image_out[ichannel],job->nliin,job->npxin,
+                        ili_first,ili_last);
+         else if (job->convol->property &
+                  (CONVOL_IS_SYMMETRIC | CONVOL_IS_ANTISYMMETRIC))
+            status = ConvolutionFoldedRows (job->convol,
+                        job->image_in[ichannel],job->image_out[ichannel],
+                        job->nliin,job->npxin,ili_first,ili_last);
+         else
+            status = ConvolutionRows (job->convol,job->image_in[ichannel],
+                        job->image_out[ichannel],job->nliin,job->npxin,
+                        ili_first,ili_last);
+         break;
+   }
+   if (status != 0)
+      job->status = 1;
+} /* ConvolutionBand */
+
+/******************************************************************************/
+/* ConvolutionApply applies the convolution on all the channels concurrently, */
+/* each channel being cut into bands of lines run on the thread pool, with    */
+/* the given method (CONVOL_AUTO: chosen by ConvolutionMethod()).             */
+/* A method that does not apply (CONVOL_SEPARABLE on a non separable matrix,  */
+/* CONVOL_FFT with no tile for the image, see ConvolutionCost()) falls back   */
+/* to CONVOL_DIRECT. The identity matrix is a mere copy.                      */
+/******************************************************************************/
+int ConvolutionApply (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_convol      *convol,            /* convolution to be applied */
+   int              method,             /* method, or CONVOL_AUTO */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_band_job    job;                /* job shared by all the bands */
+   float            vertical[MAX_FFT_SIZE];   /* separable: vertical vector */
+   float            horizontal[MAX_FFT_SIZE]; /* separable: horizontal vector */
+   int              min_lines;          /* smallest height of a band */
+   int              ichannel;           /* index among channels */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   if ((convol->size < 1) || (convol->size > MAX_FFT_SIZE))
+      return (1);
+/*----------------------------------------------------------------------------*/
+/* The identity matrix copies the image                                       */
+/*----------------------------------------------------------------------------*/
+   if (ConvolProperties(convol) & CONVOL_IS_IDENTITY)
+   {
+      for (ichannel=0; ichannel<channel_number; ichannel++)
+      {
+         if (image_out[ichannel] != image_in[ichannel])
+            memcpy (image_out[ichannel],image_in[ichannel],nliin*npxin);
+      }
+      return (0);
+   }
+   job.convol      = convol;
+   job.method      = method;
+   job.vertical    = vertical;
+   job.horizontal  = horizontal;
+   job.tile_size   = 0;
+   job.spectrum    = NULL;
+   job.image_in    = image_in;
+   job.image_out   = image_out;
+   job.nliin       = nliin;
+   job.npxin       = npxin;
+   job.status      = 0;
+   min_lines       = MIN_BAND_LINES;
+/*----------------------------------------------------------------------------*/
+/* Choose the method and prepare its data                                     */
+/*----------------------------------------------------------------------------*/
+   if (job.method == CONVOL_AUTO)
+      job.method = ConvolutionMethod (convol,nliin,npxin,&job.tile_size);
+   if (job.method == CONVOL_SEPARABLE)
+   {
+      if (convol->property & CONVOL_IS_SEPARABLE)
+         ConvolSeparate (convol,vertical,horizontal);
+      else
+         job.method = CONVOL_DIRECT;
+   }
+   if ((job.method == CONVOL_FFT) && (job.tile_size == 0)                   &&
+       (ConvolutionCost(convol,CONVOL_FFT,nliin,npxin,&job.tile_size) < 0.))
+      job.method = CONVOL_DIRECT;
+   if (job.method == CONVOL_FFT)
+   {
+      if ((job.spectrum=ConvolutionSpectrum(convol,job.tile_size)) == NULL)
+         return (1);
+/*----------------------------------------------------------------------------*/
+/*    Each FFT band recomputes its halo: keep bands at least a few blocks high*/
+/*----------------------------------------------------------------------------*/
+      min_lines = 4 * (job.tile_size - convol->size + 1);
+   }
+/*----------------------------------------------------------------------------*/
+/* Enough bands to balance the load, but not thinner than min_lines           */
+/*----------------------------------------------------------------------------*/
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      channel_number - 1) / channel_number;
+   if (job.band_number > nliin / min_lines)
+      job.band_number = nliin / min_lines;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+
+   PoolRun (pool,channel_number*job.band_number,ConvolutionBand,&job);
+   free (job.spectrum);
+   return (job.status);
+} /* ConvolutionApply */
+
+/******************************************************************************/
+/* ConvolutionBands applies the convolution with the direct method on all     */
+/* the channels concurrently. The output is identical to Convolution().       */
+/******************************************************************************/
+int ConvolutionBands (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_convol      *convol,            /* convolution to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   return (ConvolutionApply(pool,convol,CONVOL_DIRECT,channel_number,image_in,
+                            image_out,nliin,npxin));
+} /* ConvolutionBands */
+
+/******************************************************************************/
+/* ConvolutionImageBand is the pool task computing one (channel,band) pair of */
+/* ConvolutionImage().                                                        */
+/******************************************************************************/
+static void ConvolutionImageBand (
+   void             *argument,          /* type_image_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_image_job   *job;               /* job the task belongs to */
+   type_convol      *convol;            /* convolution to be applied */
+   int              ichannel;           /* channel of the band */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              half;               /* half size of the matrix */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among lines in matrix */
+   int              l;                  /* index among columns in matrix */
+   int              n;                  /* index among coefficients */
+   int              stride;             /* stride of the input image */
+   int              folded;             /* "mirrored samples paired" flag */
+   int              unit;               /* "pure move" flag */
+   int              operation;          /* CONVOL_ADD_SUM or _DIFFERENCE */
+   float            coeff;              /* current matrix coefficient */
+   float            centre;             /* central coefficient */
+   float            *output_row;        /* accumulated values of one line */
+   unsigned char    *input_row;         /* input line ili */
+   unsigned char    *output_line;       /* output line ili */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+
+   job       = (type_image_job*)argument;
+   convol    = job->convol;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->image_in->nliin)
+      ili_last = job->image_in->nliin;
+   nliin     = job->image_in->nliin;
+   npxin     = job->image_in->npxin;
+   half      = convol->size / 2;
+   stride    = job->image_in->stride;
+   unit      = ConvolutionUnitShift (convol);
+   folded    = (ConvolProperties(convol) &
+                (CONVOL_IS_SYMMETRIC | CONVOL_IS_ANTISYMMETRIC)) != 0;
+   operation = (ConvolProperties(convol) & CONVOL_IS_SYMMETRIC) ?
+               CONVOL_ADD_SUM : CONVOL_ADD_DIFFERENCE;
+   centre    = convol->coeff[half*convol->size+half];
+   if ((output_row=(float*)malloc(job->width*sizeof(float))) == NULL)
+   {
+      job->status = 1;
+      return;
+   }
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      input_row   = &(job->image_in->plane[ichannel][ili*stride]);
+      output_line = &(job->image_out->plane[ichannel][ili*
+                                                      job->image_out->stride]);
+/*----------------------------------------------------------------------------*/
+/*    Unit shift: a move of the shifted input line, as ConvolutionShiftRows   */
+/*----------------------------------------------------------------------------*/
+      if (unit)
+         memcpy (output_line,&(input_row[convol->shift_line*stride+
+                                         convol->shift_pixel]),job->width);
+/*----------------------------------------------------------------------------*/
+/*    Symmetric and antisymmetric matrices: folded as ConvolutionFoldedRows   */
+/*----------------------------------------------------------------------------*/
+      else if (folded)
+      {
+         ConvolutionBytes (CONVOL_SET,output_row,input_row,NULL,centre,0.0,
+            job->width);
+         for (n=0; n<convol->size*convol->size/2; n++)
+         {
+            coeff = convol->coeff[n];
+            if (coeff == 0.0)
+               continue;
+            k = n / convol->size - half;
+            l = n % convol->size - half;
+            ConvolutionBytes (operation,output_row,
+               &(job->image_in->plane[ichannel][(ili+k)*stride+l]),
+               &(job->image_in->plane[ichannel][(ili-k)*stride-l]),coeff,0.0,
+               job->width);
+         }
+      }
+/*----------------------------------------------------------------------------*/
+/*    Other matrices: coeff(k,l) * in(ili+k,ipx+l) as ConvolutionRows         */
+/*----------------------------------------------------------------------------*/
+      else
+      {
+         for (ipx=0; ipx<job->width; ipx++)
+            output_row[ipx] = 0.0;
+         for (k=-half; k<=half; k++)
+         {
+            for (l=-half; l<=half; l++)
+            {
+               coeff = convol->coeff[(k+half)*convol->size+(l+half)];
+               if (coeff == 0.0)
+                  continue;
+               ConvolutionBytes (CONVOL_ADD,output_row,
+                  &(job->image_in->plane[ichannel][(ili+k)*stride+l]),NULL,
+                  coeff,0.0,job->width);
+            }
+         }
+      }
+      if (!unit)
+         SaturateRow (output_row,output_line,job->width,convol->gain,
+                      convol->offset);
+/*----------------------------------------------------------------------------*/
+/*    Border pixels, where the matrix does not fit, keep their origin value   */
+/*----------------------------------------------------------------------------*/
+      if ((ili < half) || (ili >= nliin-half) || (npxin <= 2*half))
+         memcpy (output_line,input_row,npxin);
+      else if (half > 0)
+      {
+         memcpy (output_line,input_row,half);
+         memcpy (&(output_line[npxin-half]),&(input_row[npxin-half]),half);
+      }
+   }
+   free (output_row);
+} /* ConvolutionImageBand */
+
+/******************************************************************************/
+/* ConvolutionImage applies the convolution with the direct method on all the */
+/* channels concurrently; border pixels keep their origin value and the       */
+/* identity matrix is a mere copy, as with ConvolutionApply(). image_in must  */
+/* have at least size/2 guards, filled by ImageExtend(). When both images     */
+/* have padded lines (ImageAllocGuard), the padding of the output lines is    */
+/* computed too. Returns 1 if the guards are too thin or memory is lacking.   */
+/******************************************************************************/
+int ConvolutionImage (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_convol      *convol,            /* convolution to be applied */
+   type_image       *image_in,          /* input image, guards extended */
+   type_image       *image_out)         /* output image, same size */
+{
+   type_image_job   job;                /* job shared by all the bands */
+   int              nliin;              /* input line number */
+
+   if ((convol->size < 1) || (convol->size/2 > image_in->guard)            ||
+       (image_out->nliin != image_in->nliin)                               ||
+       (image_out->npxin != image_in->npxin)                               ||
+       (image_out->channel_number < image_in->channel_number))
+      return (1);
+   if (ConvolProperties(convol) & CONVOL_IS_IDENTITY)
+   {
+      if (image_out->plane[0] != image_in->plane[0])
+         ImageCopy (image_in,image_out);
+      return (0);
+   }
+   nliin         = image_in->nliin;
+   job.convol    = convol;
+   job.image_in  = image_in;
+   job.image_out = image_out;
+   job.width     = image_out->npx_padded;
+   if (job.width > image_in->npx_padded)
+      job.width = image_in->npxin;
+   job.status    = 0;
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      image_in->channel_number - 1) / image_in->channel_number;
+   if (job.band_number > nliin / MIN_BAND_LINES)
+      job.band_number = nliin / MIN_BAND_LINES;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+   PoolRun (pool,image_in->channel_number*job.band_number,
+            ConvolutionImageBand,&job);
+   return (job.status);
+} /* ConvolutionImage */
@@ -0,0 +1,86 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* convol gathers the convolution matrices of TD6 and the functions applying  */
+/* them on the image arrays.                                                  */
+/******************************************************************************/
+#ifndef CONVOL_H
+#define CONVOL_H
+
+#include  "pool.h"
+#include  "image.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_SIZE    11                  /* largest size of CONVOL[] matrices */
+#define MAX_FFT_SIZE 255                /* largest size of any matrix */
+
+#define CONVOL_AUTO      (-1)           /* method chosen by the cost model */
+#define CONVOL_DIRECT    0              /* size x size products per pixel */
+#define CONVOL_SEPARABLE 1              /* lines then columns, 2 x size */
+#define CONVOL_FFT       2              /* overlap-add of FFT tiles */
+
+#define CONVOL_IS_SEPARABLE     0x01    /* outer product of two vectors */
+#define CONVOL_IS_SYMMETRIC     0x02    /* coeff(-k,-l) =  coeff(k,l) */
+#define CONVOL_IS_ANTISYMMETRIC 0x04    /* coeff(-k,-l) = -coeff(k,l) */
+#define CONVOL_IS_INTEGER       0x08    /* integer coefficients */
+#define CONVOL_IS_ZERO_SUM      0x10    /* coefficients summing to 0 */
+#define CONVOL_IS_SHIFT         0x20    /* a single nonzero coefficient */
+#define CONVOL_IS_IDENTITY      0x40    /* shift by (0,0), output = input */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   char             name[100];          /* name displayed in the menu */
+   int              size;               /* size of the (size x size) matrix */
+   float            gain;               /* multiplicative factor */
+   float            offset;             /* value added after the gain */
+   float            *coeff;             /* matrix coefficients, line by line */
+   int              analyzed;           /* "properties are up to date" */
+   int              property;           /* CONVOL_IS_... flags */
+   int              nonzero;            /* number of nonzero coefficients */
+   int              shift_line;         /* shift: line offset of the input */
+   int              shift_pixel;        /* shift: pixel offset of the input */
+} type_convol;
+
+/******************************************************************************/
+/* Global data                                                                */
+/******************************************************************************/
+extern type_convol  *CONVOL;            /* convolution matrices (registry) */
+extern int          CONVOL_NUMBER;      /* number of entries in CONVOL[] */
+extern char         *CONVOL_METHOD_NAME[3]; /* names of the methods */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+type_convol *ConvolFind (char *name);
+int ConvolGauss (int size, type_convol *convol);
+int ConvolSeparate (type_convol *convol, float *vertical, float *horizontal);
+int ConvolAnalyze (type_convol *convol);
+int ConvolProperties (type_convol *convol);
+char *ConvolPropertyString (type_convol *convol, char *string);
+double ConvolutionCost (type_convol *convol, int method, int nliin, int npxin,
+                        int *tile_size);
+int ConvolutionMethod (type_convol *convol, int nliin, int npxin,
+                       int *tile_size);
+
+void ConvolutionLine (type_convol *convol, unsigned char *input_line[],
+                      unsigned char *output_line, int npxin,
+                      float *output_row);
+int ConvolutionRows (type_convol *convol, unsigned char *image_in,
+                     unsigned char *image_out, int nliin, int npxin,
+                     int ili_first, int ili_last);
+int Convolution (type_convol *convol, int channel_number,
+                 unsigned char *image_in[3], unsigned char *image_out[3],
+                 int nliin, int npxin);
+int ConvolutionBands (type_pool *pool, type_convol *convol, int channel_number,
+                      unsigned char *image_in[3], unsigned char *image_out[3],
+                      int nliin, int npxin);
+int ConvolutionApply (type_pool *pool, type_convol *convol, int method,
+                      int channel_number, unsigned char *image_in[3],
+                      unsigned char *image_out[3], int nliin, int npxin);
+int ConvolutionImage (type_pool *pool, type_convol *convol,
+                      type_image *image_in, type_image *image_out);
+
+#endif /* CONVOL_H */
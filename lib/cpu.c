@@ -0,0 +1,115 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* cpu chooses at run time, from cpuid, the instruction set of the vectorized */
+/* kernels: scalar, SSE4.2, AVX2 or AVX-512.                                  */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* The processor is examined on the first call of CpuLevel() (by the kernels  */
+/* themselves, possibly from several threads at once: they all compute and    */
+/* store the same values). __builtin_cpu_supports() also checks that the      */
+/* operating system saves the AVX and AVX-512 registers.                      */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "cpu.h"
+
+/******************************************************************************/
+/* Global variables                                                           */
+/******************************************************************************/
+char *CPU_LEVEL_NAME[CPU_LEVEL_NUMBER] = { "scalar", "sse4.2", "avx2",
+                                           "avx512" };
+
+static int          CPU_SUPPORTED = -1; /* best level of the processor */
+static int          CPU_FEATURES = 0;   /* CPU_HAS_... of the processor */
+static int          CPU_LEVEL = -1;     /* level of the kernels */
+
+/******************************************************************************/
+/* CpuDetect examines the processor and reads ITI_CPU.                        */
+/******************************************************************************/
+static void CpuDetect (void)
+{
+   char             *name;              /* value of ITI_CPU */
+   int              supported;          /* best level of the processor */
+   int              level;              /* level asked by ITI_CPU */
+
+   supported = CPU_SCALAR;
+#ifdef CPU_X86
+   __builtin_cpu_init ();
+   if (__builtin_cpu_supports("sse4.2"))
+      supported = CPU_SSE42;
+   if ((supported == CPU_SSE42) && __builtin_cpu_supports("avx2"))
+      supported = CPU_AVX2;
+   if ((supported == CPU_AVX2) && __builtin_cpu_supports("avx512f")           &&
+       __builtin_cpu_supports("avx512bw"))
+      supported = CPU_AVX512;
+   if ((supported == CPU_AVX512) && __builtin_cpu_supports("avx512vbmi"))
+      CPU_FEATURES = CPU_HAS_VBMI;
+#endif
+   level = supported;
+   if ((name=getenv(CPU_ENV)) != NULL)
+   {
+      for (level=0; (level<CPU_LEVEL_NUMBER)                                  &&
+                    (strcmp(name,CPU_LEVEL_NAME[level]) != 0); level++)
+         ;
+      if (level == CPU_LEVEL_NUMBER)
+      {
+         fprintf (stderr,"cpu : unknown %s \"%s\", %s used.\n",CPU_ENV,name,
+            CPU_LEVEL_NAME[supported]);
+         level = supported;
+      }
+      else if (level > supported)
+         level = supported;
+   }
+   CPU_SUPPORTED = supported;
+   CPU_LEVEL     = level;
+} /* CpuDetect */
+
+/******************************************************************************/
+/* CpuLevel returns the level of the kernels: the best one of the processor,  */
+/* capped by ITI_CPU or CpuSelect().                                          */
+/******************************************************************************/
+int CpuLevel (void)
+{
+   if (CPU_LEVEL < 0)
+      CpuDetect ();
+   return (CPU_LEVEL);
+} /* CpuLevel */
+
+/******************************************************************************/
+/* CpuFeatures returns the CPU_HAS_... flags of the processor usable at the   */
+/* current level (CPU_HAS_VBMI: level CPU_AVX512 only).                       */
+/******************************************************************************/
+int CpuFeatures (void)
+{
+   return (CpuLevel() == CPU_AVX512 ? CPU_FEATURES : 0);
+} /* CpuFeatures */
+
+/******************************************************************************/
+/* CpuSupported returns the best level of the processor, whatever ITI_CPU.    */
+/******************************************************************************/
+int CpuSupported (void)
+{
+   if (CPU_SUPPORTED < 0)
+      CpuDetect ();
+   return (CPU_SUPPORTED);
+} /* CpuSupported */
+
+/******************************************************************************/
+/* CpuSelect sets the level of the kernels (to run every variant in turn).    */
+/* Must not be called while a pool runs. Returns 1 if the processor does not  */
+/* support it.                                                                */
+/******************************************************************************/
+int CpuSelect (
+   int              level)              /* CPU_SCALAR ... CPU_AVX512 */
+{
+   if ((level < CPU_SCALAR) || (level > CpuSupported()))
+      return (1);
+   CPU_LEVEL = level;
+   return (0);
+} /* CpuSelect */
@@ -0,0 +1,77 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* cpu chooses at run time, from cpuid, the instruction set of the vectorized */
+/* kernels: scalar, SSE4.2, AVX2 or AVX-512.                                  */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A kernel is written once in C (or with intrinsics when the compiler cannot */
+/* vectorize it) and compiled for each level with the CPU_TARGET_... function */
+/* attributes; the caller indexes a table of the variants by CpuLevel(). The  */
+/* library itself is built for the baseline of the architecture, so a single  */
+/* binary runs on every processor. CPU_TARGET_... disable the contraction of  */
+/* a * b + c into fused multiply-adds: all the levels give the same bytes.    */
+/*                                                                            */
+/* The environment variable ITI_CPU (scalar, sse4.2, avx2, avx512) caps the   */
+/* level, to compare the variants (check_ops, bench_ops).                     */
+/******************************************************************************/
+#ifndef CPU_H
+#define CPU_H
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define CPU_SCALAR      0               /* plain C, not vectorized */
+#define CPU_SSE42       1               /* SSE4.2 (SSSE3, SSE4.1): 16 bytes */
+#define CPU_AVX2        2               /* AVX2: 32 bytes */
+#define CPU_AVX512      3               /* AVX-512 F and BW: 64 bytes */
+#define CPU_LEVEL_NUMBER 4              /* number of levels */
+
+#define CPU_HAS_VBMI    0x01            /* AVX-512 VBMI (byte permutes) */
+
+#define CPU_ENV         "ITI_CPU"       /* variable capping the level */
+
+/******************************************************************************/
+/* Function attributes of the variants (GCC and clang on x86)                 */
+/******************************************************************************/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_X86
+#define CPU_TARGET_SCALAR  __attribute__((optimize("no-tree-vectorize",       \
+                                                   "fp-contract=off")))
+#define CPU_TARGET_SSE42   __attribute__((target("sse4.2"),                   \
+                              optimize("tree-vectorize",                      \
+                                       "vect-cost-model=dynamic",             \
+                                       "fp-contract=off")))
+#define CPU_TARGET_AVX2    __attribute__((target("avx2"),                     \
+                              optimize("tree-vectorize",                      \
+                                       "vect-cost-model=dynamic",             \
+                                       "fp-contract=off")))
+#define CPU_TARGET_AVX512  __attribute__((target("avx512f,avx512bw"),         \
+                              optimize("tree-vectorize",                      \
+                                       "vect-cost-model=dynamic",             \
+                                       "fp-contract=off")))
+#define CPU_TARGET_VBMI    __attribute__((target("avx512f,avx512bw,"          \
+                                                 "avx512vbmi")))
+#define CPU_INLINE         __attribute__((always_inline)) inline
+#else
+#define CPU_TARGET_SCALAR
+#define CPU_TARGET_SSE42
+#define CPU_TARGET_AVX2
+#define CPU_TARGET_AVX512
+#define CPU_TARGET_VBMI
+#define CPU_INLINE         inline
+#endif
+
+/******************************************************************************/
+/* Global variables                                                           */
+/******************************************************************************/
+extern char         *CPU_LEVEL_NAME[CPU_LEVEL_NUMBER]; /* values of ITI_CPU */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int CpuLevel (void);
+int CpuFeatures (void);
+int CpuSupported (void);
+int CpuSelect (int level);
+
+#endif /* CPU_H */
@@ -0,0 +1,494 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* display shows an origin and a processed image side by side in a window of  */
+/* a TrueColor visual, until a mouse button is pressed.                       */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* This is the X part that every skelet used to carry: connection to the X    */
+/* server, choice of the deepest TrueColor visual (24 bits down to 8), frame  */
+/* buffers built from the images (InitFrameBuffer), window and events loop.   */
+/* Gray-scale images are displayed as R = G = B.                              */
+/******************************************************************************/
+/* ADMINISTRATION                                                             */
+/* Serge RIAZANOFF  | 28.01.00 | v00.01 | Creation of the SW component        */
+/* Serge RIAZANOFF  | 18.10.01 | v02.01 | Added InitFrameBuffer function      */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  <X11/X.h>
+#include  <X11/Xlib.h>
+#include  <X11/Xutil.h>
+
+#include  "display.h"
+#include  "profile.h"
+#include  "cpu.h"
+
+/******************************************************************************/
+/* Macro definitions                                                          */
+/******************************************************************************/
+#define nint(float_value)  (((float_value)-(int)(float_value) > 0.5)?          \
+                            (int)(float_value)+1 : (int)(float_value))
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              colormap_entries;   /* nb.of possible values */
+   int              offset;             /* left offset to match the mask */
+} type_component;
+
+typedef struct {
+   int              bytes_per_rgb;      /* bytes nb.per RGB pixel in frame bu*/
+   type_component   red;                /* Red component in frame buffer */
+   type_component   green;              /* Green component in frame buffer */
+   type_component   blue;               /* Blue component in frame buffer */
+} type_frame_format;
+
+typedef void (*type_frame_buffer_row) (unsigned char *red,
+                                       unsigned char *green,
+                                       unsigned char *blue,
+                                       type_frame_format *format,
+                                       unsigned int *output, int n);
+
+/******************************************************************************/
+/* DisplayComponent analyzes the way one component is mapped in frame buffer. */
+/******************************************************************************/
+static void DisplayComponent (
+   unsigned long    mask,               /* mask of the component */
+   type_component   *component)         /* number of values and offset */
+{
+   component->colormap_entries = mask;
+   component->offset           = 0;
+   while ((component->colormap_entries & 0x00000001) == 0)
+   {
+      component->offset           = component->offset + 1;
+      component->colormap_entries = (component->colormap_entries >> 1);
+   }
+   component->colormap_entries = component->colormap_entries + 1;
+} /* DisplayComponent */
+
+/******************************************************************************/
+/* FrameBufferRowKernel packs n pixels of 8-bit components into 32-bit words, */
+/* for the formats where every component has 256 entries:                     */
+/*    out = red << red offset | green << green offset | blue << blue offset   */
+/* compiled once per CPU level by the variants below.                         */
+/******************************************************************************/
+static CPU_INLINE void FrameBufferRowKernel (
+   unsigned char    *red,               /* red components */
+   unsigned char    *green,             /* green components */
+   unsigned char    *blue,              /* blue components */
+   type_frame_format *format,           /* components in frame buffer */
+   unsigned int     *output,            /* frame buffer words */
+   int              n)                  /* number of pixels */
+{
+   int              red_offset;         /* offset of the red component */
+   int              green_offset;       /* offset of the green component */
+   int              blue_offset;        /* offset of the blue component */
+   int              ipx;                /* index among pixels */
+
+   red_offset   = format->red.offset;
+   green_offset = format->green.offset;
+   blue_offset  = format->blue.offset;
+   for (ipx=0; ipx<n; ipx++)
+      output[ipx] = ((unsigned int)red[ipx]   << red_offset)                  |
+                    ((unsigned int)green[ipx] << green_offset)                |
+                    ((unsigned int)blue[ipx]  << blue_offset);
+} /* FrameBufferRowKernel */
+
+/******************************************************************************/
+/* Variants of the kernel, one per CPU level (cpu.h), and their table         */
+/******************************************************************************/
+static CPU_TARGET_SCALAR void FrameBufferRowScalar (
+   unsigned char *red, unsigned char *green, unsigned char *blue,
+   type_frame_format *format, unsigned int *output, int n)
+{
+   FrameBufferRowKernel (red,green,blue,format,output,n);
+} /* FrameBufferRowScalar */
+
+static CPU_TARGET_SSE42 void FrameBufferRowSse42 (
+   unsigned char *red, unsigned char *green, unsigned char *blue,
+   type_frame_format *format, unsigned int *output, int n)
+{
+   FrameBufferRowKernel (red,green,blue,format,output,n);
+} /* FrameBufferRowSse42 */
+
+static CPU_TARGET_AVX2 void FrameBufferRowAvx2 (
+   unsigned char *red, unsigned char *green, unsigned char *blue,
+   type_frame_format *format, unsigned int *output, int n)
+{
+   FrameBufferRowKernel (red,green,blue,format,output,n);
+} /* FrameBufferRowAvx2 */
+
+static CPU_TARGET_AVX512 void FrameBufferRowAvx512 (
+   unsigned char *red, unsigned char *green, unsigned char *blue,
+   type_frame_format *format, unsigned int *output, int n)
+{
+   FrameBufferRowKernel (red,green,blue,format,output,n);
+} /* FrameBufferRowAvx512 */
+
+static type_frame_buffer_row FRAME_BUFFER_ROW[CPU_LEVEL_NUMBER] = {
+   FrameBufferRowScalar, FrameBufferRowSse42, FrameBufferRowAvx2,
+   FrameBufferRowAvx512 };
+
+/******************************************************************************/
+/* InitFrameBuffer initializes the frame buffer from the entire image         */
+/* provided in input.                                                         */
+/* The value of a component in the frame buffer is computed once for each of  */
+/* the 256 levels. The 32-bit formats of 256 entries per component (the usual */
+/* 24-bit TrueColor) are packed a line at a time by the FrameBufferRow...     */
+/* variant of the CPU; the others pixel by pixel from the tables.             */
+/******************************************************************************/
+static int InitFrameBuffer (
+   type_image       *image,             /* image: ORIGIN or PROCESSED */
+   type_frame_format *format,           /* components in frame buffer */
+   unsigned char    *frame_buffer)      /* frame buffer to be initialized */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              ipixel;             /* index of (ili,ipx) in the planes */
+   int              icolor_rgb;         /* color value for compound RGB values*/
+   unsigned char    byte_order[4];      /* used to check byte order in int */
+   int              int_MSB_first;      /* "Most Significant Byte first in
+                                           integer representation" flag */
+   int              icolor;             /* color level, 0 to 255 */
+   int              icolor_red;         /* color value for component red */
+   int              icolor_green;       /* color value for component green */
+   int              icolor_blue;        /* color value for component blue */
+   int              bytes_per_rgb;      /* bytes nb.per RGB pixel in frame bu*/
+   int              red_table[256];     /* red value in place, per level */
+   int              green_table[256];   /* green value in place, per level */
+   int              blue_table[256];    /* blue value in place, per level */
+   unsigned char    *red;               /* red plane */
+   unsigned char    *green;             /* green plane */
+   unsigned char    *blue;              /* blue plane */
+   type_frame_buffer_row row;           /* packing variant of the CPU */
+
+/******************************************************************************/
+/* Initialise the frame buffer                                                */
+/******************************************************************************/
+/* Analyze order inside an integer                                            */
+/*----------------------------------------------------------------------------*/
+   icolor_rgb = 0x01020304;
+   memcpy (byte_order,&icolor_rgb,4);
+   if (byte_order[0] == 0x01)
+      int_MSB_first = True;
+   else
+      int_MSB_first = False;
+   bytes_per_rgb = format->bytes_per_rgb;
+/*----------------------------------------------------------------------------*/
+/* Set RGB values according to their colormap entries, shifted to their masks */
+/*----------------------------------------------------------------------------*/
+   for (icolor=0; icolor<256; icolor++)
+   {
+      icolor_red   = nint((float)format->red.colormap_entries * icolor / 256);
+      if (icolor_red >= format->red.colormap_entries)
+         icolor_red = format->red.colormap_entries - 1;
+      icolor_green = nint((float)format->green.colormap_entries * icolor / 256);
+      if (icolor_green >= format->green.colormap_entries)
+         icolor_green = format->green.colormap_entries - 1;
+      icolor_blue  = nint((float)format->blue.colormap_entries * icolor / 256);
+      if (icolor_blue >= format->blue.colormap_entries)
+         icolor_blue = format->blue.colormap_entries - 1;
+      red_table[icolor]   = icolor_red   << format->red.offset;
+      green_table[icolor] = icolor_green << format->green.offset;
+      blue_table[icolor]  = icolor_blue  << format->blue.offset;
+   }
+   row = NULL;
+   if ((bytes_per_rgb == sizeof(unsigned int))                                &&
+       (format->red.colormap_entries == 256)                                  &&
+       (format->green.colormap_entries == 256)                                &&
+       (format->blue.colormap_entries == 256))
+      row = FRAME_BUFFER_ROW[CpuLevel()];
+/*----------------------------------------------------------------------------*/
+/* Loop on lines                                                              */
+/*----------------------------------------------------------------------------*/
+   for (ili=0; ili<image->nliin; ili++)
+   {
+      red   = &(image->plane[0][ili*image->stride]);
+      green = (image->channel_number == 3 ?
+               &(image->plane[1][ili*image->stride]) : red);
+      blue  = (image->channel_number == 3 ?
+               &(image->plane[2][ili*image->stride]) : red);
+      if (row != NULL)
+      {
+         row (red,green,blue,format,
+              (unsigned int*)&(frame_buffer[ili*image->npxin*bytes_per_rgb]),
+              image->npxin);
+         continue;
+      }
+/*----------------------------------------------------------------------------*/
+/*    Interleave Red, Green and Blue components into frame buffer             */
+/*----------------------------------------------------------------------------*/
+      for (ipx=0; ipx<image->npxin; ipx++)
+      {
+         icolor_rgb = red_table[red[ipx]] | green_table[green[ipx]]           |
+                      blue_table[blue[ipx]];
+         ipixel     = (ili * image->npxin + ipx) * bytes_per_rgb;
+/*----------------------------------------------------------------------------*/
+/*       Report value in frame buffer                                         */
+/*----------------------------------------------------------------------------*/
+         if (int_MSB_first)
+         {
+            memcpy (&(frame_buffer[ipixel]),
+                 &(((unsigned char*)(&icolor_rgb))[sizeof(int)-bytes_per_rgb]),
+                 bytes_per_rgb);
+         }
+         else
+         {
+            memcpy (&(frame_buffer[ipixel]),&icolor_rgb,bytes_per_rgb);
+         }
+      } /* Loop on pixels */
+   } /* Loop on lines */
+/******************************************************************************/
+/* Return "Ok" status                                                         */
+/******************************************************************************/
+   return (0);
+} /* InitFrameBuffer */
+
+/******************************************************************************/
+/* DisplayFrameBuffer initializes a frame buffer from an image as             */
+/* DisplayImages() does, for a visual of bytes_per_rgb bytes per pixel and    */
+/* the given component masks, without connecting to the X server (to time     */
+/* it). frame_buffer holds nliin x npxin x bytes_per_rgb bytes. Returns 1 if  */
+/* a mask is empty.                                                           */
+/******************************************************************************/
+int DisplayFrameBuffer (
+   type_image       *image,             /* image to be converted */
+   int              bytes_per_rgb,      /* bytes per pixel in frame buffer */
+   unsigned long    red_mask,           /* bits of the red component */
+   unsigned long    green_mask,         /* bits of the green component */
+   unsigned long    blue_mask,          /* bits of the blue component */
+   unsigned char    *frame_buffer)      /* frame buffer to be initialized */
+{
+   type_frame_format format;            /* components in frame buffer */
+
+   if ((red_mask == 0) || (green_mask == 0) || (blue_mask == 0))
+      return (1);
+   format.bytes_per_rgb = bytes_per_rgb;
+   DisplayComponent (red_mask,&(format.red));
+   DisplayComponent (green_mask,&(format.green));
+   DisplayComponent (blue_mask,&(format.blue));
+   return (InitFrameBuffer(image,&format,frame_buffer));
+} /* DisplayFrameBuffer */
+
+/******************************************************************************/
+/* DisplayImages opens a window showing origin (left) and processed (right),  */
+/* which must have the same size, and returns when a mouse button is pressed  */
+/* in it. Returns 1 (reported on stderr) if the display cannot be done.       */
+/******************************************************************************/
+int DisplayImages (
+   char             *title,             /* title reported in window bar */
+   type_image       *origin,            /* image displayed on the left */
+   type_image       *processed)         /* image displayed on the right */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   Display          *display;           /* display returned from connection */
+   int              screen;             /* default screen of connection */
+   XImage           *origin_ximage;     /* origin XImage structure */
+   XImage           *processed_ximage;  /* processed XImage structure */
+   Visual           *visual;            /* true-color visual */
+   XVisualInfo      visual_info;        /* structure used to get visual info */
+   unsigned char    *origin_frame_buffer;    /* origin frame buffer */
+   unsigned char    *processed_frame_buffer; /* processed frame buffer */
+   XEvent           event;              /* standard event structure */
+   Window           window;             /* window XID */
+   GC               gc;                 /* graphic context */
+   int              nliin;              /* line number of the images */
+   int              npxin;              /* pixel number of the images */
+   int              required_depth;     /* expected depth when getting visual */
+   int              status;             /* status returned by X function call */
+   int              bits_per_rgb;       /* bits nb.per RGB pixel in frame buf*/
+   type_frame_format format;            /* components in frame buffer */
+   XSetWindowAttributes window_attributes; /* used to set window attributes */
+   Colormap         colormap;           /* Colormap used for TrueColor display*/
+   XGCValues        GC_values;          /* structure used to initialize GC */
+   int              ievent;             /* event of the profile */
+   double           pixel_number;       /* pixels of an image */
+
+   nliin = origin->nliin;
+   npxin = origin->npxin;
+   if ((processed->nliin != nliin) || (processed->npxin != npxin))
+   {
+      fprintf (stderr,"display : Images of different sizes.\n");
+      return (1);
+   }
+/******************************************************************************/
+/* Connect to X server                                                        */
+/******************************************************************************/
+   if ((display=XOpenDisplay(NULL)) == NULL)
+   {
+      fprintf (stderr,"display : Cannot connect to X server.\n");
+      return (1);
+   }
+   screen = DefaultScreen (display);
+/******************************************************************************/
+/* Get the TrueColor visual                                                   */
+/******************************************************************************/
+   required_depth = 24;
+   do
+   {
+      if ((status=XMatchVisualInfo(display,screen,required_depth,TrueColor,
+           &visual_info)) == 0)
+      {
+         required_depth = required_depth - 1;
+      }
+   } while ((status == 0) && (required_depth >= 8));
+   if (required_depth < 8)
+   {
+      fprintf (stderr,
+     "display : Cannot get a TrueColor visual for whatever depth.\n");
+      XCloseDisplay (display);
+      return (1);
+   }
+/*============================================================================*/
+/* Check that the number of bits per pixels in frame buffer is multiple of 8  */
+/*============================================================================*/
+   bits_per_rgb = BitmapUnit(display);
+   if (required_depth == 16)
+      bits_per_rgb = 16;
+   if (bits_per_rgb % 8 != 0)
+   {
+      fprintf (stderr,"display : Only number of bits per pixels in ");
+      fprintf (stderr,"frame buffer multiple of 8 are supported.\n");
+      XCloseDisplay (display);
+      return (1);
+   }
+   format.bytes_per_rgb = bits_per_rgb / 8;
+/******************************************************************************/
+/* Analyze the way Red, Green and Blue component are mapped in frame buffer   */
+/******************************************************************************/
+   DisplayComponent (visual_info.red_mask,&(format.red));
+   DisplayComponent (visual_info.green_mask,&(format.green));
+   DisplayComponent (visual_info.blue_mask,&(format.blue));
+/******************************************************************************/
+/* Allocate and initialize the internal frame buffers                         */
+/******************************************************************************/
+   if (((origin_frame_buffer=(unsigned char*)malloc((npxin*nliin*
+         format.bytes_per_rgb)*sizeof(char))) == NULL)                        ||
+       ((processed_frame_buffer=(unsigned char*)malloc((npxin*nliin*
+         format.bytes_per_rgb)*sizeof(char))) == NULL))
+   {
+      fprintf (stderr,
+         "display : Cannot allocate internal frame buffers.\n");
+      XCloseDisplay (display);
+      return (1);
+   }
+   pixel_number = (double)nliin * npxin;
+   ievent = ProfileBegin ("InitFrameBuffer");
+   InitFrameBuffer (origin,&format,origin_frame_buffer);
+   ProfileEnd (ievent,pixel_number,
+      pixel_number*(origin->channel_number+format.bytes_per_rgb));
+   ievent = ProfileBegin ("InitFrameBuffer");
+   InitFrameBuffer (processed,&format,processed_frame_buffer);
+   ProfileEnd (ievent,pixel_number,
+      pixel_number*(processed->channel_number+format.bytes_per_rgb));
+/******************************************************************************/
+/* Allocate memory for the XImage structures                                  */
+/******************************************************************************/
+   visual = visual_info.visual;
+   if (((origin_ximage=XCreateImage(display,visual,required_depth,ZPixmap,0,
+         (char*)origin_frame_buffer,npxin,nliin,32,0)) == NULL)               ||
+       ((processed_ximage=XCreateImage(display,visual,required_depth,ZPixmap,0,
+         (char*)processed_frame_buffer,npxin,nliin,32,0)) == NULL))
+   {
+      fprintf (stderr,
+         "display : cannot allocate ximage structures\n");
+      XCloseDisplay (display);
+      return (1);
+   }
+/******************************************************************************/
+/* Create a window                                                            */
+/******************************************************************************/
+/* Create and install a colormap for the selected visual                      */
+/*----------------------------------------------------------------------------*/
+   if ((colormap=XCreateColormap(display,RootWindow(display,screen),visual,
+        AllocNone)) == None)
+   {
+      fprintf (stderr,"display : Cannot create a colormap.\n");
+      XCloseDisplay (display);
+      return (1);
+   }
+   XInstallColormap (display,colormap);
+/*----------------------------------------------------------------------------*/
+/* Set window attributes for the window creation                              */
+/*----------------------------------------------------------------------------*/
+   window_attributes.colormap     = colormap;
+   window_attributes.border_pixel = 1;
+/*----------------------------------------------------------------------------*/
+/* Create the window                                                          */
+/*----------------------------------------------------------------------------*/
+   if ((window=XCreateWindow (
+           display,                     /* connection to X server */
+           RootWindow(display,screen),  /* parent window */
+           0,0,                         /* coord.of UL corner in parent window*/
+           2*npxin,nliin,               /* width/height of window */
+           1,                           /* border width */
+           required_depth,              /* depth of window in bits */
+           InputOutput,                 /* class of this window */
+           visual,                      /* visual to be used for the window */
+           CWBorderPixel | CWColormap,  /* value mask within window_attributes*/
+           &window_attributes)) == 0)
+   {
+      fprintf (stderr,"display : Cannot create the window \n");
+      XCloseDisplay (display);
+      return (1);
+   }
+   XStoreName (display,window,title);
+   XSelectInput (display,window,ExposureMask | ButtonPressMask);
+   XMapWindow (display,window);
+/******************************************************************************/
+/* Get graphic context                                                        */
+/******************************************************************************/
+   gc = XCreateGC(display,window,0L,&GC_values);
+/******************************************************************************/
+/* Events loop                                                                */
+/******************************************************************************/
+   while (True)
+   {
+/*----------------------------------------------------------------------------*/
+/*    Get next event                                                          */
+/*----------------------------------------------------------------------------*/
+      XNextEvent (display,&event);
+      switch (event.type) {
+/*----------------------------------------------------------------------------*/
+/*       Expose => send image into the window (profiled: until the X server   */
+/*       has drawn it)                                                        */
+/*----------------------------------------------------------------------------*/
+         case Expose:
+            ievent = ProfileBegin ("XPutImage");
+            XPutImage (display,window,gc,origin_ximage,
+                       0,0,0,0,npxin,nliin);
+            XPutImage (display,window,gc,processed_ximage,
+                       0,0,npxin,0,npxin,nliin);
+            if (ProfileEnabled())
+               XSync (display,False);
+            ProfileEnd (ievent,2*pixel_number,
+               2*pixel_number*format.bytes_per_rgb);
+            break;
+/*----------------------------------------------------------------------------*/
+/*       ButtonPress => close display and return                              */
+/*----------------------------------------------------------------------------*/
+         case ButtonPress:
+            XDestroyImage (origin_ximage);
+            XDestroyImage (processed_ximage);
+            XCloseDisplay (display);
+            return (0);
+/*----------------------------------------------------------------------------*/
+/*       Any other event is not processed                                     */
+/*----------------------------------------------------------------------------*/
+         default:
+            break;
+      }
+   } /* event loop */
+} /* DisplayImages */
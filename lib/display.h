@@ -0,0 +1,19 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* display shows an origin and a processed image side by side in a window of  */
+/* a TrueColor visual, until a mouse button is pressed.                       */
+/******************************************************************************/
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include  "image.h"
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int DisplayFrameBuffer (type_image *image, int bytes_per_rgb,
+                        unsigned long red_mask, unsigned long green_mask,
+                        unsigned long blue_mask, unsigned char *frame_buffer);
+int DisplayImages (char *title, type_image *origin, type_image *processed);
+
+#endif /* DISPLAY_H */
@@ -0,0 +1,173 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* fft computes in-place radix-2 Fast Fourier Transforms of complex float     */
+/* vectors and (size x size) arrays.                                          */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Decimation in time: the input is permuted in bit-reversed order, then      */
+/* log2(size) stages of butterflies are applied with twiddle factors computed */
+/* once in double precision by FftCreate(). The inverse transform uses the    */
+/* conjugate twiddles and is NOT divided by size (nor by size*size in 2-D):   */
+/* callers fold that factor into their own gain.                              */
+/* A type_fft is not reentrant (2-D transforms use its column vector): each   */
+/* thread must own its own.                                                   */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <math.h>
+
+#include  "fft.h"
+
+/******************************************************************************/
+/* FftPowerOfTwo returns the smallest power of 2 greater or equal to number.  */
+/******************************************************************************/
+int FftPowerOfTwo (
+   int              number)             /* number to be rounded */
+{
+   int              power;              /* power of 2 */
+
+   power = 1;
+   while (power < number)
+      power = 2 * power;
+   return (power);
+} /* FftPowerOfTwo */
+
+/******************************************************************************/
+/* FftCreate prepares the tables of a transform of size points (a power of 2).*/
+/* Returns NULL if size is not a power of 2 or memory is lacking.             */
+/******************************************************************************/
+type_fft *FftCreate (
+   int              size)               /* number of points */
+{
+   type_fft         *fft;               /* transform being prepared */
+   int              i;                  /* index among points */
+   int              j;                  /* bit-reversed index */
+   int              bit;                /* index among bits */
+
+   if ((size < 1) || (FftPowerOfTwo(size) != size))
+      return (NULL);
+   if ((fft=(type_fft*)calloc(1,sizeof(type_fft))) == NULL)
+      return (NULL);
+   fft->size = size;
+   while ((1 << fft->log2_size) < size)
+      fft->log2_size = fft->log2_size + 1;
+   if (((fft->bit_reverse=(int*)malloc(size*sizeof(int))) == NULL)          ||
+       ((fft->twiddle=(type_complex*)malloc((size/2+1)*sizeof(type_complex)))
+          == NULL)                                                            ||
+       ((fft->column=(type_complex*)malloc(size*sizeof(type_complex))) ==
+          NULL))
+   {
+      FftDestroy (fft);
+      return (NULL);
+   }
+   for (i=0; i<size; i++)
+   {
+      j = 0;
+      for (bit=0; bit<fft->log2_size; bit++)
+         j = (j << 1) | ((i >> bit) & 1);
+      fft->bit_reverse[i] = j;
+   }
+   for (i=0; i<size/2; i++)
+   {
+      fft->twiddle[i].re = (float)cos(-2. * M_PI * i / size);
+      fft->twiddle[i].im = (float)sin(-2. * M_PI * i / size);
+   }
+   return (fft);
+} /* FftCreate */
+
+/******************************************************************************/
+/* FftDestroy releases the tables of a transform.                             */
+/******************************************************************************/
+void FftDestroy (
+   type_fft         *fft)               /* transform to be released */
+{
+   if (fft == NULL)
+      return;
+   free (fft->bit_reverse);
+   free (fft->twiddle);
+   free (fft->column);
+   free (fft);
+} /* FftDestroy */
+
+/******************************************************************************/
+/* Fft transforms in place the vector of fft->size complex values.            */
+/******************************************************************************/
+void Fft (
+   type_fft         *fft,               /* transform tables */
+   type_complex     *data,              /* vector to be transformed */
+   int              inverse)            /* 0: forward, 1: inverse (unscaled)*/
+{
+   int              i;                  /* index among points */
+   int              j;                  /* bit-reversed index */
+   int              half;               /* half length of current butterflies*/
+   int              step;               /* twiddle index step of the stage */
+   int              start;              /* first point of a butterfly group */
+   int              k;                  /* index inside a butterfly group */
+   type_complex     w;                  /* twiddle factor */
+   type_complex     a;                  /* upper input of a butterfly */
+   type_complex     b;                  /* lower input times twiddle */
+
+/*----------------------------------------------------------------------------*/
+/* Bit-reversal permutation                                                   */
+/*----------------------------------------------------------------------------*/
+   for (i=0; i<fft->size; i++)
+   {
+      j = fft->bit_reverse[i];
+      if (j > i)
+      {
+         a       = data[i];
+         data[i] = data[j];
+         data[j] = a;
+      }
+   }
+/*----------------------------------------------------------------------------*/
+/* Butterfly stages                                                           */
+/*----------------------------------------------------------------------------*/
+   for (half=1; half<fft->size; half=2*half)
+   {
+      step = fft->size / (2 * half);
+      for (start=0; start<fft->size; start=start+2*half)
+      {
+         for (k=0; k<half; k++)
+         {
+            w = fft->twiddle[k*step];
+            if (inverse)
+               w.im = -w.im;
+            a      = data[start+k];
+            b.re   = w.re * data[start+k+half].re - w.im * data[start+k+half].im;
+            b.im   = w.re * data[start+k+half].im + w.im * data[start+k+half].re;
+            data[start+k].re      = a.re + b.re;
+            data[start+k].im      = a.im + b.im;
+            data[start+k+half].re = a.re - b.re;
+            data[start+k+half].im = a.im - b.im;
+         }
+      }
+   }
+} /* Fft */
+
+/******************************************************************************/
+/* Fft2D transforms in place the (size x size) array, lines then columns.     */
+/******************************************************************************/
+void Fft2D (
+   type_fft         *fft,               /* transform tables */
+   type_complex     *data,              /* array to be transformed */
+   int              inverse)            /* 0: forward, 1: inverse (unscaled)*/
+{
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+
+   for (ili=0; ili<fft->size; ili++)
+      Fft (fft,&(data[ili*fft->size]),inverse);
+   for (ipx=0; ipx<fft->size; ipx++)
+   {
+      for (ili=0; ili<fft->size; ili++)
+         fft->column[ili] = data[ili*fft->size+ipx];
+      Fft (fft,fft->column,inverse);
+      for (ili=0; ili<fft->size; ili++)
+         data[ili*fft->size+ipx] = fft->column[ili];
+   }
+} /* Fft2D */
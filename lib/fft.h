@@ -0,0 +1,34 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* fft computes in-place radix-2 Fast Fourier Transforms of complex float     */
+/* vectors and (size x size) arrays.                                          */
+/******************************************************************************/
+#ifndef FFT_H
+#define FFT_H
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   float            re;                 /* real part */
+   float            im;                 /* imaginary part */
+} type_complex;
+
+typedef struct {
+   int              size;               /* number of points (power of 2) */
+   int              log2_size;          /* log2(size) */
+   int              *bit_reverse;       /* bit-reversal permutation */
+   type_complex     *twiddle;           /* exp(-2 i PI k / size), k<size/2 */
+   type_complex     *column;            /* work vector for 2-D columns */
+} type_fft;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int FftPowerOfTwo (int number);
+type_fft *FftCreate (int size);
+void FftDestroy (type_fft *fft);
+void Fft (type_fft *fft, type_complex *data, int inverse);
+void Fft2D (type_fft *fft, type_complex *data, int inverse);
+
+#endif /* FFT_H */
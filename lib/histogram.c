@@ -0,0 +1,131 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* histogram counts the pixels of each gray level of every channel, bands of  */
+/* lines being counted concurrently.                                          */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* The loop "histogram[image[i]]++" of the TD (stretch of the dynamic,        */
+/* equalization) reads, increments and writes back the same counter when      */
+/* neighboring pixels have the same level, as in flat areas: each increment   */
+/* waits for the previous one to be stored. Here a band of lines counts into  */
+/* HISTO_COPIES tables used in turn, pixel i going to table i % HISTO_COPIES, */
+/* so that successive increments hit different counters; the tables of all    */
+/* the bands are summed at the end.                                           */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "histogram.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define HISTO_COPIES    4               /* tables counted in turn (the loop
+                                           of HistogramBand is unrolled 4) */
+#define BAND_PER_THREAD 2               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   unsigned char    **image;            /* image arrays */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   unsigned int     *count;             /* HISTO_COPIES tables per task */
+} type_histogram_job;
+
+/******************************************************************************/
+/* HistogramBand is the pool task counting one (channel,band) pair into its   */
+/* own tables.                                                                */
+/******************************************************************************/
+static void HistogramBand (
+   void             *argument,          /* type_histogram_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_histogram_job *job;             /* job the task belongs to */
+   unsigned int     *count;             /* tables of the task */
+   unsigned char    *pixel;             /* first pixel of the band */
+   size_t           n;                  /* number of pixels of the band */
+   size_t           i;                  /* index among pixels */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+
+   job       = (type_histogram_job*)argument;
+   count     = &(job->count[(size_t)itask*HISTO_COPIES*256]);
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   pixel = &(job->image[itask/job->band_number][(size_t)ili_first*job->npxin]);
+   n     = (size_t)(ili_last - ili_first) * job->npxin;
+   memset (count,0,HISTO_COPIES*256*sizeof(unsigned int));
+   for (i=0; i+HISTO_COPIES<=n; i=i+HISTO_COPIES)
+   {
+      count[          pixel[i]  ]++;
+      count[256     + pixel[i+1]]++;
+      count[2 * 256 + pixel[i+2]]++;
+      count[3 * 256 + pixel[i+3]]++;
+   }
+   for ( ; i<n; i++)
+      count[pixel[i]]++;
+} /* HistogramBand */
+
+/******************************************************************************/
+/* Histogram counts the pixels of each level of all the channels              */
+/* concurrently: histogram[c][v] is the number of pixels of channel c whose   */
+/* value is v. Returns 1 if memory is lacking.                                */
+/******************************************************************************/
+int Histogram (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image[3],          /* image arrays */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   long             histogram[3][256])  /* counts of each channel */
+{
+   type_histogram_job job;              /* job shared by all the bands */
+   int              ichannel;           /* index among channels */
+   int              itask;              /* index among tasks */
+   int              icopy;              /* index among tables of a task */
+   int              v;                  /* index among levels */
+
+   memset (histogram,0,3*sizeof(histogram[0]));
+   job.image       = image;
+   job.nliin       = nliin;
+   job.npxin       = npxin;
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      channel_number - 1) / channel_number;
+   if (job.band_number > nliin / MIN_BAND_LINES)
+      job.band_number = nliin / MIN_BAND_LINES;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+   if ((job.count=(unsigned int*)malloc((size_t)channel_number*
+         job.band_number*HISTO_COPIES*256*sizeof(unsigned int))) == NULL)
+      return (1);
+   PoolRun (pool,channel_number*job.band_number,HistogramBand,&job);
+/*----------------------------------------------------------------------------*/
+/* Sum of the tables of all the bands of each channel                         */
+/*----------------------------------------------------------------------------*/
+   for (itask=0; itask<channel_number*job.band_number; itask++)
+   {
+      ichannel = itask / job.band_number;
+      for (icopy=0; icopy<HISTO_COPIES; icopy++)
+      {
+         for (v=0; v<256; v++)
+            histogram[ichannel][v] = histogram[ichannel][v] +
+               job.count[((size_t)itask*HISTO_COPIES+icopy)*256+v];
+      }
+   }
+   free (job.count);
+   return (0);
+} /* Histogram */
@@ -0,0 +1,17 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* histogram counts the pixels of each gray level of every channel, bands of  */
+/* lines being counted concurrently.                                          */
+/******************************************************************************/
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int Histogram (type_pool *pool, int channel_number, unsigned char *image[3],
+               int nliin, int npxin, long histogram[3][256]);
+
+#endif /* HISTOGRAM_H */
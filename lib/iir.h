@@ -0,0 +1,29 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* iir applies a recursive (Infinite Impulse Response) Gauss filter whose     */
+/* cost per pixel does not depend on sigma.                                   */
+/******************************************************************************/
+#ifndef IIR_H
+#define IIR_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MIN_IIR_SIGMA 0.5               /* smallest sigma of IirGauss() */
+#define IIR_REFERENCE_SIGMAS 6.0        /* half support of the reference */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int IirGaussCoefficients (double sigma, double coeff[4]);
+int IirGaussImpulse (double sigma, int size, double *response);
+int IirGaussBound (double sigma);
+int IirGaussReference (double sigma, unsigned char *image_in,
+                       unsigned char *image_out, int nliin, int npxin);
+int IirGauss (type_pool *pool, double sigma, int channel_number,
+              unsigned char *image_in[3], unsigned char *image_out[3],
+              int nliin, int npxin);
+
+#endif /* IIR_H */
@@ -0,0 +1,413 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* image is the image type shared by the programs and the operators: up to 3  */
+/* planes of bytes in one aligned allocation, and the BSQ file loader.        */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* ImageLoad() is the parameter and file reading part that every skelet used  */
+/* to carry:                                                                  */
+/* COLOR               <image_red> <image_green> <image_blue> [ <line_number> */
+/*                                                [ <pixel_number> ] ]        */
+/* GRAY-SCALE          <image_gray> <line_number> <pixel_number>              */
+/* Missing names and sizes are asked on the standard input. Files are in BSQ  */
+/* (DUMP) format, 8 bits per pixel, and must hold at least N x M bytes.       */
+/*                                                                            */
+/* ImageLoadRegion() reads only a window of the files: each of its lines is   */
+/* read with pread() at its offset, so inspecting a small area of a huge      */
+/* scene reads a few kilobytes. ImageView() gives a window of an image in     */
+/* memory without copying it.                                                 */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <errno.h>
+#include  <fcntl.h>
+#include  <unistd.h>
+
+#include  "image.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+static char *CHANNEL_PROMPT[3] = {      /* questions asked for missing names */
+   "Nom du fichier image: ROUGE  : ",
+   "Nom du fichier image: VERT   : ",
+   "Nom du fichier image: BLEU   : "};
+
+/******************************************************************************/
+/* ImagePlanes allocates the planes of an image whose fields are set, plane c */
+/* starting at c x plane_size + offset bytes from an aligned block. Returns 1 */
+/* if memory is lacking.                                                      */
+/******************************************************************************/
+static int ImagePlanes (
+   type_image       *image,             /* image to be allocated */
+   size_t           plane_size,         /* size of one plane, guards included */
+   size_t           offset)             /* offset of pixel (0,0) in a plane */
+{
+   int              ichannel;           /* index among channels */
+   char             *block;             /* first aligned byte of the block */
+
+   if ((image->buffer=malloc(image->channel_number*plane_size+IMAGE_ALIGN-1))
+       == NULL)
+      return (1);
+   block = (char*)image->buffer + (IMAGE_ALIGN - 1);
+   block = block - (size_t)block % IMAGE_ALIGN;
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+      image->plane[ichannel] = (unsigned char*)(block + ichannel*plane_size +
+                                                offset);
+   return (0);
+} /* ImagePlanes */
+
+/******************************************************************************/
+/* ImageAlloc allocates the planes of an image with packed lines              */
+/* (stride = npxin, no guard). Returns 1 if the size is wrong or memory is    */
+/* lacking.                                                                   */
+/******************************************************************************/
+int ImageAlloc (
+   type_image       *image,             /* image to be allocated */
+   int              channel_number,     /* number of channels (1 or 3) */
+   int              nliin,              /* line number */
+   int              npxin)              /* pixel number */
+{
+   memset (image,0,sizeof(type_image));
+   if ((channel_number < 1) || (channel_number > 3) || (nliin <= 0)         ||
+       (npxin <= 0))
+      return (1);
+   image->channel_number = channel_number;
+   image->nliin          = nliin;
+   image->npxin          = npxin;
+   image->npx_padded     = npxin;
+   image->stride         = npxin;
+   return (ImagePlanes(image,IMAGE_ROUND((size_t)nliin*npxin),0));
+} /* ImageAlloc */
+
+/******************************************************************************/
+/* ImageAllocGuard allocates the planes of an image with lines of             */
+/* npx_padded = IMAGE_ROUND(npxin) pixels and guard lines and pixels around   */
+/* them (see image.h). Guard pixels are not initialized: see ImageExtend().   */
+/* Returns 1 if the size is wrong or memory is lacking.                       */
+/******************************************************************************/
+int ImageAllocGuard (
+   type_image       *image,             /* image to be allocated */
+   int              channel_number,     /* number of channels (1 or 3) */
+   int              nliin,              /* line number */
+   int              npxin,              /* pixel number */
+   int              guard)              /* guard lines and pixels per side */
+{
+   memset (image,0,sizeof(type_image));
+   if ((channel_number < 1) || (channel_number > 3) || (nliin <= 0)         ||
+       (npxin <= 0) || (guard < 0))
+      return (1);
+   image->channel_number = channel_number;
+   image->nliin          = nliin;
+   image->npxin          = npxin;
+   image->npx_padded     = IMAGE_ROUND(npxin);
+   image->guard          = guard;
+   image->stride         = image->npx_padded + 2 * IMAGE_ROUND(guard);
+   return (ImagePlanes(image,(size_t)(nliin+2*guard)*image->stride,
+                       (size_t)guard*image->stride+IMAGE_ROUND(guard)));
+} /* ImageAllocGuard */
+
+/******************************************************************************/
+/* ImageView makes view the window of nliin x npxin pixels of image whose     */
+/* first pixel is (ili,ipx). The view shares the planes of image: nothing is  */
+/* copied nor allocated, and ImageFree() of the view releases nothing. The    */
+/* pixels of image around the window (guards included) are the guards of the  */
+/* view, so that ConvolutionImage() on a view reads the true neighbors of its */
+/* border pixels. Returns 1 if the window is not within image.                */
+/******************************************************************************/
+int ImageView (
+   type_image       *image,             /* image the window is taken from */
+   int              ili,                /* first line of the window */
+   int              ipx,                /* first pixel of the window */
+   int              nliin,              /* line number of the window */
+   int              npxin,              /* pixel number of the window */
+   type_image       *view)              /* view of the window */
+{
+   int              ichannel;           /* index among channels */
+
+   memset (view,0,sizeof(type_image));
+   if ((ili < 0) || (ipx < 0) || (nliin <= 0) || (npxin <= 0)              ||
+       (ili + nliin > image->nliin) || (ipx + npxin > image->npxin))
+      return (1);
+   view->channel_number = image->channel_number;
+   view->nliin          = nliin;
+   view->npxin          = npxin;
+   view->npx_padded     = npxin;
+   view->stride         = image->stride;
+   view->guard          = ili;
+   if (view->guard > ipx)
+      view->guard = ipx;
+   if (view->guard > image->nliin - ili - nliin)
+      view->guard = image->nliin - ili - nliin;
+   if (view->guard > image->npxin - ipx - npxin)
+      view->guard = image->npxin - ipx - npxin;
+   view->guard = view->guard + image->guard;
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+      view->plane[ichannel] = &(image->plane[ichannel][ili*image->stride+ipx]);
+   return (0);
+} /* ImageView */
+
+/******************************************************************************/
+/* ImageExtend fills the guard pixels of an image by replicating its border   */
+/* pixels, and the padding at the right of the lines with the last pixel. The */
+/* guards of a view are pixels of its image, left as they are.                */
+/******************************************************************************/
+void ImageExtend (
+   type_image       *image)             /* image whose guards are filled */
+{
+   int              ichannel;           /* index among channels */
+   int              ili;                /* index among lines */
+   int              left;               /* pixels at the left of a line */
+   int              right;              /* pixels at the right of a line */
+   unsigned char    *line;              /* first pixel of the current line */
+
+   if (((image->guard == 0) && (image->npx_padded == image->npxin))        ||
+       (image->buffer == NULL))
+      return;
+   left  = IMAGE_ROUND(image->guard);
+   right = image->stride - left - image->npxin;
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      for (ili=0; ili<image->nliin; ili++)
+      {
+         line = &(image->plane[ichannel][ili*image->stride]);
+         memset (line-left,line[0],left);
+         memset (line+image->npxin,line[image->npxin-1],right);
+      }
+      for (ili=1; ili<=image->guard; ili++)
+      {
+         memcpy (image->plane[ichannel]-ili*image->stride-left,
+                 image->plane[ichannel]-left,image->stride);
+         memcpy (image->plane[ichannel]+(image->nliin-1+ili)*image->stride-
+                 left,image->plane[ichannel]+(image->nliin-1)*image->stride-
+                 left,image->stride);
+      }
+   }
+} /* ImageExtend */
+
+/******************************************************************************/
+/* ImageCopy copies the pixels of an image into another one of the same size  */
+/* and channel number, whatever their strides.                                */
+/******************************************************************************/
+void ImageCopy (
+   type_image       *image_in,          /* image to be copied */
+   type_image       *image_out)         /* copy */
+{
+   int              ichannel;           /* index among channels */
+   int              ili;                /* index among lines */
+
+   for (ichannel=0; ichannel<image_in->channel_number; ichannel++)
+   {
+      for (ili=0; ili<image_in->nliin; ili++)
+         memcpy (&(image_out->plane[ichannel][ili*image_out->stride]),
+                 &(image_in->plane[ichannel][ili*image_in->stride]),
+                 image_in->npxin);
+   }
+} /* ImageCopy */
+
+/******************************************************************************/
+/* ImageFree releases the planes of an image.                                 */
+/******************************************************************************/
+void ImageFree (
+   type_image       *image)             /* image to be released */
+{
+   free (image->buffer);
+   memset (image,0,sizeof(type_image));
+} /* ImageFree */
+
+/******************************************************************************/
+/* ImageRegion reads the window of an allocated image from BSQ files of       */
+/* file_npxin pixels per line, one file per channel, the window starting at   */
+/* pixel (ili,ipx) of the files. Lines are read by pread() at their offset,   */
+/* whole planes at once when the window has the width of the files. Returns 1 */
+/* (reported on stderr) if a file cannot be read.                             */
+/******************************************************************************/
+static int ImageRegion (
+   type_image       *image,             /* allocated image to be read */
+   char             *file_name[3],      /* file name of each channel */
+   int              file_npxin,         /* pixel number of the files */
+   int              ili,                /* first line of the window */
+   int              ipx)                /* first pixel of the window */
+{
+   int              fd;                 /* file of the current channel */
+   int              ichannel;           /* index among channels */
+   int              jli;                /* index among lines of the window */
+   int              line_number;        /* lines read by one pread() */
+   size_t           size;               /* bytes read by one pread() */
+   size_t           done;               /* bytes of them already read */
+   ssize_t          nread;              /* bytes returned by pread() */
+   unsigned char    *line;              /* first pixel of the lines read */
+
+   line_number = 1;
+   if ((ipx == 0) && (image->npxin == file_npxin)                           &&
+       (image->stride == image->npxin))
+      line_number = image->nliin;
+   size = (size_t)line_number * image->npxin;
+   for (ichannel=0; ichannel<image->channel_number; ichannel++)
+   {
+      if ((fd=open(file_name[ichannel],O_RDONLY)) < 0)
+      {
+         fprintf (stderr,"image : can't open \"%s\"\n",file_name[ichannel]);
+         return (1);
+      }
+      for (jli=0; jli<image->nliin; jli=jli+line_number)
+      {
+         line = &(image->plane[ichannel][jli*image->stride]);
+         for (done=0, nread=1; (done < size) && (nread > 0); done=done+nread)
+         {
+            nread = pread (fd,line+done,size-done,
+                           ((off_t)(ili+jli)*file_npxin+ipx)+(off_t)done);
+            if (nread <= 0)
+               nread = 0;
+         }
+         if (done < size)
+         {
+            fprintf (stderr,
+         "image : error while reading record nb. %d from \"%s\",  ",
+               ili+jli,file_name[ichannel]);
+            fprintf (stderr,"(returned=%ld, status=%d)\n",(long)done,errno);
+            close (fd);
+            return (1);
+         }
+      }
+      close (fd);
+   }
+   return (0);
+} /* ImageRegion */
+
+/******************************************************************************/
+/* ImageRead reads the channels of an allocated image from BSQ files, one     */
+/* file per channel. Returns 1 (reported on stderr) if a file cannot be read. */
+/******************************************************************************/
+int ImageRead (
+   type_image       *image,             /* allocated image to be read */
+   char             *file_name[3])      /* file name of each channel */
+{
+   return (ImageRegion(image,file_name,image->npxin,0,0));
+} /* ImageRead */
+
+/******************************************************************************/
+/* ImageLoadRegion gets the file names and the size from the command line (or */
+/* the standard input), allocates the image of the window of region_nliin x   */
+/* region_npxin pixels from pixel (ili,ipx) of the files and reads it. A      */
+/* region size of 0 gives the whole files. title receives "- <name> - ... -"  */
+/* for the window bar. Returns 1 (reported on stderr) on failure or if the    */
+/* window is not within the files.                                            */
+/******************************************************************************/
+int ImageLoadRegion (
+   int              argc,               /* argument count */
+   char             **argv,             /* argument list */
+   int              ili,                /* first line of the window */
+   int              ipx,                /* first pixel of the window */
+   int              region_nliin,       /* line number of the window (0) */
+   int              region_npxin,       /* pixel number of the window (0) */
+   type_image       *image,             /* image to be loaded */
+   char             *title)             /* title, IMAGE_TITLE_LENGTH bytes */
+{
+   char             file_name[3][IMAGE_NAME_LENGTH]; /* name of each channel */
+   char             *name[3];           /* pointers to file_name[] */
+   int              channel_number;     /* number of channels (1 or 3) */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              ichannel;           /* index among channels */
+
+/*----------------------------------------------------------------------------*/
+/* Gray-scale: the name and the size are all given                            */
+/*----------------------------------------------------------------------------*/
+   if ((argc == 4)                                                            &&
+       (sscanf(argv[2],"%d",&nliin) == 1)                                     &&
+       (sscanf(argv[3],"%d",&npxin) == 1))
+   {
+      channel_number = 1;
+      strncpy (file_name[0],argv[1],IMAGE_NAME_LENGTH-1);
+      file_name[0][IMAGE_NAME_LENGTH-1] = '\0';
+   }
+/*----------------------------------------------------------------------------*/
+/* Red-Green-Blue: missing names and sizes are asked                          */
+/*----------------------------------------------------------------------------*/
+   else
+   {
+      channel_number = 3;
+      for (ichannel=0; ichannel<3; ichannel++)
+      {
+         if (argc >= ichannel+2)
+         {
+            strncpy (file_name[ichannel],argv[ichannel+1],
+                     IMAGE_NAME_LENGTH-1);
+            file_name[ichannel][IMAGE_NAME_LENGTH-1] = '\0';
+         }
+         else
+         {
+            printf ("%s",CHANNEL_PROMPT[ichannel]);
+            if (scanf("%79s",file_name[ichannel]) != 1)
+               return (1);
+         }
+      }
+      if ((argc < 5)                                                          ||
+          (sscanf(argv[4],"%d",&nliin) <= 0))
+      {
+         printf ("Nombre de lignes en entree   : ");
+         if (scanf("%d",&nliin) != 1)
+            return (1);
+      }
+      if ((argc < 6)                                                          ||
+          (sscanf(argv[5],"%d",&npxin) <= 0))
+      {
+         printf ("Nombre de pixels en entree   : ");
+         if (scanf("%d",&npxin) != 1)
+            return (1);
+      }
+   }
+/*----------------------------------------------------------------------------*/
+/* Allocate, read and name the image of the window                            */
+/*----------------------------------------------------------------------------*/
+   if (region_nliin == 0)
+      region_nliin = nliin - ili;
+   if (region_npxin == 0)
+      region_npxin = npxin - ipx;
+   if ((ili < 0) || (ipx < 0) || (ili + region_nliin > nliin)               ||
+       (ipx + region_npxin > npxin))
+   {
+      fprintf (stderr,"image : window %d x %d at (%d,%d) out of %d x %d.\n",
+         region_nliin,region_npxin,ili,ipx,nliin,npxin);
+      return (1);
+   }
+   if (ImageAlloc(image,channel_number,region_nliin,region_npxin) != 0)
+   {
+      fprintf (stderr,"image : Cannot allocate %d x %d image.\n",
+         region_nliin,region_npxin);
+      return (1);
+   }
+   strcpy (title,"-");
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      name[ichannel] = file_name[ichannel];
+      strcat (title," ");
+      strcat (title,file_name[ichannel]);
+      strcat (title," -");
+   }
+   if (ImageRegion(image,name,npxin,ili,ipx) != 0)
+   {
+      ImageFree (image);
+      return (1);
+   }
+   return (0);
+} /* ImageLoadRegion */
+
+/******************************************************************************/
+/* ImageLoad loads the whole image named on the command line, as              */
+/* ImageLoadRegion() does.                                                    */
+/******************************************************************************/
+int ImageLoad (
+   int              argc,               /* argument count */
+   char             **argv,             /* argument list */
+   type_image       *image,             /* image to be loaded */
+   char             *title)             /* title, IMAGE_TITLE_LENGTH bytes */
+{
+   return (ImageLoadRegion(argc,argv,0,0,0,0,image,title));
+} /* ImageLoad */
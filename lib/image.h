@@ -0,0 +1,70 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* image is the image type shared by the programs and the operators: up to 3  */
+/* planes of bytes in one aligned allocation, and the BSQ file loader.        */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Pixel (ili,ipx) of channel c is plane[c][ili*stride+ipx]. Every plane      */
+/* starts on an IMAGE_ALIGN byte boundary, so that vector loads of the first  */
+/* pixels are aligned.                                                        */
+/* . ImageAlloc() packs the lines (stride = npxin): the plane[] array can be  */
+/*   passed as is to the operators, which take "unsigned char *image[3]"      */
+/*   arrays of npxin pixel lines.                                             */
+/* . ImageAllocGuard() rounds the width up to a multiple of IMAGE_ALIGN       */
+/*   (npx_padded) and surrounds it with guard pixels: guard lines above and   */
+/*   below, guard pixels rounded up to IMAGE_ALIGN on the left and on the     */
+/*   right. Every line then starts on an IMAGE_ALIGN boundary, vector kernels */
+/*   may read and write npx_padded pixels per line without a scalar tail, and */
+/*   a (2 guard + 1) square neighborhood can be read around any pixel without */
+/*   bounds checks once ImageExtend() has replicated the borders.             */
+/* . ImageView() describes a window of another image: its planes point into   */
+/*   that image, its stride is the stride of that image and its buffer is     */
+/*   NULL (it owns nothing). Operators taking a type_image run on the window  */
+/*   without copying it; a window of whole lines (stride = npxin) can also be */
+/*   passed as plane[] to the operators taking packed arrays.                 */
+/******************************************************************************/
+#ifndef IMAGE_H
+#define IMAGE_H
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define IMAGE_ALIGN         64          /* alignment of the planes (bytes) */
+#define IMAGE_NAME_LENGTH   80          /* longest file name of a channel */
+#define IMAGE_TITLE_LENGTH  (3*IMAGE_NAME_LENGTH+8) /* "- r - g - b -" */
+#define IMAGE_ROUND(size)   (((size) + IMAGE_ALIGN - 1) / IMAGE_ALIGN *       \
+                             IMAGE_ALIGN) /* size rounded to IMAGE_ALIGN */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              channel_number;     /* number of channels (1 or 3) */
+   int              nliin;              /* line number (height) */
+   int              npxin;              /* pixel number (width) */
+   int              stride;             /* bytes from a line to the next one */
+   int              npx_padded;         /* pixels of a line that may be used */
+   int              guard;              /* guard lines and pixels per side */
+   unsigned char    *plane[3];          /* first pixel of each channel */
+   void             *buffer;            /* all the planes, one allocation
+                                           (NULL: view of another image) */
+} type_image;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int ImageAlloc (type_image *image, int channel_number, int nliin, int npxin);
+int ImageAllocGuard (type_image *image, int channel_number, int nliin,
+                     int npxin, int guard);
+int ImageView (type_image *image, int ili, int ipx, int nliin, int npxin,
+               type_image *view);
+void ImageExtend (type_image *image);
+void ImageCopy (type_image *image_in, type_image *image_out);
+void ImageFree (type_image *image);
+int ImageRead (type_image *image, char *file_name[3]);
+int ImageLoadRegion (int argc, char **argv, int ili, int ipx,
+                     int region_nliin, int region_npxin, type_image *image,
+                     char *title);
+int ImageLoad (int argc, char **argv, type_image *image, char *title);
+
+#endif /* IMAGE_H */
@@ -0,0 +1,303 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* median applies median and rank (percentile) filters whose cost per pixel   */
+/* does not depend on the size of the window.                                 */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Perreault - Hebert algorithm (IEEE Trans. Image Processing 16(9), 2007).   */
+/* Each column keeps the histogram of its 2r+1 pixels around the current      */
+/* line: moving to the next line removes one pixel and adds one per column.   */
+/* The histogram of the (2r+1) x (2r+1) window is the sum of 2r+1 column      */
+/* histograms: moving to the next pixel adds the entering column and          */
+/* subtracts the leaving one. Histograms have two levels, 16 coarse bins      */
+/* (value / 16) and 256 fine bins: the coarse level is kept up to date at     */
+/* every pixel (16 adds), the rank is located in it, and only the 16 fine     */
+/* bins of the selected coarse bin are brought up to date, from the column    */
+/* where they were last used. The cost per pixel is thus bounded whatever r.  */
+/*                                                                            */
+/* The output value is the smallest v such that more than                     */
+/*    rank = nint(percentile / 100 * ((2r+1)^2 - 1))                          */
+/* pixels of the window are <= v (percentile 50: median, 0: minimum, 100:     */
+/* maximum). As for the convolutions, border pixels where the window does not */
+/* fit keep their origin value. Every channel is cut into bands of lines run  */
+/* on the thread pool; each band rebuilds its column histograms once.         */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "median.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define FINE_BINS   256                 /* one bin per gray level */
+#define COARSE_BINS 16                  /* one bin per 16 gray levels */
+#define COARSE_SHIFT 4                  /* value >> COARSE_SHIFT: coarse bin */
+#define BAND_PER_THREAD 2               /* bands per thread for load balance */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              radius;             /* half size of the window */
+   double           percentile;         /* rank of the output, in % */
+   unsigned char    **image_in;         /* input image arrays */
+   unsigned char    **image_out;        /* output image arrays */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a band */
+} type_rank_job;
+
+/******************************************************************************/
+/* RankColumns adds (sign = 1) or removes (sign = -1) one input line to the   */
+/* column histograms.                                                         */
+/******************************************************************************/
+static void RankColumns (
+   unsigned char    *input_line,        /* line to be added or removed */
+   int              npxin,              /* input pixel number */
+   int              sign,               /* 1: add, -1: remove */
+   unsigned short   *fine,              /* fine column histograms */
+   unsigned short   *coarse)            /* coarse column histograms */
+{
+   int              ipx;                /* index among pixels */
+
+   for (ipx=0; ipx<npxin; ipx++)
+   {
+      fine[ipx*FINE_BINS+input_line[ipx]] =
+         fine[ipx*FINE_BINS+input_line[ipx]] + sign;
+      coarse[ipx*COARSE_BINS+(input_line[ipx]>>COARSE_SHIFT)] =
+         coarse[ipx*COARSE_BINS+(input_line[ipx]>>COARSE_SHIFT)] + sign;
+   }
+} /* RankColumns */
+
+/******************************************************************************/
+/* RankFilterRows applies the rank filter on lines [ili_first,ili_last[ of    */
+/* one channel. Other lines of image_in are only read.                        */
+/******************************************************************************/
+int RankFilterRows (
+   int              radius,             /* half size of the window */
+   double           percentile,         /* rank of the output, in % */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   int              width;              /* size of the window (2r+1) */
+   int              rank;               /* 0-based rank of the output */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              ili_begin;          /* first line where the window fits */
+   int              ili_end;            /* line following the last one */
+   unsigned short   *fine;              /* fine column histograms */
+   unsigned short   *coarse;            /* coarse column histograms */
+   unsigned short   kernel_coarse[COARSE_BINS]; /* coarse window histogram */
+   unsigned short   kernel_fine[COARSE_BINS][COARSE_BINS]; /* fine window
+                                           histogram, per coarse bin */
+   int              updated[COARSE_BINS]; /* pixel where kernel_fine[b] was
+                                             last brought up to date */
+   unsigned short   *entering;          /* column entering the window */
+   unsigned short   *leaving;           /* column leaving the window */
+   int              b;                  /* index among coarse bins */
+   int              v;                  /* index among fine bins of b */
+   int              j;                  /* index among columns */
+   int              count;              /* pixels below the current bin */
+
+   if ((radius < 0) || (radius > MAX_RANK_RADIUS) || (percentile < 0.)      ||
+       (percentile > 100.))
+      return (1);
+   width = 2 * radius + 1;
+   rank  = (int)(percentile / 100. * (width * width - 1) + 0.5);
+/*----------------------------------------------------------------------------*/
+/* Lines where the window does not fit keep their origin value                */
+/*----------------------------------------------------------------------------*/
+   ili_begin = (ili_first > radius ? ili_first : radius);
+   ili_end   = (ili_last < nliin-radius ? ili_last : nliin-radius);
+   if (npxin < width)
+      ili_end = ili_begin;
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      if ((ili < ili_begin) || (ili >= ili_end))
+         memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),npxin);
+   }
+   if (ili_begin >= ili_end)
+      return (0);
+   if (((fine=(unsigned short*)calloc(npxin*FINE_BINS,sizeof(unsigned short)))
+        == NULL)                                                              ||
+       ((coarse=(unsigned short*)calloc(npxin*COARSE_BINS,
+         sizeof(unsigned short))) == NULL))
+   {
+      free (fine);
+      return (1);
+   }
+/*----------------------------------------------------------------------------*/
+/* Column histograms of the 2r lines above the last line of the first window  */
+/*----------------------------------------------------------------------------*/
+   for (ili=ili_begin-radius; ili<ili_begin+radius; ili++)
+      RankColumns (&(image_in[ili*npxin]),npxin,1,fine,coarse);
+   for (ili=ili_begin; ili<ili_end; ili++)
+   {
+      RankColumns (&(image_in[(ili+radius)*npxin]),npxin,1,fine,coarse);
+      if (ili > ili_begin)
+         RankColumns (&(image_in[(ili-radius-1)*npxin]),npxin,-1,fine,coarse);
+      memcpy (&(image_out[ili*npxin]),&(image_in[ili*npxin]),radius);
+      memcpy (&(image_out[ili*npxin+npxin-radius]),
+              &(image_in[ili*npxin+npxin-radius]),radius);
+/*----------------------------------------------------------------------------*/
+/*    Window histogram of the first pixel: coarse level only, fine levels     */
+/*    are computed when first needed                                          */
+/*----------------------------------------------------------------------------*/
+      memset (kernel_coarse,0,sizeof(kernel_coarse));
+      for (j=0; j<width; j++)
+      {
+         for (b=0; b<COARSE_BINS; b++)
+            kernel_coarse[b] = kernel_coarse[b] + coarse[j*COARSE_BINS+b];
+      }
+      for (b=0; b<COARSE_BINS; b++)
+         updated[b] = -width - 1;
+      for (ipx=radius; ipx<npxin-radius; ipx++)
+      {
+         if (ipx > radius)
+         {
+            entering = &(coarse[(ipx+radius)*COARSE_BINS]);
+            leaving  = &(coarse[(ipx-radius-1)*COARSE_BINS]);
+            for (b=0; b<COARSE_BINS; b++)
+               kernel_coarse[b] = kernel_coarse[b] + entering[b] - leaving[b];
+         }
+/*----------------------------------------------------------------------------*/
+/*       Coarse bin holding the rank                                          */
+/*----------------------------------------------------------------------------*/
+         count = 0;
+         for (b=0; count+kernel_coarse[b]<=rank; b++)
+            count = count + kernel_coarse[b];
+/*----------------------------------------------------------------------------*/
+/*       Bring its fine bins up to date: slide them from the pixel where they */
+/*       were last used, or rebuild them if the windows do not overlap        */
+/*----------------------------------------------------------------------------*/
+         if (ipx - updated[b] >= width)
+         {
+            memset (kernel_fine[b],0,sizeof(kernel_fine[b]));
+            for (j=ipx-radius; j<=ipx+radius; j++)
+            {
+               entering = &(fine[j*FINE_BINS+(b<<COARSE_SHIFT)]);
+               for (v=0; v<COARSE_BINS; v++)
+                  kernel_fine[b][v] = kernel_fine[b][v] + entering[v];
+            }
+         }
+         else
+         {
+            for (j=updated[b]+1; j<=ipx; j++)
+            {
+               entering = &(fine[(j+radius)*FINE_BINS+(b<<COARSE_SHIFT)]);
+               leaving  = &(fine[(j-radius-1)*FINE_BINS+(b<<COARSE_SHIFT)]);
+               for (v=0; v<COARSE_BINS; v++)
+                  kernel_fine[b][v] = kernel_fine[b][v] + entering[v] -
+                                      leaving[v];
+            }
+         }
+         updated[b] = ipx;
+         for (v=0; count+kernel_fine[b][v]<=rank; v++)
+            count = count + kernel_fine[b][v];
+         image_out[ili*npxin+ipx] = (unsigned char)((b << COARSE_SHIFT) + v);
+      } /* Loop on pixels */
+   } /* Loop on lines */
+   free (fine);
+   free (coarse);
+   return (0);
+} /* RankFilterRows */
+
+/******************************************************************************/
+/* RankBand is the pool task computing one (channel,band) pair.               */
+/******************************************************************************/
+static void RankBand (
+   void             *argument,          /* type_rank_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_rank_job    *job;               /* job the task belongs to */
+   int              ichannel;           /* channel of the band */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+
+   job       = (type_rank_job*)argument;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   if (RankFilterRows(job->radius,job->percentile,job->image_in[ichannel],
+                      job->image_out[ichannel],job->nliin,job->npxin,
+                      ili_first,ili_last) != 0)
+      job->status = 1;
+} /* RankBand */
+
+/******************************************************************************/
+/* RankFilter applies the rank filter of the given radius and percentile on   */
+/* all the channels concurrently. Returns 1 if radius or percentile is out of */
+/* range or memory is lacking.                                                */
+/******************************************************************************/
+int RankFilter (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              radius,             /* half size of the window */
+   double           percentile,         /* rank of the output, in % */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_rank_job    job;                /* job shared by all the bands */
+   int              min_lines;          /* smallest height of a band */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   job.radius     = radius;
+   job.percentile = percentile;
+   job.image_in   = image_in;
+   job.image_out  = image_out;
+   job.nliin      = nliin;
+   job.npxin      = npxin;
+   job.status     = 0;
+/*----------------------------------------------------------------------------*/
+/* A band first reads 2r lines: keep bands a few windows high                 */
+/*----------------------------------------------------------------------------*/
+   min_lines       = 4 * (2 * radius + 1);
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      channel_number - 1) / channel_number;
+   if (job.band_number > nliin / min_lines)
+      job.band_number = nliin / min_lines;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+
+   PoolRun (pool,channel_number*job.band_number,RankBand,&job);
+   return (job.status);
+} /* RankFilter */
+
+/******************************************************************************/
+/* MedianFilter applies the median filter of the given radius on all the      */
+/* channels concurrently.                                                     */
+/******************************************************************************/
+int MedianFilter (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              radius,             /* half size of the window */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   return (RankFilter(pool,radius,50.,channel_number,image_in,image_out,
+                      nliin,npxin));
+} /* MedianFilter */
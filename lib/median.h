@@ -0,0 +1,29 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* median applies median and rank (percentile) filters whose cost per pixel   */
+/* does not depend on the size of the window.                                 */
+/******************************************************************************/
+#ifndef MEDIAN_H
+#define MEDIAN_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_RANK_RADIUS 127             /* (2r+1)^2 counts fit 16 bits */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int RankFilterRows (int radius, double percentile, unsigned char *image_in,
+                    unsigned char *image_out, int nliin, int npxin,
+                    int ili_first, int ili_last);
+int RankFilter (type_pool *pool, int radius, double percentile,
+                int channel_number, unsigned char *image_in[3],
+                unsigned char *image_out[3], int nliin, int npxin);
+int MedianFilter (type_pool *pool, int radius, int channel_number,
+                  unsigned char *image_in[3], unsigned char *image_out[3],
+                  int nliin, int npxin);
+
+#endif /* MEDIAN_H */
@@ -0,0 +1,418 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* morpho applies the gray-scale (and binary) morphological operators with    */
+/* rectangular structuring elements, at a cost independent of their size.     */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A (width x height) rectangle is the product of a horizontal and a vertical */
+/* segment: erosion (dilation) is a running minimum (maximum) along the lines */
+/* then along the columns. Each running extremum over w = 2r+1 values uses    */
+/* the van Herk / Gil-Werman algorithm: the signal, padded by r neutral       */
+/* values (255 for the minimum, 0 for the maximum) on each side, is cut into  */
+/* blocks of w values; g is the running extremum from the start of each       */
+/* block, h from its end, and                                                 */
+/*    out(x) = extremum (h(x), g(x + 2r))                                     */
+/* i.e. 3 comparisons per value whatever w. The padding makes the element     */
+/* shrink on the borders, so that every output pixel is defined (binary       */
+/* images are processed as 0 / 255 gray-scale images).                        */
+/*                                                                            */
+/* Along the columns, g and h are computed on whole lines, so that every      */
+/* comparison runs across a line with SSE2 byte min/max (16 pixels per        */
+/* instruction) when available; along the lines, only the final combination   */
+/* of h and g is vectorized. Bands of lines (line pass) and stripes of        */
+/* columns (column pass) of all the channels are run on the pool.             */
+/*                                                                            */
+/* Composed operators go through a single work plane per channel: the line    */
+/* pass writes it, the column pass writes the output, and the second          */
+/* operation of an opening or closing reuses both. Top-hats subtract the      */
+/* image and the opening (closing) with saturating byte subtractions.         */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#ifdef __SSE2__
+#include  <emmintrin.h>
+#endif
+
+#include  "morpho.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+#define STRIPE      256                 /* columns per column-pass task */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+
+#define PHASE_LINES     0               /* running extremum along lines */
+#define PHASE_COLUMNS   1               /* running extremum along columns */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              maximum;            /* 1: dilation, 0: erosion */
+   int              width;              /* width of the element (odd) */
+   int              height;             /* height of the element (odd) */
+   int              phase;              /* PHASE_LINES or PHASE_COLUMNS */
+   unsigned char    **image_in;         /* input of the pass */
+   unsigned char    **image_out;        /* output of the pass */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              task_number;        /* number of tasks per channel */
+   int              band_lines;         /* lines per band (line pass) */
+   int              status;             /* 0 or error reported by a task */
+} type_morpho_job;
+
+/******************************************************************************/
+/* Global data                                                                */
+/******************************************************************************/
+char *MORPHO_NAME[MORPHO_NUMBER] = { "erosion", "dilatation", "ouverture",
+                                     "fermeture", "chapeau haut de forme",
+                                     "chapeau haut de forme noir" };
+
+/******************************************************************************/
+/* MorphoExtremum computes out[i] = max (a[i],b[i]) (or min) for n values.    */
+/******************************************************************************/
+static void MorphoExtremum (
+   int              maximum,            /* 1: maximum, 0: minimum */
+   unsigned char    *a,                 /* first operand */
+   unsigned char    *b,                 /* second operand */
+   unsigned char    *out,               /* result (may be a or b) */
+   int              n)                  /* number of values */
+{
+   int              i;                  /* index among values */
+
+   i = 0;
+#ifdef __SSE2__
+   if (maximum)
+   {
+      for (; i+16<=n; i=i+16)
+         _mm_storeu_si128 ((__m128i*)&(out[i]),
+            _mm_max_epu8(_mm_loadu_si128((__m128i*)&(a[i])),
+                         _mm_loadu_si128((__m128i*)&(b[i]))));
+   }
+   else
+   {
+      for (; i+16<=n; i=i+16)
+         _mm_storeu_si128 ((__m128i*)&(out[i]),
+            _mm_min_epu8(_mm_loadu_si128((__m128i*)&(a[i])),
+                         _mm_loadu_si128((__m128i*)&(b[i]))));
+   }
+#endif
+   if (maximum)
+   {
+      for (; i<n; i++)
+         out[i] = (a[i] > b[i] ? a[i] : b[i]);
+   }
+   else
+   {
+      for (; i<n; i++)
+         out[i] = (a[i] < b[i] ? a[i] : b[i]);
+   }
+} /* MorphoExtremum */
+
+/******************************************************************************/
+/* MorphoSubtract computes out[i] = a[i] - b[i], saturated at 0.              */
+/******************************************************************************/
+static void MorphoSubtract (
+   unsigned char    *a,                 /* first operand */
+   unsigned char    *b,                 /* second operand */
+   unsigned char    *out,               /* result (may be a or b) */
+   int              n)                  /* number of values */
+{
+   int              i;                  /* index among values */
+
+   i = 0;
+#ifdef __SSE2__
+   for (; i+16<=n; i=i+16)
+      _mm_storeu_si128 ((__m128i*)&(out[i]),
+         _mm_subs_epu8(_mm_loadu_si128((__m128i*)&(a[i])),
+                       _mm_loadu_si128((__m128i*)&(b[i]))));
+#endif
+   for (; i<n; i++)
+      out[i] = (a[i] > b[i] ? a[i] - b[i] : 0);
+} /* MorphoSubtract */
+
+/******************************************************************************/
+/* MorphoLines computes the running extremum over width pixels along lines    */
+/* [ili_first,ili_last[ of one channel.                                       */
+/******************************************************************************/
+static int MorphoLines (
+   int              maximum,            /* 1: maximum, 0: minimum */
+   int              width,              /* length of the segment (odd) */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              npxin,              /* input pixel number */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   int              half;               /* half length of the segment */
+   int              length;             /* padded length, multiple of width */
+   unsigned char    *g;                 /* extremum from block starts */
+   unsigned char    *h;                 /* extremum from block ends */
+   unsigned char    neutral;            /* padding value */
+   int              ili;                /* index among lines */
+   int              i;                  /* index in the padded line */
+   unsigned char    *input_line;        /* current input line */
+
+   half    = width / 2;
+   length  = ((npxin + 2*half + width - 1) / width) * width;
+   neutral = (maximum ? 0 : MAX_COLOR);
+   if (((g=(unsigned char*)malloc(length)) == NULL)                         ||
+       ((h=(unsigned char*)malloc(length)) == NULL))
+   {
+      free (g);
+      return (1);
+   }
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      input_line = &(image_in[ili*npxin]);
+      if (width == 1)
+      {
+         memcpy (&(image_out[ili*npxin]),input_line,npxin);
+         continue;
+      }
+/*----------------------------------------------------------------------------*/
+/*    Padded line in h, running extrema from the block starts in g            */
+/*----------------------------------------------------------------------------*/
+      memset (h,neutral,length);
+      memcpy (&(h[half]),input_line,npxin);
+      for (i=0; i<length; i++)
+      {
+         if (i % width == 0)
+            g[i] = h[i];
+         else if (maximum)
+            g[i] = (h[i] > g[i-1] ? h[i] : g[i-1]);
+         else
+            g[i] = (h[i] < g[i-1] ? h[i] : g[i-1]);
+      }
+/*----------------------------------------------------------------------------*/
+/*    Running extrema from the block ends, in place, then combination         */
+/*----------------------------------------------------------------------------*/
+      for (i=length-2; i>=0; i--)
+      {
+         if (i % width == width-1)
+            continue;
+         if (maximum)
+            h[i] = (h[i] > h[i+1] ? h[i] : h[i+1]);
+         else
+            h[i] = (h[i] < h[i+1] ? h[i] : h[i+1]);
+      }
+      MorphoExtremum (maximum,h,&(g[2*half]),&(image_out[ili*npxin]),npxin);
+   }
+   free (g);
+   free (h);
+   return (0);
+} /* MorphoLines */
+
+/******************************************************************************/
+/* MorphoColumns computes the running extremum over height lines along the    */
+/* columns [ipx_first,ipx_last[ of one channel, a whole line at a time.       */
+/******************************************************************************/
+static int MorphoColumns (
+   int              maximum,            /* 1: maximum, 0: minimum */
+   int              height,             /* length of the segment (odd) */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              ipx_first,          /* first column */
+   int              ipx_last)           /* column following the last one */
+{
+   int              half;               /* half length of the segment */
+   int              length;             /* padded length, multiple of height */
+   int              stripe;             /* number of columns */
+   unsigned char    *g;                 /* extrema from block starts */
+   unsigned char    *h;                 /* extrema from block ends */
+   int              i;                  /* index among padded lines */
+   int              ili;                /* index among lines */
+
+   half   = height / 2;
+   length = ((nliin + 2*half + height - 1) / height) * height;
+   stripe = ipx_last - ipx_first;
+   if (((g=(unsigned char*)malloc(length*stripe)) == NULL)                  ||
+       ((h=(unsigned char*)malloc(length*stripe)) == NULL))
+   {
+      free (g);
+      return (1);
+   }
+/*----------------------------------------------------------------------------*/
+/* Padded columns in h, then g and h line by line                             */
+/*----------------------------------------------------------------------------*/
+   memset (h,(maximum ? 0 : MAX_COLOR),length*stripe);
+   for (ili=0; ili<nliin; ili++)
+      memcpy (&(h[(ili+half)*stripe]),&(image_in[ili*npxin+ipx_first]),
+              stripe);
+   for (i=0; i<length; i++)
+   {
+      if (i % height == 0)
+         memcpy (&(g[i*stripe]),&(h[i*stripe]),stripe);
+      else
+         MorphoExtremum (maximum,&(h[i*stripe]),&(g[(i-1)*stripe]),
+                         &(g[i*stripe]),stripe);
+   }
+   for (i=length-2; i>=0; i--)
+   {
+      if (i % height != height-1)
+         MorphoExtremum (maximum,&(h[i*stripe]),&(h[(i+1)*stripe]),
+                         &(h[i*stripe]),stripe);
+   }
+   for (ili=0; ili<nliin; ili++)
+      MorphoExtremum (maximum,&(h[ili*stripe]),&(g[(ili+2*half)*stripe]),
+                      &(image_out[ili*npxin+ipx_first]),stripe);
+   free (g);
+   free (h);
+   return (0);
+} /* MorphoColumns */
+
+/******************************************************************************/
+/* MorphoTask is the pool task running one band or stripe of a pass.          */
+/******************************************************************************/
+static void MorphoTask (
+   void             *argument,          /* type_morpho_job being run */
+   int              itask)              /* channel * task_number + part */
+{
+   type_morpho_job  *job;               /* job the task belongs to */
+   int              ichannel;           /* channel of the task */
+   int              first;              /* first line or column */
+   int              last;               /* line or column following it */
+   int              status;             /* status of the task */
+
+   job      = (type_morpho_job*)argument;
+   ichannel = itask / job->task_number;
+   if (job->phase == PHASE_LINES)
+   {
+      first  = (itask % job->task_number) * job->band_lines;
+      last   = (first + job->band_lines < job->nliin ?
+                first + job->band_lines : job->nliin);
+      status = MorphoLines (job->maximum,job->width,job->image_in[ichannel],
+                  job->image_out[ichannel],job->npxin,first,last);
+   }
+   else
+   {
+      first  = (itask % job->task_number) * STRIPE;
+      last   = (first + STRIPE < job->npxin ? first + STRIPE : job->npxin);
+      status = MorphoColumns (job->maximum,job->height,
+                  job->image_in[ichannel],job->image_out[ichannel],
+                  job->nliin,job->npxin,first,last);
+   }
+   if (status != 0)
+      job->status = 1;
+} /* MorphoTask */
+
+/******************************************************************************/
+/* MorphoPass computes an erosion or a dilation: line pass from image_in to   */
+/* work, column pass from work to image_out.                                  */
+/******************************************************************************/
+static int MorphoPass (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              maximum,            /* 1: dilation, 0: erosion */
+   int              width,              /* width of the element (odd) */
+   int              height,             /* height of the element (odd) */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *work[3],           /* work image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_morpho_job  job;                /* job shared by all the tasks */
+
+   job.maximum   = maximum;
+   job.width     = width;
+   job.height    = height;
+   job.nliin     = nliin;
+   job.npxin     = npxin;
+   job.status    = 0;
+/*----------------------------------------------------------------------------*/
+/* Line pass, by bands of lines                                               */
+/*----------------------------------------------------------------------------*/
+   job.phase       = PHASE_LINES;
+   job.image_in    = image_in;
+   job.image_out   = work;
+   job.task_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      channel_number - 1) / channel_number;
+   if (job.task_number > nliin / MIN_BAND_LINES)
+      job.task_number = nliin / MIN_BAND_LINES;
+   if (job.task_number < 1)
+      job.task_number = 1;
+   job.band_lines  = (nliin + job.task_number - 1) / job.task_number;
+   job.task_number = (nliin + job.band_lines - 1) / job.band_lines;
+   PoolRun (pool,channel_number*job.task_number,MorphoTask,&job);
+/*----------------------------------------------------------------------------*/
+/* Column pass, by stripes of columns                                         */
+/*----------------------------------------------------------------------------*/
+   job.phase       = PHASE_COLUMNS;
+   job.image_in    = work;
+   job.image_out   = image_out;
+   job.task_number = (npxin + STRIPE - 1) / STRIPE;
+   if (job.status == 0)
+      PoolRun (pool,channel_number*job.task_number,MorphoTask,&job);
+   return (job.status);
+} /* MorphoPass */
+
+/******************************************************************************/
+/* Morphology applies a morphological operator with a (width x height)        */
+/* rectangle (odd sizes) on all the channels. Returns 1 if the operator or    */
+/* the sizes are wrong, or memory is lacking.                                 */
+/******************************************************************************/
+int Morphology (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              operation,          /* MORPHO_ERODE ... MORPHO_BLACKHAT */
+   int              width,              /* width of the element (odd) */
+   int              height,             /* height of the element (odd) */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   unsigned char    *work[3];           /* work image arrays */
+   int              first;              /* 1: dilation first, 0: erosion */
+   int              ichannel;           /* index among channels */
+   int              status;             /* status of the passes */
+
+   if ((operation < 0) || (operation >= MORPHO_NUMBER)                      ||
+       (width < 1) || (width % 2 == 0) || (height < 1) || (height % 2 == 0))
+      return (1);
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   memset (work,0,sizeof(work));
+   status = 0;
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      if ((work[ichannel]=(unsigned char*)malloc(nliin*npxin)) == NULL)
+         status = 1;
+   }
+/*----------------------------------------------------------------------------*/
+/* First operation into image_out, second one from image_out to image_out     */
+/*----------------------------------------------------------------------------*/
+   first = ((operation == MORPHO_DILATE) || (operation == MORPHO_CLOSE) ||
+            (operation == MORPHO_BLACKHAT));
+   if (status == 0)
+      status = MorphoPass (pool,first,width,height,channel_number,image_in,
+                  work,image_out,nliin,npxin);
+   if ((status == 0) && (operation >= MORPHO_OPEN))
+      status = MorphoPass (pool,!first,width,height,channel_number,
+                  image_out,work,image_out,nliin,npxin);
+/*----------------------------------------------------------------------------*/
+/* Top-hats                                                                   */
+/*----------------------------------------------------------------------------*/
+   for (ichannel=0; (ichannel<channel_number) && (status == 0); ichannel++)
+   {
+      if (operation == MORPHO_TOPHAT)
+         MorphoSubtract (image_in[ichannel],image_out[ichannel],
+                         image_out[ichannel],nliin*npxin);
+      else if (operation == MORPHO_BLACKHAT)
+         MorphoSubtract (image_out[ichannel],image_in[ichannel],
+                         image_out[ichannel],nliin*npxin);
+   }
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+      free (work[ichannel]);
+   return (status);
+} /* Morphology */
@@ -0,0 +1,34 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* morpho applies the gray-scale (and binary) morphological operators with    */
+/* rectangular structuring elements, at a cost independent of their size.     */
+/******************************************************************************/
+#ifndef MORPHO_H
+#define MORPHO_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MORPHO_ERODE        0           /* minimum over the element */
+#define MORPHO_DILATE       1           /* maximum over the element */
+#define MORPHO_OPEN         2           /* erosion then dilation */
+#define MORPHO_CLOSE        3           /* dilation then erosion */
+#define MORPHO_TOPHAT       4           /* image - opening (white top-hat) */
+#define MORPHO_BLACKHAT     5           /* closing - image (black top-hat) */
+#define MORPHO_NUMBER       6           /* number of operators */
+
+/******************************************************************************/
+/* Global data                                                                */
+/******************************************************************************/
+extern char         *MORPHO_NAME[MORPHO_NUMBER]; /* names of the operators */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int Morphology (type_pool *pool, int operation, int width, int height,
+                int channel_number, unsigned char *image_in[3],
+                unsigned char *image_out[3], int nliin, int npxin);
+
+#endif /* MORPHO_H */
@@ -0,0 +1,1092 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* pipeline runs a graph of operators (look-up tables, arithmetic,            */
+/* thresholds, convolutions) tile by tile, without whole intermediate planes. */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A treatment such as "stretch the dynamic (TD4), blur with Gauss 5x5 (TD6), */
+/* threshold" is declared as a graph of stages, each reading the input image  */
+/* or earlier stages:                                                         */
+/*    ConvolGauss (5,&gauss);                                                 */
+/*    stretch = PipelineLinear (&pipeline,PIPE_INPUT,gain,offset);            */
+/*    blur    = PipelineConvol (&pipeline,stretch,&gauss);                    */
+/*    PipelineThreshold (&pipeline,blur,128);                                 */
+/* The last declared stage gives the output. Run step by step, every stage    */
+/* writes a whole plane that the next one reads back from memory.             */
+/*                                                                            */
+/* PipelinePlan() prepares the graph for an image size:                       */
+/* . fusion: a point operator on bytes is a table of 256 values; a table      */
+/*   whose input is read by no other stage is composed into the table         */
+/*   applied to the output of that stage (a chain of point operators becomes  */
+/*   one table, a table after a convolution is applied to each line as soon   */
+/*   as it is computed);                                                      */
+/* . margins: to give the lines of a tile, a stage needs the lines of the     */
+/*   tile plus its margin, and its inputs that margin plus size/2 more lines  */
+/*   for a convolution;                                                       */
+/* . tiles: groups of whole lines, as high as the lines that all the          */
+/*   intermediates need for one tile fit in PIPE_CACHE bytes.                 */
+/* PipelineApply() cuts the channels into bands run on the thread pool (and   */
+/* PipelineApplyImage() on images of any stride, e.g. views, see image.h). A  */
+/* band goes down tile by tile; for each tile, the stages compute their new   */
+/* lines one after the other into rings of lines that stay in cache. Every    */
+/* line is computed once, except the margins of the bands, computed by both   */
+/* neighboring bands.                                                         */
+/* PipelineApplyPlanes() runs the same plan stage after stage on whole        */
+/* planes. Both take their memory (rings, planes) from the arena of the       */
+/* pipeline (arena.c), which plans the lifetimes of the planes, reports the   */
+/* peak memory and is kept from a run to the next until PipelineRelease().    */
+/*                                                                            */
+/* In place (image_out = image_in, PIPE_IN_PLACE[] of every stage set): the   */
+/* tables and combinations read the input line they write, a convolution the  */
+/* size/2 lines around it. A band thus copies, before any band runs, the      */
+/* input lines it reads beyond its own lines (its halo), and keeps its output */
+/* lines in a ring until no stage reads the input lines they replace: no      */
+/* second image is needed, only the halos and a ring of output lines.         */
+/*                                                                            */
+/* Every stage gives the same values as when applied alone on whole planes    */
+/* (convolutions: ConvolutionApply(CONVOL_DIRECT), border lines and pixels    */
+/* keeping their input value; arithmetic: SaturateRow()).                     */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "pipeline.h"
+#include  "image.h"
+#include  "saturate.h"
+#include  "cpu.h"
+
+#ifdef CPU_X86
+#include  <immintrin.h>
+#endif
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define PIPE_CACHE      (256*1024)      /* bytes of intermediates per tile */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+#define MIN_TILE_LINES  8               /* smallest height of a tile */
+
+static int PIPE_IN_PLACE[3] = {         /* "can be run in place" per kind */
+   1,                                   /* PIPE_LUT: point operator */
+   1,                                   /* PIPE_CONVOL: output delayed */
+   1};                                  /* PIPE_COMBINE: point operator */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   type_pipeline    *pipeline;          /* planned pipeline */
+   unsigned char    **image_in;         /* input image arrays */
+   unsigned char    **image_out;        /* output image arrays */
+   int              stride_in;          /* bytes between input lines */
+   int              stride_out;         /* bytes between output lines */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              tile_lines;         /* lines per tile, at most a band */
+   int              ring[MAX_STAGE];    /* lines of the ring of each stage */
+   unsigned char    *plane[MAX_STAGE][3]; /* planes of the stages (planes) */
+   int              istage;             /* stage being run (planes) */
+   int              in_place;           /* "image_out is image_in" */
+   int              halo_lines;         /* input lines read beyond a band */
+   char             *memory;            /* memory of the tasks, in the arena */
+   size_t           task_bytes;         /* bytes of memory per task */
+   int              status;             /* 0 or error reported by a task */
+} type_pipeline_job;
+
+typedef struct {
+   unsigned char    *image_in;          /* input array of the channel */
+   unsigned char    *buffer[MAX_STAGE]; /* lines of each stage */
+   int              ring[MAX_STAGE];    /* lines of buffer[] (0: the image) */
+   unsigned char    *halo;              /* input lines beyond the band (in
+                                           place), or NULL */
+   int              halo_lines;         /* lines of halo on each side */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              stride_in;          /* bytes between input lines */
+   int              stride_out;         /* bytes between lines of an image
+                                           buffer[] (ring 0) */
+   int              npxin;              /* input pixel number */
+} type_band;
+
+/******************************************************************************/
+/* PipelineInit initializes an empty pipeline.                                */
+/******************************************************************************/
+void PipelineInit (
+   type_pipeline    *pipeline)          /* pipeline to be initialized */
+{
+   memset (pipeline,0,sizeof(type_pipeline));
+} /* PipelineInit */
+
+/******************************************************************************/
+/* PipelineStage appends a stage reading input_a (and input_b) and returns    */
+/* it, or NULL if the pipeline is full or an input is not declared yet.       */
+/******************************************************************************/
+static type_stage *PipelineStage (
+   type_pipeline    *pipeline,          /* pipeline being built */
+   int              kind,               /* PIPE_... operator */
+   int              input_a,            /* first input stage */
+   int              input_b)            /* second input stage */
+{
+   type_stage       *stage;             /* stage appended */
+
+   if ((pipeline->stage_number >= MAX_STAGE)                                  ||
+       (input_a < PIPE_INPUT) || (input_a >= pipeline->stage_number)          ||
+       (input_b < PIPE_INPUT) || (input_b >= pipeline->stage_number))
+      return (NULL);
+   stage = &(pipeline->stage[pipeline->stage_number]);
+   memset (stage,0,sizeof(type_stage));
+   stage->kind     = kind;
+   stage->input[0] = input_a;
+   stage->input[1] = input_b;
+   pipeline->stage_number = pipeline->stage_number + 1;
+   pipeline->planned      = 0;
+   return (stage);
+} /* PipelineStage */
+
+/******************************************************************************/
+/* PipelineLut appends a look-up table: out = table[in]. Returns the index of */
+/* the stage, or PIPE_ERROR if the pipeline is full or input is undeclared    */
+/* (a PIPE_ERROR input thus makes the following stages fail too).             */
+/******************************************************************************/
+int PipelineLut (
+   type_pipeline    *pipeline,          /* pipeline being built */
+   int              input,              /* stage read, or PIPE_INPUT */
+   unsigned char    *table)             /* the 256 output values */
+{
+   type_stage       *stage;             /* stage appended */
+
+   if ((stage=PipelineStage(pipeline,PIPE_LUT,input,input)) == NULL)
+      return (PIPE_ERROR);
+   memcpy (stage->table,table,256);
+   stage->tabled = 1;
+   return (pipeline->stage_number - 1);
+} /* PipelineLut */
+
+/******************************************************************************/
+/* PipelineLinear appends out = gain x in + offset, clipped as SaturateRow()  */
+/* does (e.g. the dynamic stretch of TD4). Returns as PipelineLut().          */
+/******************************************************************************/
+int PipelineLinear (
+   type_pipeline    *pipeline,          /* pipeline being built */
+   int              input,              /* stage read, or PIPE_INPUT */
+   float            gain,               /* multiplicative factor */
+   float            offset)             /* value added after the gain */
+{
+   float            value[256];         /* the 256 input values */
+   unsigned char    table[256];         /* their output values */
+   int              i;                  /* index among values */
+
+   for (i=0; i<256; i++)
+      value[i] = (float)i;
+   SaturateRow (value,table,256,gain,offset);
+   return (PipelineLut(pipeline,input,table));
+} /* PipelineLinear */
+
+/******************************************************************************/
+/* PipelineThreshold appends out = 255 where in >= threshold, 0 elsewhere.    */
+/* Returns as PipelineLut().                                                  */
+/******************************************************************************/
+int PipelineThreshold (
+   type_pipeline    *pipeline,          /* pipeline being built */
+   int              input,              /* stage read, or PIPE_INPUT */
+   int              threshold)          /* smallest value set to 255 */
+{
+   unsigned char    table[256];         /* output values */
+   int              i;                  /* index among values */
+
+   for (i=0; i<256; i++)
+      table[i] = (i >= threshold ? 255 : 0);
+   return (PipelineLut(pipeline,input,table));
+} /* PipelineThreshold */
+
+/******************************************************************************/
+/* PipelineConvol appends a convolution. Returns as PipelineLut(), or         */
+/* PIPE_ERROR if the matrix is NULL (ConvolFind() of an unknown name) or      */
+/* exceeds MAX_FFT_SIZE.                                                      */
+/******************************************************************************/
+int PipelineConvol (
+   type_pipeline    *pipeline,          /* pipeline being built */
+   int              input,              /* stage read, or PIPE_INPUT */
+   type_convol      *convol)            /* matrix to be applied */
+{
+   type_stage       *stage;             /* stage appended */
+
+   if ((convol == NULL) || (convol->size < 1)                                 ||
+       (convol->size > MAX_FFT_SIZE)                                          ||
+       ((stage=PipelineStage(pipeline,PIPE_CONVOL,input,input)) == NULL))
+      return (PIPE_ERROR);
+   stage->convol = convol;
+   return (pipeline->stage_number - 1);
+} /* PipelineConvol */
+
+/******************************************************************************/
+/* PipelineCombine appends out = gain_a x a + gain_b x b + offset, clipped as */
+/* SaturateRow() does (difference, high boost, blending...). Returns as       */
+/* PipelineLut().                                                             */
+/******************************************************************************/
+int PipelineCombine (
+   type_pipeline    *pipeline,          /* pipeline being built */
+   int              input_a,            /* first stage read, or PIPE_INPUT */
+   int              input_b,            /* second stage read, or PIPE_INPUT */
+   float            gain_a,             /* gain of the first input */
+   float            gain_b,             /* gain of the second input */
+   float            offset)             /* value added */
+{
+   type_stage       *stage;             /* stage appended */
+
+   if ((stage=PipelineStage(pipeline,PIPE_COMBINE,input_a,input_b)) == NULL)
+      return (PIPE_ERROR);
+   stage->gain[0] = gain_a;
+   stage->gain[1] = gain_b;
+   stage->offset  = offset;
+   return (pipeline->stage_number - 1);
+} /* PipelineCombine */
+
+/******************************************************************************/
+/* PipelineInPlace returns 1 if every stage of the pipeline can be run in     */
+/* place (see PIPE_IN_PLACE[]), 0 else.                                       */
+/******************************************************************************/
+int PipelineInPlace (
+   type_pipeline    *pipeline)          /* pipeline built */
+{
+   int              istage;             /* index among stages */
+
+   for (istage=0; istage<pipeline->stage_number; istage++)
+   {
+      if (!PIPE_IN_PLACE[pipeline->stage[istage].kind])
+         return (0);
+   }
+   return (1);
+} /* PipelineInPlace */
+
+/******************************************************************************/
+/* PipelineReach returns the lines a stage reads beyond the line it computes. */
+/******************************************************************************/
+static int PipelineReach (
+   type_stage       *stage)             /* stage of the plan */
+{
+   if (stage->kind == PIPE_CONVOL)
+      return (stage->convol->size / 2);
+   return (0);
+} /* PipelineReach */
+
+/******************************************************************************/
+/* PipelinePlan fuses the tables of the pipeline into their input stages,     */
+/* computes the margins of the stages and the height of the tiles for the     */
+/* image size. Returns 1 if the pipeline is empty.                            */
+/******************************************************************************/
+int PipelinePlan (
+   type_pipeline    *pipeline,          /* pipeline to be planned */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   type_stage       *plan;              /* stages after fusion */
+   type_stage       *producer;          /* stage a table is fused into */
+   int              consumer[MAX_STAGE];/* readers of each stage (+ output) */
+   int              istage;             /* index among stages */
+   int              j;                  /* index among inputs of a stage */
+   int              i;                  /* index among table values */
+   int              input;              /* input stage */
+   int              margin;             /* margin required on an input */
+   int              buffer_number;      /* stages held in tile buffers */
+   int              halo_lines;         /* margin lines of those buffers */
+
+   if (pipeline->stage_number < 1)
+      return (1);
+   plan = pipeline->plan;
+   memcpy (plan,pipeline->stage,pipeline->stage_number*sizeof(type_stage));
+/*----------------------------------------------------------------------------*/
+/* Fusion of the tables into the stage they read, if nobody else reads it     */
+/*----------------------------------------------------------------------------*/
+   memset (consumer,0,sizeof(consumer));
+   for (istage=0; istage<pipeline->stage_number; istage++)
+   {
+      for (j=0; j<2; j++)
+      {
+         if ((plan[istage].input[j] != PIPE_INPUT)                            &&
+             ((j == 0) || (plan[istage].input[1] != plan[istage].input[0])))
+            consumer[plan[istage].input[j]]++;
+      }
+   }
+   consumer[pipeline->stage_number-1]++;
+   for (istage=0; istage<pipeline->stage_number; istage++)
+   {
+      for (j=0; j<2; j++)
+      {
+         while ((plan[istage].input[j] != PIPE_INPUT)                         &&
+                plan[plan[istage].input[j]].fused)
+            plan[istage].input[j] = plan[plan[istage].input[j]].input[0];
+      }
+      input = plan[istage].input[0];
+      if ((plan[istage].kind != PIPE_LUT) || (input == PIPE_INPUT)            ||
+          (consumer[input] != 1))
+         continue;
+      producer = &(plan[input]);
+      if (producer->tabled)
+      {
+         for (i=0; i<256; i++)
+            producer->table[i] = plan[istage].table[producer->table[i]];
+      }
+      else
+         memcpy (producer->table,plan[istage].table,256);
+      producer->tabled    = 1;
+      consumer[input]     = consumer[istage];
+      plan[istage].fused  = 1;
+   }
+   pipeline->output = pipeline->stage_number - 1;
+   while (plan[pipeline->output].fused)
+      pipeline->output = plan[pipeline->output].input[0];
+/*----------------------------------------------------------------------------*/
+/* Live stages and their margins, from the output back to the input           */
+/*----------------------------------------------------------------------------*/
+   plan[pipeline->output].live = 1;
+   pipeline->kernel_number = 0;
+   buffer_number = 0;
+   halo_lines    = 0;
+   for (istage=pipeline->output; istage>=0; istage--)
+   {
+      if ((!plan[istage].live) || plan[istage].fused)
+         continue;
+      pipeline->kernel_number = pipeline->kernel_number + 1;
+      if (istage != pipeline->output)
+      {
+         buffer_number = buffer_number + 1;
+         halo_lines    = halo_lines + 2 * plan[istage].margin;
+      }
+      margin = plan[istage].margin + PipelineReach (&(plan[istage]));
+      for (j=0; j<2; j++)
+      {
+         input = plan[istage].input[j];
+         if (input == PIPE_INPUT)
+            continue;
+         plan[input].live = 1;
+         if (plan[input].margin < margin)
+            plan[input].margin = margin;
+      }
+   }
+/*----------------------------------------------------------------------------*/
+/* Tiles: the lines of all the intermediates within PIPE_CACHE                */
+/*----------------------------------------------------------------------------*/
+   pipeline->tile_lines = nliin;
+   if (buffer_number > 0)
+   {
+      pipeline->tile_lines = (PIPE_CACHE / npxin - halo_lines) / buffer_number;
+      if (pipeline->tile_lines < MIN_TILE_LINES)
+         pipeline->tile_lines = MIN_TILE_LINES;
+   }
+   if (pipeline->tile_lines > nliin)
+      pipeline->tile_lines = nliin;
+   pipeline->nliin   = nliin;
+   pipeline->npxin   = npxin;
+   pipeline->planned = 1;
+   return (0);
+} /* PipelinePlan */
+
+/******************************************************************************/
+/* PipelineLine returns line ili of a stage in the buffers of a band: the     */
+/* image (or the halo beyond the band) for PIPE_INPUT, the image or the ring  */
+/* of the stage else.                                                         */
+/******************************************************************************/
+static unsigned char *PipelineLine (
+   type_band        *band,              /* band being computed */
+   int              istage,             /* stage, or PIPE_INPUT */
+   int              ili)                /* line of the image */
+{
+   if ((istage == PIPE_INPUT) && (band->halo != NULL))
+   {
+      if (ili < band->ili_first)
+         return (&(band->halo[(ili-band->ili_first+band->halo_lines)*
+                              band->npxin]));
+      if (ili >= band->ili_last)
+         return (&(band->halo[(ili-band->ili_last+band->halo_lines)*
+                              band->npxin]));
+   }
+   if (istage == PIPE_INPUT)
+      return (&(band->image_in[ili*band->stride_in]));
+   if (band->ring[istage] == 0)
+      return (&(band->buffer[istage][ili*band->stride_out]));
+   return (&(band->buffer[istage][(ili%band->ring[istage])*band->npxin]));
+} /* PipelineLine */
+
+/******************************************************************************/
+/* PipelineTableScalar applies a table on n bytes (in place if out = in).     */
+/******************************************************************************/
+static CPU_TARGET_SCALAR void PipelineTableScalar (
+   unsigned char    *table,             /* table of 256 values */
+   unsigned char    *input_line,        /* input bytes */
+   unsigned char    *output_line,       /* output bytes */
+   int              n)                  /* number of bytes */
+{
+   int              ipx;                /* index among pixels */
+
+   for (ipx=0; ipx<n; ipx++)
+      output_line[ipx] = table[input_line[ipx]];
+} /* PipelineTableScalar */
+
+#ifdef CPU_X86
+/******************************************************************************/
+/* PipelineTableAvx2 applies the table 32 bytes at a time. A byte shuffle     */
+/* looks up 16 entries; the 16 slices of the table are swept, the index       */
+/* lowered by 16 at each slice: index + 0x70, saturated, keeps its high bit   */
+/* clear (entry selected) only for the slice holding it, the other slices     */
+/* giving zeros. The bytes beyond the last 32 go through the scalar loop.     */
+/******************************************************************************/
+static CPU_TARGET_AVX2 void PipelineTableAvx2 (
+   unsigned char    *table,             /* table of 256 values */
+   unsigned char    *input_line,        /* input bytes */
+   unsigned char    *output_line,       /* output bytes */
+   int              n)                  /* number of bytes */
+{
+   __m256i          slice[16];          /* the table, 16 entries per lane */
+   __m256i          bias;               /* 0x70 in every byte */
+   __m256i          step;               /* 16 in every byte */
+   __m256i          index;              /* input bytes lowered by 16 k */
+   __m256i          value;              /* output bytes */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among slices */
+
+   for (k=0; k<16; k++)
+      slice[k] = _mm256_broadcastsi128_si256 (
+                    _mm_loadu_si128((__m128i*)&(table[16*k])));
+   bias = _mm256_set1_epi8 (0x70);
+   step = _mm256_set1_epi8 (16);
+   for (ipx=0; ipx+32<=n; ipx+=32)
+   {
+      index = _mm256_loadu_si256 ((__m256i*)&(input_line[ipx]));
+      value = _mm256_setzero_si256 ();
+      for (k=0; k<16; k++)
+      {
+         value = _mm256_or_si256 (value,_mm256_shuffle_epi8(slice[k],
+                                     _mm256_adds_epu8(index,bias)));
+         index = _mm256_sub_epi8 (index,step);
+      }
+      _mm256_storeu_si256 ((__m256i*)&(output_line[ipx]),value);
+   }
+   PipelineTableScalar (table,&(input_line[ipx]),&(output_line[ipx]),n-ipx);
+} /* PipelineTableAvx2 */
+
+/******************************************************************************/
+/* PipelineTableAvx512 is PipelineTableAvx2 on 64 bytes, the last bytes read  */
+/* and written under a mask.                                                  */
+/******************************************************************************/
+static CPU_TARGET_AVX512 void PipelineTableAvx512 (
+   unsigned char    *table,             /* table of 256 values */
+   unsigned char    *input_line,        /* input bytes */
+   unsigned char    *output_line,       /* output bytes */
+   int              n)                  /* number of bytes */
+{
+   __m512i          slice[16];          /* the table, 16 entries per lane */
+   __m512i          bias;               /* 0x70 in every byte */
+   __m512i          step;               /* 16 in every byte */
+   __m512i          index;              /* input bytes lowered by 16 k */
+   __m512i          value;              /* output bytes */
+   __mmask64        mask;               /* bytes of the line */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among slices */
+
+   for (k=0; k<16; k++)
+      slice[k] = _mm512_broadcast_i32x4 (
+                    _mm_loadu_si128((__m128i*)&(table[16*k])));
+   bias = _mm512_set1_epi8 (0x70);
+   step = _mm512_set1_epi8 (16);
+   for (ipx=0; ipx<n; ipx+=64)
+   {
+      mask  = (n-ipx >= 64 ? ~(__mmask64)0 : ((__mmask64)1 << (n-ipx)) - 1);
+      index = _mm512_maskz_loadu_epi8 (mask,&(input_line[ipx]));
+      value = _mm512_setzero_si512 ();
+      for (k=0; k<16; k++)
+      {
+         value = _mm512_or_si512 (value,_mm512_shuffle_epi8(slice[k],
+                                     _mm512_adds_epu8(index,bias)));
+         index = _mm512_sub_epi8 (index,step);
+      }
+      _mm512_mask_storeu_epi8 (&(output_line[ipx]),mask,value);
+   }
+} /* PipelineTableAvx512 */
+
+/******************************************************************************/
+/* PipelineTableVbmi applies the table 64 bytes at a time with the byte       */
+/* permutes of AVX-512 VBMI: two 128-entry lookups (7 low bits of the index), */
+/* the high bit choosing between them.                                        */
+/******************************************************************************/
+static CPU_TARGET_VBMI void PipelineTableVbmi (
+   unsigned char    *table,             /* table of 256 values */
+   unsigned char    *input_line,        /* input bytes */
+   unsigned char    *output_line,       /* output bytes */
+   int              n)                  /* number of bytes */
+{
+   __m512i          quarter[4];         /* the table, 64 entries each */
+   __m512i          index;              /* input bytes */
+   __m512i          low;                /* entries 0 to 127 */
+   __m512i          high;               /* entries 128 to 255 */
+   __mmask64        mask;               /* bytes of the line */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among quarters */
+
+   for (k=0; k<4; k++)
+      quarter[k] = _mm512_loadu_si512 (&(table[64*k]));
+   for (ipx=0; ipx<n; ipx+=64)
+   {
+      mask  = (n-ipx >= 64 ? ~(__mmask64)0 : ((__mmask64)1 << (n-ipx)) - 1);
+      index = _mm512_maskz_loadu_epi8 (mask,&(input_line[ipx]));
+      low   = _mm512_permutex2var_epi8 (quarter[0],index,quarter[1]);
+      high  = _mm512_permutex2var_epi8 (quarter[2],index,quarter[3]);
+      _mm512_mask_storeu_epi8 (&(output_line[ipx]),mask,
+         _mm512_mask_blend_epi8(_mm512_movepi8_mask(index),low,high));
+   }
+} /* PipelineTableVbmi */
+#endif
+
+/******************************************************************************/
+/* PipelineTable applies a table on n bytes with the variant of the CPU: the  */
+/* scalar loop up to SSE4.2 (a 16-byte sweep of the table is slower than it), */
+/* the sweep on AVX2 and AVX-512, the byte permutes on AVX-512 VBMI.          */
+/******************************************************************************/
+static void PipelineTable (
+   unsigned char    *table,             /* table of 256 values */
+   unsigned char    *input_line,        /* input bytes */
+   unsigned char    *output_line,       /* output bytes */
+   int              n)                  /* number of bytes */
+{
+#ifdef CPU_X86
+   if (CpuFeatures() & CPU_HAS_VBMI)
+      PipelineTableVbmi (table,input_line,output_line,n);
+   else if (CpuLevel() == CPU_AVX512)
+      PipelineTableAvx512 (table,input_line,output_line,n);
+   else if (CpuLevel() == CPU_AVX2)
+      PipelineTableAvx2 (table,input_line,output_line,n);
+   else
+#endif
+      PipelineTableScalar (table,input_line,output_line,n);
+} /* PipelineTable */
+
+/******************************************************************************/
+/* PipelineStageLine computes line ili of a stage, its inputs being computed  */
+/* up to the lines it reads.                                                  */
+/******************************************************************************/
+static void PipelineStageLine (
+   type_band        *band,              /* band being computed */
+   type_stage       *stage,             /* stage to be computed */
+   int              istage,             /* index of the stage */
+   int              ili,                /* line to be computed */
+   int              nliin,              /* input line number */
+   float            *row)               /* work row of npxin floats */
+{
+   int              npxin;              /* input pixel number */
+   int              half;               /* half size of a matrix */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among lines in matrix */
+   unsigned char    *input_line[MAX_FFT_SIZE]; /* input lines of a matrix */
+   unsigned char    *a_line;            /* line of the first input */
+   unsigned char    *b_line;            /* line of the second input */
+   unsigned char    *output_line;       /* line being computed */
+
+   npxin       = band->npxin;
+   output_line = PipelineLine (band,istage,ili);
+   a_line      = PipelineLine (band,stage->input[0],ili);
+   switch (stage->kind)
+   {
+      case PIPE_LUT:
+         PipelineTable (stage->table,a_line,output_line,npxin);
+         return;
+      case PIPE_CONVOL:
+         half = stage->convol->size / 2;
+         if ((ili < half) || (ili >= nliin-half))
+            memcpy (output_line,a_line,npxin);
+         else
+         {
+            for (k=-half; k<=half; k++)
+               input_line[half+k] = PipelineLine (band,stage->input[0],ili+k);
+            ConvolutionLine (stage->convol,input_line,output_line,npxin,row);
+         }
+         break;
+      default:
+         b_line = PipelineLine (band,stage->input[1],ili);
+         for (ipx=0; ipx<npxin; ipx++)
+            row[ipx] = stage->gain[0] * a_line[ipx] +
+                       stage->gain[1] * b_line[ipx];
+         SaturateRow (row,output_line,npxin,1.f,stage->offset);
+         break;
+   }
+/*----------------------------------------------------------------------------*/
+/* Tables fused into the stage, while the line is in cache                    */
+/*----------------------------------------------------------------------------*/
+   if (stage->tabled)
+      PipelineTable (stage->table,output_line,output_line,npxin);
+} /* PipelineStageLine */
+
+/******************************************************************************/
+/* PipelineBand is the pool task computing one (channel,band) pair, tile by   */
+/* tile of job->tile_lines lines. For each tile, every live stage             */
+/* computes the lines it has not computed yet up to the end of the tile plus  */
+/* its margin, in a ring of tile_lines + 2 margin lines: the lines still read */
+/* by the next stages are kept, the older ones are overwritten.               */
+/* In place, the output stage writes a ring too, whose lines are copied into  */
+/* the image once the stages reading the input have gone past them.           */
+/******************************************************************************/
+static void PipelineBand (
+   void             *argument,          /* type_pipeline_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   type_pipeline_job *job;              /* job the task belongs to */
+   type_pipeline    *pipeline;          /* planned pipeline */
+   type_stage       *stage;             /* current stage */
+   type_band        band;               /* buffers of the band */
+   int              done[MAX_STAGE];    /* first line not computed yet */
+   int              nliin;              /* input line number */
+   int              ichannel;           /* channel of the band */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              tile_last;          /* line following the current tile */
+   int              istage;             /* index among stages */
+   int              last;               /* line following a stage's lines */
+   int              ili;                /* index among lines */
+   int              written;            /* first output line not in the image */
+   int              read;               /* first input line still to be read */
+   char             *memory;            /* row, halo and rings of the task */
+   size_t           size;               /* bytes of memory given out */
+
+   job       = (type_pipeline_job*)argument;
+   pipeline  = job->pipeline;
+   nliin     = pipeline->nliin;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > nliin)
+      ili_last = nliin;
+/*----------------------------------------------------------------------------*/
+/* Rings of the intermediate stages, the output stage writing the image (or   */
+/* its ring, in place)                                                        */
+/*----------------------------------------------------------------------------*/
+   memory = job->memory + itask * job->task_bytes;
+   size   = IMAGE_ROUND(pipeline->npxin*sizeof(float));
+   band.halo = NULL;
+   if (job->in_place)
+      band.halo = (unsigned char*)(memory + size);
+   size = size + IMAGE_ROUND((size_t)2*job->halo_lines*pipeline->npxin);
+   for (istage=0; istage<=pipeline->output; istage++)
+   {
+      band.ring[istage]   = job->ring[istage];
+      band.buffer[istage] = (unsigned char*)(memory + size);
+      size = size + IMAGE_ROUND((size_t)job->ring[istage]*pipeline->npxin);
+      done[istage] = ili_first - pipeline->plan[istage].margin;
+      if (done[istage] < 0)
+         done[istage] = 0;
+   }
+   if (!job->in_place)
+   {
+      band.buffer[pipeline->output] = job->image_out[ichannel];
+      band.ring[pipeline->output]   = 0;
+   }
+   done[pipeline->output] = ili_first;
+   written                = ili_first;
+   band.image_in   = job->image_in[ichannel];
+   band.halo_lines = job->halo_lines;
+   band.ili_first  = ili_first;
+   band.ili_last   = ili_last;
+   band.stride_in  = job->stride_in;
+   band.stride_out = job->stride_out;
+   band.npxin      = pipeline->npxin;
+/*----------------------------------------------------------------------------*/
+/* Tiles in order, each stage going down to the end of the tile + its margin  */
+/*----------------------------------------------------------------------------*/
+   for (tile_last=ili_first; tile_last<ili_last; )
+   {
+      tile_last = tile_last + job->tile_lines;
+      if (tile_last > ili_last)
+         tile_last = ili_last;
+      for (istage=0; istage<=pipeline->output; istage++)
+      {
+         stage = &(pipeline->plan[istage]);
+         if ((!stage->live) || stage->fused)
+            continue;
+         last = tile_last + stage->margin;
+         if (last > nliin)
+            last = nliin;
+         for (ili=done[istage]; ili<last; ili++)
+            PipelineStageLine (&band,stage,istage,ili,nliin,(float*)memory);
+         if (done[istage] < last)
+            done[istage] = last;
+      }
+      if (!job->in_place)
+         continue;
+/*----------------------------------------------------------------------------*/
+/*    In place: output lines above the lowest input line still to be read     */
+/*----------------------------------------------------------------------------*/
+      read = done[pipeline->output];
+      for (istage=0; (istage<=pipeline->output) && (read<ili_last); istage++)
+      {
+         stage = &(pipeline->plan[istage]);
+         if (stage->live && (!stage->fused)                                   &&
+             ((stage->input[0] == PIPE_INPUT) ||
+              (stage->input[1] == PIPE_INPUT))                                &&
+             (read > done[istage] - PipelineReach(stage)))
+            read = done[istage] - PipelineReach (stage);
+      }
+      for (ili=written; ili<read; ili++)
+         memcpy (&(job->image_out[ichannel][ili*job->stride_out]),
+                 PipelineLine(&band,pipeline->output,ili),pipeline->npxin);
+      if (written < read)
+         written = read;
+   }
+} /* PipelineBand */
+
+/******************************************************************************/
+/* PipelinePlaneBand is the pool task computing one (channel,band) pair of    */
+/* stage job->istage on whole planes.                                         */
+/******************************************************************************/
+static void PipelinePlaneBand (
+   void             *argument,          /* type_pipeline_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_pipeline_job *job;              /* job the task belongs to */
+   type_pipeline    *pipeline;          /* planned pipeline */
+   type_band        band;               /* planes of the channel */
+   int              ichannel;           /* channel of the band */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              istage;             /* index among stages */
+   int              ili;                /* index among lines */
+
+   job       = (type_pipeline_job*)argument;
+   pipeline  = job->pipeline;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > pipeline->nliin)
+      ili_last = pipeline->nliin;
+   for (istage=0; istage<=job->istage; istage++)
+   {
+      band.buffer[istage] = job->plane[istage][ichannel];
+      band.ring[istage]   = 0;
+   }
+   band.image_in   = job->image_in[ichannel];
+   band.halo       = NULL;
+   band.stride_in  = pipeline->npxin;
+   band.stride_out = pipeline->npxin;
+   band.npxin      = pipeline->npxin;
+   for (ili=ili_first; ili<ili_last; ili++)
+      PipelineStageLine (&band,&(pipeline->plan[job->istage]),job->istage,ili,
+                         pipeline->nliin,
+                         (float*)(job->memory + itask * job->task_bytes));
+} /* PipelinePlaneBand */
+
+/******************************************************************************/
+/* PipelineJob plans the pipeline if needed and cuts the channels into bands  */
+/* for the threads of the pool. Returns 1 if the pipeline is empty.           */
+/******************************************************************************/
+static int PipelineJob (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pipeline    *pipeline,          /* pipeline to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   type_pipeline_job *job)              /* job to be prepared */
+{
+   if (((!pipeline->planned) || (pipeline->nliin != nliin)                  ||
+        (pipeline->npxin != npxin))                                         &&
+       (PipelinePlan(pipeline,nliin,npxin) != 0))
+      return (1);
+   job->pipeline    = pipeline;
+   job->image_in    = image_in;
+   job->image_out   = image_out;
+   job->stride_in   = npxin;
+   job->stride_out  = npxin;
+   job->status      = 0;
+   job->in_place    = 0;
+   job->halo_lines  = 0;
+   job->band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                       channel_number - 1) / channel_number;
+   if (job->band_number > nliin / MIN_BAND_LINES)
+      job->band_number = nliin / MIN_BAND_LINES;
+   if (job->band_number < 1)
+      job->band_number = 1;
+   job->band_lines  = (nliin + job->band_number - 1) / job->band_number;
+   job->band_number = (nliin + job->band_lines - 1) / job->band_lines;
+   return (0);
+} /* PipelineJob */
+
+/******************************************************************************/
+/* PipelineHalo copies, for an in-place run, the input lines that the band of */
+/* task itask reads beyond its own lines into its halo, before the            */
+/* neighboring bands overwrite them.                                          */
+/******************************************************************************/
+static void PipelineHalo (
+   type_pipeline_job *job,              /* job about to be run */
+   int              itask)              /* channel * band_number + band */
+{
+   unsigned char    *image;             /* image array of the channel */
+   unsigned char    *halo;              /* halo of the band */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              k;                  /* index among halo lines */
+
+   nliin     = job->pipeline->nliin;
+   npxin     = job->pipeline->npxin;
+   image     = job->image_in[itask/job->band_number];
+   halo      = (unsigned char*)(job->memory + itask * job->task_bytes +
+                                IMAGE_ROUND(npxin*sizeof(float)));
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   for (k=0; k<job->halo_lines; k++)
+   {
+      if (ili_first - job->halo_lines + k >= 0)
+         memcpy (&(halo[k*npxin]),
+                 &(image[(ili_first-job->halo_lines+k)*job->stride_in]),npxin);
+      if (ili_last + k < nliin)
+         memcpy (&(halo[(job->halo_lines+k)*npxin]),
+                 &(image[(ili_last+k)*job->stride_in]),npxin);
+   }
+} /* PipelineHalo */
+
+/******************************************************************************/
+/* PipelineRun applies the pipeline on all the channels concurrently, band by */
+/* band on the thread pool, for images whose lines are stride_in and          */
+/* stride_out bytes apart. Returns as PipelineApply().                        */
+/******************************************************************************/
+static int PipelineRun (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pipeline    *pipeline,          /* pipeline to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin,              /* input pixel number */
+   int              stride_in,          /* bytes between input lines */
+   int              stride_out)         /* bytes between output lines */
+{
+   type_pipeline_job job;               /* job shared by all the bands */
+   type_stage       *stage;             /* current stage */
+   int              istage;             /* index among stages */
+   int              ichannel;           /* index among channels */
+   int              itask;              /* index among tasks */
+   int              ibuffer;            /* buffer of the rings in the arena */
+
+   if (PipelineJob(pool,pipeline,channel_number,image_in,image_out,nliin,
+                   npxin,&job) != 0)
+      return (1);
+   job.stride_in  = stride_in;
+   job.stride_out = stride_out;
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      if (image_out[ichannel] == image_in[ichannel])
+         job.in_place = 1;
+   }
+   if (job.in_place && ((!PipelineInPlace(pipeline)) ||
+                        (stride_in != stride_out)))
+      return (1);
+   job.tile_lines = pipeline->tile_lines;
+   if (job.tile_lines > job.band_lines)
+      job.tile_lines = job.band_lines;
+/*----------------------------------------------------------------------------*/
+/* In place: halo of the stages reading the input and ring of the output, the */
+/* output ring taking its share of the PIPE_CACHE bytes of a tile             */
+/*----------------------------------------------------------------------------*/
+   for (istage=0; job.in_place && (istage<=pipeline->output); istage++)
+   {
+      stage = &(pipeline->plan[istage]);
+      if (stage->live && (!stage->fused)                                      &&
+          ((stage->input[0] == PIPE_INPUT) ||
+           (stage->input[1] == PIPE_INPUT))                                   &&
+          (job.halo_lines < stage->margin + PipelineReach(stage)))
+         job.halo_lines = stage->margin + PipelineReach (stage);
+   }
+   if (job.in_place)
+   {
+      if (pipeline->kernel_number > 1)
+         job.tile_lines = job.tile_lines * (pipeline->kernel_number - 1) /
+                          pipeline->kernel_number;
+      else if (job.tile_lines > PIPE_CACHE / npxin)
+         job.tile_lines = PIPE_CACHE / npxin;
+      if (job.tile_lines < MIN_TILE_LINES)
+         job.tile_lines = MIN_TILE_LINES;
+      if (job.tile_lines > job.band_lines)
+         job.tile_lines = job.band_lines;
+   }
+   job.task_bytes = IMAGE_ROUND(npxin*sizeof(float)) +
+                    IMAGE_ROUND((size_t)2*job.halo_lines*npxin);
+   for (istage=0; istage<=pipeline->output; istage++)
+   {
+      job.ring[istage] = 0;
+      if (istage == pipeline->output)
+      {
+         if (job.in_place)
+            job.ring[istage] = job.tile_lines + job.halo_lines;
+      }
+      else if (pipeline->plan[istage].live && !pipeline->plan[istage].fused)
+         job.ring[istage] = job.tile_lines + 2 * pipeline->plan[istage].margin;
+      job.task_bytes = job.task_bytes +
+                       IMAGE_ROUND((size_t)job.ring[istage]*npxin);
+   }
+   ArenaReset (&pipeline->arena);
+   if (((ibuffer=ArenaRequest(&pipeline->arena,channel_number*
+                  job.band_number*job.task_bytes,0,0)) < 0)                 ||
+       (ArenaPlan(&pipeline->arena) != 0))
+      return (1);
+   job.memory = (char*)ArenaBuffer (&pipeline->arena,ibuffer);
+   for (itask=0; job.in_place && (itask<channel_number*job.band_number);
+        itask++)
+      PipelineHalo (&job,itask);
+   PoolRun (pool,channel_number*job.band_number,PipelineBand,&job);
+   return (job.status);
+} /* PipelineRun */
+
+/******************************************************************************/
+/* PipelineApply applies the pipeline on all the channels concurrently, band  */
+/* by band on the thread pool, planning it first if needed. Only the margins  */
+/* of the bands are computed twice. The rings of all the bands are taken from */
+/* the arena of the pipeline, allocated once for a given size.                */
+/* image_out may be image_in (in place, see PipelineInPlace()), but must not  */
+/* overlap it otherwise. Returns 1 if the pipeline is empty, cannot be run in */
+/* place when asked to, or memory is lacking.                                 */
+/******************************************************************************/
+int PipelineApply (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pipeline    *pipeline,          /* pipeline to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   return (PipelineRun(pool,pipeline,channel_number,image_in,image_out,nliin,
+                       npxin,npxin,npxin));
+} /* PipelineApply */
+
+/******************************************************************************/
+/* PipelineApplyImage applies the pipeline as PipelineApply() does on images  */
+/* of any stride, such as windows of larger images (ImageView): the window    */
+/* is processed without being copied, its borders as the borders of an        */
+/* image. Returns 1 if the sizes differ, or as PipelineApply().               */
+/******************************************************************************/
+int PipelineApplyImage (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pipeline    *pipeline,          /* pipeline to be applied */
+   type_image       *image_in,          /* input image */
+   type_image       *image_out)         /* output image, same size */
+{
+   if ((image_out->nliin != image_in->nliin)                               ||
+       (image_out->npxin != image_in->npxin)                               ||
+       (image_out->channel_number < image_in->channel_number))
+      return (1);
+   return (PipelineRun(pool,pipeline,image_in->channel_number,
+                       image_in->plane,image_out->plane,image_in->nliin,
+                       image_in->npxin,image_in->stride,image_out->stride));
+} /* PipelineApplyImage */
+
+/******************************************************************************/
+/* PipelineApplyPlanes applies the pipeline stage after stage on whole        */
+/* planes, each stage on the bands of all the channels concurrently (for      */
+/* stages too wide to be tiled, or to compare). The planes of the stages are  */
+/* taken from the arena of the pipeline: a plane lives from its stage to the  */
+/* last stage reading it, and planes that do not live at the same time share  */
+/* their memory (a chain of stages needs 2 planes). arena.peak gives the      */
+/* bytes used, arena.total the bytes of a plane per stage. Returns 1 if the   */
+/* pipeline is empty, image_out is image_in or memory is lacking.             */
+/******************************************************************************/
+int PipelineApplyPlanes (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pipeline    *pipeline,          /* pipeline to be applied */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_pipeline_job job;               /* job shared by all the bands */
+   type_stage       *plan;              /* stages after fusion */
+   int              buffer[MAX_STAGE];  /* planes of the stages in the arena */
+   int              ibuffer;            /* buffer of the rows in the arena */
+   int              istage;             /* index among stages */
+   int              jstage;             /* index among readers of a stage */
+   int              last;               /* last stage reading a plane */
+   int              ichannel;           /* index among channels */
+   size_t           plane_size;         /* bytes of a plane */
+
+   if (PipelineJob(pool,pipeline,channel_number,image_in,image_out,nliin,
+                   npxin,&job) != 0)
+      return (1);
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      if (image_out[ichannel] == image_in[ichannel])
+         return (1);
+   }
+   plan = pipeline->plan;
+   memset (job.plane,0,sizeof(job.plane));
+/*----------------------------------------------------------------------------*/
+/* Lifetimes of the planes, step i being the run of stage i                   */
+/*----------------------------------------------------------------------------*/
+   ArenaReset (&pipeline->arena);
+   job.task_bytes = IMAGE_ROUND(npxin*sizeof(float));
+   ibuffer    = ArenaRequest (&pipeline->arena,channel_number*
+                              job.band_number*job.task_bytes,0,
+                              pipeline->output);
+   plane_size = IMAGE_ROUND((size_t)nliin*npxin);
+   for (istage=0; istage<pipeline->output; istage++)
+   {
+      buffer[istage] = 0;
+      if ((!plan[istage].live) || plan[istage].fused)
+         continue;
+      last = istage;
+      for (jstage=istage+1; jstage<=pipeline->output; jstage++)
+      {
+         if (plan[jstage].live && (!plan[jstage].fused)                       &&
+             ((plan[jstage].input[0] == istage)                               ||
+              (plan[jstage].input[1] == istage)))
+            last = jstage;
+      }
+      if ((buffer[istage]=ArenaRequest(&pipeline->arena,
+                          channel_number*plane_size,istage,last)) < 0)
+         return (1);
+   }
+   if ((ibuffer < 0) || (ArenaPlan(&pipeline->arena) != 0))
+      return (1);
+   job.memory = (char*)ArenaBuffer (&pipeline->arena,ibuffer);
+   for (istage=0; istage<pipeline->output; istage++)
+   {
+      for (ichannel=0; ichannel<channel_number; ichannel++)
+      {
+         if (plan[istage].live && !plan[istage].fused)
+            job.plane[istage][ichannel] = (unsigned char*)ArenaBuffer(
+               &pipeline->arena,buffer[istage]) + ichannel * plane_size;
+      }
+   }
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+      job.plane[pipeline->output][ichannel] = image_out[ichannel];
+/*----------------------------------------------------------------------------*/
+/* Stages in order                                                            */
+/*----------------------------------------------------------------------------*/
+   for (istage=0; (istage<=pipeline->output) && (job.status == 0); istage++)
+   {
+      if ((!plan[istage].live) || plan[istage].fused)
+         continue;
+      job.istage = istage;
+      PoolRun (pool,channel_number*job.band_number,PipelinePlaneBand,&job);
+   }
+   return (job.status);
+} /* PipelineApplyPlanes */
+
+/******************************************************************************/
+/* PipelineRelease frees the arena of the pipeline, whose stages are kept.    */
+/******************************************************************************/
+void PipelineRelease (
+   type_pipeline    *pipeline)          /* pipeline to be released */
+{
+   ArenaFree (&pipeline->arena);
+} /* PipelineRelease */
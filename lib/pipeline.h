@@ -0,0 +1,78 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* pipeline runs a graph of operators (look-up tables, arithmetic,            */
+/* thresholds, convolutions) tile by tile, without whole intermediate planes. */
+/******************************************************************************/
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include  "pool.h"
+#include  "convol.h"
+#include  "arena.h"
+#include  "image.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_STAGE       16              /* greatest number of stages */
+#define PIPE_INPUT      (-1)            /* the input image, as a stage input */
+#define PIPE_ERROR      (-2)            /* stage that could not be appended */
+
+#define PIPE_LUT        0               /* table of the 256 output values */
+#define PIPE_CONVOL     1               /* convolution, direct method */
+#define PIPE_COMBINE    2               /* gain_a a + gain_b b + offset */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              kind;               /* PIPE_... operator */
+   int              input[2];           /* stages read, or PIPE_INPUT */
+   unsigned char    table[256];         /* table of PIPE_LUT, or table applied
+                                           to the output (fused tables) */
+   int              tabled;             /* "table is applied to the output" */
+   type_convol      *convol;            /* PIPE_CONVOL: matrix */
+   float            gain[2];            /* PIPE_COMBINE: gains of the inputs */
+   float            offset;             /* PIPE_COMBINE: value added */
+   int              fused;              /* "merged into its input stage" */
+   int              live;               /* "needed by the output" */
+   int              margin;             /* lines computed around a tile */
+} type_stage;
+
+typedef struct {
+   int              stage_number;       /* number of declared stages */
+   type_stage       stage[MAX_STAGE];   /* stages as declared */
+   type_stage       plan[MAX_STAGE];    /* stages after fusion */
+   int              planned;            /* "PipelinePlan() has been called" */
+   int              output;             /* stage of plan[] giving the output */
+   int              kernel_number;      /* stages run per tile */
+   int              nliin;              /* line number planned for */
+   int              npxin;              /* pixel number planned for */
+   int              tile_lines;         /* output lines per tile */
+   type_arena       arena;              /* rings or planes of the stages */
+} type_pipeline;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+void PipelineInit (type_pipeline *pipeline);
+int PipelineLut (type_pipeline *pipeline, int input, unsigned char *table);
+int PipelineLinear (type_pipeline *pipeline, int input, float gain,
+                    float offset);
+int PipelineThreshold (type_pipeline *pipeline, int input, int threshold);
+int PipelineConvol (type_pipeline *pipeline, int input, type_convol *convol);
+int PipelineCombine (type_pipeline *pipeline, int input_a, int input_b,
+                     float gain_a, float gain_b, float offset);
+int PipelineInPlace (type_pipeline *pipeline);
+int PipelinePlan (type_pipeline *pipeline, int nliin, int npxin);
+int PipelineApply (type_pool *pool, type_pipeline *pipeline,
+                   int channel_number, unsigned char *image_in[3],
+                   unsigned char *image_out[3], int nliin, int npxin);
+int PipelineApplyImage (type_pool *pool, type_pipeline *pipeline,
+                        type_image *image_in, type_image *image_out);
+int PipelineApplyPlanes (type_pool *pool, type_pipeline *pipeline,
+                         int channel_number, unsigned char *image_in[3],
+                         unsigned char *image_out[3], int nliin, int npxin);
+void PipelineRelease (type_pipeline *pipeline);
+
+#endif /* PIPELINE_H */
@@ -0,0 +1,210 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* pool is a minimal thread pool used to run image processing tasks (row      */
+/* bands, tiles, channels) concurrently.                                      */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Workers sleep on a condition variable until PoolRun() publishes a new job  */
+/* (a new "generation"). Task indices are then distributed one by one under   */
+/* the pool mutex, so that faster threads pick more tasks. The caller thread  */
+/* takes part in the job and waits for the completion of the last task.       */
+/* A NULL pool is accepted everywhere and means "run serially".               */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <unistd.h>
+#include  <pthread.h>
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_THREAD  64                  /* greatest number of threads */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+struct type_pool {
+   int              thread_number;      /* number of threads incl. caller */
+   pthread_t        thread[MAX_THREAD]; /* worker threads */
+   pthread_mutex_t  mutex;              /* protects all the fields below */
+   pthread_cond_t   start_cond;         /* signaled when a job is published */
+   pthread_cond_t   done_cond;          /* signaled when a job is completed */
+   int              generation;         /* index of the current job */
+   int              stop;               /* "workers must exit" flag */
+   type_task        task;               /* task function of the current job */
+   void             *argument;          /* argument of the current job */
+   int              task_number;        /* number of tasks in the current job*/
+   int              next_task;          /* next task index to be distributed */
+   int              done_task;          /* number of completed tasks */
+};
+
+/******************************************************************************/
+/* PoolWork runs the tasks of the current job until none is left.             */
+/* The pool mutex must be held on entry; it is held again on exit.            */
+/******************************************************************************/
+static void PoolWork (
+   type_pool        *pool)              /* pool to work for */
+{
+   int              itask;              /* index of the task to be run */
+
+   while (pool->next_task < pool->task_number)
+   {
+      itask = pool->next_task;
+      pool->next_task = pool->next_task + 1;
+      pthread_mutex_unlock (&pool->mutex);
+      pool->task (pool->argument,itask);
+      pthread_mutex_lock (&pool->mutex);
+      pool->done_task = pool->done_task + 1;
+      if (pool->done_task == pool->task_number)
+         pthread_cond_broadcast (&pool->done_cond);
+   }
+} /* PoolWork */
+
+/******************************************************************************/
+/* PoolWorker is the main loop of the worker threads.                         */
+/******************************************************************************/
+static void *PoolWorker (
+   void             *argument)          /* pool the worker belongs to */
+{
+   type_pool        *pool;              /* pool the worker belongs to */
+   int              generation;         /* last job seen by this worker */
+
+   pool = (type_pool*)argument;
+   pthread_mutex_lock (&pool->mutex);
+   generation = pool->generation;
+   for (;;)
+   {
+      while ((pool->generation == generation) && (!pool->stop))
+         pthread_cond_wait (&pool->start_cond,&pool->mutex);
+      if (pool->stop)
+         break;
+      generation = pool->generation;
+      PoolWork (pool);
+   }
+   pthread_mutex_unlock (&pool->mutex);
+   return (NULL);
+} /* PoolWorker */
+
+/******************************************************************************/
+/* PoolDefaultThreadNumber returns the number of online processors, possibly  */
+/* overridden by the ITI_THREADS environment variable.                        */
+/******************************************************************************/
+int PoolDefaultThreadNumber (void)
+{
+   char             *value;             /* value of ITI_THREADS */
+   int              thread_number;      /* number of threads */
+
+   value = getenv ("ITI_THREADS");
+   if ((value == NULL) || (sscanf(value,"%d",&thread_number) != 1))
+      thread_number = (int)sysconf (_SC_NPROCESSORS_ONLN);
+   if (thread_number < 1)
+      thread_number = 1;
+   if (thread_number > MAX_THREAD)
+      thread_number = MAX_THREAD;
+   return (thread_number);
+} /* PoolDefaultThreadNumber */
+
+/******************************************************************************/
+/* PoolCreate starts a pool of thread_number threads (caller included).       */
+/* thread_number <= 0 selects PoolDefaultThreadNumber().                      */
+/* Returns NULL if the pool cannot be created.                                */
+/******************************************************************************/
+type_pool *PoolCreate (
+   int              thread_number)      /* number of threads incl. caller */
+{
+   type_pool        *pool;              /* pool being created */
+   int              ithread;            /* index among threads */
+
+   if (thread_number <= 0)
+      thread_number = PoolDefaultThreadNumber ();
+   if (thread_number > MAX_THREAD)
+      thread_number = MAX_THREAD;
+   if ((pool=(type_pool*)calloc(1,sizeof(type_pool))) == NULL)
+      return (NULL);
+   pool->thread_number = 1;
+   pthread_mutex_init (&pool->mutex,NULL);
+   pthread_cond_init (&pool->start_cond,NULL);
+   pthread_cond_init (&pool->done_cond,NULL);
+   for (ithread=1; ithread<thread_number; ithread++)
+   {
+      if (pthread_create(&pool->thread[ithread],NULL,PoolWorker,pool) != 0)
+      {
+         PoolDestroy (pool);
+         return (NULL);
+      }
+      pool->thread_number = pool->thread_number + 1;
+   }
+   return (pool);
+} /* PoolCreate */
+
+/******************************************************************************/
+/* PoolThreadNumber returns the number of threads of the pool (1 if NULL).    */
+/******************************************************************************/
+int PoolThreadNumber (
+   type_pool        *pool)              /* pool to be queried */
+{
+   if (pool == NULL)
+      return (1);
+   return (pool->thread_number);
+} /* PoolThreadNumber */
+
+/******************************************************************************/
+/* PoolRun calls task(argument,itask) for itask=0,task_number-1 on the pool   */
+/* threads and returns 0 when all the tasks are completed.                    */
+/******************************************************************************/
+int PoolRun (
+   type_pool        *pool,              /* pool to run on (NULL = serial) */
+   int              task_number,        /* number of tasks */
+   type_task        task,               /* task function */
+   void             *argument)          /* argument passed to every task */
+{
+   int              itask;              /* index among tasks */
+
+   if ((pool == NULL) || (pool->thread_number == 1) || (task_number <= 1))
+   {
+      for (itask=0; itask<task_number; itask++)
+         task (argument,itask);
+      return (0);
+   }
+   pthread_mutex_lock (&pool->mutex);
+   pool->task        = task;
+   pool->argument    = argument;
+   pool->task_number = task_number;
+   pool->next_task   = 0;
+   pool->done_task   = 0;
+   pool->generation  = pool->generation + 1;
+   pthread_cond_broadcast (&pool->start_cond);
+   PoolWork (pool);
+   while (pool->done_task < pool->task_number)
+      pthread_cond_wait (&pool->done_cond,&pool->mutex);
+   pthread_mutex_unlock (&pool->mutex);
+   return (0);
+} /* PoolRun */
+
+/******************************************************************************/
+/* PoolDestroy stops the worker threads and releases the pool.                */
+/******************************************************************************/
+void PoolDestroy (
+   type_pool        *pool)              /* pool to be released */
+{
+   int              ithread;            /* index among threads */
+
+   if (pool == NULL)
+      return;
+   pthread_mutex_lock (&pool->mutex);
+   pool->stop = 1;
+   pthread_cond_broadcast (&pool->start_cond);
+   pthread_mutex_unlock (&pool->mutex);
+   for (ithread=1; ithread<pool->thread_number; ithread++)
+      pthread_join (pool->thread[ithread],NULL);
+   pthread_mutex_destroy (&pool->mutex);
+   pthread_cond_destroy (&pool->start_cond);
+   pthread_cond_destroy (&pool->done_cond);
+   free (pool);
+} /* PoolDestroy */
@@ -0,0 +1,33 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* pool is a minimal thread pool used to run image processing tasks (row      */
+/* bands, tiles, channels) concurrently.                                      */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A pool owns (thread_number - 1) worker threads; the calling thread is the  */
+/* last worker. PoolRun() behaves as a parallel "for" loop: the task function */
+/* is called once for each index in [0,task_number) and PoolRun() returns     */
+/* when all of them are completed. Tasks must not call PoolRun() themselves.  */
+/******************************************************************************/
+#ifndef POOL_H
+#define POOL_H
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef void (*type_task) (
+   void             *argument,          /* argument shared by all the tasks */
+   int              itask);             /* index of the task to be run */
+
+typedef struct type_pool type_pool;     /* opaque pool of worker threads */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int PoolDefaultThreadNumber (void);
+type_pool *PoolCreate (int thread_number);
+int PoolThreadNumber (type_pool *pool);
+int PoolRun (type_pool *pool, int task_number, type_task task, void *argument);
+void PoolDestroy (type_pool *pool);
+
+#endif /* POOL_H */
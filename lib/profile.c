@@ -0,0 +1,238 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* profile records the wall and CPU time, pixels and bytes of the stages of a */
+/* run (load, operator, frame buffer, XPutImage), for a summary table and a   */
+/* Chrome trace.                                                              */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A stage is timed by a pair ProfileBegin() / ProfileEnd(), which may nest.  */
+/* Until ProfileStart() is called the profile is disabled: ProfileBegin()     */
+/* returns PROFILE_OFF without reading any clock and ProfileEnd() ignores it, */
+/* so that the calls may stay in the code. Enabled, a pair costs four         */
+/* clock_gettime() calls: the wall time on CLOCK_MONOTONIC and the CPU time   */
+/* of the process (all the threads of the pools) on CLOCK_PROCESS_CPUTIME_ID, */
+/* a CPU time greater than the wall time showing the parallelism of the       */
+/* stage. The pixels processed and bytes read and written are given by the    */
+/* caller to ProfileEnd().                                                    */
+/*                                                                            */
+/* ProfileReport() prints one line per stage name, calls summed, in the order */
+/* of their first call. ProfileTrace() writes every event as a complete event */
+/* ("ph":"X") of the Chrome trace format, opened by chrome://tracing or       */
+/* ui.perfetto.dev. Events are recorded by the calling thread only: stages    */
+/* are timed around the pool runs, never inside the tasks.                    */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <time.h>
+
+#include  "profile.h"
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   char             name[PROFILE_NAME_LENGTH]; /* name of the stage */
+   double           start;              /* wall time of ProfileBegin() */
+   double           wall;               /* wall time of the stage (s) */
+   double           cpu;                /* CPU time of the stage (s) */
+   double           pixels;             /* pixels processed */
+   double           bytes;              /* bytes read and written */
+   int              depth;              /* stages open around this one */
+   int              open;               /* "ProfileEnd() not yet called" */
+} type_profile_event;
+
+/******************************************************************************/
+/* Events of the run                                                          */
+/******************************************************************************/
+static type_profile_event PROFILE_EVENT[PROFILE_MAX_EVENT];
+static int          PROFILE_EVENT_NUMBER = 0; /* events recorded */
+static int          PROFILE_DROPPED = 0;      /* events beyond the table */
+static int          PROFILE_DEPTH = 0;        /* stages currently open */
+static int          PROFILE_ENABLED = 0;      /* "ProfileStart() called" */
+static double       PROFILE_ORIGIN = 0.;      /* wall time of ProfileStart() */
+
+/******************************************************************************/
+/* ProfileClock returns the time in seconds of a clock.                       */
+/******************************************************************************/
+static double ProfileClock (
+   clockid_t        clock)              /* CLOCK_MONOTONIC or CPU time */
+{
+   struct timespec  now;                /* current time */
+
+   clock_gettime (clock,&now);
+   return (now.tv_sec + 1.e-9 * now.tv_nsec);
+} /* ProfileClock */
+
+/******************************************************************************/
+/* ProfileStart enables the profile; the trace starts at this time.           */
+/******************************************************************************/
+void ProfileStart (void)
+{
+   PROFILE_ENABLED      = 1;
+   PROFILE_EVENT_NUMBER = 0;
+   PROFILE_DROPPED      = 0;
+   PROFILE_DEPTH        = 0;
+   PROFILE_ORIGIN       = ProfileClock (CLOCK_MONOTONIC);
+} /* ProfileStart */
+
+/******************************************************************************/
+/* ProfileEnabled returns 1 if ProfileStart() has been called, 0 otherwise    */
+/* (to skip work done only to be measured, such as XSync()).                  */
+/******************************************************************************/
+int ProfileEnabled (void)
+{
+   return (PROFILE_ENABLED);
+} /* ProfileEnabled */
+
+/******************************************************************************/
+/* ProfileBegin opens a stage. Returns the event to be given to ProfileEnd(), */
+/* or PROFILE_OFF if the profile is disabled or the table is full.            */
+/******************************************************************************/
+int ProfileBegin (
+   char             *name)              /* name of the stage */
+{
+   type_profile_event *event;           /* event recorded */
+
+   if (!PROFILE_ENABLED)
+      return (PROFILE_OFF);
+   if (PROFILE_EVENT_NUMBER == PROFILE_MAX_EVENT)
+   {
+      PROFILE_DROPPED = PROFILE_DROPPED + 1;
+      return (PROFILE_OFF);
+   }
+   event = &(PROFILE_EVENT[PROFILE_EVENT_NUMBER]);
+   strncpy (event->name,name,PROFILE_NAME_LENGTH-1);
+   event->name[PROFILE_NAME_LENGTH-1] = '\0';
+   event->depth  = PROFILE_DEPTH;
+   event->open   = 1;
+   event->pixels = 0.;
+   event->bytes  = 0.;
+   PROFILE_DEPTH = PROFILE_DEPTH + 1;
+   event->cpu    = ProfileClock (CLOCK_PROCESS_CPUTIME_ID);
+   event->start  = ProfileClock (CLOCK_MONOTONIC);
+   PROFILE_EVENT_NUMBER = PROFILE_EVENT_NUMBER + 1;
+   return (PROFILE_EVENT_NUMBER - 1);
+} /* ProfileBegin */
+
+/******************************************************************************/
+/* ProfileEnd closes the stage opened by ProfileBegin().                      */
+/******************************************************************************/
+void ProfileEnd (
+   int              ievent,             /* returned by ProfileBegin() */
+   double           pixels,             /* pixels processed by the stage */
+   double           bytes)              /* bytes read and written by it */
+{
+   type_profile_event *event;           /* event recorded */
+   double           wall;               /* wall time at the end */
+
+   if ((ievent < 0) || (ievent >= PROFILE_EVENT_NUMBER)                       ||
+       (!PROFILE_EVENT[ievent].open))
+      return;
+   wall   = ProfileClock (CLOCK_MONOTONIC);
+   event  = &(PROFILE_EVENT[ievent]);
+   event->cpu    = ProfileClock (CLOCK_PROCESS_CPUTIME_ID) - event->cpu;
+   event->wall   = wall - event->start;
+   event->pixels = pixels;
+   event->bytes  = bytes;
+   event->open   = 0;
+   PROFILE_DEPTH = PROFILE_DEPTH - 1;
+} /* ProfileEnd */
+
+/******************************************************************************/
+/* ProfileReport prints the stages, those of the same name summed, with the   */
+/* throughput on their wall time.                                             */
+/******************************************************************************/
+void ProfileReport (
+   FILE             *file)              /* stdout, stderr or a file */
+{
+   type_profile_event total;            /* stages of one name, summed */
+   int              ievent;             /* index among events */
+   int              jevent;             /* events of the same name */
+   int              call_number;        /* calls of the stage */
+
+   if (!PROFILE_ENABLED)
+      return;
+   fprintf (file,"%-28s %5s %10s %10s %9s %9s\n","stage","calls","wall ms",
+      "cpu ms","Mpixel/s","Gbyte/s");
+   for (ievent=0; ievent<PROFILE_EVENT_NUMBER; ievent++)
+   {
+      for (jevent=0; (jevent<ievent)                                          &&
+                     (strcmp(PROFILE_EVENT[jevent].name,
+                             PROFILE_EVENT[ievent].name) != 0); jevent++)
+         ;
+      if ((jevent < ievent) || PROFILE_EVENT[ievent].open)
+         continue;
+      memset (&total,0,sizeof(total));
+      call_number = 0;
+      for (jevent=ievent; jevent<PROFILE_EVENT_NUMBER; jevent++)
+      {
+         if ((PROFILE_EVENT[jevent].open)                                     ||
+             (strcmp(PROFILE_EVENT[jevent].name,
+                     PROFILE_EVENT[ievent].name) != 0))
+            continue;
+         total.wall   = total.wall + PROFILE_EVENT[jevent].wall;
+         total.cpu    = total.cpu + PROFILE_EVENT[jevent].cpu;
+         total.pixels = total.pixels + PROFILE_EVENT[jevent].pixels;
+         total.bytes  = total.bytes + PROFILE_EVENT[jevent].bytes;
+         call_number  = call_number + 1;
+      }
+      fprintf (file,"%*s%-*s %5d %10.3f %10.3f",
+         2*PROFILE_EVENT[ievent].depth,"",28-2*PROFILE_EVENT[ievent].depth,
+         PROFILE_EVENT[ievent].name,call_number,1.e3*total.wall,
+         1.e3*total.cpu);
+      if ((total.wall > 0.) && (total.pixels > 0.))
+         fprintf (file," %9.1f %9.3f",1.e-6*total.pixels/total.wall,
+            1.e-9*total.bytes/total.wall);
+      fprintf (file,"\n");
+   }
+   if (PROFILE_DROPPED > 0)
+      fprintf (file,"(%d events beyond %d dropped)\n",PROFILE_DROPPED,
+         PROFILE_MAX_EVENT);
+} /* ProfileReport */
+
+/******************************************************************************/
+/* ProfileTrace writes the closed events in the Chrome trace format, times in */
+/* microseconds from ProfileStart(). Returns 1 if the file cannot be written. */
+/******************************************************************************/
+int ProfileTrace (
+   char             *file_name)         /* name of the JSON file */
+{
+   FILE             *file;              /* trace file */
+   type_profile_event *event;           /* event written */
+   int              ievent;             /* index among events */
+   int              first;              /* "no event written yet" flag */
+
+   if ((file=fopen(file_name,"w")) == NULL)
+   {
+      fprintf (stderr,"profile : Cannot create \"%s\".\n",file_name);
+      return (1);
+   }
+   fprintf (file,"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+   first = 1;
+   for (ievent=0; ievent<PROFILE_EVENT_NUMBER; ievent++)
+   {
+      event = &(PROFILE_EVENT[ievent]);
+      if (event->open)
+         continue;
+      fprintf (file,"%s  {\"name\": \"%s\", \"cat\": \"iti\", \"ph\": \"X\", ",
+         (first ? "" : ",\n"),event->name);
+      fprintf (file,"\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1, ",
+         1.e6*(event->start-PROFILE_ORIGIN),1.e6*event->wall);
+      fprintf (file,"\"args\": {\"cpu_ms\": %.3f, \"pixels\": %.0f, ",
+         1.e3*event->cpu,event->pixels);
+      fprintf (file,"\"bytes\": %.0f}}",event->bytes);
+      first = 0;
+   }
+   fprintf (file,"\n]}\n");
+   if (fclose(file) != 0)
+   {
+      fprintf (stderr,"profile : Cannot write \"%s\".\n",file_name);
+      return (1);
+   }
+   return (0);
+} /* ProfileTrace */
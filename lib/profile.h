@@ -0,0 +1,29 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* profile records the wall and CPU time, pixels and bytes of the stages of a */
+/* run (load, operator, frame buffer, XPutImage), for a summary table and a   */
+/* Chrome trace.                                                              */
+/******************************************************************************/
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include  <stdio.h>
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define PROFILE_MAX_EVENT   1024        /* events kept, later ones dropped */
+#define PROFILE_NAME_LENGTH 48          /* longest stage name */
+#define PROFILE_OFF         (-1)        /* event of a disabled profile */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+void ProfileStart (void);
+int ProfileEnabled (void);
+int ProfileBegin (char *name);
+void ProfileEnd (int ievent, double pixels, double bytes);
+void ProfileReport (FILE *file);
+int ProfileTrace (char *file_name);
+
+#endif /* PROFILE_H */
@@ -0,0 +1,573 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* pyramid builds the Gaussian and Laplacian pyramids of an image (levels     */
+/* halved in both directions) and collapses a Laplacian pyramid.              */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Burt - Adelson pyramids with the 5 x 5 Gauss kernel [1 4 6 4 1]^2 / 256    */
+/* (the 5x5 matrix of gauss.c):                                               */
+/* . reduce: G(k+1) = [G(k) * gauss] taken one line and one pixel out of      */
+/*   two. Blur and decimation are fused: each output line combines 5 input    */
+/*   lines into one row of 16 bit sums, then the row is filtered at the even  */
+/*   pixels only, so 1/4 of the blurred plane is ever computed;               */
+/* . expand: E(G(k+1)) interpolates G(k+1) to the size of G(k) with the same  */
+/*   kernel (weights 1 6 1 / 8 at even, 4 4 / 8 at odd positions);            */
+/* . Laplacian: L(k) = G(k) - E(G(k+1)) (16 bit), the last level being the    */
+/*   last Gaussian level;                                                     */
+/* . collapse: G(k) = L(k) + E(G(k+1)) from the top, exact when the           */
+/*   Laplacian levels were not modified.                                      */
+/* Level k+1 has (n+1)/2 lines and pixels for n at level k; borders are       */
+/* extended by replication. All sums are integer: inner loops go along the    */
+/* lines and are compiled once per CPU level (cpu.h), where the compiler      */
+/* vectorizes them.                                                           */
+/*                                                                            */
+/* All the levels of all the channels, Gaussian and Laplacian, are parts of   */
+/* ONE allocation made by PyramidAlloc(); level 0 is a copy of the image, so  */
+/* that a built pyramid is a cache independent of the image arrays. Each      */
+/* level is computed by bands of lines of every channel on the pool.          */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+
+#include  "pyramid.h"
+#include  "cpu.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+#define PLANE_ALIGN 16                  /* alignment of the levels (bytes) */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+
+#define PHASE_REDUCE    0               /* G(k) -> G(k+1) */
+#define PHASE_LAPLACE   1               /* G(k), G(k+1) -> L(k) */
+#define PHASE_COLLAPSE  2               /* L(k), G(k+1) -> G(k) */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   type_pyramid     *pyramid;           /* pyramid being computed */
+   int              phase;              /* PHASE_REDUCE ... PHASE_COLLAPSE */
+   int              level;              /* level k of the phase */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a task */
+} type_pyramid_job;
+
+typedef void (*type_pyramid_reduce) (unsigned char *in, int nli_in,
+                                     int npx_in, unsigned char *out,
+                                     int npx_out, int ili_first, int ili_last,
+                                     unsigned short *row);
+typedef void (*type_pyramid_expand) (type_pyramid *pyramid, int level,
+                                     int ichannel, int collapse,
+                                     int ili_first, int ili_last, int *row,
+                                     int *expanded);
+
+/******************************************************************************/
+/* PyramidClamp returns i clamped into [0,n[.                                 */
+/******************************************************************************/
+static int PyramidClamp (
+   int              i,                  /* index, possibly outside */
+   int              n)                  /* number of samples */
+{
+   if (i < 0)
+      return (0);
+   if (i >= n)
+      return (n - 1);
+   return (i);
+} /* PyramidClamp */
+
+/******************************************************************************/
+/* PyramidReduceKernel computes lines [ili_first,ili_last[ of G(k+1) from     */
+/* G(k), compiled once per CPU level by the variants below.                   */
+/******************************************************************************/
+static CPU_INLINE void PyramidReduceKernel (
+   unsigned char    *in,                /* level k */
+   int              nli_in,             /* line number of level k */
+   int              npx_in,             /* pixel number of level k */
+   unsigned char    *out,               /* level k+1 */
+   int              npx_out,            /* pixel number of level k+1 */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last,           /* line following the last one */
+   unsigned short   *row)               /* npx_in + 4 sums of 5 lines */
+{
+   int              ili;                /* index among output lines */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among taps */
+   unsigned char    *line[5];           /* input lines under the taps */
+   unsigned short   *sum;               /* row without its left margin */
+
+   sum = row + 2;
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      for (k=0; k<5; k++)
+         line[k] = &(in[PyramidClamp(2*ili+k-2,nli_in)*npx_in]);
+      for (ipx=0; ipx<npx_in; ipx++)
+         sum[ipx] = (unsigned short)(line[0][ipx] + line[4][ipx] +
+                                     4 * (line[1][ipx] + line[3][ipx]) +
+                                     6 * line[2][ipx]);
+      sum[-2]       = sum[0];
+      sum[-1]       = sum[0];
+      sum[npx_in]   = sum[npx_in-1];
+      sum[npx_in+1] = sum[npx_in-1];
+      for (ipx=0; ipx<npx_out; ipx++)
+         out[ili*npx_out+ipx] = (unsigned char)
+            ((sum[2*ipx-2] + sum[2*ipx+2] + 4 * (sum[2*ipx-1] + sum[2*ipx+1]) +
+              6 * sum[2*ipx] + 128) >> 8);
+   }
+} /* PyramidReduceKernel */
+
+/******************************************************************************/
+/* Variants of the reduce kernel, one per CPU level (cpu.h), and their table  */
+/******************************************************************************/
+#define PYRAMID_REDUCE_VARIANT(name,target)                                    \
+static target void name (                                                      \
+   unsigned char *in, int nli_in, int npx_in, unsigned char *out,              \
+   int npx_out, int ili_first, int ili_last, unsigned short *row)              \
+{                                                                              \
+   PyramidReduceKernel (in,nli_in,npx_in,out,npx_out,ili_first,ili_last,row);  \
+}
+
+PYRAMID_REDUCE_VARIANT (PyramidReduceScalar,CPU_TARGET_SCALAR)
+PYRAMID_REDUCE_VARIANT (PyramidReduceSse42,CPU_TARGET_SSE42)
+PYRAMID_REDUCE_VARIANT (PyramidReduceAvx2,CPU_TARGET_AVX2)
+PYRAMID_REDUCE_VARIANT (PyramidReduceAvx512,CPU_TARGET_AVX512)
+
+static type_pyramid_reduce PYRAMID_REDUCE[CPU_LEVEL_NUMBER] = {
+   PyramidReduceScalar, PyramidReduceSse42, PyramidReduceAvx2,
+   PyramidReduceAvx512 };
+
+/******************************************************************************/
+/* PyramidExpandRow computes line ili of E(G(k+1)), 64 times too large.       */
+/******************************************************************************/
+static CPU_INLINE void PyramidExpandRow (
+   unsigned char    *small,             /* level k+1 */
+   int              nli_small,          /* line number of level k+1 */
+   int              npx_small,          /* pixel number of level k+1 */
+   int              npx,                /* pixel number of level k */
+   int              ili,                /* line of level k */
+   int              *row,               /* npx_small + 2 vertical sums */
+   int              *expanded)          /* npx expanded values x 64 */
+{
+   int              ipx;                /* index among pixels */
+   int              *sum;               /* row without its left margin */
+   unsigned char    *above;             /* line of level k+1 above */
+   unsigned char    *centre;            /* line of level k+1 at or below */
+   unsigned char    *below;             /* line of level k+1 below */
+
+   sum = row + 1;
+   if (ili % 2 == 0)
+   {
+      above  = &(small[PyramidClamp(ili/2-1,nli_small)*npx_small]);
+      centre = &(small[(ili/2)*npx_small]);
+      below  = &(small[PyramidClamp(ili/2+1,nli_small)*npx_small]);
+      for (ipx=0; ipx<npx_small; ipx++)
+         sum[ipx] = above[ipx] + 6 * centre[ipx] + below[ipx];
+   }
+   else
+   {
+      above = &(small[(ili/2)*npx_small]);
+      below = &(small[PyramidClamp(ili/2+1,nli_small)*npx_small]);
+      for (ipx=0; ipx<npx_small; ipx++)
+         sum[ipx] = 4 * (above[ipx] + below[ipx]);
+   }
+   sum[-1]        = sum[0];
+   sum[npx_small] = sum[npx_small-1];
+   for (ipx=0; ipx<npx/2; ipx++)
+   {
+      expanded[2*ipx]   = sum[ipx-1] + 6 * sum[ipx] + sum[ipx+1];
+      expanded[2*ipx+1] = 4 * (sum[ipx] + sum[ipx+1]);
+   }
+   if (npx % 2 != 0)
+      expanded[npx-1] = sum[npx/2-1] + 6 * sum[npx/2] + sum[npx/2+1];
+} /* PyramidExpandRow */
+
+/******************************************************************************/
+/* PyramidExpandKernel computes lines [ili_first,ili_last[ of L(k) (laplace)  */
+/* or of G(k) from L(k) (collapse), for one channel, compiled once per CPU    */
+/* level by the variants below.                                               */
+/******************************************************************************/
+static CPU_INLINE void PyramidExpandKernel (
+   type_pyramid     *pyramid,           /* pyramid being computed */
+   int              level,              /* level k */
+   int              ichannel,           /* channel */
+   int              collapse,           /* 1: collapse, 0: Laplacian */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last,           /* line following the last one */
+   int              *row,               /* vertical sums of level k+1 */
+   int              *expanded)          /* expanded line x 64 */
+{
+   int              npx;                /* pixel number of level k */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   unsigned char    *gauss;             /* line of G(k) */
+   short            *laplace;           /* line of L(k) */
+   int              output_value;       /* G(k) before clipping */
+
+   npx = pyramid->npx[level];
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      PyramidExpandRow (pyramid->gauss[level+1][ichannel],
+         pyramid->nli[level+1],pyramid->npx[level+1],npx,ili,row,expanded);
+      gauss   = &(pyramid->gauss[level][ichannel][ili*npx]);
+      laplace = &(pyramid->laplace[level][ichannel][ili*npx]);
+      if (collapse)
+      {
+         for (ipx=0; ipx<npx; ipx++)
+         {
+            output_value = laplace[ipx] + ((expanded[ipx] + 32) >> 6);
+            if (output_value < 0)
+               output_value = 0;
+            if (output_value > MAX_COLOR)
+               output_value = MAX_COLOR;
+            gauss[ipx] = (unsigned char)output_value;
+         }
+      }
+      else
+      {
+         for (ipx=0; ipx<npx; ipx++)
+            laplace[ipx] = (short)(gauss[ipx] - ((expanded[ipx] + 32) >> 6));
+      }
+   }
+} /* PyramidExpandKernel */
+
+/******************************************************************************/
+/* Variants of the expand kernel, one per CPU level (cpu.h), and their table  */
+/******************************************************************************/
+#define PYRAMID_EXPAND_VARIANT(name,target)                                    \
+static target void name (                                                      \
+   type_pyramid *pyramid, int level, int ichannel, int collapse,               \
+   int ili_first, int ili_last, int *row, int *expanded)                       \
+{                                                                              \
+   PyramidExpandKernel (pyramid,level,ichannel,collapse,ili_first,ili_last,    \
+      row,expanded);                                                           \
+}
+
+PYRAMID_EXPAND_VARIANT (PyramidExpandScalar,CPU_TARGET_SCALAR)
+PYRAMID_EXPAND_VARIANT (PyramidExpandSse42,CPU_TARGET_SSE42)
+PYRAMID_EXPAND_VARIANT (PyramidExpandAvx2,CPU_TARGET_AVX2)
+PYRAMID_EXPAND_VARIANT (PyramidExpandAvx512,CPU_TARGET_AVX512)
+
+static type_pyramid_expand PYRAMID_EXPAND[CPU_LEVEL_NUMBER] = {
+   PyramidExpandScalar, PyramidExpandSse42, PyramidExpandAvx2,
+   PyramidExpandAvx512 };
+
+/******************************************************************************/
+/* PyramidExpandRows allocates the rows of PyramidExpandKernel() and runs the */
+/* variant of the CPU level. Returns 1 if memory is lacking.                  */
+/******************************************************************************/
+static int PyramidExpandRows (
+   type_pyramid     *pyramid,           /* pyramid being computed */
+   int              level,              /* level k */
+   int              ichannel,           /* channel */
+   int              collapse,           /* 1: collapse, 0: Laplacian */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last)           /* line following the last one */
+{
+   int              *row;               /* vertical sums of level k+1 */
+   int              *expanded;          /* expanded line x 64 */
+
+   if (((row=(int*)malloc((pyramid->npx[level+1]+2)*sizeof(int))) == NULL) ||
+       ((expanded=(int*)malloc(pyramid->npx[level]*sizeof(int))) == NULL))
+   {
+      free (row);
+      return (1);
+   }
+   PYRAMID_EXPAND[CpuLevel()] (pyramid,level,ichannel,collapse,ili_first,
+      ili_last,row,expanded);
+   free (expanded);
+   free (row);
+   return (0);
+} /* PyramidExpandRows */
+
+/******************************************************************************/
+/* PyramidTask is the pool task running one band of one channel.              */
+/******************************************************************************/
+static void PyramidTask (
+   void             *argument,          /* type_pyramid_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_pyramid_job *job;               /* job the task belongs to */
+   type_pyramid     *pyramid;           /* pyramid being computed */
+   int              ichannel;           /* channel of the task */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   int              level;              /* level of the computed lines */
+   unsigned short   *row;               /* sums of 5 lines (reduce) */
+
+   job       = (type_pyramid_job*)argument;
+   pyramid   = job->pyramid;
+   ichannel  = itask / job->band_number;
+   level     = (job->phase == PHASE_REDUCE ? job->level+1 : job->level);
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > pyramid->nli[level])
+      ili_last = pyramid->nli[level];
+   if (job->phase == PHASE_REDUCE)
+   {
+      if ((row=(unsigned short*)malloc((pyramid->npx[job->level]+4)*
+            sizeof(unsigned short))) == NULL)
+      {
+         job->status = 1;
+         return;
+      }
+      PYRAMID_REDUCE[CpuLevel()] (pyramid->gauss[job->level][ichannel],
+         pyramid->nli[job->level],pyramid->npx[job->level],
+         pyramid->gauss[level][ichannel],pyramid->npx[level],ili_first,
+         ili_last,row);
+      free (row);
+   }
+   else if (PyramidExpandRows(pyramid,job->level,ichannel,
+               job->phase == PHASE_COLLAPSE,ili_first,ili_last) != 0)
+      job->status = 1;
+} /* PyramidTask */
+
+/******************************************************************************/
+/* PyramidRun runs one phase on every channel of the lines of the computed    */
+/* level (k+1 for reduce, k otherwise).                                       */
+/******************************************************************************/
+static int PyramidRun (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pyramid     *pyramid,           /* pyramid being computed */
+   int              phase,              /* PHASE_REDUCE ... PHASE_COLLAPSE */
+   int              level)              /* level k */
+{
+   type_pyramid_job job;                /* job shared by all the tasks */
+   int              nli;                /* lines of the computed level */
+
+   memset (&job,0,sizeof(type_pyramid_job));
+   job.pyramid     = pyramid;
+   job.phase       = phase;
+   job.level       = level;
+   nli             = pyramid->nli[phase == PHASE_REDUCE ? level+1 : level];
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      pyramid->channel_number - 1) / pyramid->channel_number;
+   if (job.band_number > nli / MIN_BAND_LINES)
+      job.band_number = nli / MIN_BAND_LINES;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nli + job.band_number - 1) / job.band_number;
+   job.band_number = (nli + job.band_lines - 1) / job.band_lines;
+   PoolRun (pool,pyramid->channel_number*job.band_number,PyramidTask,&job);
+   return (job.status);
+} /* PyramidRun */
+
+/******************************************************************************/
+/* PyramidAlloc allocates the Gaussian and Laplacian levels of a pyramid in   */
+/* one block. level_number <= 0 asks for all the levels down to 1 x 1.        */
+/* Returns 1 if level_number is too large or memory is lacking.               */
+/******************************************************************************/
+int PyramidAlloc (
+   type_pyramid     *pyramid,           /* pyramid to be allocated */
+   int              level_number,       /* number of levels, 0: all */
+   int              channel_number,     /* number of channels (1 or 3) */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              level;              /* index among levels */
+   int              ichannel;           /* index among channels */
+   size_t           size;               /* size of the block (bytes) */
+   size_t           plane_size;         /* size of one level (bytes) */
+   char             *block;             /* the block, as bytes */
+
+   memset (pyramid,0,sizeof(type_pyramid));
+   if ((level_number > MAX_PYRAMID_LEVEL) || (nliin <= 0) || (npxin <= 0)   ||
+       (channel_number < 1) || (channel_number > 3))
+      return (1);
+   pyramid->nli[0] = nliin;
+   pyramid->npx[0] = npxin;
+   for (level=1; level<MAX_PYRAMID_LEVEL; level++)
+   {
+      if (((level_number > 0) && (level >= level_number))                  ||
+          ((pyramid->nli[level-1] == 1) && (pyramid->npx[level-1] == 1)))
+         break;
+      pyramid->nli[level] = (pyramid->nli[level-1] + 1) / 2;
+      pyramid->npx[level] = (pyramid->npx[level-1] + 1) / 2;
+   }
+   pyramid->level_number   = level;
+   pyramid->channel_number = channel_number;
+/*----------------------------------------------------------------------------*/
+/* One block: Laplacian levels (short) then Gaussian levels, aligned          */
+/*----------------------------------------------------------------------------*/
+   size = 0;
+   for (level=0; level<pyramid->level_number; level++)
+   {
+      plane_size = (size_t)pyramid->nli[level] * pyramid->npx[level];
+      size = size + channel_number *
+             ((plane_size * (sizeof(short) + 1) + 2 * (PLANE_ALIGN - 1)) /
+              PLANE_ALIGN * PLANE_ALIGN);
+   }
+   if ((pyramid->buffer=malloc(size)) == NULL)
+      return (1);
+   block = (char*)pyramid->buffer;
+   for (level=0; level<pyramid->level_number; level++)
+   {
+      plane_size = (size_t)pyramid->nli[level] * pyramid->npx[level];
+      for (ichannel=0; ichannel<channel_number; ichannel++)
+      {
+         pyramid->laplace[level][ichannel] = (short*)block;
+         block = block + (plane_size * sizeof(short) + PLANE_ALIGN - 1) /
+                 PLANE_ALIGN * PLANE_ALIGN;
+      }
+   }
+   for (level=0; level<pyramid->level_number; level++)
+   {
+      plane_size = (size_t)pyramid->nli[level] * pyramid->npx[level];
+      for (ichannel=0; ichannel<channel_number; ichannel++)
+      {
+         pyramid->gauss[level][ichannel] = (unsigned char*)block;
+         block = block + (plane_size + PLANE_ALIGN - 1) / PLANE_ALIGN *
+                 PLANE_ALIGN;
+      }
+   }
+   return (0);
+} /* PyramidAlloc */
+
+/******************************************************************************/
+/* PyramidFree releases the levels of a pyramid.                              */
+/******************************************************************************/
+void PyramidFree (
+   type_pyramid     *pyramid)           /* pyramid to be released */
+{
+   free (pyramid->buffer);
+   memset (pyramid,0,sizeof(type_pyramid));
+} /* PyramidFree */
+
+/******************************************************************************/
+/* PyramidBuild copies the image to level 0 and reduces it into the Gaussian  */
+/* levels. Returns 1 if memory is lacking.                                    */
+/******************************************************************************/
+int PyramidBuild (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pyramid     *pyramid,           /* allocated pyramid */
+   unsigned char    *image_in[3])       /* input image arrays */
+{
+   int              ichannel;           /* index among channels */
+   int              level;              /* index among levels */
+
+   for (ichannel=0; ichannel<pyramid->channel_number; ichannel++)
+      memcpy (pyramid->gauss[0][ichannel],image_in[ichannel],
+              (size_t)pyramid->nli[0]*pyramid->npx[0]);
+   for (level=0; level<pyramid->level_number-1; level++)
+   {
+      if (PyramidRun(pool,pyramid,PHASE_REDUCE,level) != 0)
+         return (1);
+   }
+   return (0);
+} /* PyramidBuild */
+
+/******************************************************************************/
+/* PyramidLaplacian computes the Laplacian levels of a built pyramid.         */
+/* Returns 1 if memory is lacking.                                            */
+/******************************************************************************/
+int PyramidLaplacian (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pyramid     *pyramid)           /* built pyramid */
+{
+   int              ichannel;           /* index among channels */
+   int              level;              /* index among levels */
+   int              ipixel;             /* index among pixels */
+
+   level = pyramid->level_number - 1;
+   for (ichannel=0; ichannel<pyramid->channel_number; ichannel++)
+   {
+      for (ipixel=0; ipixel<pyramid->nli[level]*pyramid->npx[level]; ipixel++)
+         pyramid->laplace[level][ichannel][ipixel] =
+            pyramid->gauss[level][ichannel][ipixel];
+   }
+   for (level=0; level<pyramid->level_number-1; level++)
+   {
+      if (PyramidRun(pool,pyramid,PHASE_LAPLACE,level) != 0)
+         return (1);
+   }
+   return (0);
+} /* PyramidLaplacian */
+
+/******************************************************************************/
+/* PyramidCollapse rebuilds the Gaussian levels from the Laplacian ones, top  */
+/* down, and copies level 0 to the output. Returns 1 if memory is lacking.    */
+/******************************************************************************/
+int PyramidCollapse (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_pyramid     *pyramid,           /* pyramid with Laplacian levels */
+   unsigned char    *image_out[3])      /* output image arrays */
+{
+   int              ichannel;           /* index among channels */
+   int              level;              /* index among levels */
+   int              ipixel;             /* index among pixels */
+   int              output_value;       /* top level before clipping */
+
+   level = pyramid->level_number - 1;
+   for (ichannel=0; ichannel<pyramid->channel_number; ichannel++)
+   {
+      for (ipixel=0; ipixel<pyramid->nli[level]*pyramid->npx[level]; ipixel++)
+      {
+         output_value = pyramid->laplace[level][ichannel][ipixel];
+         if (output_value < 0)
+            output_value = 0;
+         if (output_value > MAX_COLOR)
+            output_value = MAX_COLOR;
+         pyramid->gauss[level][ichannel][ipixel] = (unsigned char)output_value;
+      }
+   }
+   for (level=pyramid->level_number-2; level>=0; level--)
+   {
+      if (PyramidRun(pool,pyramid,PHASE_COLLAPSE,level) != 0)
+         return (1);
+   }
+   for (ichannel=0; ichannel<pyramid->channel_number; ichannel++)
+      memcpy (image_out[ichannel],pyramid->gauss[0][ichannel],
+              (size_t)pyramid->nli[0]*pyramid->npx[0]);
+   return (0);
+} /* PyramidCollapse */
+
+/******************************************************************************/
+/* PyramidLevel displays a Gaussian level, or a Laplacian level offset by     */
+/* half the dynamic, in the upper left corner of black output images of the   */
+/* size of level 0. Returns 1 if the level does not exist.                    */
+/******************************************************************************/
+int PyramidLevel (
+   type_pyramid     *pyramid,           /* built pyramid */
+   int              level,              /* level to be displayed */
+   int              laplacian,          /* 1: Laplacian, 0: Gaussian level */
+   unsigned char    *image_out[3])      /* output image arrays */
+{
+   int              ichannel;           /* index among channels */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              output_value;       /* output value before clipping */
+
+   if ((level < 0) || (level >= pyramid->level_number))
+      return (1);
+   for (ichannel=0; ichannel<pyramid->channel_number; ichannel++)
+   {
+      memset (image_out[ichannel],0,(size_t)pyramid->nli[0]*pyramid->npx[0]);
+      for (ili=0; ili<pyramid->nli[level]; ili++)
+      {
+         for (ipx=0; ipx<pyramid->npx[level]; ipx++)
+         {
+            if (laplacian && (level < pyramid->level_number-1))
+               output_value = (MAX_COLOR+1)/2 +
+                  pyramid->laplace[level][ichannel][ili*pyramid->npx[level]+
+                                                    ipx];
+            else
+               output_value =
+                  pyramid->gauss[level][ichannel][ili*pyramid->npx[level]+ipx];
+            if (output_value < 0)
+               output_value = 0;
+            if (output_value > MAX_COLOR)
+               output_value = MAX_COLOR;
+            image_out[ichannel][ili*pyramid->npx[0]+ipx] =
+               (unsigned char)output_value;
+         }
+      }
+   }
+   return (0);
+} /* PyramidLevel */
@@ -0,0 +1,43 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* pyramid builds the Gaussian and Laplacian pyramids of an image (levels     */
+/* halved in both directions) and collapses a Laplacian pyramid.              */
+/******************************************************************************/
+#ifndef PYRAMID_H
+#define PYRAMID_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_PYRAMID_LEVEL   16          /* greatest number of levels */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              level_number;       /* number of levels (0: the image) */
+   int              channel_number;     /* number of channels (1 or 3) */
+   int              nli[MAX_PYRAMID_LEVEL]; /* line numbers of the levels */
+   int              npx[MAX_PYRAMID_LEVEL]; /* pixel numbers of the levels */
+   unsigned char    *gauss[MAX_PYRAMID_LEVEL][3];   /* Gaussian levels */
+   short            *laplace[MAX_PYRAMID_LEVEL][3]; /* Laplacian levels */
+   void             *buffer;            /* all the levels, one allocation */
+} type_pyramid;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int PyramidAlloc (type_pyramid *pyramid, int level_number,
+                  int channel_number, int nliin, int npxin);
+void PyramidFree (type_pyramid *pyramid);
+int PyramidBuild (type_pool *pool, type_pyramid *pyramid,
+                  unsigned char *image_in[3]);
+int PyramidLaplacian (type_pool *pool, type_pyramid *pyramid);
+int PyramidCollapse (type_pool *pool, type_pyramid *pyramid,
+                     unsigned char *image_out[3]);
+int PyramidLevel (type_pyramid *pyramid, int level, int laplacian,
+                  unsigned char *image_out[3]);
+
+#endif /* PYRAMID_H */
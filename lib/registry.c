@@ -0,0 +1,241 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* registry appends to CONVOL[] the convolution matrices described in a text  */
+/* file, so that new matrices can be tried without rebuilding.                */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* A description file holds any number of matrices, each one introduced by    */
+/* the "kernel" keyword; "#" starts a comment:                                */
+/*                                                                            */
+/*    # Image moved 2 pixels left (Rapport6, 2.a)                             */
+/*    kernel Decalage 2 pixels a gauche                                       */
+/*    size   5                                                                */
+/*    gain   1                  (default 1, "a/b", b != 0, e.g. 10/9.657)     */
+/*    offset 0                  (default 0)                                   */
+/*    0 0 0 0 0                                                               */
+/*    0 0 0 0 0                                                               */
+/*    0 0 0 0 1                 (size x size coefficients, line by line,      */
+/*    0 0 0 0 0                  spread over any number of lines)             */
+/*    0 0 0 0 0                                                               */
+/*                                                                            */
+/* Each matrix is analyzed once by ConvolAnalyze() when registered. CONVOL[]  */
+/* is reallocated as it grows: matrices must be registered at startup, before */
+/* any pointer to a CONVOL[] entry is kept.                                   */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <ctype.h>
+
+#include  "registry.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_LINE    1024                /* longest line of a description file*/
+
+/******************************************************************************/
+/* Static data                                                                */
+/******************************************************************************/
+static int          REGISTRY_CAPACITY = 0; /* allocated entries (0: CONVOL[]
+                                              is still the compiled table) */
+
+/******************************************************************************/
+/* ConvolRegister appends a copy of the matrix (coefficients included) to     */
+/* CONVOL[] and analyzes it. Returns 1 if memory is lacking.                  */
+/******************************************************************************/
+int ConvolRegister (
+   type_convol      *convol)            /* matrix to be registered */
+{
+   type_convol      *registry;          /* reallocated CONVOL[] */
+   type_convol      *entry;             /* new entry */
+   int              capacity;           /* new number of allocated entries */
+
+/*----------------------------------------------------------------------------*/
+/* Grow the registry, copying the compiled table the first time               */
+/*----------------------------------------------------------------------------*/
+   if (CONVOL_NUMBER >= REGISTRY_CAPACITY)
+   {
+      capacity = 2 * CONVOL_NUMBER + 8;
+      if (REGISTRY_CAPACITY == 0)
+      {
+         if ((registry=(type_convol*)malloc(capacity*sizeof(type_convol))) ==
+             NULL)
+            return (1);
+         memcpy (registry,CONVOL,CONVOL_NUMBER*sizeof(type_convol));
+      }
+      else if ((registry=(type_convol*)realloc(CONVOL,capacity*
+                sizeof(type_convol))) == NULL)
+         return (1);
+      CONVOL            = registry;
+      REGISTRY_CAPACITY = capacity;
+   }
+   entry  = &CONVOL[CONVOL_NUMBER];
+   *entry = *convol;
+   if ((entry->coeff=(float*)malloc(convol->size*convol->size*sizeof(float)))
+       == NULL)
+      return (1);
+   memcpy (entry->coeff,convol->coeff,convol->size*convol->size*sizeof(float));
+   ConvolAnalyze (entry);
+   CONVOL_NUMBER = CONVOL_NUMBER + 1;
+   return (0);
+} /* ConvolRegister */
+
+/******************************************************************************/
+/* ConvolNumber reads a number or a ratio "a/b" from string. Returns 1 if     */
+/* string does not hold one, or if b is 0.                                    */
+/******************************************************************************/
+static int ConvolNumber (
+   char             *string,            /* text to be read */
+   float            *value)             /* value read */
+{
+   char             *end;               /* first character not read */
+   double           numerator;          /* number before "/" */
+   double           denominator;        /* number after "/" */
+
+   numerator = strtod (string,&end);
+   if (end == string)
+      return (1);
+   while (isspace((unsigned char)*end))
+      end++;
+   denominator = 1.;
+   if (*end == '/')
+   {
+      string      = end + 1;
+      denominator = strtod (string,&end);
+      if ((end == string) || (denominator == 0.))
+         return (1);
+   }
+   *value = (float)(numerator / denominator);
+   return (0);
+} /* ConvolNumber */
+
+/******************************************************************************/
+/* ConvolLoad registers all the matrices of a description file.               */
+/* Returns 0, 1 if the file cannot be opened, 2 on a syntax error (reported   */
+/* in *line_number) or if memory is lacking.                                  */
+/******************************************************************************/
+int ConvolLoad (
+   char             *file_name,         /* description file */
+   int              *line_number)       /* line of the syntax error */
+{
+/******************************************************************************/
+/* Local variables                                                            */
+/******************************************************************************/
+   FILE             *fp;                /* description file */
+   char             line[MAX_LINE];     /* current line */
+   char             keyword[MAX_LINE];  /* first word of the line */
+   char             *text;              /* text following the keyword */
+   char             *end;               /* first character not read */
+   type_convol      convol;             /* matrix being read */
+   int              coeff_number;       /* coefficients read so far */
+   int              reading;            /* "a matrix is being read" flag */
+   int              status;             /* status of the loading */
+   float            value;              /* number read */
+
+   *line_number = 0;
+   if ((fp=fopen(file_name,"r")) == NULL)
+      return (1);
+   memset (&convol,0,sizeof(convol));
+   coeff_number = 0;
+   reading      = 0;
+   status       = 0;
+   while ((status == 0) && (fgets(line,MAX_LINE,fp) != NULL))
+   {
+      *line_number = *line_number + 1;
+      if ((text=strchr(line,'#')) != NULL)
+         *text = '\0';
+      if (sscanf(line,"%s",keyword) != 1)
+         continue;
+      text = strstr(line,keyword) + strlen(keyword);
+      while (isspace((unsigned char)*text))
+         text++;
+/*----------------------------------------------------------------------------*/
+/*    A new matrix: register the previous one                                 */
+/*----------------------------------------------------------------------------*/
+      if (strcmp(keyword,"kernel") == 0)
+      {
+         if (reading)
+         {
+            if ((convol.coeff == NULL) ||
+                (coeff_number != convol.size * convol.size) ||
+                (ConvolRegister(&convol) != 0))
+            {
+               status = 2;
+               break;
+            }
+            free (convol.coeff);
+         }
+         memset (&convol,0,sizeof(convol));
+         strncpy (convol.name,text,sizeof(convol.name)-1);
+         for (end=convol.name+strlen(convol.name); (end > convol.name) &&
+              isspace((unsigned char)end[-1]); end--)
+            end[-1] = '\0';
+         convol.gain  = 1.;
+         coeff_number = 0;
+         reading      = 1;
+      }
+      else if (!reading)
+         status = 2;
+/*----------------------------------------------------------------------------*/
+/*    Size, gain, offset                                                      */
+/*----------------------------------------------------------------------------*/
+      else if (strcmp(keyword,"size") == 0)
+      {
+         if ((convol.coeff != NULL)                                          ||
+             (sscanf(text,"%d",&convol.size) != 1)                           ||
+             (convol.size < 1) || (convol.size % 2 == 0)                     ||
+             (convol.size > MAX_FFT_SIZE)                                    ||
+             ((convol.coeff=(float*)malloc(convol.size*convol.size*
+               sizeof(float))) == NULL))
+            status = 2;
+      }
+      else if (strcmp(keyword,"gain") == 0)
+      {
+         if (ConvolNumber(text,&convol.gain) != 0)
+            status = 2;
+      }
+      else if (strcmp(keyword,"offset") == 0)
+      {
+         if (ConvolNumber(text,&convol.offset) != 0)
+            status = 2;
+      }
+/*----------------------------------------------------------------------------*/
+/*    Coefficients, any number per line                                       */
+/*----------------------------------------------------------------------------*/
+      else
+      {
+         text = line;
+         while ((status == 0) && (sscanf(text,"%s",keyword) == 1))
+         {
+            value = (float)strtod (text,&end);
+            if ((end == text) || (convol.coeff == NULL)                     ||
+                (coeff_number >= convol.size * convol.size))
+               status = 2;
+            else
+            {
+               convol.coeff[coeff_number] = value;
+               coeff_number = coeff_number + 1;
+               text = end;
+            }
+         }
+      }
+   }
+/*----------------------------------------------------------------------------*/
+/* Register the last matrix                                                   */
+/*----------------------------------------------------------------------------*/
+   if ((status == 0) && reading)
+   {
+      if ((convol.coeff == NULL) ||
+          (coeff_number != convol.size * convol.size) ||
+          (ConvolRegister(&convol) != 0))
+         status = 2;
+   }
+   free (convol.coeff);
+   fclose (fp);
+   return (status);
+} /* ConvolLoad */
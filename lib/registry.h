@@ -0,0 +1,23 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* registry appends to CONVOL[] the convolution matrices described in a text  */
+/* file, so that new matrices can be tried without rebuilding.                */
+/******************************************************************************/
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include  "convol.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define CONVOL_FILE     "convol.txt"    /* default description file */
+#define CONVOL_FILE_ENV "ITI_CONVOL"    /* variable overriding CONVOL_FILE */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int ConvolRegister (type_convol *convol);
+int ConvolLoad (char *file_name, int *line_number);
+
+#endif /* REGISTRY_H */
@@ -0,0 +1,227 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* saturate is the output stage shared by the filters: gain, offset,          */
+/* clipping to [0,255] and conversion to bytes, without branches.             */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/*    output[i] = (unsigned char) min(max(gain x value[i] + offset, 0), 255)  */
+/* i.e. the "if (v < 0) v = 0; if (v > MAX_COLOR) v = MAX_COLOR;" of every    */
+/* filter, truncated as the C conversion does (add 0.5 to the offset to       */
+/* round). On noisy images the two tests are taken at random and cost a       */
+/* branch misprediction every few pixels when they are compiled as jumps.     */
+/*                                                                            */
+/* SaturateRow() runs the variant of the CPU level (cpu.h). From SSE4.2 on,   */
+/* vectors of floats are scaled, shifted and clipped by min / max, truncated  */
+/* to 32 bit integers, then narrowed to bytes: with SSE4.2, 4 vectors of 4    */
+/* floats packed with saturation to 16 bits (_mm_packs_epi32) and to 8 bits   */
+/* (_mm_packus_epi16); with AVX2 the same on 8 floats, the packs working on   */
+/* each 128-bit lane, whose 32-bit groups are put back in order by a permute; */
+/* with AVX-512, 16 floats narrowed by _mm512_cvtepi32_epi8, the last values  */
+/* read and written under a mask. Clipping before the conversion keeps huge   */
+/* values (and NaN, sent to 0) out of the integer range. Remaining values, or */
+/* all of them at the scalar level, are clipped one by one by maxss / minss   */
+/* (the compiler turns conditional expressions into jumps), or without SSE2   */
+/* by conditional expressions. Every variant gives the same bytes: the        */
+/* multiply and the add are never fused.                                      */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+
+#include  "saturate.h"
+#include  "cpu.h"
+
+#if defined(CPU_X86) || defined(__SSE2__)
+#include  <immintrin.h>
+#endif
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+
+/******************************************************************************/
+/* SaturateRowScalar converts n accumulated values into bytes, one by one.    */
+/******************************************************************************/
+static CPU_TARGET_SCALAR void SaturateRowScalar (
+   float            *value,             /* accumulated values */
+   unsigned char    *output,            /* output bytes */
+   int              n,                  /* number of values */
+   float            gain,               /* factor applied on the values */
+   float            offset)             /* added after the gain */
+{
+   int              i;                  /* index among values */
+   float            v;                  /* scaled value */
+#ifdef __SSE2__
+   __m128           vzero;              /* 0 in the low lane */
+   __m128           vmax;               /* MAX_COLOR in the low lane */
+
+   vzero = _mm_setzero_ps ();
+   vmax  = _mm_set_ss ((float)MAX_COLOR);
+   for (i=0; i<n; i++)
+   {
+      v = gain * value[i] + offset;
+      v = _mm_cvtss_f32 (_mm_min_ss(_mm_max_ss(_mm_set_ss(v),vzero),vmax));
+      output[i] = (unsigned char)v;
+   }
+#else
+   for (i=0; i<n; i++)
+   {
+      v = gain * value[i] + offset;
+      v = (v > 0 ? v : 0);
+      v = (v < MAX_COLOR ? v : MAX_COLOR);
+      output[i] = (unsigned char)v;
+   }
+#endif
+} /* SaturateRowScalar */
+
+#ifdef CPU_X86
+/******************************************************************************/
+/* SaturateRowSse42 converts 16 values at a time, the others one by one.      */
+/******************************************************************************/
+static CPU_TARGET_SSE42 void SaturateRowSse42 (
+   float            *value,             /* accumulated values */
+   unsigned char    *output,            /* output bytes */
+   int              n,                  /* number of values */
+   float            gain,               /* factor applied on the values */
+   float            offset)             /* added after the gain */
+{
+   int              i;                  /* index among values */
+   __m128           vgain;              /* gain in the 4 lanes */
+   __m128           voffset;            /* offset in the 4 lanes */
+   __m128           vzero;              /* 0 in the 4 lanes */
+   __m128           vmax;               /* MAX_COLOR in the 4 lanes */
+   __m128i          q[4];               /* 16 clipped values, as int32 */
+
+   vgain   = _mm_set1_ps (gain);
+   voffset = _mm_set1_ps (offset);
+   vzero   = _mm_setzero_ps ();
+   vmax    = _mm_set1_ps ((float)MAX_COLOR);
+   for (i=0; i+16<=n; i=i+16)
+   {
+      q[0] = _mm_cvttps_epi32 (_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(
+                _mm_loadu_ps(&(value[i])),vgain),voffset),vzero),vmax));
+      q[1] = _mm_cvttps_epi32 (_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(
+                _mm_loadu_ps(&(value[i+4])),vgain),voffset),vzero),vmax));
+      q[2] = _mm_cvttps_epi32 (_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(
+                _mm_loadu_ps(&(value[i+8])),vgain),voffset),vzero),vmax));
+      q[3] = _mm_cvttps_epi32 (_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(
+                _mm_loadu_ps(&(value[i+12])),vgain),voffset),vzero),vmax));
+      _mm_storeu_si128 ((__m128i*)&(output[i]),
+         _mm_packus_epi16(_mm_packs_epi32(q[0],q[1]),
+                          _mm_packs_epi32(q[2],q[3])));
+   }
+   SaturateRowScalar (&(value[i]),&(output[i]),n-i,gain,offset);
+} /* SaturateRowSse42 */
+
+/******************************************************************************/
+/* SaturateRowAvx2 converts 32 values at a time, the others one by one.       */
+/******************************************************************************/
+static CPU_TARGET_AVX2 void SaturateRowAvx2 (
+   float            *value,             /* accumulated values */
+   unsigned char    *output,            /* output bytes */
+   int              n,                  /* number of values */
+   float            gain,               /* factor applied on the values */
+   float            offset)             /* added after the gain */
+{
+   int              i;                  /* index among values */
+   __m256           vgain;              /* gain in the 8 lanes */
+   __m256           voffset;            /* offset in the 8 lanes */
+   __m256           vzero;              /* 0 in the 8 lanes */
+   __m256           vmax;               /* MAX_COLOR in the 8 lanes */
+   __m256i          order;              /* 32-bit groups back in order */
+   __m256i          q0, q1, q2, q3;     /* 32 clipped values, as int32 */
+
+   vgain   = _mm256_set1_ps (gain);
+   voffset = _mm256_set1_ps (offset);
+   vzero   = _mm256_setzero_ps ();
+   vmax    = _mm256_set1_ps ((float)MAX_COLOR);
+   order   = _mm256_setr_epi32 (0,4,1,5,2,6,3,7);
+   for (i=0; i+32<=n; i=i+32)
+   {
+      q0 = _mm256_cvttps_epi32 (_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(
+              _mm256_mul_ps(_mm256_loadu_ps(&(value[i])),vgain),voffset),
+              vzero),vmax));
+      q1 = _mm256_cvttps_epi32 (_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(
+              _mm256_mul_ps(_mm256_loadu_ps(&(value[i+8])),vgain),voffset),
+              vzero),vmax));
+      q2 = _mm256_cvttps_epi32 (_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(
+              _mm256_mul_ps(_mm256_loadu_ps(&(value[i+16])),vgain),voffset),
+              vzero),vmax));
+      q3 = _mm256_cvttps_epi32 (_mm256_min_ps(_mm256_max_ps(_mm256_add_ps(
+              _mm256_mul_ps(_mm256_loadu_ps(&(value[i+24])),vgain),voffset),
+              vzero),vmax));
+      _mm256_storeu_si256 ((__m256i*)&(output[i]),
+         _mm256_permutevar8x32_epi32(
+            _mm256_packus_epi16(_mm256_packs_epi32(q0,q1),
+                                _mm256_packs_epi32(q2,q3)),order));
+   }
+/*----------------------------------------------------------------------------*/
+/* The upper halves are cleared before the SSE code of the tail and caller    */
+/*----------------------------------------------------------------------------*/
+   _mm256_zeroupper ();
+   SaturateRowScalar (&(value[i]),&(output[i]),n-i,gain,offset);
+} /* SaturateRowAvx2 */
+
+/******************************************************************************/
+/* SaturateRowAvx512 converts 16 values at a time, the last ones under a      */
+/* mask.                                                                      */
+/******************************************************************************/
+static CPU_TARGET_AVX512 void SaturateRowAvx512 (
+   float            *value,             /* accumulated values */
+   unsigned char    *output,            /* output bytes */
+   int              n,                  /* number of values */
+   float            gain,               /* factor applied on the values */
+   float            offset)             /* added after the gain */
+{
+   int              i;                  /* index among values */
+   __m512           vgain;              /* gain in the 16 lanes */
+   __m512           voffset;            /* offset in the 16 lanes */
+   __m512           vzero;              /* 0 in the 16 lanes */
+   __m512           vmax;               /* MAX_COLOR in the 16 lanes */
+   __mmask16        mask;               /* values of the row */
+
+   vgain   = _mm512_set1_ps (gain);
+   voffset = _mm512_set1_ps (offset);
+   vzero   = _mm512_setzero_ps ();
+   vmax    = _mm512_set1_ps ((float)MAX_COLOR);
+   for (i=0; i<n; i=i+16)
+   {
+      mask = (n-i >= 16 ? (__mmask16)0xffff : (__mmask16)((1 << (n-i)) - 1));
+      _mm512_mask_cvtepi32_storeu_epi8 (&(output[i]),mask,
+         _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(_mm512_add_ps(
+            _mm512_mul_ps(_mm512_maskz_loadu_ps(mask,&(value[i])),vgain),
+            voffset),vzero),vmax)));
+   }
+} /* SaturateRowAvx512 */
+#endif
+
+/******************************************************************************/
+/* SaturateRow converts n accumulated values into bytes with the variant of   */
+/* the CPU.                                                                   */
+/******************************************************************************/
+void SaturateRow (
+   float            *value,             /* accumulated values */
+   unsigned char    *output,            /* output bytes */
+   int              n,                  /* number of values */
+   float            gain,               /* factor applied on the values */
+   float            offset)             /* added after the gain */
+{
+#ifdef CPU_X86
+   switch (CpuLevel())
+   {
+      case CPU_AVX512:
+         SaturateRowAvx512 (value,output,n,gain,offset);
+         return;
+      case CPU_AVX2:
+         SaturateRowAvx2 (value,output,n,gain,offset);
+         return;
+      case CPU_SSE42:
+         SaturateRowSse42 (value,output,n,gain,offset);
+         return;
+   }
+#endif
+   SaturateRowScalar (value,output,n,gain,offset);
+} /* SaturateRow */
@@ -0,0 +1,15 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* saturate is the output stage shared by the filters: gain, offset,          */
+/* clipping to [0,255] and conversion to bytes, without branches.             */
+/******************************************************************************/
+#ifndef SATURATE_H
+#define SATURATE_H
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+void SaturateRow (float *value, unsigned char *output, int n, float gain,
+                  float offset);
+
+#endif /* SATURATE_H */
@@ -0,0 +1,525 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* starlet decomposes an image into wavelet detail planes by the "a trous"    */
+/* algorithm (isotropic undecimated wavelet), thresholds and reconstructs it. */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/* Starting from c0 = image, each scale j = 0 ... J-1 smooths                 */
+/*    c(j+1) = h(j) * c(j)                                                    */
+/* by the B3-spline [1 4 6 4 1] / 16 applied along lines then columns, with   */
+/* 2^j - 1 holes ("trous") between its taps, and keeps the detail plane       */
+/*    w(j+1) = c(j) - c(j+1).                                                 */
+/* The image is the sum w1 + ... + wJ + cJ: the reconstruction is a plain     */
+/* sum. These planes replace the growing Gauss matrices of the report         */
+/* ("Composantes des ondelettes"): a 5 tap kernel per scale whatever its      */
+/* size. Planes are extended by mirror symmetry on the borders.               */
+/*                                                                            */
+/* Memory: the J + 1 output planes and ONE work plane are allocated together  */
+/* once by StarletAlloc() and reused by every decomposition. c(j) is kept in  */
+/* the slot of w(j+1): the line pass writes h(j) * c(j) to the work plane,    */
+/* the column pass writes c(j+1) to the next slot and, on the same lines,     */
+/* turns c(j) into w(j+1) = c(j) - c(j+1). c0 is read from the input image.   */
+/*                                                                            */
+/* Denoising thresholds every detail plane at factor x sigma(j), sigma(j)     */
+/* being the noise of scale j for a white Gaussian noise of deviation sigma   */
+/* (Starck, Murtagh: sigma(j) = STARLET_NOISE[j] x sigma). sigma is estimated */
+/* from the median absolute value of w1 when it is not known.                 */
+/*                                                                            */
+/* Both passes and the reconstruction run bands of lines on the pool.         */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "starlet.h"
+#include  "saturate.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_COLOR   255                 /* Greatest pixel value */
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+#define MAD_BIN     16                  /* bins per gray level, median of w1 */
+#define MAD_TO_SIGMA 0.6745             /* median |x| / sigma, Gaussian noise */
+
+#define PHASE_LINES     0               /* c(j) -> work */
+#define PHASE_COLUMNS   1               /* work -> c(j+1), c(j) -> w(j+1) */
+#define PHASE_OUTPUT    2               /* sum of the planes -> output */
+
+/******************************************************************************/
+/* Global data                                                                */
+/******************************************************************************/
+static const double STARLET_NOISE[MAX_STARLET_SCALE] = /* sigma(j) / sigma */
+   { 0.8908, 0.2007, 0.0856, 0.0413, 0.0205, 0.0103, 0.0052, 0.0026 };
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   type_starlet     *starlet;           /* planes being computed */
+   int              phase;              /* PHASE_LINES ... PHASE_OUTPUT */
+   int              scale;              /* current scale j */
+   unsigned char    *image_in;          /* input image array (c0) */
+   unsigned char    *image_out;         /* output image array */
+   int              band_number;        /* number of bands */
+   int              band_lines;         /* number of lines per band */
+} type_starlet_job;
+
+/******************************************************************************/
+/* StarletMirror returns the index of i mirrored into [0,n[.                  */
+/******************************************************************************/
+static int StarletMirror (
+   int              i,                  /* index, possibly outside */
+   int              n)                  /* number of samples */
+{
+   if (n == 1)
+      return (0);
+   while ((i < 0) || (i >= n))
+   {
+      if (i < 0)
+         i = -i;
+      if (i >= n)
+         i = 2*(n-1) - i;
+   }
+   return (i);
+} /* StarletMirror */
+
+/******************************************************************************/
+/* StarletBorder smooths pixel ipx of a line of c(j) along the line, with     */
+/* mirrored taps (in0 is the line of c0 when j = 0, else in is used).         */
+/******************************************************************************/
+static float StarletBorder (
+   float            *in,                /* line of c(j) (j > 0) */
+   unsigned char    *in0,               /* line of c0 (j = 0) or NULL */
+   int              ipx,                /* pixel to be smoothed */
+   int              step,               /* distance between taps: 2^j */
+   int              npxin)              /* pixel number */
+{
+   float            tap[5];             /* values under the taps */
+   int              k;                  /* index among taps */
+
+   for (k=0; k<5; k++)
+   {
+      if (in0 != NULL)
+         tap[k] = in0[StarletMirror(ipx+(k-2)*step,npxin)];
+      else
+         tap[k] = in[StarletMirror(ipx+(k-2)*step,npxin)];
+   }
+   return ((tap[0] + tap[4] + 4.f * (tap[1] + tap[3]) + 6.f * tap[2]) / 16.f);
+} /* StarletBorder */
+
+/******************************************************************************/
+/* StarletLines smooths lines [ili_first,ili_last[ of c(j) along the lines    */
+/* into the work plane.                                                       */
+/******************************************************************************/
+static void StarletLines (
+   type_starlet_job *job,               /* job being run */
+   int              ili_first,          /* first line of the band */
+   int              ili_last)           /* line following the band */
+{
+   type_starlet     *starlet;           /* planes being computed */
+   int              npxin;              /* pixel number */
+   int              step;               /* distance between taps: 2^j */
+   int              left;               /* first pixel without mirror */
+   int              right;              /* first mirrored pixel on the right */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   float            *in;                /* line of c(j) (j > 0) */
+   unsigned char    *in0;               /* line of c0 (j = 0) or NULL */
+   float            *out;               /* line of the work plane */
+
+   starlet = job->starlet;
+   npxin   = starlet->npxin;
+   step    = 1 << job->scale;
+   left    = (2*step < npxin ? 2*step : npxin);
+   right   = (npxin-2*step > left ? npxin-2*step : left);
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      out = &(starlet->work[ili*npxin]);
+      in  = &(starlet->plane[job->scale][ili*npxin]);
+      in0 = (job->scale == 0 ? &(job->image_in[ili*npxin]) : NULL);
+      for (ipx=0; ipx<left; ipx++)
+         out[ipx] = StarletBorder(in,in0,ipx,step,npxin);
+      if (in0 != NULL)
+      {
+         for (ipx=left; ipx<right; ipx++)
+            out[ipx] = (in0[ipx-2] + in0[ipx+2] +
+                        4.f * (in0[ipx-1] + in0[ipx+1]) + 6.f * in0[ipx]) /
+                       16.f;
+      }
+      else
+      {
+         for (ipx=left; ipx<right; ipx++)
+            out[ipx] = (in[ipx-2*step] + in[ipx+2*step] +
+                        4.f * (in[ipx-step] + in[ipx+step]) + 6.f * in[ipx]) /
+                       16.f;
+      }
+      for (ipx=right; ipx<npxin; ipx++)
+         out[ipx] = StarletBorder(in,in0,ipx,step,npxin);
+   }
+} /* StarletLines */
+
+/******************************************************************************/
+/* StarletColumns smooths the work plane along the columns into c(j+1) on     */
+/* lines [ili_first,ili_last[ and turns c(j) into w(j+1) on these lines.      */
+/******************************************************************************/
+static void StarletColumns (
+   type_starlet_job *job,               /* job being run */
+   int              ili_first,          /* first line of the band */
+   int              ili_last)           /* line following the band */
+{
+   type_starlet     *starlet;           /* planes being computed */
+   int              nliin;              /* line number */
+   int              npxin;              /* pixel number */
+   int              step;               /* distance between taps: 2^j */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among taps */
+   float            *row[5];            /* lines of the work plane (taps) */
+   float            *next;              /* line of c(j+1) */
+   float            *detail;            /* line of c(j), then w(j+1) */
+   unsigned char    *in0;               /* line of c0 */
+
+   starlet = job->starlet;
+   nliin   = starlet->nliin;
+   npxin   = starlet->npxin;
+   step    = 1 << job->scale;
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+      for (k=0; k<5; k++)
+         row[k] = &(starlet->work[StarletMirror(ili+(k-2)*step,nliin)*npxin]);
+      next   = &(starlet->plane[job->scale+1][ili*npxin]);
+      detail = &(starlet->plane[job->scale][ili*npxin]);
+      in0    = &(job->image_in[ili*npxin]);
+      for (ipx=0; ipx<npxin; ipx++)
+         next[ipx] = (row[0][ipx] + row[4][ipx] +
+                      4.f * (row[1][ipx] + row[3][ipx]) +
+                      6.f * row[2][ipx]) / 16.f;
+      if (job->scale == 0)
+      {
+         for (ipx=0; ipx<npxin; ipx++)
+            detail[ipx] = in0[ipx] - next[ipx];
+      }
+      else
+      {
+         for (ipx=0; ipx<npxin; ipx++)
+            detail[ipx] = detail[ipx] - next[ipx];
+      }
+   }
+} /* StarletColumns */
+
+/******************************************************************************/
+/* StarletOutput sums the planes on lines [ili_first,ili_last[ into the       */
+/* same lines of the work plane, then rounds and clips them into the output   */
+/* image.                                                                     */
+/******************************************************************************/
+static void StarletOutput (
+   type_starlet_job *job,               /* job being run */
+   int              ili_first,          /* first line of the band */
+   int              ili_last)           /* line following the band */
+{
+   type_starlet     *starlet;           /* planes being summed */
+   int              first;              /* first pixel of the band */
+   int              count;              /* pixel number of the band */
+   int              ipixel;             /* index among pixels */
+   int              iscale;             /* index among planes */
+   float            *sum;               /* sums of the band */
+
+   starlet = job->starlet;
+   first   = ili_first * starlet->npxin;
+   count   = (ili_last - ili_first) * starlet->npxin;
+   sum     = &(starlet->work[first]);
+   memcpy (sum,&(starlet->plane[0][first]),count*sizeof(float));
+   for (iscale=1; iscale<=starlet->scale_number; iscale++)
+   {
+      for (ipixel=0; ipixel<count; ipixel++)
+         sum[ipixel] = sum[ipixel] + starlet->plane[iscale][first+ipixel];
+   }
+   SaturateRow (sum,&(job->image_out[first]),count,1.f,0.5f);
+} /* StarletOutput */
+
+/******************************************************************************/
+/* StarletTask is the pool task running one band of the current phase.        */
+/******************************************************************************/
+static void StarletTask (
+   void             *argument,          /* type_starlet_job being run */
+   int              itask)              /* index of the band */
+{
+   type_starlet_job *job;               /* job the task belongs to */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+
+   job       = (type_starlet_job*)argument;
+   ili_first = itask * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->starlet->nliin)
+      ili_last = job->starlet->nliin;
+   if (job->phase == PHASE_LINES)
+      StarletLines (job,ili_first,ili_last);
+   else if (job->phase == PHASE_COLUMNS)
+      StarletColumns (job,ili_first,ili_last);
+   else
+      StarletOutput (job,ili_first,ili_last);
+} /* StarletTask */
+
+/******************************************************************************/
+/* StarletInit fills the job and cuts the planes into bands of lines.         */
+/******************************************************************************/
+static void StarletInit (
+   type_starlet_job *job,               /* job to be filled */
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_starlet     *starlet)           /* planes of the job */
+{
+   memset (job,0,sizeof(type_starlet_job));
+   job->starlet     = starlet;
+   job->band_number = BAND_PER_THREAD * PoolThreadNumber(pool);
+   if (job->band_number > starlet->nliin / MIN_BAND_LINES)
+      job->band_number = starlet->nliin / MIN_BAND_LINES;
+   if (job->band_number < 1)
+      job->band_number = 1;
+   job->band_lines  = (starlet->nliin + job->band_number - 1) /
+                      job->band_number;
+   job->band_number = (starlet->nliin + job->band_lines - 1) /
+                      job->band_lines;
+} /* StarletInit */
+
+/******************************************************************************/
+/* StarletAlloc allocates the J + 1 planes of a decomposition and its work    */
+/* plane. Returns 1 if scale_number is not in [1,MAX_STARLET_SCALE] or        */
+/* memory is lacking.                                                         */
+/******************************************************************************/
+int StarletAlloc (
+   type_starlet     *starlet,           /* decomposition to be allocated */
+   int              scale_number,       /* number J of detail planes */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   int              iscale;             /* index among planes */
+
+   memset (starlet,0,sizeof(type_starlet));
+   if ((scale_number < 1) || (scale_number > MAX_STARLET_SCALE)           ||
+       (nliin <= 0) || (npxin <= 0))
+      return (1);
+   if ((starlet->buffer=(float*)malloc((size_t)(scale_number+2)*nliin*npxin*
+         sizeof(float))) == NULL)
+      return (1);
+   starlet->scale_number = scale_number;
+   starlet->nliin        = nliin;
+   starlet->npxin        = npxin;
+   for (iscale=0; iscale<=scale_number; iscale++)
+      starlet->plane[iscale] = &(starlet->buffer[(size_t)iscale*nliin*npxin]);
+   starlet->work = &(starlet->buffer[(size_t)(scale_number+1)*nliin*npxin]);
+   return (0);
+} /* StarletAlloc */
+
+/******************************************************************************/
+/* StarletFree releases the planes of a decomposition.                        */
+/******************************************************************************/
+void StarletFree (
+   type_starlet     *starlet)           /* decomposition to be released */
+{
+   free (starlet->buffer);
+   memset (starlet,0,sizeof(type_starlet));
+} /* StarletFree */
+
+/******************************************************************************/
+/* StarletDecompose computes w1 ... wJ and cJ of one channel.                 */
+/******************************************************************************/
+int StarletDecompose (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_starlet     *starlet,           /* allocated decomposition */
+   unsigned char    *image_in)          /* input image array (one channel) */
+{
+   type_starlet_job job;                /* job shared by all the tasks */
+
+   StarletInit (&job,pool,starlet);
+   job.image_in = image_in;
+   for (job.scale=0; job.scale<starlet->scale_number; job.scale++)
+   {
+      job.phase = PHASE_LINES;
+      PoolRun (pool,job.band_number,StarletTask,&job);
+      job.phase = PHASE_COLUMNS;
+      PoolRun (pool,job.band_number,StarletTask,&job);
+   }
+   return (0);
+} /* StarletDecompose */
+
+/******************************************************************************/
+/* StarletThreshold sets to 0 the detail coefficients below factor x          */
+/* sigma(j) (hard), or also moves the others towards 0 by as much (soft).     */
+/* If *noise_sigma <= 0, it is estimated from w1 and returned.                */
+/******************************************************************************/
+int StarletThreshold (
+   type_starlet     *starlet,           /* decomposition to be thresholded */
+   double           factor,             /* threshold in noise deviations */
+   double           *noise_sigma,       /* deviation of the image noise */
+   int              soft)               /* 1: soft thresholding, 0: hard */
+{
+   int              *histogram;         /* histogram of |w1| */
+   int              pixel_number;       /* pixels of a plane */
+   int              ipixel;             /* index among pixels */
+   int              ibin;               /* index among bins */
+   int              count;              /* pixels below the bin */
+   int              iscale;             /* index among detail planes */
+   float            threshold;          /* threshold of the current scale */
+   float            *plane;             /* detail plane being thresholded */
+
+   pixel_number = starlet->nliin * starlet->npxin;
+   if (*noise_sigma <= 0.)
+   {
+/*----------------------------------------------------------------------------*/
+/*    Median absolute value of w1, by a histogram of 1/MAD_BIN gray levels    */
+/*----------------------------------------------------------------------------*/
+      if ((histogram=(int*)calloc((MAX_COLOR+1)*MAD_BIN,sizeof(int))) == NULL)
+         return (1);
+      for (ipixel=0; ipixel<pixel_number; ipixel++)
+      {
+         ibin = (int)(fabs(starlet->plane[0][ipixel]) * MAD_BIN);
+         if (ibin > (MAX_COLOR+1)*MAD_BIN-1)
+            ibin = (MAX_COLOR+1)*MAD_BIN-1;
+         histogram[ibin] = histogram[ibin] + 1;
+      }
+      count = 0;
+      for (ibin=0; count+histogram[ibin]<=pixel_number/2; ibin++)
+         count = count + histogram[ibin];
+      free (histogram);
+      *noise_sigma = (ibin + 0.5) / MAD_BIN / MAD_TO_SIGMA / STARLET_NOISE[0];
+   }
+   for (iscale=0; iscale<starlet->scale_number; iscale++)
+   {
+      threshold = (float)(factor * *noise_sigma * STARLET_NOISE[iscale]);
+      plane     = starlet->plane[iscale];
+      for (ipixel=0; ipixel<pixel_number; ipixel++)
+      {
+         if (fabsf(plane[ipixel]) < threshold)
+            plane[ipixel] = 0.f;
+         else if (soft)
+            plane[ipixel] = (plane[ipixel] > 0.f ? plane[ipixel] - threshold :
+                             plane[ipixel] + threshold);
+      }
+   }
+   return (0);
+} /* StarletThreshold */
+
+/******************************************************************************/
+/* StarletReconstruct sums the planes of a decomposition into one channel.    */
+/******************************************************************************/
+int StarletReconstruct (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   type_starlet     *starlet,           /* decomposition */
+   unsigned char    *image_out)         /* output image array (one channel) */
+{
+   type_starlet_job job;                /* job shared by all the tasks */
+
+   StarletInit (&job,pool,starlet);
+   job.phase     = PHASE_OUTPUT;
+   job.image_out = image_out;
+   PoolRun (pool,job.band_number,StarletTask,&job);
+   return (0);
+} /* StarletReconstruct */
+
+/******************************************************************************/
+/* StarletScale displays plane iscale (1 ... J: detail, offset by half the    */
+/* dynamic; J + 1: residual) into one channel. Returns 1 if iscale is out of  */
+/* range.                                                                     */
+/******************************************************************************/
+int StarletScale (
+   type_starlet     *starlet,           /* decomposition */
+   int              iscale,             /* plane to be displayed */
+   unsigned char    *image_out)         /* output image array (one channel) */
+{
+   int              pixel_number;       /* pixels of a plane */
+   int              ipixel;             /* index among pixels */
+   float            offset;             /* gray level of a zero coefficient */
+   float            output_value;       /* output value before clipping */
+
+   if ((iscale < 1) || (iscale > starlet->scale_number+1))
+      return (1);
+   pixel_number = starlet->nliin * starlet->npxin;
+   offset       = (iscale <= starlet->scale_number ? (MAX_COLOR+1)/2 : 0);
+   for (ipixel=0; ipixel<pixel_number; ipixel++)
+   {
+      output_value = starlet->plane[iscale-1][ipixel] + offset + 0.5f;
+      if (output_value < 0)
+         output_value = 0;
+      if (output_value > MAX_COLOR)
+         output_value = MAX_COLOR;
+      image_out[ipixel] = (unsigned char)output_value;
+   }
+   return (0);
+} /* StarletScale */
+
+/******************************************************************************/
+/* StarletDenoise thresholds the J detail planes of every channel at factor   */
+/* times the estimated noise (hard thresholding: soft thresholding shrinks    */
+/* the edges as well) and reconstructs it.                                    */
+/* Returns 1 if scale_number is out of range or memory is lacking.            */
+/******************************************************************************/
+int StarletDenoise (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              scale_number,       /* number J of detail planes */
+   double           factor,             /* threshold in noise deviations */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_starlet     starlet;            /* planes reused by the channels */
+   int              ichannel;           /* index among channels */
+   double           noise_sigma;        /* estimated noise of the channel */
+
+   if (StarletAlloc(&starlet,scale_number,nliin,npxin) != 0)
+      return (1);
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      noise_sigma = 0.;
+      StarletDecompose (pool,&starlet,image_in[ichannel]);
+      if (StarletThreshold(&starlet,factor,&noise_sigma,0) != 0)
+      {
+         StarletFree (&starlet);
+         return (1);
+      }
+      StarletReconstruct (pool,&starlet,image_out[ichannel]);
+   }
+   StarletFree (&starlet);
+   return (0);
+} /* StarletDenoise */
+
+/******************************************************************************/
+/* StarletDetail displays plane iscale (see StarletScale) of every channel.   */
+/* Returns 1 if a number of planes is out of range or memory is lacking.      */
+/******************************************************************************/
+int StarletDetail (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   int              scale_number,       /* number J of detail planes */
+   int              iscale,             /* plane to be displayed */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_starlet     starlet;            /* planes reused by the channels */
+   int              ichannel;           /* index among channels */
+
+   if (StarletAlloc(&starlet,scale_number,nliin,npxin) != 0)
+      return (1);
+   for (ichannel=0; ichannel<channel_number; ichannel++)
+   {
+      StarletDecompose (pool,&starlet,image_in[ichannel]);
+      if (StarletScale(&starlet,iscale,image_out[ichannel]) != 0)
+      {
+         StarletFree (&starlet);
+         return (1);
+      }
+   }
+   StarletFree (&starlet);
+   return (0);
+} /* StarletDetail */
@@ -0,0 +1,49 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* starlet decomposes an image into wavelet detail planes by the "a trous"    */
+/* algorithm (isotropic undecimated wavelet), thresholds and reconstructs it. */
+/******************************************************************************/
+#ifndef STARLET_H
+#define STARLET_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MAX_STARLET_SCALE   8           /* greatest number of detail planes */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   int              scale_number;       /* number J of detail planes */
+   int              nliin;              /* line number of the planes */
+   int              npxin;              /* pixel number of the planes */
+   float            *buffer;            /* the J + 2 planes, one allocation */
+   float            *plane[MAX_STARLET_SCALE+1]; /* w1 ... wJ, residual cJ */
+   float            *work;              /* line pass of the current scale */
+} type_starlet;
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int StarletAlloc (type_starlet *starlet, int scale_number, int nliin,
+                  int npxin);
+void StarletFree (type_starlet *starlet);
+int StarletDecompose (type_pool *pool, type_starlet *starlet,
+                      unsigned char *image_in);
+int StarletThreshold (type_starlet *starlet, double factor,
+                      double *noise_sigma, int soft);
+int StarletReconstruct (type_pool *pool, type_starlet *starlet,
+                        unsigned char *image_out);
+int StarletScale (type_starlet *starlet, int iscale,
+                  unsigned char *image_out);
+int StarletDenoise (type_pool *pool, int scale_number, double factor,
+                    int channel_number, unsigned char *image_in[3],
+                    unsigned char *image_out[3], int nliin, int npxin);
+int StarletDetail (type_pool *pool, int scale_number, int iscale,
+                   int channel_number, unsigned char *image_in[3],
+                   unsigned char *image_out[3], int nliin, int npxin);
+
+#endif /* STARLET_H */
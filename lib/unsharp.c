@@ -0,0 +1,255 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* unsharp sharpens an image by unsharp masking (high boost) in one pass:     */
+/* Gauss blur, difference, gain and clipping fused line by line.              */
+/******************************************************************************/
+/* DESCRIPTION                                                                */
+/*    out = in + amount x (in - gauss * in)     where |in - gauss * in| >=    */
+/*                                              threshold, out = in elsewhere */
+/* amount = A - 1 gives the high boost filter A in - gauss * in.              */
+/*                                                                            */
+/* Run as a Gauss convolution followed by an arithmetic pass, the operator    */
+/* writes and reads back a whole blurred plane. Here, for each output line:   */
+/* . the 2R + 1 input lines around it are combined into ONE row of floats     */
+/*   (vertical pass of the separable Gauss, R = ceil(3 sigma));               */
+/* . the row is blurred horizontally into a second row, with folded           */
+/*   symmetric taps, then difference, gain, threshold and clipping write the  */
+/*   output line.                                                             */
+/* The only intermediates are 2 rows of floats per band, which stay in        */
+/* cache: the image is read once and written once. Lines are clamped on       */
+/* the borders (replication). Output values are rounded, so that amount = 0   */
+/* gives back the input.                                                      */
+/******************************************************************************/
+
+/******************************************************************************/
+/* Standard inclusion files                                                   */
+/******************************************************************************/
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <string.h>
+#include  <math.h>
+
+#include  "unsharp.h"
+#include  "cpu.h"
+#include  "saturate.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define BAND_PER_THREAD 4               /* bands per thread for load balance */
+#define MIN_BAND_LINES  16              /* smallest height of a band */
+
+/******************************************************************************/
+/* Type definitions                                                           */
+/******************************************************************************/
+typedef struct {
+   float            weight[MAX_UNSHARP_RADIUS+1]; /* Gauss taps 0 ... R */
+   int              radius;             /* half size R of the blur */
+   float            amount;             /* gain of the difference */
+   float            threshold;          /* smallest difference sharpened */
+   unsigned char    **image_in;         /* input image arrays */
+   unsigned char    **image_out;        /* output image arrays */
+   int              nliin;              /* input line number */
+   int              npxin;              /* input pixel number */
+   int              band_number;        /* number of bands per channel */
+   int              band_lines;         /* number of lines per band */
+   int              status;             /* 0 or error reported by a task */
+} type_unsharp_job;
+
+typedef void (*type_unsharp_rows) (type_unsharp_job *job,
+                                   unsigned char *image_in,
+                                   unsigned char *image_out, int ili_first,
+                                   int ili_last, float *row);
+
+/******************************************************************************/
+/* UnsharpWeights computes the taps 0 ... R of the normalized Gauss vector of */
+/* sigma. Returns R, or -1 if sigma is out of range.                          */
+/******************************************************************************/
+int UnsharpWeights (
+   double           sigma,              /* Gaussian standard deviation */
+   float            weight[MAX_UNSHARP_RADIUS+1]) /* taps 0 ... R */
+{
+   int              radius;             /* half size R of the blur */
+   int              k;                  /* index among taps */
+   double           sum;                /* sum of the 2R + 1 taps */
+
+   radius = (int)ceil(3. * sigma);
+   if ((sigma < MIN_UNSHARP_SIGMA) || (radius > MAX_UNSHARP_RADIUS))
+      return (-1);
+   sum = 0.;
+   for (k=0; k<=radius; k++)
+   {
+      weight[k] = (float)exp(-k*k / (2. * sigma * sigma));
+      sum = sum + (k == 0 ? 1. : 2.) * weight[k];
+   }
+   for (k=0; k<=radius; k++)
+      weight[k] = (float)(weight[k] / sum);
+   return (radius);
+} /* UnsharpWeights */
+
+/******************************************************************************/
+/* UnsharpKernel sharpens lines [ili_first,ili_last[ of one channel, compiled */
+/* once per CPU level by the variants below: the loops along the row are      */
+/* vectorized.                                                                */
+/******************************************************************************/
+static CPU_INLINE void UnsharpKernel (
+   type_unsharp_job *job,               /* job being run */
+   unsigned char    *image_in,          /* input image array */
+   unsigned char    *image_out,         /* output image array */
+   int              ili_first,          /* first line to be computed */
+   int              ili_last,           /* line following the last one */
+   float            *row)               /* 2 npxin + 2R floats */
+{
+   int              radius;             /* half size R of the blur */
+   int              npxin;              /* pixel number */
+   int              ili;                /* index among lines */
+   int              ipx;                /* index among pixels */
+   int              k;                  /* index among taps */
+   unsigned char    *above;             /* input line k lines above */
+   unsigned char    *below;             /* input line k lines below */
+   unsigned char    *in;                /* input line of the output */
+   float            *sum;               /* row without its left margin */
+   float            *blur;              /* blurred row */
+   float            difference;         /* in - blur */
+   float            weight;             /* current tap */
+
+   radius = job->radius;
+   npxin  = job->npxin;
+   sum    = row + radius;
+   blur   = row + npxin + 2*radius;
+   for (ili=ili_first; ili<ili_last; ili++)
+   {
+/*----------------------------------------------------------------------------*/
+/*    Vertical pass: 2R + 1 lines -> one row                                  */
+/*----------------------------------------------------------------------------*/
+      in     = &(image_in[ili*npxin]);
+      weight = job->weight[0];
+      for (ipx=0; ipx<npxin; ipx++)
+         sum[ipx] = weight * in[ipx];
+      for (k=1; k<=radius; k++)
+      {
+         above  = &(image_in[(ili-k < 0 ? 0 : ili-k)*npxin]);
+         below  = &(image_in[(ili+k >= job->nliin ? job->nliin-1 : ili+k)*
+                             npxin]);
+         weight = job->weight[k];
+         for (ipx=0; ipx<npxin; ipx++)
+            sum[ipx] = sum[ipx] + weight * (above[ipx] + below[ipx]);
+      }
+      for (k=1; k<=radius; k++)
+      {
+         sum[-k]        = sum[0];
+         sum[npxin-1+k] = sum[npxin-1];
+      }
+/*----------------------------------------------------------------------------*/
+/*    Horizontal pass, tap by tap along the row                               */
+/*----------------------------------------------------------------------------*/
+      weight = job->weight[0];
+      for (ipx=0; ipx<npxin; ipx++)
+         blur[ipx] = weight * sum[ipx];
+      for (k=1; k<=radius; k++)
+      {
+         weight = job->weight[k];
+         for (ipx=0; ipx<npxin; ipx++)
+            blur[ipx] = blur[ipx] + weight * (sum[ipx-k] + sum[ipx+k]);
+      }
+/*----------------------------------------------------------------------------*/
+/*    Difference, gain and threshold, then rounding and clipping              */
+/*----------------------------------------------------------------------------*/
+      for (ipx=0; ipx<npxin; ipx++)
+      {
+         difference = in[ipx] - blur[ipx];
+         blur[ipx]  = (fabsf(difference) >= job->threshold ?
+                       in[ipx] + job->amount * difference : in[ipx]);
+      }
+      SaturateRow (blur,&(image_out[ili*npxin]),npxin,1.f,0.5f);
+   }
+} /* UnsharpKernel */
+
+/******************************************************************************/
+/* Variants of the kernel, one per CPU level (cpu.h), and their table         */
+/******************************************************************************/
+#define UNSHARP_VARIANT(name,target)                                           \
+static target void name (type_unsharp_job *job, unsigned char *image_in,       \
+                         unsigned char *image_out, int ili_first,              \
+                         int ili_last, float *row)                             \
+{                                                                              \
+   UnsharpKernel (job,image_in,image_out,ili_first,ili_last,row);              \
+}
+
+UNSHARP_VARIANT (UnsharpScalar,CPU_TARGET_SCALAR)
+UNSHARP_VARIANT (UnsharpSse42,CPU_TARGET_SSE42)
+UNSHARP_VARIANT (UnsharpAvx2,CPU_TARGET_AVX2)
+UNSHARP_VARIANT (UnsharpAvx512,CPU_TARGET_AVX512)
+
+static type_unsharp_rows UNSHARP_ROWS[CPU_LEVEL_NUMBER] = {
+   UnsharpScalar, UnsharpSse42, UnsharpAvx2, UnsharpAvx512 };
+
+/******************************************************************************/
+/* UnsharpTask is the pool task sharpening one band of one channel.           */
+/******************************************************************************/
+static void UnsharpTask (
+   void             *argument,          /* type_unsharp_job being run */
+   int              itask)              /* channel * band_number + band */
+{
+   type_unsharp_job *job;               /* job the task belongs to */
+   int              ichannel;           /* channel of the task */
+   int              ili_first;          /* first line of the band */
+   int              ili_last;           /* line following the band */
+   float            *row;               /* row of the vertical pass */
+
+   job       = (type_unsharp_job*)argument;
+   ichannel  = itask / job->band_number;
+   ili_first = (itask % job->band_number) * job->band_lines;
+   ili_last  = ili_first + job->band_lines;
+   if (ili_last > job->nliin)
+      ili_last = job->nliin;
+   if ((row=(float*)malloc((2*job->npxin+2*job->radius)*sizeof(float))) ==
+       NULL)
+   {
+      job->status = 1;
+      return;
+   }
+   UNSHARP_ROWS[CpuLevel()] (job,job->image_in[ichannel],
+      job->image_out[ichannel],ili_first,ili_last,row);
+   free (row);
+} /* UnsharpTask */
+
+/******************************************************************************/
+/* UnsharpMask sharpens all the channels. The output must not be the input.   */
+/* Returns 1 if sigma is out of range or memory is lacking.                   */
+/******************************************************************************/
+int UnsharpMask (
+   type_pool        *pool,              /* thread pool (NULL = serial) */
+   double           sigma,              /* standard deviation of the blur */
+   double           amount,             /* gain of the difference */
+   double           threshold,          /* smallest difference sharpened */
+   int              channel_number,     /* number of channels (1 or 3) */
+   unsigned char    *image_in[3],       /* input image arrays */
+   unsigned char    *image_out[3],      /* output image arrays */
+   int              nliin,              /* input line number */
+   int              npxin)              /* input pixel number */
+{
+   type_unsharp_job job;                /* job shared by all the tasks */
+
+   if ((nliin <= 0) || (npxin <= 0))
+      return (0);
+   memset (&job,0,sizeof(type_unsharp_job));
+   if ((job.radius=UnsharpWeights(sigma,job.weight)) < 0)
+      return (1);
+   job.amount      = (float)amount;
+   job.threshold   = (float)threshold;
+   job.image_in    = image_in;
+   job.image_out   = image_out;
+   job.nliin       = nliin;
+   job.npxin       = npxin;
+   job.band_number = (BAND_PER_THREAD * PoolThreadNumber(pool) +
+                      channel_number - 1) / channel_number;
+   if (job.band_number > nliin / MIN_BAND_LINES)
+      job.band_number = nliin / MIN_BAND_LINES;
+   if (job.band_number < 1)
+      job.band_number = 1;
+   job.band_lines  = (nliin + job.band_number - 1) / job.band_number;
+   job.band_number = (nliin + job.band_lines - 1) / job.band_lines;
+   PoolRun (pool,channel_number*job.band_number,UnsharpTask,&job);
+   return (job.status);
+} /* UnsharpMask */
@@ -0,0 +1,26 @@
+/******************************************************************************/
+/* NAME                                                                       */
+/* unsharp sharpens an image by unsharp masking (high boost) in one pass:     */
+/* Gauss blur, difference, gain and clipping fused line by line.              */
+/******************************************************************************/
+#ifndef UNSHARP_H
+#define UNSHARP_H
+
+#include  "pool.h"
+
+/******************************************************************************/
+/* Constant definitions                                                       */
+/******************************************************************************/
+#define MIN_UNSHARP_SIGMA   0.5         /* smallest sigma of the blur */
+#define MAX_UNSHARP_RADIUS  64          /* greatest half size of the blur */
+
+/******************************************************************************/
+/* Function declarations                                                      */
+/******************************************************************************/
+int UnsharpWeights (double sigma, float weight[MAX_UNSHARP_RADIUS+1]);
+int UnsharpMask (type_pool *pool, double sigma, double amount,
+                 double threshold, int channel_number,
+                 unsigned char *image_in[3], unsigned char *image_out[3],
+                 int nliin, int npxin);
+
+#endif /* UNSHARP_H */